@@ -0,0 +1,393 @@
+// This file is part of the Luau programming language and is licensed under MIT License; see LICENSE.txt for details
+#include "lua.h"
+
+#include "Luau/Common.h"
+#include "Luau/HeapSnapshot.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct GroupStats
+{
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+struct Snapshot
+{
+    uint64_t totalbytes = 0;
+    GroupStats objects;
+    uint64_t edges = 0;
+
+    // objects are grouped by type and category, and by type and name; keys pack the two values
+    std::unordered_map<uint64_t, GroupStats> bycategory;
+    std::unordered_map<uint64_t, GroupStats> byname;
+
+    std::vector<std::string> names;
+    std::string categorynames[LUA_MEMORY_CATEGORIES];
+};
+
+// snapshots are read in chunks, so that they don't need to fit in memory
+struct SnapshotReader
+{
+    FILE* file = nullptr;
+    char buffer[16384];
+    size_t pos = 0;
+    size_t size = 0;
+    bool error = false;
+
+    uint8_t byte()
+    {
+        if (pos == size)
+        {
+            size = fread(buffer, 1, sizeof(buffer), file);
+            pos = 0;
+
+            if (size == 0)
+            {
+                error = true;
+                return 0;
+            }
+        }
+
+        return uint8_t(buffer[pos++]);
+    }
+
+    uint64_t varint()
+    {
+        uint64_t result = 0;
+
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t value = byte();
+            result |= uint64_t(value & 127) << shift;
+
+            if (!(value & 128))
+                return result;
+        }
+
+        error = true;
+        return 0;
+    }
+
+    std::string string()
+    {
+        uint64_t length = varint();
+        std::string result;
+
+        for (uint64_t i = 0; i < length && !error; ++i)
+            result += char(byte());
+
+        return result;
+    }
+};
+
+static const char* typeName(int type)
+{
+    switch (type)
+    {
+    case LUA_TSTRING:
+        return "string";
+    case LUA_TTABLE:
+        return "table";
+    case LUA_TFUNCTION:
+        return "function";
+    case LUA_TUSERDATA:
+        return "userdata";
+    case LUA_TTHREAD:
+        return "thread";
+    case LUA_TBUFFER:
+        return "buffer";
+    case LUA_TPROTO:
+        return "proto";
+    case LUA_TUPVAL:
+        return "upvalue";
+    case 255:
+        return "native";
+    default:
+        return "unknown";
+    }
+}
+
+static uint64_t groupKey(uint32_t type, uint32_t value)
+{
+    return (uint64_t(type) << 32) | value;
+}
+
+static bool readSnapshot(const char* path, Snapshot& snapshot)
+{
+    SnapshotReader reader;
+    reader.file = fopen(path, "rb");
+
+    if (!reader.file)
+    {
+        fprintf(stderr, "Error opening %s\n", path);
+        return false;
+    }
+
+    for (const char* magic = LHS_MAGIC; *magic; ++magic)
+        if (reader.byte() != uint8_t(*magic))
+            reader.error = true;
+
+    if (reader.error || reader.byte() != LHS_VERSION)
+    {
+        fprintf(stderr, "Error reading %s: not a heap snapshot, or unsupported snapshot version\n", path);
+        fclose(reader.file);
+        return false;
+    }
+
+    bool done = false;
+
+    while (!done && !reader.error)
+    {
+        switch (reader.byte())
+        {
+        case LHS_END:
+            snapshot.totalbytes = reader.varint();
+            done = true;
+            break;
+
+        case LHS_NAME:
+            snapshot.names.push_back(reader.string());
+            break;
+
+        case LHS_OBJECT:
+        {
+            reader.varint(); // id
+            uint8_t type = reader.byte();
+            uint8_t memcat = reader.byte();
+            uint64_t size = reader.varint();
+            uint64_t name = reader.varint();
+
+            for (GroupStats* stats : {&snapshot.objects, &snapshot.bycategory[groupKey(type, memcat)], &snapshot.byname[groupKey(type, uint32_t(name))]})
+            {
+                stats->count++;
+                stats->bytes += size;
+            }
+            break;
+        }
+
+        case LHS_SOURCE:
+            reader.varint(); // id
+            break;
+
+        case LHS_EDGE:
+            reader.varint(); // id
+            reader.varint(); // name
+            snapshot.edges++;
+            break;
+
+        case LHS_ROOT:
+            reader.varint(); // id
+            reader.varint(); // name
+            break;
+
+        case LHS_CATEGORY:
+        {
+            uint8_t memcat = reader.byte();
+            reader.varint(); // size
+            uint64_t name = reader.varint();
+
+            if (name != 0 && name <= snapshot.names.size())
+                snapshot.categorynames[memcat] = snapshot.names[name - 1];
+            break;
+        }
+
+        default:
+            reader.error = true;
+        }
+    }
+
+    fclose(reader.file);
+
+    if (reader.error)
+    {
+        fprintf(stderr, "Error reading %s: snapshot is truncated or corrupted\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+struct Growth
+{
+    std::string name;
+    GroupStats before;
+    GroupStats after;
+
+    int64_t countDelta() const
+    {
+        return int64_t(after.count) - int64_t(before.count);
+    }
+
+    int64_t bytesDelta() const
+    {
+        return int64_t(after.bytes) - int64_t(before.bytes);
+    }
+};
+
+static void addGrowth(std::unordered_map<std::string, Growth>& growth, const std::string& name, const GroupStats& stats, bool after)
+{
+    Growth& entry = growth[name];
+    entry.name = name;
+
+    GroupStats& target = after ? entry.after : entry.before;
+    target.count += stats.count;
+    target.bytes += stats.bytes;
+}
+
+static void printGrowth(const char* title, const std::unordered_map<std::string, Growth>& growth, size_t limit)
+{
+    std::vector<Growth> entries;
+
+    for (const auto& [name, entry] : growth)
+        if (entry.countDelta() != 0 || entry.bytesDelta() != 0)
+            entries.push_back(entry);
+
+    // largest growth first, then largest shrinkage
+    std::sort(
+        entries.begin(),
+        entries.end(),
+        [](const Growth& l, const Growth& r)
+        {
+            return l.bytesDelta() != r.bytesDelta() ? l.bytesDelta() > r.bytesDelta() : l.name < r.name;
+        }
+    );
+
+    if (entries.size() > limit)
+        entries.resize(limit);
+
+    printf("\n%s:\n", title);
+    printf("%12s %12s %14s %14s  %s\n", "count", "delta", "bytes", "delta", "name");
+
+    for (const Growth& entry : entries)
+        printf(
+            "%12llu %+12lld %14llu %+14lld  %s\n",
+            (unsigned long long)entry.after.count,
+            (long long)entry.countDelta(),
+            (unsigned long long)entry.after.bytes,
+            (long long)entry.bytesDelta(),
+            entry.name.c_str()
+        );
+}
+
+static std::string categoryName(const Snapshot& before, const Snapshot& after, int memcat)
+{
+    const std::string& name = !after.categorynames[memcat].empty() ? after.categorynames[memcat] : before.categorynames[memcat];
+
+    return name.empty() ? std::to_string(memcat) : std::to_string(memcat) + " " + name;
+}
+
+static void displayHelp(const char* argv0)
+{
+    printf("Usage: %s [options] before.snapshot after.snapshot\n", argv0);
+    printf("\n");
+    printf("Reports heap growth between two heap snapshots, by object type, by memory category and by object name.\n");
+    printf("\n");
+    printf("Available options:\n");
+    printf("  -h, --help: Display this usage message.\n");
+    printf("  --top=N: report the N largest changes of each kind (default 20).\n");
+}
+
+static int assertionHandler(const char* expr, const char* file, int line, const char* function)
+{
+    printf("%s(%d): ASSERTION FAILED: %s\n", file, line, expr);
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    Luau::assertHandler() = assertionHandler;
+
+    size_t top = 20;
+    std::vector<const char*> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            displayHelp(argv[0]);
+            return 0;
+        }
+        else if (strncmp(argv[i], "--top=", 6) == 0)
+        {
+            top = size_t(atoi(argv[i] + 6));
+        }
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "Error: Unrecognized option '%s'.\n\n", argv[i]);
+            displayHelp(argv[0]);
+            return 1;
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if (files.size() != 2)
+    {
+        displayHelp(argv[0]);
+        return 1;
+    }
+
+    Snapshot before;
+    Snapshot after;
+
+    if (!readSnapshot(files[0], before) || !readSnapshot(files[1], after))
+        return 1;
+
+    printf(
+        "Heap: %llu -> %llu bytes (%+lld), %llu -> %llu objects (%+lld), %llu -> %llu references\n",
+        (unsigned long long)before.totalbytes,
+        (unsigned long long)after.totalbytes,
+        (long long)(int64_t(after.totalbytes) - int64_t(before.totalbytes)),
+        (unsigned long long)before.objects.count,
+        (unsigned long long)after.objects.count,
+        (long long)(int64_t(after.objects.count) - int64_t(before.objects.count)),
+        (unsigned long long)before.edges,
+        (unsigned long long)after.edges
+    );
+
+    std::unordered_map<std::string, Growth> bytype;
+    std::unordered_map<std::string, Growth> bycategory;
+    std::unordered_map<std::string, Growth> byname;
+
+    for (const Snapshot* snapshot : {&before, &after})
+    {
+        bool isAfter = snapshot == &after;
+
+        for (const auto& [key, stats] : snapshot->bycategory)
+        {
+            const char* type = typeName(int(key >> 32));
+            int memcat = int(key & 0xffffffff);
+
+            addGrowth(bytype, type, stats, isAfter);
+            addGrowth(bycategory, categoryName(before, after, memcat), stats, isAfter);
+        }
+
+        for (const auto& [key, stats] : snapshot->byname)
+        {
+            uint32_t name = uint32_t(key & 0xffffffff);
+
+            // name indices are local to each snapshot, names are matched by their text
+            std::string label = typeName(int(key >> 32));
+            label += " ";
+            label += name != 0 && name <= snapshot->names.size() ? snapshot->names[name - 1] : "(unnamed)";
+
+            addGrowth(byname, label, stats, isAfter);
+        }
+    }
+
+    printGrowth("Growth by type", bytype, top);
+    printGrowth("Growth by category", bycategory, top);
+    printGrowth("Growth by object name", byname, top);
+
+    return 0;
+}
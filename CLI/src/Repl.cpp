@@ -641,6 +641,117 @@ static bool runFile(const char* name, lua_State* GL, bool repl)
     return status == 0;
 }
 
+static void gcstatsDump(lua_State* L, const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening GC stats %s\n", path);
+        return;
+    }
+
+    // objects that are not exposed as Luau values are reported under their internal names, other memory is reported as "data"
+    static const struct
+    {
+        int type;
+        const char* name;
+    } kTypes[] = {
+        {LUA_TSTRING, "string"},
+        {LUA_TTABLE, "table"},
+        {LUA_TFUNCTION, "function"},
+        {LUA_TUSERDATA, "userdata"},
+        {LUA_TTHREAD, "thread"},
+        {LUA_TBUFFER, "buffer"},
+        {LUA_TPROTO, "proto"},
+        {LUA_TUPVAL, "upval"},
+        {LUA_TNIL, "data"},
+    };
+
+    lua_GCTypeStats stats = {};
+    lua_gettypestats(L, 0, LUA_TNIL, &stats);
+
+    fprintf(f, "{\"totalbytes\":%llu,\"cycletime\":%.6f,\"categories\":[", (unsigned long long)lua_totalbytes(L, -1), stats.cycletime);
+
+    bool firstcat = true;
+
+    for (int cat = 0; cat < LUA_MEMORY_CATEGORIES; ++cat)
+    {
+        // categories that were never used are skipped
+        bool used = false;
+
+        for (const auto& type : kTypes)
+        {
+            lua_gettypestats(L, cat, type.type, &stats);
+            used |= stats.allocated != 0;
+        }
+
+        if (!used)
+            continue;
+
+        fprintf(f, "%s\n{\"category\":%d,\"totalbytes\":%llu,\"types\":{", firstcat ? "" : ",", cat, (unsigned long long)lua_totalbytes(L, cat));
+        firstcat = false;
+
+        bool firsttype = true;
+
+        for (const auto& type : kTypes)
+        {
+            lua_gettypestats(L, cat, type.type, &stats);
+
+            if (stats.allocated == 0)
+                continue;
+
+            double allocrate = stats.cycletime > 0 ? double(stats.cycleallocated) / stats.cycletime : 0;
+
+            fprintf(
+                f,
+                "%s\"%s\":{\"count\":%llu,\"bytes\":%llu,\"allocated\":%llu,\"freed\":%llu,\"cycleallocated\":%llu,\"cyclefreed\":%llu,"
+                "\"allocrate\":%.0f}",
+                firsttype ? "" : ",",
+                type.name,
+                (unsigned long long)stats.count,
+                (unsigned long long)stats.bytes,
+                (unsigned long long)stats.allocated,
+                (unsigned long long)stats.freed,
+                (unsigned long long)stats.cycleallocated,
+                (unsigned long long)stats.cyclefreed,
+                allocrate
+            );
+            firsttype = false;
+        }
+
+        fprintf(f, "}}");
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    printf("GC stats written to %s\n", path);
+}
+
+static void heapSnapshotDump(lua_State* L, const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening heap snapshot %s\n", path);
+        return;
+    }
+
+    lua_heapsnapshot(
+        L,
+        f,
+        [](void* context, const void* data, size_t size)
+        {
+            fwrite(data, 1, size, static_cast<FILE*>(context));
+        },
+        nullptr
+    );
+
+    fclose(f);
+
+    printf("Heap snapshot written to %s\n", path);
+}
+
 static void displayHelp(const char* argv0)
 {
     printf("Usage: %s [options] [file list] [-a] [arg list]\n", argv0);
@@ -655,6 +766,8 @@ static void displayHelp(const char* argv0)
     printf("  -g<n>: compile with debug level n (default 1, n should be between 0 and 2).\n");
     printf("  --profile[=N]: profile the code using N Hz sampling (default 10000) and output results to profile.out\n");
     printf("  --timetrace: record compiler time tracing information into trace.json\n");
+    printf("  --gcstats: collect allocation counters for each memory category and object type and output results to gcstats.json\n");
+    printf("  --heapsnapshot: write a snapshot of the heap after running the code to heap.snapshot (see luau-heapdiff)\n");
     printf("  --codegen: execute code using native code generation\n");
     printf("  --program-args,-a: declare start of arguments to be passed to the Luau program\n");
 }
@@ -675,6 +788,8 @@ int replMain(int argc, char** argv)
 
     int profile = 0;
     bool coverage = false;
+    bool gcstats = false;
+    bool heapsnapshot = false;
     bool interactive = false;
     bool codegenPerf = false;
     int program_args = argc;
@@ -731,6 +846,14 @@ int replMain(int argc, char** argv)
         {
             coverage = true;
         }
+        else if (strcmp(argv[i], "--gcstats") == 0)
+        {
+            gcstats = true;
+        }
+        else if (strcmp(argv[i], "--heapsnapshot") == 0)
+        {
+            heapsnapshot = true;
+        }
         else if (strcmp(argv[i], "--timetrace") == 0)
         {
             FFlag::DebugLuauTimeTracing.value = true;
@@ -809,6 +932,9 @@ int replMain(int argc, char** argv)
         if (coverage)
             coverageInit(L);
 
+        if (gcstats)
+            lua_gc(L, LUA_GCTYPESTATS, 1);
+
         int failed = 0;
 
         for (size_t i = 0; i < files.size(); ++i)
@@ -826,6 +952,12 @@ int replMain(int argc, char** argv)
         if (coverage)
             coverageDump("coverage.out");
 
+        if (gcstats)
+            gcstatsDump(L, "gcstats.json");
+
+        if (heapsnapshot)
+            heapSnapshotDump(L, "heap.snapshot");
+
         return failed ? 1 : 0;
     }
 }
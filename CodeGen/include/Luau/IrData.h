@@ -75,6 +75,11 @@ enum class IrCmd : uint8_t
     // B: int
     GET_ARR_ADDR,
 
+    // Load a number from the packed array of a table at index
+    // A: pointer (LuaTable)
+    // B: int
+    LOAD_PACKED,
+
     // Get pointer (LuaNode) to table node element at the active cached slot index
     // A: pointer (LuaTable)
     // B: unsigned int (pcpos)
@@ -139,6 +144,12 @@ enum class IrCmd : uint8_t
     // D: int (optional 'A' pointer offset)
     STORE_SPLIT_TVALUE,
 
+    // Store a number into the packed array of a table at index
+    // A: pointer (LuaTable)
+    // B: int
+    // C: double
+    STORE_PACKED,
+
     // Add/Sub two integers together
     // A, B: int
     ADD_INT,
@@ -574,6 +585,13 @@ enum class IrCmd : uint8_t
     // When undef is specified instead of a block, execution is aborted on check failure
     CHECK_ARRAY_SIZE,
 
+    // Guard against the table not having a packed array (see ltable.cpp) or index overflowing its size
+    // A: pointer (LuaTable)
+    // B: int (index)
+    // C: block/vmexit/undef
+    // When undef is specified instead of a block, execution is aborted on check failure
+    CHECK_PACKED_SIZE,
+
     // Guard against cached table node slot not matching the actual table node slot for a key
     // A: pointer (LuaNode)
     // B: Kn
@@ -61,6 +61,7 @@ inline bool isNonTerminatingJump(IrCmd cmd)
     case IrCmd::CHECK_NO_METATABLE:
     case IrCmd::CHECK_SAFE_ENV:
     case IrCmd::CHECK_ARRAY_SIZE:
+    case IrCmd::CHECK_PACKED_SIZE:
     case IrCmd::CHECK_SLOT_MATCH:
     case IrCmd::CHECK_NODE_NO_NEXT:
     case IrCmd::CHECK_NODE_VALUE:
@@ -87,6 +88,7 @@ inline bool hasResult(IrCmd cmd)
     case IrCmd::LOAD_TVALUE:
     case IrCmd::LOAD_ENV:
     case IrCmd::GET_ARR_ADDR:
+    case IrCmd::LOAD_PACKED:
     case IrCmd::GET_SLOT_NODE_ADDR:
     case IrCmd::GET_HASH_NODE_ADDR:
     case IrCmd::GET_CLOSURE_UPVAL_ADDR:
@@ -62,16 +62,16 @@ static void emitInterrupt(AssemblyBuilderA64& build)
     // Stash return address in rBase; we need to reload rBase anyway
     build.mov(rBase, x1);
 
-    // Load interrupt handler; it may be nullptr in case the update raced with the check before we got here
-    build.ldr(x2, mem(rState, offsetof(lua_State, global)));
-    build.ldr(x2, mem(x2, offsetof(global_State, cb.interrupt)));
-    build.cbz(x2, skip);
-
     // Update savedpc; required in case interrupt errors
     build.add(x0, rCode, x0);
     build.ldr(x1, mem(rState, offsetof(lua_State, ci)));
     build.str(x0, mem(x1, offsetof(CallInfo, savedpc)));
 
+    // Load interrupt handler; it may be nullptr in case the update raced with the check before we got here
+    build.ldr(x2, mem(rState, offsetof(lua_State, global)));
+    build.ldr(x2, mem(x2, offsetof(global_State, cb.interrupt)));
+    build.cbz(x2, skip);
+
     // Call interrupt
     build.mov(x0, rState);
     build.mov(w1, -1);
@@ -92,10 +92,25 @@ static void emitInterrupt(AssemblyBuilderA64& build)
 
     build.setLabel(skip);
 
+#ifdef LUAU_MULTITHREAD
+    // Park while another thread runs a GC step
+    Label noRequest;
+
+    build.ldr(x2, mem(rState, offsetof(lua_State, global)));
+    build.ldr(w2, mem(x2, offsetof(global_State, threads.gcrequest)));
+    build.cbz(w2, noRequest);
+
+    build.mov(x0, rState);
+    build.ldr(x1, mem(rNativeContext, offsetof(NativeContext, luaE_safepoint)));
+    build.blr(x1);
+
+    build.setLabel(noRequest);
+#endif
+
     // Return back to caller; rBase has stashed return address
     build.mov(x0, rBase);
 
-    emitUpdateBase(build); // interrupt may have reallocated stack
+    emitUpdateBase(build); // interrupt or GC step may have reallocated stack
 
     build.br(x0);
 }
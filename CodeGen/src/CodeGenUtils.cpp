@@ -61,10 +61,60 @@ namespace Luau
 namespace CodeGen
 {
 
+// slots of a shaped table are numbered after its sentinel node
+static bool forgLoopSlotIter(lua_State* L, LuaTable* h, int index, TValue* ra)
+{
+    LuaShapedNode* sn = gshaped(h);
+    int first = sizearraykeys(h) + 1;
+
+    while (unsigned(index - first) < unsigned(sn->shape->count))
+    {
+        TValue* e = &sn->slots[index - first];
+
+        if (!ttisnil(e))
+        {
+            setpvalue(ra + 2, reinterpret_cast<void*>(uintptr_t(index + 1)), LU_TAG_ITERATOR);
+            setsvalue(L, ra + 3, sn->shape->keys[index - first]);
+            setobj(L, ra + 4, e);
+
+            return true;
+        }
+
+        index++;
+    }
+
+    return false;
+}
+
+// packed arrays have no nil values, and their keys are numbered like an array part
+static bool forgLoopPackedIter(LuaTable* h, int index, TValue* ra)
+{
+    LuaPackedArray* pa = gpacked(h);
+
+    if (unsigned(index) < unsigned(pa->size))
+    {
+        setpvalue(ra + 2, reinterpret_cast<void*>(uintptr_t(index + 1)), LU_TAG_ITERATOR);
+        setnvalue(ra + 3, double(index + 1));
+        setnvalue(ra + 4, pa->values[index]);
+
+        return true;
+    }
+
+    return false;
+}
+
 bool forgLoopTableIter(lua_State* L, LuaTable* h, int index, TValue* ra)
 {
     int sizearray = h->sizearray;
 
+    if (ispacked(h))
+    {
+        if (forgLoopPackedIter(h, index, ra))
+            return true;
+
+        sizearray = gpacked(h)->size;
+    }
+
     // first we advance index through the array portion
     while (unsigned(index) < unsigned(sizearray))
     {
@@ -85,7 +135,7 @@ bool forgLoopTableIter(lua_State* L, LuaTable* h, int index, TValue* ra)
     int sizenode = 1 << h->lsizenode;
 
     // then we advance index through the hash portion
-    while (unsigned(index - h->sizearray) < unsigned(sizenode))
+    while (unsigned(index - sizearray) < unsigned(sizenode))
     {
         LuaNode* n = &h->node[index - sizearray];
 
@@ -101,7 +151,7 @@ bool forgLoopTableIter(lua_State* L, LuaTable* h, int index, TValue* ra)
         index++;
     }
 
-    return false;
+    return isshaped(h) && forgLoopSlotIter(L, h, index, ra);
 }
 
 bool forgLoopNodeIter(lua_State* L, LuaTable* h, int index, TValue* ra)
@@ -109,6 +159,15 @@ bool forgLoopNodeIter(lua_State* L, LuaTable* h, int index, TValue* ra)
     int sizearray = h->sizearray;
     int sizenode = 1 << h->lsizenode;
 
+    // the array part is empty for packed tables, and the elements of their packed array come first
+    if (ispacked(h))
+    {
+        if (forgLoopPackedIter(h, index, ra))
+            return true;
+
+        sizearray = gpacked(h)->size;
+    }
+
     // then we advance index through the hash portion
     while (unsigned(index - sizearray) < unsigned(sizenode))
     {
@@ -126,7 +185,7 @@ bool forgLoopNodeIter(lua_State* L, LuaTable* h, int index, TValue* ra)
         index++;
     }
 
-    return false;
+    return isshaped(h) && forgLoopSlotIter(L, h, index, ra);
 }
 
 bool forgLoopNonTableFallback(lua_State* L, int insnA, int aux)
@@ -134,6 +193,15 @@ bool forgLoopNonTableFallback(lua_State* L, int insnA, int aux)
     TValue* base = L->base;
     TValue* ra = VM_REG(insnA);
 
+    // ipairs-style traversal of a table leaves the inline path at the end of the array part, where the elements of a packed array follow
+    if (aux < 0 && ttisnil(ra) && ttistable(ra + 1))
+    {
+        LuaTable* h = hvalue(ra + 1);
+        int index = int(reinterpret_cast<uintptr_t>(pvalue(ra + 2)));
+
+        return ispacked(h) && forgLoopPackedIter(h, index, ra);
+    }
+
     // note: it's safe to push arguments past top for complicated reasons (see lvmexecute.cpp)
     setobj2s(L, ra + 3 + 2, ra + 2);
     setobj2s(L, ra + 3 + 1, ra + 1);
@@ -484,7 +484,21 @@ void emitInterrupt(AssemblyBuilderX64& build)
 
     build.setLabel(skip);
 
-    emitUpdateBase(build); // interrupt may have reallocated stack
+#ifdef LUAU_MULTITHREAD
+    // Park while another thread runs a GC step
+    Label noRequest;
+
+    build.mov(rax, qword[rState + offsetof(lua_State, global)]);
+    build.cmp(dword[rax + offsetof(global_State, threads.gcrequest)], 0);
+    build.jcc(ConditionX64::Equal, noRequest);
+
+    build.mov(rArg1, rState);
+    build.call(qword[rNativeContext + offsetof(NativeContext, luaE_safepoint)]);
+
+    build.setLabel(noRequest);
+#endif
+
+    emitUpdateBase(build); // interrupt or GC step may have reallocated stack
 
     build.jmp(rbx);
 }
@@ -111,6 +111,8 @@ const char* getCmdName(IrCmd cmd)
         return "LOAD_ENV";
     case IrCmd::GET_ARR_ADDR:
         return "GET_ARR_ADDR";
+    case IrCmd::LOAD_PACKED:
+        return "LOAD_PACKED";
     case IrCmd::GET_SLOT_NODE_ADDR:
         return "GET_SLOT_NODE_ADDR";
     case IrCmd::GET_HASH_NODE_ADDR:
@@ -133,6 +135,8 @@ const char* getCmdName(IrCmd cmd)
         return "STORE_TVALUE";
     case IrCmd::STORE_SPLIT_TVALUE:
         return "STORE_SPLIT_TVALUE";
+    case IrCmd::STORE_PACKED:
+        return "STORE_PACKED";
     case IrCmd::ADD_INT:
         return "ADD_INT";
     case IrCmd::SUB_INT:
@@ -327,6 +331,8 @@ const char* getCmdName(IrCmd cmd)
         return "CHECK_SAFE_ENV";
     case IrCmd::CHECK_ARRAY_SIZE:
         return "CHECK_ARRAY_SIZE";
+    case IrCmd::CHECK_PACKED_SIZE:
+        return "CHECK_PACKED_SIZE";
     case IrCmd::CHECK_SLOT_MATCH:
         return "CHECK_SLOT_MATCH";
     case IrCmd::CHECK_NODE_NO_NEXT:
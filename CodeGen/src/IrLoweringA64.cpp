@@ -385,6 +385,14 @@ void IrLoweringA64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
             CODEGEN_ASSERT(!"Unsupported instruction form");
         break;
     }
+    case IrCmd::LOAD_PACKED:
+    {
+        inst.regA64 = regs.allocReg(KindA64::d, index);
+        AddressA64 addr = tempAddrPacked(inst.a, inst.b);
+
+        build.ldr(inst.regA64, addr);
+        break;
+    }
     case IrCmd::GET_SLOT_NODE_ADDR:
     {
         inst.regA64 = regs.allocReuse(KindA64::x, index, {inst.a});
@@ -596,6 +604,14 @@ void IrLoweringA64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
         }
         break;
     }
+    case IrCmd::STORE_PACKED:
+    {
+        RegisterA64 temp = tempDouble(inst.c);
+        AddressA64 addr = tempAddrPacked(inst.a, inst.b);
+
+        build.str(temp, addr);
+        break;
+    }
     case IrCmd::ADD_INT:
         inst.regA64 = regs.allocReuse(KindA64::w, index, {inst.a, inst.b});
         if (inst.b.kind == IrOpKind::Constant && unsigned(intOp(inst.b)) <= AssemblyBuilderA64::kMaxImmediate)
@@ -2265,6 +2281,47 @@ void IrLoweringA64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
         finalizeTargetLabel(inst.c, fresh);
         break;
     }
+    case IrCmd::CHECK_PACKED_SIZE:
+    {
+        Label fresh; // used when guard aborts execution or jumps to a VM exit
+        Label& fail = getTargetLabel(inst.c, fresh);
+
+        RegisterA64 temp = regs.allocTemp(KindA64::x);
+        RegisterA64 tempw = castReg(KindA64::w, temp);
+
+        // A packed table has no array part, and its 'array' points to the packed array
+        build.ldr(tempw, mem(regOp(inst.a), offsetof(LuaTable, sizearray)));
+        build.cbnz(tempw, fail);
+        build.ldr(temp, mem(regOp(inst.a), offsetof(LuaTable, array)));
+        build.cbz(temp, fail);
+        build.ldr(tempw, mem(temp, offsetof(LuaPackedArray, size)));
+
+        if (inst.b.kind == IrOpKind::Inst)
+        {
+            build.cmp(tempw, regOp(inst.b));
+            build.b(ConditionA64::UnsignedLessEqual, fail);
+        }
+        else if (inst.b.kind == IrOpKind::Constant)
+        {
+            if (size_t(intOp(inst.b)) <= AssemblyBuilderA64::kMaxImmediate)
+            {
+                build.cmp(tempw, uint16_t(intOp(inst.b)));
+                build.b(ConditionA64::UnsignedLessEqual, fail);
+            }
+            else
+            {
+                RegisterA64 temp2 = regs.allocTemp(KindA64::w);
+                build.mov(temp2, intOp(inst.b));
+                build.cmp(tempw, temp2);
+                build.b(ConditionA64::UnsignedLessEqual, fail);
+            }
+        }
+        else
+            CODEGEN_ASSERT(!"Unsupported instruction form");
+
+        finalizeTargetLabel(inst.c, fresh);
+        break;
+    }
     case IrCmd::JUMP_SLOT_MATCH:
     case IrCmd::CHECK_SLOT_MATCH:
     {
@@ -2534,6 +2591,11 @@ void IrLoweringA64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
 
         build.ldr(x0, mem(rGlobalState, offsetof(global_State, cb.interrupt)));
         build.cbnz(x0, self);
+#ifdef LUAU_MULTITHREAD
+        // Another thread waits for this one to reach a safepoint so it can run a GC step
+        build.ldr(w0, mem(rGlobalState, offsetof(global_State, threads.gcrequest)));
+        build.cbnz(w0, self);
+#endif
 
         Label next = build.setLabel();
 
@@ -3651,6 +3713,40 @@ AddressA64 IrLoweringA64::tempAddr(IrOp op, int offset, RegisterA64 tempStorage)
     }
 }
 
+AddressA64 IrLoweringA64::tempAddrPacked(IrOp tableOp, IrOp indexOp)
+{
+    RegisterA64 temp = regs.allocTemp(KindA64::x);
+    build.ldr(temp, mem(regOp(tableOp), offsetof(LuaTable, array)));
+
+    if (indexOp.kind == IrOpKind::Inst)
+    {
+        CODEGEN_ASSERT(!producesDirtyHighRegisterBits(function.instOp(indexOp).cmd));
+
+        build.add(temp, temp, regOp(indexOp), 3); // implicit uxtw, packed elements are doubles
+        return mem(temp, offsetof(LuaPackedArray, values));
+    }
+    else if (indexOp.kind == IrOpKind::Constant)
+    {
+        // indexOp can only be negative in dead code (since the size is checked); this avoids assertion in emitAddOffset
+        if (intOp(indexOp) < 0)
+            return mem(temp, offsetof(LuaPackedArray, values));
+
+        size_t offset = offsetof(LuaPackedArray, values) + size_t(intOp(indexOp)) * sizeof(double);
+
+        if (offset <= AddressA64::kMaxOffset)
+            return mem(temp, int(offset));
+
+        RegisterA64 temp2 = regs.allocTemp(KindA64::x);
+        emitAddOffset(build, temp2, temp, offset);
+        return mem(temp2, 0);
+    }
+    else
+    {
+        CODEGEN_ASSERT(!"Unsupported instruction form");
+        return noreg;
+    }
+}
+
 AddressA64 IrLoweringA64::tempAddrBuffer(IrOp bufferOp, IrOp indexOp, uint8_t tag)
 {
     CODEGEN_ASSERT(tag == LUA_TUSERDATA || tag == LUA_TBUFFER);
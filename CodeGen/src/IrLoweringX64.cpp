@@ -177,6 +177,14 @@ void IrLoweringX64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
             CODEGEN_ASSERT(!"Unsupported instruction form");
         }
         break;
+    case IrCmd::LOAD_PACKED:
+    {
+        inst.regX64 = regs.allocReg(SizeX64::xmmword, index);
+
+        ScopedRegX64 tmp{regs, SizeX64::qword};
+        build.vmovsd(inst.regX64, qword[packedAddrOp(inst.a, inst.b, tmp.reg)]);
+        break;
+    }
     case IrCmd::GET_SLOT_NODE_ADDR:
     {
         inst.regX64 = regs.allocReg(SizeX64::qword, index);
@@ -368,6 +376,28 @@ void IrLoweringX64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
         }
         break;
     }
+    case IrCmd::STORE_PACKED:
+    {
+        ScopedRegX64 tmp{regs, SizeX64::qword};
+        OperandX64 valueLhs = qword[packedAddrOp(inst.a, inst.b, tmp.reg)];
+
+        if (inst.c.kind == IrOpKind::Constant)
+        {
+            ScopedRegX64 tmp2{regs, SizeX64::xmmword};
+
+            build.vmovsd(tmp2.reg, build.f64(doubleOp(inst.c)));
+            build.vmovsd(valueLhs, tmp2.reg);
+        }
+        else if (inst.c.kind == IrOpKind::Inst)
+        {
+            build.vmovsd(valueLhs, regOp(inst.c));
+        }
+        else
+        {
+            CODEGEN_ASSERT(!"Unsupported instruction form");
+        }
+        break;
+    }
     case IrCmd::ADD_INT:
     {
         inst.regX64 = regs.allocRegOrReuse(SizeX64::dword, index, {inst.a});
@@ -1960,6 +1990,28 @@ void IrLoweringX64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
 
         jumpOrAbortOnUndef(ConditionX64::BelowEqual, inst.c, next);
         break;
+    case IrCmd::CHECK_PACKED_SIZE:
+    {
+        ScopedRegX64 tmp{regs, SizeX64::qword};
+
+        // A packed table has no array part, and its 'array' points to the packed array
+        build.cmp(dword[regOp(inst.a) + offsetof(LuaTable, sizearray)], 0);
+        jumpOrAbortOnUndef(ConditionX64::NotEqual, inst.c, next);
+
+        build.mov(tmp.reg, qword[regOp(inst.a) + offsetof(LuaTable, array)]);
+        build.test(tmp.reg, tmp.reg);
+        jumpOrAbortOnUndef(ConditionX64::Zero, inst.c, next);
+
+        if (inst.b.kind == IrOpKind::Inst)
+            build.cmp(dword[tmp.reg + offsetof(LuaPackedArray, size)], regOp(inst.b));
+        else if (inst.b.kind == IrOpKind::Constant)
+            build.cmp(dword[tmp.reg + offsetof(LuaPackedArray, size)], intOp(inst.b));
+        else
+            CODEGEN_ASSERT(!"Unsupported instruction form");
+
+        jumpOrAbortOnUndef(ConditionX64::BelowEqual, inst.c, next);
+        break;
+    }
     case IrCmd::JUMP_SLOT_MATCH:
     case IrCmd::CHECK_SLOT_MATCH:
     {
@@ -2211,6 +2263,11 @@ void IrLoweringX64::lowerInst(IrInst& inst, uint32_t index, const IrBlock& next)
         build.mov(tmp.reg, qword[rState + offsetof(lua_State, global)]);
         build.cmp(qword[tmp.reg + offsetof(global_State, cb.interrupt)], 0);
         build.jcc(ConditionX64::NotEqual, self);
+#ifdef LUAU_MULTITHREAD
+        // Another thread waits for this one to reach a safepoint so it can run a GC step
+        build.cmp(dword[tmp.reg + offsetof(global_State, threads.gcrequest)], 0);
+        build.jcc(ConditionX64::NotEqual, self);
+#endif
 
         Label next = build.setLabel();
 
@@ -3164,6 +3221,25 @@ RegisterX64 IrLoweringX64::regOp(IrOp op)
     return inst.regX64;
 }
 
+OperandX64 IrLoweringX64::packedAddrOp(IrOp tableOp, IrOp indexOp, RegisterX64 tmp)
+{
+    build.mov(tmp, qword[regOp(tableOp) + offsetof(LuaTable, array)]);
+
+    if (indexOp.kind == IrOpKind::Inst)
+    {
+        CODEGEN_ASSERT(!producesDirtyHighRegisterBits(function.instOp(indexOp).cmd)); // Ensure that high register bits are cleared
+
+        return tmp + qwordReg(regOp(indexOp)) * sizeof(double) + offsetof(LuaPackedArray, values);
+    }
+    else if (indexOp.kind == IrOpKind::Constant)
+    {
+        return tmp + intOp(indexOp) * int(sizeof(double)) + offsetof(LuaPackedArray, values);
+    }
+
+    CODEGEN_ASSERT(!"Unsupported instruction form");
+    return noreg;
+}
+
 OperandX64 IrLoweringX64::bufferAddrOp(IrOp bufferOp, IrOp indexOp, uint8_t tag)
 {
     CODEGEN_ASSERT(tag == LUA_TUSERDATA || tag == LUA_TBUFFER);
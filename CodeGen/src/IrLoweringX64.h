@@ -55,6 +55,7 @@ struct IrLoweringX64
     OperandX64 memRegTagOp(IrOp op);
     RegisterX64 regOp(IrOp op);
     OperandX64 bufferAddrOp(IrOp bufferOp, IrOp indexOp, uint8_t tag);
+    OperandX64 packedAddrOp(IrOp tableOp, IrOp indexOp, RegisterX64 tmp); // Loads the packed array into 'tmp'
     RegisterX64 vecOp(IrOp op, ScopedRegX64& tmp);
 
     IrConst constOp(IrOp op) const;
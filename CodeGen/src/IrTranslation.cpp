@@ -1265,6 +1265,7 @@ void translateInstForGLoopIpairs(IrBuilder& build, const Instruction* pc, int pc
     IrOp loopRepeat = build.blockAtInst(getJumpTarget(*pc, pcpos));
     IrOp loopExit = build.blockAtInst(pcpos + getOpLength(LuauOpcode(LUAU_INSN_OP(*pc))));
     IrOp fallback = build.block(IrBlockKind::Fallback);
+    IrOp packed = build.block(IrBlockKind::Fallback);
 
     IrOp hasElem = build.block(IrBlockKind::Internal);
 
@@ -1279,8 +1280,8 @@ void translateInstForGLoopIpairs(IrBuilder& build, const Instruction* pc, int pc
 
     IrOp elemPtr = build.inst(IrCmd::GET_ARR_ADDR, table, index);
 
-    // Terminate if array has ended
-    build.inst(IrCmd::CHECK_ARRAY_SIZE, table, index, loopExit);
+    // Terminate if array has ended; the array part of a packed table is empty, and its packed array is iterated separately
+    build.inst(IrCmd::CHECK_ARRAY_SIZE, table, index, packed);
 
     // Terminate if element is nil
     IrOp elemTag = build.inst(IrCmd::LOAD_TAG, elemPtr);
@@ -1304,6 +1305,25 @@ void translateInstForGLoopIpairs(IrBuilder& build, const Instruction* pc, int pc
 
     build.inst(IrCmd::JUMP, loopRepeat);
 
+    // Packed arrays of numbers have no holes, and traversal ends with them like it does with the array part
+    build.beginBlock(packed);
+
+    IrOp packedTable = build.inst(IrCmd::LOAD_POINTER, build.vmReg(ra + 1));
+    IrOp packedIndex = build.inst(IrCmd::LOAD_INT, build.vmReg(ra + 2));
+
+    build.inst(IrCmd::CHECK_PACKED_SIZE, packedTable, packedIndex, loopExit);
+
+    IrOp packedNextIndex = build.inst(IrCmd::ADD_INT, packedIndex, build.constInt(1));
+    build.inst(IrCmd::STORE_INT, build.vmReg(ra + 2), packedNextIndex);
+
+    build.inst(IrCmd::STORE_DOUBLE, build.vmReg(ra + 3), build.inst(IrCmd::INT_TO_NUM, packedNextIndex));
+    build.inst(IrCmd::STORE_TAG, build.vmReg(ra + 3), build.constTag(LUA_TNUMBER));
+
+    build.inst(IrCmd::STORE_DOUBLE, build.vmReg(ra + 4), build.inst(IrCmd::LOAD_PACKED, packedTable, packedIndex));
+    build.inst(IrCmd::STORE_TAG, build.vmReg(ra + 4), build.constTag(LUA_TNUMBER));
+
+    build.inst(IrCmd::JUMP, loopRepeat);
+
     build.beginBlock(fallback);
     build.inst(IrCmd::SET_SAVEDPC, build.constUint(pcpos + 1));
     build.inst(IrCmd::FORGLOOP_FALLBACK, build.vmReg(ra), build.constInt(int(pc[1])), loopRepeat, loopExit);
@@ -1329,13 +1349,14 @@ void translateInstGetTableN(IrBuilder& build, const Instruction* pc, int pcpos)
     }
 
     IrOp fallback = build.block(IrBlockKind::Fallback);
+    IrOp packed = build.block(IrBlockKind::Fallback);
 
     IrOp tb = build.inst(IrCmd::LOAD_TAG, build.vmReg(rb));
     build.inst(IrCmd::CHECK_TAG, tb, build.constTag(LUA_TTABLE), bcTypes.a == LBC_TYPE_TABLE ? build.vmExit(pcpos) : fallback);
 
     IrOp vb = build.inst(IrCmd::LOAD_POINTER, build.vmReg(rb));
 
-    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, build.constInt(c), fallback);
+    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, build.constInt(c), packed);
     build.inst(IrCmd::CHECK_NO_METATABLE, vb, fallback);
 
     IrOp arrEl = build.inst(IrCmd::GET_ARR_ADDR, vb, build.constInt(0));
@@ -1344,8 +1365,17 @@ void translateInstGetTableN(IrBuilder& build, const Instruction* pc, int pcpos)
     build.inst(IrCmd::STORE_TVALUE, build.vmReg(ra), arrElTval);
 
     IrOp next = build.blockAtInst(pcpos + 1);
-    FallbackStreamScope scope(build, fallback, next);
+    FallbackStreamScope scope(build, packed, next);
 
+    // Packed arrays of numbers have no slots (see ltable.cpp), and their elements are never nil, so __index doesn't matter
+    IrOp packedTable = build.inst(IrCmd::LOAD_POINTER, build.vmReg(rb));
+    build.inst(IrCmd::CHECK_PACKED_SIZE, packedTable, build.constInt(c), fallback);
+
+    build.inst(IrCmd::STORE_DOUBLE, build.vmReg(ra), build.inst(IrCmd::LOAD_PACKED, packedTable, build.constInt(c)));
+    build.inst(IrCmd::STORE_TAG, build.vmReg(ra), build.constTag(LUA_TNUMBER));
+    build.inst(IrCmd::JUMP, next);
+
+    build.beginBlock(fallback);
     build.inst(IrCmd::SET_SAVEDPC, build.constUint(pcpos + 1));
     build.inst(IrCmd::GET_TABLE, build.vmReg(ra), build.vmReg(rb), build.constUint(c + 1));
     build.inst(IrCmd::JUMP, next);
@@ -1367,13 +1397,14 @@ void translateInstSetTableN(IrBuilder& build, const Instruction* pc, int pcpos)
     }
 
     IrOp fallback = build.block(IrBlockKind::Fallback);
+    IrOp packed = build.block(IrBlockKind::Fallback);
 
     IrOp tb = build.inst(IrCmd::LOAD_TAG, build.vmReg(rb));
     build.inst(IrCmd::CHECK_TAG, tb, build.constTag(LUA_TTABLE), bcTypes.a == LBC_TYPE_TABLE ? build.vmExit(pcpos) : fallback);
 
     IrOp vb = build.inst(IrCmd::LOAD_POINTER, build.vmReg(rb));
 
-    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, build.constInt(c), fallback);
+    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, build.constInt(c), packed);
     build.inst(IrCmd::CHECK_NO_METATABLE, vb, fallback);
     build.inst(IrCmd::CHECK_READONLY, vb, fallback);
 
@@ -1385,8 +1416,20 @@ void translateInstSetTableN(IrBuilder& build, const Instruction* pc, int pcpos)
     build.inst(IrCmd::BARRIER_TABLE_FORWARD, vb, build.vmReg(ra), build.undef());
 
     IrOp next = build.blockAtInst(pcpos + 1);
-    FallbackStreamScope scope(build, fallback, next);
+    FallbackStreamScope scope(build, packed, next);
+
+    // Packed elements are never nil, so __newindex doesn't matter, and other values unpack the table in the fallback
+    IrOp packedTable = build.inst(IrCmd::LOAD_POINTER, build.vmReg(rb));
+    build.inst(IrCmd::CHECK_PACKED_SIZE, packedTable, build.constInt(c), fallback);
+    build.inst(IrCmd::CHECK_READONLY, packedTable, fallback);
+
+    IrOp ta = build.inst(IrCmd::LOAD_TAG, build.vmReg(ra));
+    build.inst(IrCmd::CHECK_TAG, ta, build.constTag(LUA_TNUMBER), fallback);
 
+    build.inst(IrCmd::STORE_PACKED, packedTable, build.constInt(c), build.inst(IrCmd::LOAD_DOUBLE, build.vmReg(ra)));
+    build.inst(IrCmd::JUMP, next);
+
+    build.beginBlock(fallback);
     build.inst(IrCmd::SET_SAVEDPC, build.constUint(pcpos + 1));
     build.inst(IrCmd::SET_TABLE, build.vmReg(ra), build.vmReg(rb), build.constUint(c + 1));
     build.inst(IrCmd::JUMP, next);
@@ -1408,6 +1451,7 @@ void translateInstGetTable(IrBuilder& build, const Instruction* pc, int pcpos)
     }
 
     IrOp fallback = build.block(IrBlockKind::Fallback);
+    IrOp packed = build.block(IrBlockKind::Fallback);
 
     IrOp tb = build.inst(IrCmd::LOAD_TAG, build.vmReg(rb));
     build.inst(IrCmd::CHECK_TAG, tb, build.constTag(LUA_TTABLE), bcTypes.a == LBC_TYPE_TABLE ? build.vmExit(pcpos) : fallback);
@@ -1422,7 +1466,7 @@ void translateInstGetTable(IrBuilder& build, const Instruction* pc, int pcpos)
 
     index = build.inst(IrCmd::SUB_INT, index, build.constInt(1));
 
-    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, index, fallback);
+    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, index, packed);
     build.inst(IrCmd::CHECK_NO_METATABLE, vb, fallback);
 
     IrOp arrEl = build.inst(IrCmd::GET_ARR_ADDR, vb, index);
@@ -1431,8 +1475,20 @@ void translateInstGetTable(IrBuilder& build, const Instruction* pc, int pcpos)
     build.inst(IrCmd::STORE_TVALUE, build.vmReg(ra), arrElTval);
 
     IrOp next = build.blockAtInst(pcpos + 1);
-    FallbackStreamScope scope(build, fallback, next);
+    FallbackStreamScope scope(build, packed, next);
+
+    // Packed arrays of numbers have no slots (see ltable.cpp), and their elements are never nil, so __index doesn't matter
+    IrOp packedTable = build.inst(IrCmd::LOAD_POINTER, build.vmReg(rb));
+    IrOp packedIndex = build.inst(IrCmd::TRY_NUM_TO_INDEX, build.inst(IrCmd::LOAD_DOUBLE, build.vmReg(rc)), fallback);
+    packedIndex = build.inst(IrCmd::SUB_INT, packedIndex, build.constInt(1));
 
+    build.inst(IrCmd::CHECK_PACKED_SIZE, packedTable, packedIndex, fallback);
+
+    build.inst(IrCmd::STORE_DOUBLE, build.vmReg(ra), build.inst(IrCmd::LOAD_PACKED, packedTable, packedIndex));
+    build.inst(IrCmd::STORE_TAG, build.vmReg(ra), build.constTag(LUA_TNUMBER));
+    build.inst(IrCmd::JUMP, next);
+
+    build.beginBlock(fallback);
     build.inst(IrCmd::SET_SAVEDPC, build.constUint(pcpos + 1));
     build.inst(IrCmd::GET_TABLE, build.vmReg(ra), build.vmReg(rb), build.vmReg(rc));
     build.inst(IrCmd::JUMP, next);
@@ -1454,6 +1510,7 @@ void translateInstSetTable(IrBuilder& build, const Instruction* pc, int pcpos)
     }
 
     IrOp fallback = build.block(IrBlockKind::Fallback);
+    IrOp packed = build.block(IrBlockKind::Fallback);
 
     IrOp tb = build.inst(IrCmd::LOAD_TAG, build.vmReg(rb));
     build.inst(IrCmd::CHECK_TAG, tb, build.constTag(LUA_TTABLE), bcTypes.a == LBC_TYPE_TABLE ? build.vmExit(pcpos) : fallback);
@@ -1468,7 +1525,7 @@ void translateInstSetTable(IrBuilder& build, const Instruction* pc, int pcpos)
 
     index = build.inst(IrCmd::SUB_INT, index, build.constInt(1));
 
-    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, index, fallback);
+    build.inst(IrCmd::CHECK_ARRAY_SIZE, vb, index, packed);
     build.inst(IrCmd::CHECK_NO_METATABLE, vb, fallback);
     build.inst(IrCmd::CHECK_READONLY, vb, fallback);
 
@@ -1480,8 +1537,23 @@ void translateInstSetTable(IrBuilder& build, const Instruction* pc, int pcpos)
     build.inst(IrCmd::BARRIER_TABLE_FORWARD, vb, build.vmReg(ra), build.undef());
 
     IrOp next = build.blockAtInst(pcpos + 1);
-    FallbackStreamScope scope(build, fallback, next);
+    FallbackStreamScope scope(build, packed, next);
+
+    // Packed elements are never nil, so __newindex doesn't matter, and other values unpack the table in the fallback
+    IrOp packedTable = build.inst(IrCmd::LOAD_POINTER, build.vmReg(rb));
+    IrOp packedIndex = build.inst(IrCmd::TRY_NUM_TO_INDEX, build.inst(IrCmd::LOAD_DOUBLE, build.vmReg(rc)), fallback);
+    packedIndex = build.inst(IrCmd::SUB_INT, packedIndex, build.constInt(1));
+
+    build.inst(IrCmd::CHECK_PACKED_SIZE, packedTable, packedIndex, fallback);
+    build.inst(IrCmd::CHECK_READONLY, packedTable, fallback);
 
+    IrOp ta = build.inst(IrCmd::LOAD_TAG, build.vmReg(ra));
+    build.inst(IrCmd::CHECK_TAG, ta, build.constTag(LUA_TNUMBER), fallback);
+
+    build.inst(IrCmd::STORE_PACKED, packedTable, packedIndex, build.inst(IrCmd::LOAD_DOUBLE, build.vmReg(ra)));
+    build.inst(IrCmd::JUMP, next);
+
+    build.beginBlock(fallback);
     build.inst(IrCmd::SET_SAVEDPC, build.constUint(pcpos + 1));
     build.inst(IrCmd::SET_TABLE, build.vmReg(ra), build.vmReg(rb), build.vmReg(rc));
     build.inst(IrCmd::JUMP, next);
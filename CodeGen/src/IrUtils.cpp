@@ -163,6 +163,8 @@ IrValueKind getCmdValueKind(IrCmd cmd)
     case IrCmd::GET_HASH_NODE_ADDR:
     case IrCmd::GET_CLOSURE_UPVAL_ADDR:
         return IrValueKind::Pointer;
+    case IrCmd::LOAD_PACKED:
+        return IrValueKind::Double;
     case IrCmd::STORE_TAG:
     case IrCmd::STORE_EXTRA:
     case IrCmd::STORE_POINTER:
@@ -171,6 +173,7 @@ IrValueKind getCmdValueKind(IrCmd cmd)
     case IrCmd::STORE_VECTOR:
     case IrCmd::STORE_TVALUE:
     case IrCmd::STORE_SPLIT_TVALUE:
+    case IrCmd::STORE_PACKED:
         return IrValueKind::None;
     case IrCmd::ADD_INT:
     case IrCmd::SUB_INT:
@@ -294,6 +297,7 @@ IrValueKind getCmdValueKind(IrCmd cmd)
     case IrCmd::CHECK_NO_METATABLE:
     case IrCmd::CHECK_SAFE_ENV:
     case IrCmd::CHECK_ARRAY_SIZE:
+    case IrCmd::CHECK_PACKED_SIZE:
     case IrCmd::CHECK_SLOT_MATCH:
     case IrCmd::CHECK_NODE_NO_NEXT:
     case IrCmd::CHECK_NODE_VALUE:
@@ -60,6 +60,9 @@ void initFunctions(NativeContext& context)
     context.luaC_barrierf = luaC_barrierf;
     context.luaC_barrierback = luaC_barrierback;
     context.luaC_step = luaC_step;
+#ifdef LUAU_MULTITHREAD
+    context.luaE_safepoint = luaE_safepoint;
+#endif
 
     context.luaF_close = luaF_close;
     context.luaF_findupval = luaF_findupval;
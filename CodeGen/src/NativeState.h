@@ -64,6 +64,9 @@ struct NativeContext
     void (*luaC_barrierf)(lua_State* L, GCObject* o, GCObject* v) = nullptr;
     void (*luaC_barrierback)(lua_State* L, GCObject* o, GCObject** gclist) = nullptr;
     size_t (*luaC_step)(lua_State* L, bool assist) = nullptr;
+#ifdef LUAU_MULTITHREAD
+    void (*luaE_safepoint)(lua_State* L) = nullptr;
+#endif
 
     void (*luaF_close)(lua_State* L, StkId level) = nullptr;
     UpVal* (*luaF_findupval)(lua_State* L, StkId level) = nullptr;
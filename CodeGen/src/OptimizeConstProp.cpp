@@ -2265,6 +2265,9 @@ static void constPropInInst(ConstPropState& state, IrBuilder& build, IrFunction&
         break;
     case IrCmd::LOAD_ENV:
         break;
+    case IrCmd::LOAD_PACKED:
+    case IrCmd::STORE_PACKED:
+        break;
     case IrCmd::GET_ARR_ADDR:
         for (uint32_t prevIdx : state.getArrAddrCache)
         {
@@ -2819,6 +2822,8 @@ static void constPropInInst(ConstPropState& state, IrBuilder& build, IrFunction&
             state.checkArraySizeCache.push_back(index);
         break;
     }
+    case IrCmd::CHECK_PACKED_SIZE:
+        break;
     case IrCmd::CHECK_SLOT_MATCH:
         for (uint32_t prevIdx : state.checkSlotMatchCache)
         {
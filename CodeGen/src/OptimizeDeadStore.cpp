@@ -792,6 +792,9 @@ static void markDeadStoresInInst(RemoveDeadStoreState& state, IrBuilder& build,
     case IrCmd::CHECK_ARRAY_SIZE:
         state.checkLiveIns(inst.c);
         break;
+    case IrCmd::CHECK_PACKED_SIZE:
+        state.checkLiveIns(inst.c);
+        break;
     case IrCmd::CHECK_SLOT_MATCH:
         state.checkLiveIns(inst.c);
         break;
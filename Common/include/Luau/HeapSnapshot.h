@@ -0,0 +1,65 @@
+// This file is part of the Luau programming language and is licensed under MIT License; see LICENSE.txt for details
+#pragma once
+
+// clang-format off
+
+// This header contains the definition of the heap snapshot format
+// Snapshots are written by lua_heapsnapshot and read by luau-heapdiff
+
+// # Encoding
+// A snapshot starts with the 4-byte magic "LHSS" followed by a version byte, and is followed by a sequence of records until the end record.
+// Every record starts with a tag byte (enum below). Integers are unsigned LEB128 varints, strings are a varint length followed by the bytes.
+// Object ids are object addresses; they are unique within one snapshot only.
+//
+// Names (object names, edge names and category names) are interned: the first time a name is used it's introduced by a name record, which assigns it the next index starting from 1.
+// Records then refer to names by index, with 0 standing for no name.
+//
+// Each object record is followed by the edges of the object. An edge always starts from the current source, which is the last object or the one set by a source record.
+// The writer visits objects one at a time and only keeps the name table, so snapshots are written in time and size linear in the size of the heap.
+
+// # Snapshot version history
+//
+// Version 1: Baseline version.
+
+// Heap snapshot record tag
+enum LuauHeapSnapshotTag
+{
+    // END: last record of the snapshot
+    // totalbytes: varint, total size of the heap
+    LHS_END,
+
+    // NAME: introduces the next name
+    // name: string
+    LHS_NAME,
+
+    // OBJECT: an object of the heap, which becomes the current source
+    // id: varint
+    // type: byte, LUA_T* type; objects that are not exposed as Luau values use the VM type numbers, such as LUA_TPROTO and LUA_TUPVAL, and native code uses LUA_TNONE (255)
+    // memcat: byte, memory category
+    // size: varint, size in bytes, including the memory owned by the object
+    // name: varint, name index
+    LHS_OBJECT,
+
+    // SOURCE: sets the current source, for edges that don't follow the record of their object
+    // id: varint
+    LHS_SOURCE,
+
+    // EDGE: reference from the current source to another object
+    // id: varint, referenced object
+    // name: varint, name index
+    LHS_EDGE,
+
+    // ROOT: a root of the heap
+    // id: varint
+    // name: varint, name index
+    LHS_ROOT,
+
+    // CATEGORY: a memory category that holds memory
+    // memcat: byte
+    // size: varint, size in bytes
+    // name: varint, name index
+    LHS_CATEGORY,
+};
+
+#define LHS_MAGIC "LHSS"
+#define LHS_VERSION 1
@@ -6,6 +6,7 @@ target_sources(Luau.Common PRIVATE
     Common/include/Luau/DenseHash.h
     Common/include/Luau/ExperimentalFlags.h
     Common/include/Luau/HashUtil.h
+    Common/include/Luau/HeapSnapshot.h
     Common/include/Luau/StringUtils.h
     Common/include/Luau/TimeTrace.h
     Common/include/Luau/Variant.h
@@ -367,6 +368,7 @@ target_sources(Luau.VM PRIVATE
     VM/src/lstrlib.cpp
     VM/src/ltable.cpp
     VM/src/ltablib.cpp
+    VM/src/ltasklib.cpp
     VM/src/ltm.cpp
     VM/src/ludata.cpp
     VM/src/lutf8lib.cpp
@@ -620,3 +622,9 @@ if(TARGET Luau.Bytecode.CLI)
     target_sources(Luau.Bytecode.CLI PRIVATE
         CLI/src/Bytecode.cpp)
 endif()
+
+if(TARGET Luau.HeapDiff.CLI)
+    # Luau.HeapDiff.CLI Sources
+    target_sources(Luau.HeapDiff.CLI PRIVATE
+        CLI/src/HeapDiff.cpp)
+endif()
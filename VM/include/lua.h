@@ -115,6 +115,26 @@ LUA_API void lua_resetthread(lua_State* L);
 LUA_API int lua_isthreadreset(lua_State* L);
 LUA_API void lua_enableThreads(lua_State* L,int threadsDiff, int suspendedDiff);
 
+// register the calling OS thread as running Lua code on the VM of L; a VM with no attached threads takes no locks
+LUA_API void lua_threadattach(lua_State* L);
+LUA_API void lua_threaddetach(lua_State* L);
+// an attached thread must be suspended while it blocks outside of Lua code (1), and resumed before running Lua again (0)
+LUA_API void lua_threadsuspend(lua_State* L, int suspend);
+
+// contention counters of the locks guarding global state, string table and shared tables; shared by all states in the process
+struct lua_LockStats
+{
+    uint64_t exclusivecontended; // exclusive acquisitions that had to wait
+    uint64_t sharedcontended;    // shared (read) acquisitions that had to wait
+    uint64_t spins;              // backoff rounds spent spinning while waiting
+    uint64_t parks;              // times a waiting thread was parked
+    uint64_t globalacquired;     // acquisitions of the global lock of this VM, contended or not
+};
+typedef struct lua_LockStats lua_LockStats;
+
+LUA_API void lua_getlockstats(lua_State* L, lua_LockStats* stats);
+LUA_API void lua_resetlockstats(lua_State* L);
+
 /*
 ** basic stack manipulation
 */
@@ -302,6 +322,68 @@ enum lua_GCOp
 
     /* Returns 1 if a GC step is needed */
     LUA_GCNEEDED,
+
+    /*
+    ** switch the collector to generational or incremental mode, returning the previous mode (LUA_GCGEN or LUA_GCINC)
+    **
+    ** in generational mode, objects that survive a collection become old and are not traced again by minor collections, which only
+    ** mark objects allocated since the previous collection and old objects modified since then. a minor collection starts after the
+    ** application allocates the minor multiplier percentage of the heap size (20% by default), and once the heap grows by the major
+    ** multiplier percentage over its size after the last major collection (100% by default), a major collection traces the whole heap.
+    ** the goal setting is not used in generational mode; the switch takes effect at the next collection cycle.
+    */
+    LUA_GCGEN,
+    LUA_GCINC,
+    LUA_GCSETGENMINORMUL,
+    LUA_GCSETGENMAJORMUL,
+
+    /*
+    ** sweep on a helper thread when data is not 0, returning the previous setting
+    **
+    ** when enabled, the sweep stage of incremental collections frees dead objects on a helper thread while the application keeps
+    ** running; GC steps only link swept pages back into the heap. this requires LUAU_MULTITHREAD and otherwise has no effect, and a
+    ** sweep only moves to the helper thread while no other thread is attached (see lua_threadattach) and the collector is not in
+    ** generational mode. userdata with destructors, threads and functions with native code are still freed by GC steps.
+    */
+    LUA_GCSWEEPTHREAD,
+
+    /*
+    ** perform explicit GC steps for at most the specified number of microseconds, returning 1 if the cycle finished
+    **
+    ** steps are sized like regular GC steps and the time measured for them decides whether another step fits in the remaining budget;
+    ** the atomic stage can't be split, so a call that reaches it may go over budget. the work done is credited to the pacer like for
+    ** LUA_GCSTEP, so it is meant to be called during idle time, e.g. at the end of a frame.
+    */
+    LUA_GCSTEPTIME,
+
+    /*
+    ** perform a full collection, then move strings and tables out of sparsely populated pages, returning the amount of memory released in Kbytes
+    **
+    ** pages that are at most data percent full (LUAI_GCCOMPACTOCCUPANCY by default, when data is 0) are evacuated if all objects in them
+    ** can be moved; the pages are returned to the allocator once references to the objects are updated. strings and tables that C code
+    ** may refer to by address are never moved: values in the stack frames and upvalues of C functions that are running or suspended in
+    ** any thread, tables used as keys, shared tables and fixed objects. pointers obtained with lua_tostring or lua_topointer for other
+    ** values are invalidated by this call.
+    */
+    LUA_GCCOMPACT,
+
+    /*
+    ** blocks that are too large for regular pages but not larger than 256 KB get a page of their own, and freed pages are pooled for reuse
+    ** set the maximum size of the pool in KB, returning the previous limit; pages over the new limit are released right away
+    */
+    LUA_GCSETLARGEPOOL,
+
+    // return the size of the pool in KB, and the number of large block allocations that reused a pooled page or needed a new one
+    LUA_GCLARGEPOOLCOUNT,
+    LUA_GCLARGEPOOLHITS,
+    LUA_GCLARGEPOOLMISSES,
+
+    /*
+    ** keep allocation counters for each memory category and object type when data is not 0, returning the previous setting
+    **
+    ** counters are read with lua_gettypestats; enabling them walks the heap once to count the objects that are already allocated
+    */
+    LUA_GCTYPESTATS,
 };
 
 LUA_API int lua_gc(lua_State* L, int what, int data);
@@ -315,6 +397,53 @@ LUA_API void lua_postgc(lua_State* L, int (*dtor)(lua_State *L,void*),void *data
 LUA_API void lua_setmemcat(lua_State* L, int category);
 LUA_API size_t lua_totalbytes(lua_State* L, int category);
 
+/*
+** allocation counters of a memory category for one type of objects (LUA_TSTRING..LUA_TBUFFER, LUA_TPROTO, LUA_TUPVAL), or with LUA_TNIL,
+** for memory that doesn't hold objects, such as array and hash parts of tables, thread stacks and function bytecode
+**
+** lua_gettypestats returns 0 and leaves stats untouched unless counters are enabled with LUA_GCTYPESTATS. allocation rates can be
+** derived from the bytes allocated during the last cycle and its duration
+*/
+typedef struct lua_GCTypeStats
+{
+    size_t count; // live objects; always 0 for LUA_TNIL
+    size_t bytes; // live bytes
+
+    uint64_t allocated; // bytes allocated since the counters were enabled, including the objects that were live at that point
+    uint64_t freed;     // bytes freed since the counters were enabled
+
+    size_t cycleallocated; // bytes allocated during the last collection cycle
+    size_t cyclefreed;     // bytes freed during the last collection cycle
+    double cycletime;      // duration of the last collection cycle in seconds, measured from the end of the previous one
+} lua_GCTypeStats;
+
+LUA_API int lua_gettypestats(lua_State* L, int category, int type, lua_GCTypeStats* stats);
+
+/*
+** allocation regions: tables created by the thread between lua_pushregion and lua_popregion are allocated in the LUA_REGIONMEMCAT
+** memory category, out of memory that is released all at once when the region is popped
+**
+** a table escapes the region when it's stored into an object that was not allocated in the region, captured by a closure or an upvalue,
+** passed to another thread or left on the stack of the thread when the region is popped. if nothing escaped, lua_popregion releases the
+** region memory without a collection and returns 1; otherwise region tables are moved to the memory category that was active at
+** lua_pushregion and left to the collector, and 0 is returned
+**
+** regions nest, inner regions are joined with the outermost one and popping them returns 0. lua_pushregion returns 0 and no region is
+** started when another thread holds a region, when other threads run Lua code or when native code generation is enabled; lua_popregion
+** must only be called when it returned 1. references to region tables must not be kept outside of the VM past lua_popregion.
+*/
+LUA_API int lua_pushregion(lua_State* L);
+LUA_API int lua_popregion(lua_State* L);
+
+/*
+** table shapes: when enabled, small tables with string keys share an immutable description of their keys (a shape) between all tables
+** that were built by inserting the same keys in the same order, and only store their values. tables switch back to a regular hash part
+** when a key that isn't a string is inserted or when the number of keys or shapes exceeds the limits in luaconf.h
+**
+** lua_settableshapes only affects tables created afterwards and returns the previous setting; shapes are disabled by default
+*/
+LUA_API int lua_settableshapes(lua_State* L, int enable);
+
 /*
 ** miscellaneous functions
 */
@@ -337,6 +466,13 @@ typedef void (*lua_Destructor)(lua_State* L, void* userdata);
 LUA_API void lua_setuserdatadtor(lua_State* L, int tag, lua_Destructor dtor);
 LUA_API lua_Destructor lua_getuserdatadtor(lua_State* L, int tag);
 
+// batch destructors receive the data of dead userdata in arrays; GC steps collect the dead userdata of each page and call the destructor once for each tag
+// when a tag has a batch destructor, it's called instead of the destructor set with lua_setuserdatadtor
+typedef void (*lua_BatchDestructor)(lua_State* L, void** userdata, int count);
+
+LUA_API void lua_setuserdatabatchdtor(lua_State* L, int tag, lua_BatchDestructor dtor);
+LUA_API lua_BatchDestructor lua_getuserdatabatchdtor(lua_State* L, int tag);
+
 // alternative access for metatables already registered with luaL_newmetatable
 // used by lua_newuserdatataggedwithmetatable to create tagged userdata with the associated metatable assigned
 LUA_API void lua_setuserdatametatable(lua_State* L, int tag);
@@ -516,6 +652,24 @@ LUA_API int lua_pushint64(lua_State *L, long long z);
 LUA_API long long luaL_checkint64(lua_State *L, int n);
 LUA_API int lua_isclosing(lua_State *L);
 LUA_API int lua_findreferences(lua_State* L);
+
+// Incremental heap queries: a query walks the heap a step at a time, each step visiting pages until stepsize KB were visited (all of them if stepsize <= 0).
+// lua_newrefsearch pops an object and searches for its referrers; lua_refsearchresult pushes them once the query is done, in the same table as lua_findreferences.
+// lua_newrefindex records the referrers of every object; lua_refindexlookup pops an object and pushes the table of its referrers, or nil if the object wasn't indexed.
+// Objects allocated while a query walks the heap might not be visited. The background sweeper and heap compaction are suspended until every query is freed.
+typedef struct lua_HeapQuery lua_HeapQuery;
+LUA_API lua_HeapQuery* lua_newrefsearch(lua_State* L);
+LUA_API lua_HeapQuery* lua_newrefindex(lua_State* L);
+LUA_API int lua_heapquerystep(lua_State* L, lua_HeapQuery* q, int stepsize);
+LUA_API void lua_refsearchresult(lua_State* L, lua_HeapQuery* q);
+LUA_API int lua_refindexlookup(lua_State* L, lua_HeapQuery* q);
+LUA_API void lua_freeheapquery(lua_State* L, lua_HeapQuery* q);
+
+// Writes a binary snapshot of the heap (objects, references, roots and memory categories, see Luau/HeapSnapshot.h) through write, in chunks, while the world is stopped.
+// categoryname is optional and names the memory categories in the snapshot.
+LUA_API void lua_heapsnapshot(
+    lua_State* L, void* context, void (*write)(void* context, const void* data, size_t size), const char* (*categoryname)(lua_State* L, uint8_t memcat)
+);
 LUA_API void lua_clonetable(lua_State* L, int idx);
 LUA_API void lua_remaptable(lua_State* L, int idx, int mapIdx);
 LUA_API int lua_gettablesize(lua_State* L, int idx);
@@ -134,16 +134,57 @@
 #define LUA_SIZECLASSES 40
 #endif
 
+// number of size classes for blocks above the paged allocation limit that are kept in the large page pool; must be a multiple of 4
+// each class covers a quarter of a power of two interval, so 32 classes pool blocks of up to 256 KB
+#ifndef LUA_LARGESIZECLASSES
+#define LUA_LARGESIZECLASSES 32
+#endif
+
 // available number of separate memory categories
 #ifndef LUA_MEMORY_CATEGORIES
 #define LUA_MEMORY_CATEGORIES 256
 #endif
 
+// memory category reserved for tables allocated in a region (see lua_pushregion)
+#ifndef LUA_REGIONMEMCAT
+#define LUA_REGIONMEMCAT (LUA_MEMORY_CATEGORIES - 1)
+#endif
+
 // extra storage for execution callbacks in global state
 #ifndef LUA_EXECUTION_CALLBACK_STORAGE
 #define LUA_EXECUTION_CALLBACK_STORAGE 512
 #endif
 
+// maximum number of keys of a table shape (see lua_settableshapes); slot hints of shaped tables must fit in 8 bits
+#ifndef LUA_MAXSHAPEKEYS
+#define LUA_MAXSHAPEKEYS 32
+#endif
+
+// maximum number of table shapes; shapes are kept until the state is closed, tables that need a new shape past this point get a hash part
+#ifndef LUA_MAXSHAPES
+#define LUA_MAXSHAPES 16384
+#endif
+
+// log2 of the size from which the hash part of a table uses open addressing instead of chaining (see ltable.cpp)
+#ifndef LUA_PROBEDLSIZE
+#define LUA_PROBEDLSIZE 12
+#endif
+
+// minimum size of an array part that switches to a packed array of numbers when a number is appended to it (see ltable.cpp)
+#ifndef LUA_PACKEDMINSIZE
+#define LUA_PACKEDMINSIZE 32
+#endif
+
+// number of entries in the inline cache of a table access instruction, used when the slot hint of the instruction misses
+#ifndef LUA_INLINECACHESIZE
+#define LUA_INLINECACHESIZE 4
+#endif
+
+// number of __index chain lookups cached by the VM, keyed by metatable and key (must be power of 2)
+#ifndef LUA_INDEXCACHESIZE
+#define LUA_INDEXCACHESIZE 256
+#endif
+
 // minimum size for the string table (must be power of 2)
 #ifndef LUA_MINSTRTABSIZE
 #define LUA_MINSTRTABSIZE 32
@@ -152,9 +152,52 @@ LUALIB_API int luaopen_io (lua_State *L);
 #define LUA_VECLIBNAME "vector"
 LUALIB_API int luaopen_vector(lua_State* L);
 
+#define LUA_TASKLIBNAME "task"
+LUALIB_API int luaopen_task(lua_State* L);
+
 // open all builtin libraries
 LUALIB_API void luaL_openlibs(lua_State* L);
 
 // sandbox libraries and globals
 LUALIB_API void luaL_sandbox(lua_State* L);
 LUALIB_API void luaL_sandboxthread(lua_State* L);
+
+#ifdef __cplusplus
+// attaches the calling OS thread to the VM of L for the lifetime of the object
+struct luaL_ThreadAttach
+{
+    lua_State* L;
+
+    explicit luaL_ThreadAttach(lua_State* L)
+        : L(L)
+    {
+        lua_threadattach(L);
+    }
+    ~luaL_ThreadAttach()
+    {
+        lua_threaddetach(L);
+    }
+
+    luaL_ThreadAttach(const luaL_ThreadAttach&) = delete;
+    luaL_ThreadAttach& operator=(const luaL_ThreadAttach&) = delete;
+};
+
+// suspends an attached thread for the lifetime of the object, around blocking calls that don't run Lua code
+struct luaL_ThreadSuspend
+{
+    lua_State* L;
+
+    explicit luaL_ThreadSuspend(lua_State* L)
+        : L(L)
+    {
+        lua_threadsuspend(L, 1);
+    }
+    ~luaL_ThreadSuspend()
+    {
+        lua_threadsuspend(L, 0);
+    }
+
+    luaL_ThreadSuspend(const luaL_ThreadSuspend&) = delete;
+    luaL_ThreadSuspend& operator=(const luaL_ThreadSuspend&) = delete;
+};
+#endif
@@ -7,6 +7,7 @@
 #include "ltable.h"
 #include "lfunc.h"
 #include "lgc.h"
+#include "lmem.h"
 #include "ldo.h"
 #include "ludata.h"
 #include "lvm.h"
@@ -187,7 +188,10 @@ void lua_xmove(lua_State* from, lua_State* to, int n)
     StkId ttop = to->top;
     StkId ftop = from->top - n;
     for (int i = 0; i < n; i++)
+    {
+        luaC_regionescape(from, ftop + i);
         setobj2s(to, ttop + i, ftop + i);
+    }
 
     from->top = ftop;
     to->top = ttop + n;
@@ -198,6 +202,7 @@ void lua_xpush(lua_State* from, lua_State* to, int idx)
     lua_State* L=from;
     api_check(from, from->global == to->global);
     luaC_threadbarrier(to);
+    luaC_regionescape(from, index2addr(from, idx));
     setobj2s(to, to->top, index2addr(from, idx));
     api_incr_top(to);
 }
@@ -216,10 +221,54 @@ lua_State* lua_newthread(lua_State* L)
 }
 
 void lua_enableThreads(lua_State* L,int threadDiff, int suspendedDiff) {
-    lualock_global();
-    lua_hasThreads+=threadDiff;
-    lua_suspendedThreads+=suspendedDiff;
-    luaunlock_global();
+#ifdef LUAU_MULTITHREAD
+    luaE_enablethreads(L, threadDiff, suspendedDiff);
+#endif
+}
+
+void lua_threadattach(lua_State* L)
+{
+#ifdef LUAU_MULTITHREAD
+    luaE_enablethreads(L, 1, 0);
+#endif
+}
+
+void lua_threaddetach(lua_State* L)
+{
+#ifdef LUAU_MULTITHREAD
+    luaE_enablethreads(L, -1, 0);
+#endif
+}
+
+void lua_threadsuspend(lua_State* L, int suspend)
+{
+#ifdef LUAU_MULTITHREAD
+    luaE_enablethreads(L, 0, suspend ? 1 : -1);
+#endif
+}
+
+void lua_getlockstats(lua_State* L, lua_LockStats* stats)
+{
+#ifdef LUAU_MULTITHREAD
+    stats->exclusivecontended = lua_lockCounters.exclusivecontended.load(std::memory_order_relaxed);
+    stats->sharedcontended = lua_lockCounters.sharedcontended.load(std::memory_order_relaxed);
+    stats->spins = lua_lockCounters.spins.load(std::memory_order_relaxed);
+    stats->parks = lua_lockCounters.parks.load(std::memory_order_relaxed);
+    stats->globalacquired = L->global->threads.acquired;
+#else
+    memset(stats, 0, sizeof(lua_LockStats));
+#endif
+}
+
+void lua_resetlockstats(lua_State* L)
+{
+#ifdef LUAU_MULTITHREAD
+    lua_lockCounters.exclusivecontended.store(0, std::memory_order_relaxed);
+    lua_lockCounters.sharedcontended.store(0, std::memory_order_relaxed);
+    lua_lockCounters.spins.store(0, std::memory_order_relaxed);
+    lua_lockCounters.parks.store(0, std::memory_order_relaxed);
+    L->global->threads.acquired = 0;
+#endif
 }
 
 lua_State* lua_mainthread(lua_State* L)
@@ -294,6 +343,7 @@ void lua_replace(lua_State* L, int idx)
     else if (idx == LUA_GLOBALSINDEX)
     {
         api_check(L, ttistable(L->top - 1));
+        luaC_regionescape(L, L->top - 1);
         L->gt = hvalue(L->top - 1);
     }
     else
@@ -792,7 +842,10 @@ void lua_pushcclosurek(lua_State* L, lua_CFunction fn, const char* debugname, in
     cl->c.debugname = debugname;
     L->top -= nup;
     while (nup--)
+    {
+        luaC_regionescape(L, L->top + nup);
         setobj2n(L, &cl->c.upvals[nup], L->top + nup);
+    }
     setclvalue(L, L->top, cl);
     LUAU_ASSERT(iswhite(obj2gco(cl)));
     api_incr_top(L);
@@ -852,9 +905,9 @@ int lua_rawgetfield(lua_State* L, int idx, const char* k)
     TValue key;
     setsvalue(L, &key, luaS_new(L, k));
     LuaTable *tt=hvalue(t);
-	lualock_table(tt);
+	lualock_tableread(tt);
     setobj2s(L, L->top, luaH_getstr(tt, tsvalue(&key)));
-	luaunlock_table(tt);
+	luaunlock_tableread(tt);
     api_incr_top(L);
     return ttype(L->top - 1);
 }
@@ -865,9 +918,10 @@ int lua_rawget(lua_State* L, int idx)
     StkId t = index2addr(L, idx);
     api_check(L, ttistable(t));
     LuaTable *tt=hvalue(t);
-	lualock_table(tt);
-    setobj2s(L, L->top - 1, luaH_get(tt, L->top - 1));
-	luaunlock_table(tt);
+    TValue copy;
+	lualock_tableread(tt);
+    setobj2s(L, L->top - 1, luaH_getcopy(tt, L->top - 1, &copy));
+	luaunlock_tableread(tt);
     return ttype(L->top - 1);
 }
 
@@ -877,9 +931,10 @@ int lua_rawgeti(lua_State* L, int idx, int n)
     StkId t = index2addr(L, idx);
     api_check(L, ttistable(t));
     LuaTable *tt=hvalue(t);
-	lualock_table(tt);
-    setobj2s(L, L->top, luaH_getnum(tt, n));
-	luaunlock_table(tt);
+    TValue copy;
+	lualock_tableread(tt);
+    setobj2s(L, L->top, luaH_getnumcopy(tt, n, &copy));
+	luaunlock_tableread(tt);
     api_incr_top(L);
     return ttype(L->top - 1);
 }
@@ -910,7 +965,7 @@ void lua_setreadonly(lua_State* L, int objindex, int enabled)
     api_check(L, ttistable(o));
     LuaTable* t = hvalue(o);
     api_check(L, t != hvalue(registry(L)));
-    t->readonly = bool(enabled);
+    t->readonly = (t->readonly & ~READONLYFLAG) | (enabled ? READONLYFLAG : 0);
 }
 
 int lua_getreadonly(lua_State* L, int objindex)
@@ -918,7 +973,7 @@ int lua_getreadonly(lua_State* L, int objindex)
     const TValue* o = index2addr(L, objindex);
     api_check(L, ttistable(o));
     LuaTable* t = hvalue(o);
-    int res = t->readonly;
+    int res = isreadonly(t);
     return res;
 }
 
@@ -1004,8 +1059,7 @@ void lua_rawsetfield(lua_State* L, int idx, const char* k)
     api_checknelems(L, 1);
     StkId t = index2addr(L, idx);
     api_check(L, ttistable(t));
-    if (hvalue(t)->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, hvalue(t));
     setobj2t(L, luaH_setstr(L, hvalue(t), luaS_new(L, k)), L->top - 1);
     luaC_barriert(L, hvalue(t), L->top - 1);
     L->top--;
@@ -1016,11 +1070,11 @@ void lua_rawset(lua_State* L, int idx)
     api_checknelems(L, 2);
     StkId t = index2addr(L, idx);
     api_check(L, ttistable(t));
-    if (hvalue(t)->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, hvalue(t));
     LuaTable *tt=hvalue(t);
 	lualock_table(tt);
-    setobj2t(L, luaH_set(L, tt, L->top - 2), L->top - 1);
+    if (!luaH_ispackedstore(tt, L->top - 2, L->top - 1) || !luaH_setpacked(L, tt, L->top - 2, L->top - 1))
+        setobj2t(L, luaH_set(L, tt, L->top - 2), L->top - 1);
 	luaunlock_table(tt);
     luaC_barriert(L, tt, L->top - 1);
     L->top -= 2;
@@ -1031,11 +1085,13 @@ void lua_rawseti(lua_State* L, int idx, int n)
     api_checknelems(L, 1);
     StkId o = index2addr(L, idx);
     api_check(L, ttistable(o));
-    if (hvalue(o)->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, hvalue(o));
     LuaTable *tt=hvalue(o);
 	lualock_table(tt);
-    setobj2t(L, luaH_setnum(L, tt, n), L->top - 1);
+    TValue key;
+    setnvalue(&key, cast_num(n));
+    if (!luaH_ispackedstore(tt, &key, L->top - 1) || !luaH_setpacked(L, tt, &key, L->top - 1))
+        setobj2t(L, luaH_setnum(L, tt, n), L->top - 1);
 	luaunlock_table(tt);
     luaC_barriert(L, tt, L->top - 1);
     L->top--;
@@ -1046,8 +1102,7 @@ void lua_rawsetptagged(lua_State* L, int idx, void* p, int tag)
     api_checknelems(L, 1);
     StkId o = index2addr(L, idx);
     api_check(L, ttistable(o));
-    if (hvalue(o)->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, hvalue(o));
     setobj2t(L, luaH_setp(L, hvalue(o), p, tag), L->top - 1);
     luaC_barriert(L, hvalue(o), L->top - 1);
     L->top--;
@@ -1068,8 +1123,7 @@ int lua_setmetatable(lua_State* L, int objindex)
     {
     case LUA_TTABLE:
     {
-        if (hvalue(obj)->readonly)
-            luaG_readonlyerror(L);
+        luaH_checkwrite(L, hvalue(obj));
         hvalue(obj)->metatable = mt;
         if (mt)
             luaC_objbarrier(L, hvalue(obj), mt);
@@ -1084,6 +1138,7 @@ int lua_setmetatable(lua_State* L, int objindex)
     }
     default:
     {
+        luaC_regionescape(L, L->top - 1);
         L->global->mt[ttype(obj)] = mt;
         break;
     }
@@ -1102,14 +1157,18 @@ int lua_setfenv(lua_State* L, int idx)
     switch (ttype(o))
     {
     case LUA_TFUNCTION:
-#ifdef LUAU_MULTITHREADING
-    	hvalue(L->top - 1)->shared=true;
+#ifdef LUAU_MULTITHREAD
+        if (ispacked(hvalue(L->top - 1)))
+            luaH_unpackarray(L, hvalue(L->top - 1));
+    	luaC_setbit(hvalue(L->top - 1), SHAREDBIT);
 #endif
         clvalue(o)->env = hvalue(L->top - 1);
         break;
     case LUA_TTHREAD:
-#ifdef LUAU_MULTITHREADING
-    	hvalue(L->top - 1)->shared=true;
+#ifdef LUAU_MULTITHREAD
+        if (ispacked(hvalue(L->top - 1)))
+            luaH_unpackarray(L, hvalue(L->top - 1));
+    	luaC_setbit(hvalue(L->top - 1), SHAREDBIT);
 #endif
         thvalue(o)->gt = hvalue(L->top - 1);
         break;
@@ -1360,6 +1419,93 @@ int lua_gc(lua_State* L, int what, int data)
         }
         break;
     }
+    case LUA_GCSTEPTIME:
+    {
+        double budget = data * 1e-6;
+        double start = lua_clock();
+        double elapsed = 0.0;
+        ptrdiff_t oldcredit = g->gcstate == GCSpause ? 0 : g->GCthreshold - g->totalbytes;
+
+        // track how much work the loop will actually perform
+        size_t actualwork = 0;
+
+        // each step is sized by the regular pacer settings, so the time measured for earlier steps predicts whether the next one fits
+        while (elapsed + g->gcstats.steptime <= budget)
+        {
+            int laststate = g->gcstate;
+
+            g->GCthreshold = 0;
+
+            double stepstart = lua_clock();
+            size_t stepsize = luaC_step(L, false);
+            double stepend = lua_clock();
+
+            actualwork += stepsize;
+            elapsed = stepend - start;
+
+            // atomic stage is indivisible and can't be budgeted for, so it doesn't count towards the estimate
+            if (stepsize != 0 && laststate != GCSatomic)
+            {
+                double steptime = stepend - stepstart;
+                g->gcstats.steptime = g->gcstats.steptime == 0.0 ? steptime : (g->gcstats.steptime * 7 + steptime) / 8;
+            }
+
+            if ((g->gcstate == GCSpause) || (stepsize == 0))
+            { // end of cycle?
+                res = 1; // signal it
+                break;
+            }
+        }
+
+        g->gcstats.timedsteps++;
+
+        if (elapsed > budget)
+        {
+            double overrun = elapsed - budget;
+
+            g->gcstats.budgetoverruns++;
+            g->gcstats.overruntime += overrun;
+
+            if (overrun > g->gcstats.maxoverruntime)
+                g->gcstats.maxoverruntime = overrun;
+        }
+
+        // the work done within the budget is credited to the pacer so that assists don't repeat it
+        if (g->gcstate != GCSpause)
+        {
+            ptrdiff_t newthreshold = g->totalbytes + actualwork + oldcredit;
+            g->GCthreshold = newthreshold < 0 ? 0 : newthreshold;
+        }
+        break;
+    }
+    case LUA_GCCOMPACT:
+    {
+        size_t released = luaC_compact(L, data > 0 && data <= 100 ? data : LUAI_GCCOMPACTOCCUPANCY);
+        res = cast_int(released >> 10);
+        break;
+    }
+    case LUA_GCSETLARGEPOOL:
+    {
+        res = cast_int(g->largepoollimit >> 10);
+        g->largepoollimit = size_t(data < 0 ? 0 : data) << 10;
+        luaM_trimlargepool(L, g->largepoollimit);
+        break;
+    }
+    case LUA_GCLARGEPOOLCOUNT:
+    {
+        res = cast_int(g->largepoolbytes >> 10);
+        break;
+    }
+    case LUA_GCLARGEPOOLHITS:
+    {
+        res = g->largepoolhits > INT_MAX ? INT_MAX : cast_int(g->largepoolhits);
+        break;
+    }
+    case LUA_GCLARGEPOOLMISSES:
+    {
+        res = g->largepoolmisses > INT_MAX ? INT_MAX : cast_int(g->largepoolmisses);
+        break;
+    }
     case LUA_GCSETGOAL:
     {
         res = g->gcgoal;
@@ -1385,6 +1531,36 @@ int lua_gc(lua_State* L, int what, int data)
         res = luaC_needsGC(L)?1:0;
         break;
     }
+    case LUA_GCGEN:
+    case LUA_GCINC:
+    {
+        res = g->gckind == GCKgenerational ? LUA_GCGEN : LUA_GCINC;
+        g->gckind = what == LUA_GCGEN ? GCKgenerational : GCKincremental;
+        break;
+    }
+    case LUA_GCSETGENMINORMUL:
+    {
+        res = g->gcgenminormul;
+        g->gcgenminormul = data;
+        break;
+    }
+    case LUA_GCSETGENMAJORMUL:
+    {
+        res = g->gcgenmajormul;
+        g->gcgenmajormul = data;
+        break;
+    }
+    case LUA_GCSWEEPTHREAD:
+    {
+        res = g->gcbgsweep;
+        g->gcbgsweep = data != 0;
+        break;
+    }
+    case LUA_GCTYPESTATS:
+    {
+        res = luaC_settypecounters(L, data != 0);
+        break;
+    }
     default:
         res = -1; // invalid option
     }
@@ -1412,9 +1588,9 @@ int lua_next(lua_State* L, int idx)
     luaC_threadbarrier(L);
     StkId t = index2addr(L, idx);
     api_check(L, ttistable(t));
-	lualock_table(hvalue(t));
+	lualock_tableread(hvalue(t));
     int more = luaH_next(L, hvalue(t), L->top - 1);
-	luaunlock_table(hvalue(t));
+	luaunlock_tableread(hvalue(t));
     if (more)
     {
         api_incr_top(L);
@@ -1434,6 +1610,23 @@ int lua_rawiter(lua_State* L, int idx, int iter)
     LuaTable* h = hvalue(t);
     int sizearray = h->sizearray;
 
+    // packed arrays have no nil values, and their keys are numbered like an array part
+    if (ispacked(h))
+    {
+        LuaPackedArray* pa = gpacked(h);
+
+        if (unsigned(iter) < unsigned(pa->size))
+        {
+            StkId top = L->top;
+            setnvalue(top + 0, double(iter + 1));
+            setnvalue(top + 1, pa->values[iter]);
+            api_update_top(L, top + 2);
+            return iter + 1;
+        }
+
+        sizearray = pa->size;
+    }
+
     // first we advance iter through the array portion
     for (; unsigned(iter) < unsigned(sizearray); ++iter)
     {
@@ -1466,6 +1659,26 @@ int lua_rawiter(lua_State* L, int idx, int iter)
         }
     }
 
+    // and finally through the slots of a shaped table
+    if (isshaped(h))
+    {
+        LuaShapedNode* sn = gshaped(h);
+
+        for (; unsigned(iter - sizearray - sizenode) < unsigned(sn->shape->count); ++iter)
+        {
+            TValue* e = &sn->slots[iter - sizearray - sizenode];
+
+            if (!ttisnil(e))
+            {
+                StkId top = L->top;
+                setsvalue(L, top + 0, sn->shape->keys[iter - sizearray - sizenode]);
+                setobj2s(L, top + 1, e);
+                api_update_top(L, top + 2);
+                return iter + 1;
+            }
+        }
+    }
+
     // traversal finished
     return -1;
 }
@@ -1607,29 +1820,15 @@ int lua_ref(lua_State* L, int idx)
 {
     api_check(L, idx != LUA_REGISTRYINDEX); // idx is a stack index for value
     int ref = LUA_REFNIL;
-    global_State* g = L->global;
     StkId p = index2addr(L, idx);
     if (!ttisnil(p))
     {
-        lualock_global();
         LuaTable* reg = hvalue(registry(L));
+        ref = luaE_allocref(L);
 
-        if (g->registryfree != 0)
-        { // reuse existing slot
-            ref = g->registryfree;
-        }
-        else
-        { // no free elements
-            ref = luaH_getn(reg);
-            ref++; // create new reference
-        }
-
-        TValue* slot = luaH_setnum(L, reg, ref);
-        if (g->registryfree != 0)
-            g->registryfree = int(nvalue(slot));
-
-        luaunlock_global();
-        setobj2t(L, slot, p);
+        lualock_table(reg);
+        setobj2t(L, luaH_setnum(L, reg, ref), p);
+        luaunlock_table(reg);
         luaC_barriert(L, reg, p);
     }
     return ref;
@@ -1640,9 +1839,8 @@ void lua_unref(lua_State* L, int ref)
     if (ref <= LUA_REFNIL)
         return;
 
-    global_State* g = L->global;
-    lualock_global();
     LuaTable* reg = hvalue(registry(L));
+    lualock_table(reg);
 
     const TValue* slot = luaH_getnum(reg, ref);
     api_check(L, slot != luaO_nilobject);
@@ -1650,10 +1848,11 @@ void lua_unref(lua_State* L, int ref)
     // similar to how 'luaH_setnum' makes non-nil slot value mutable
     TValue* mutableSlot = (TValue*)slot;
 
-    // NB: no barrier needed because value isn't collectable
-    setnvalue(mutableSlot, g->registryfree);
-    g->registryfree = ref;
-    luaunlock_global();
+    // free slots are linked outside of the registry, so the slot is just cleared
+    api_check(L, !ttisnil(slot));
+    setnilvalue(mutableSlot);
+    luaE_freeref(L, ref);
+    luaunlock_table(reg);
 }
 
 void lua_setuserdatatag(lua_State* L, int idx, int tag)
@@ -1676,11 +1875,24 @@ lua_Destructor lua_getuserdatadtor(lua_State* L, int tag)
     return L->global->udatagc[tag];
 }
 
+void lua_setuserdatabatchdtor(lua_State* L, int tag, lua_BatchDestructor dtor)
+{
+    api_check(L, unsigned(tag) < LUA_UTAG_LIMIT);
+    L->global->udatagcbatch[tag] = dtor;
+}
+
+lua_BatchDestructor lua_getuserdatabatchdtor(lua_State* L, int tag)
+{
+    api_check(L, unsigned(tag) < LUA_UTAG_LIMIT);
+    return L->global->udatagcbatch[tag];
+}
+
 void lua_setuserdatametatable(lua_State* L, int tag)
 {
     api_check(L, unsigned(tag) < LUA_UTAG_LIMIT);
     api_check(L, !L->global->udatamt[tag]); // reassignment not supported
     api_check(L, ttistable(L->top - 1));
+    luaC_regionescape(L, L->top - 1);
     L->global->udatamt[tag] = hvalue(L->top - 1);
     L->top--;
 }
@@ -1729,7 +1941,10 @@ void lua_clonefunction(lua_State* L, int idx)
     Closure* cl = clvalue(p);
     Closure* newcl = luaF_newLclosure(L, cl->nupvalues, L->gt, cl->l.p);
     for (int i = 0; i < cl->nupvalues; ++i)
+    {
+        luaC_regionescape(L, &cl->l.uprefs[i]);
         setobj2n(L, &newcl->l.uprefs[i], &cl->l.uprefs[i]);
+    }
     setclvalue(L, L->top, newcl);
     api_incr_top(L);
 }
@@ -1742,9 +1957,9 @@ void lua_clonetable(lua_State* L, int idx)
     api_check(L, ttistable(o));
     LuaTable* t = hvalue(o);
     api_check(L, t != hvalue(registry(L)));
-    lualock_table(t);
+    lualock_tableread(t);
     LuaTable* tt = luaH_clone(L, t);
-    luaunlock_table(t);
+    luaunlock_tableread(t);
     sethvalue(L, L->top, tt);
     api_incr_top(L);
     profiletable(L, tt, NULL);
@@ -1762,6 +1977,9 @@ void lua_remaptable(lua_State* L, int idx, int mapIdx)
     api_check(L, ttistable(mo));
     LuaTable *lt = hvalue(mo);
     lualock_table(t);
+    // packed numbers may be mapped to other values
+    if (ispacked(t))
+        luaH_unpackarray(L, t);
     luaH_remaptable(t, lt);
     luaunlock_table(t);
 }
@@ -1771,8 +1989,7 @@ void lua_cleartable(lua_State* L, int idx)
     StkId t = index2addr(L, idx);
     api_check(L, ttistable(t));
     LuaTable* tt = hvalue(t);
-    if (tt->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, tt);
     luaH_clear(tt);
 }
 
@@ -1792,6 +2009,7 @@ lua_Callbacks* lua_callbacks(lua_State* L)
 void lua_setmemcat(lua_State* L, int category)
 {
     api_check(L, unsigned(category) < LUA_MEMORY_CATEGORIES);
+    api_check(L, category != LUA_REGIONMEMCAT);
     L->activememcat = uint8_t(category);
 }
 
@@ -1801,6 +2019,70 @@ size_t lua_totalbytes(lua_State* L, int category)
     return category < 0 ? L->global->totalbytes : L->global->memcatbytes[category];
 }
 
+int lua_gettypestats(lua_State* L, int category, int type, lua_GCTypeStats* stats)
+{
+    api_check(L, unsigned(category) < LUA_MEMORY_CATEGORIES);
+    api_check(L, type == LUA_TNIL || (type >= LUA_TSTRING && type <= LUA_TUPVAL));
+
+    global_State* g = L->global;
+
+    if (!g->typecounters)
+        return 0;
+
+    const lua_TypeCounters* c = &g->typecounters[category][type == LUA_TNIL ? typecounterdata : typecounterslot(type)];
+
+    uint64_t allocs = c->allocs;
+    uint64_t frees = c->frees;
+    uint64_t allocbytes = c->allocbytes;
+    uint64_t freebytes = c->freebytes;
+
+    // counters are updated one at a time by threads that allocate concurrently, so a read may briefly see more frees than allocations
+    stats->count = allocs > frees ? size_t(allocs - frees) : 0;
+    stats->bytes = allocbytes > freebytes ? size_t(allocbytes - freebytes) : 0;
+    stats->allocated = allocbytes;
+    stats->freed = freebytes;
+    stats->cycleallocated = size_t(c->cycleallocbytes);
+    stats->cyclefreed = size_t(c->cyclefreebytes);
+    stats->cycletime = g->typecounterscycle;
+    return 1;
+}
+
+int lua_pushregion(lua_State* L)
+{
+    global_State* g = L->global;
+    lua_Region* r = &g->region;
+
+    if (r->owner == L)
+    {
+        r->depth++;
+        return 1;
+    }
+
+    // escape checks rely on the interpreter, and allocation from the region isn't synchronized with other threads
+    if (r->owner || g->ecb.enter || luaE_luathreads(g))
+        return 0;
+
+    r->owner = L;
+    r->depth = 1;
+    r->escaped = false;
+    r->memcat = L->activememcat;
+    return 1;
+}
+
+int lua_popregion(lua_State* L)
+{
+    api_check(L, L->global->region.owner == L && L->global->region.depth > 0);
+    return luaC_popregion(L);
+}
+
+int lua_settableshapes(lua_State* L, int enable)
+{
+    global_State* g = L->global;
+    int previous = g->shapes.enabled;
+    g->shapes.enabled = enable != 0;
+    return previous;
+}
+
 lua_Alloc lua_getallocf(lua_State* L, void** ud)
 {
     lua_Alloc f = L->global->frealloc;
@@ -1852,9 +2134,9 @@ int lua_rawgettoken(lua_State* L, int idx, int token)
     TValue key;
     setsvalue(L, &key, L->global->ttoken[token]);
     LuaTable *tt=hvalue(t);
-	lualock_table(tt);
+	lualock_tableread(tt);
     setobj2s(L, L->top, luaH_getstr(tt, tsvalue(&key)));
-	luaunlock_table(tt);
+	luaunlock_tableread(tt);
     api_incr_top(L);
     return ttype(L->top - 1);
 }
@@ -1865,8 +2147,7 @@ void lua_rawsettoken(lua_State* L, int idx, int token)
     api_checknelems(L, 1);
     StkId t = index2addr(L, idx);
     api_check(L, ttistable(t));
-    if (hvalue(t)->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, hvalue(t));
     setobj2t(L, luaH_setstr(L, hvalue(t), L->global->ttoken[token]), L->top - 1);
     luaC_barriert(L, hvalue(t), L->top - 1);
     L->top--;
@@ -583,6 +583,35 @@ static int luaB_collectgarbage(lua_State* L)
         return 1;
     }
 
+    if (strcmp(option, "steptime") == 0)
+    {
+        int c = lua_gc(L, LUA_GCSTEPTIME, luaL_checkint(L,2));
+        lua_pushboolean(L, c);
+        return 1;
+    }
+
+    if (strcmp(option, "compact") == 0)
+    {
+        int c = lua_gc(L, LUA_GCCOMPACT, luaL_optint(L,2,0));
+        lua_pushnumber(L, c);
+        return 1;
+    }
+
+    if (strcmp(option, "largepool") == 0)
+    {
+        if (!lua_isnoneornil(L, 2))
+        {
+            int c = lua_gc(L, LUA_GCSETLARGEPOOL, luaL_checkint(L, 2));
+            lua_pushnumber(L, c);
+            return 1;
+        }
+
+        lua_pushnumber(L, lua_gc(L, LUA_GCLARGEPOOLCOUNT, 0));
+        lua_pushnumber(L, lua_gc(L, LUA_GCLARGEPOOLHITS, 0));
+        lua_pushnumber(L, lua_gc(L, LUA_GCLARGEPOOLMISSES, 0));
+        return 3;
+    }
+
     if (strcmp(option, "stop") == 0)
     {
         int c = lua_gc(L, LUA_GCSTOP, 0);
@@ -590,7 +619,21 @@ static int luaB_collectgarbage(lua_State* L)
         return 1;
     }
 
-    luaL_error(L, "collectgarbage must be called with one of the supported options");
+    if (strcmp(option, "generational") == 0 || strcmp(option, "incremental") == 0)
+    {
+        int c = lua_gc(L, option[0] == 'g' ? LUA_GCGEN : LUA_GCINC, 0);
+        lua_pushstring(L, c == LUA_GCGEN ? "generational" : "incremental");
+        return 1;
+    }
+
+    if (strcmp(option, "sweepthread") == 0)
+    {
+        int c = lua_gc(L, LUA_GCSWEEPTHREAD, lua_isnoneornil(L, 2) || lua_toboolean(L, 2));
+        lua_pushboolean(L, c);
+        return 1;
+    }
+
+        luaL_error(L, "collectgarbage must be called with one of the supported options");
     return 0;
 }
 
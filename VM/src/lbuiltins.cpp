@@ -979,9 +979,10 @@ static int luauF_rawget(lua_State* L, StkId res, TValue* arg0, int nresults, Stk
 {
     if (nparams >= 2 && nresults <= 1 && ttistable(arg0))
     {
-    	lualock_table(hvalue(arg0));
-        setobj2s(L, res, luaH_get(hvalue(arg0), args));
-    	luaunlock_table(hvalue(arg0));
+        TValue copy;
+    	lualock_tableread(hvalue(arg0));
+        setobj2s(L, res, luaH_getcopy(hvalue(arg0), args, &copy));
+    	luaunlock_tableread(hvalue(arg0));
         return 1;
     }
 
@@ -1006,7 +1007,8 @@ static int luauF_rawset(lua_State* L, StkId res, TValue* arg0, int nresults, Stk
 
         setobj2s(L, res, arg0);
     	lualock_table(t);
-        setobj2t(L, luaH_set(L, t, args), args + 1);
+        if (!luaH_ispackedstore(t, args, args + 1) || !luaH_setpacked(L, t, args, args + 1))
+            setobj2t(L, luaH_set(L, t, args), args + 1);
     	luaunlock_table(t);
         luaC_barriert(L, t, args + 1);
         return 1;
@@ -1024,8 +1026,10 @@ static int luauF_tinsert(lua_State* L, StkId res, TValue* arg0, int nresults, St
             return -1;
 
     	lualock_table(t);
-        int pos = luaH_getn(t) + 1;
-        setobj2t(L, luaH_setnum(L, t, pos), args);
+        TValue pos;
+        setnvalue(&pos, cast_num(luaH_getn(t) + 1));
+        if (!luaH_ispackedstore(t, &pos, args) || !luaH_setpacked(L, t, &pos, args))
+            setobj2t(L, luaH_setnum(L, t, int(nvalue(&pos))), args);
     	luaunlock_table(t);
         luaC_barriert(L, t, args);
         return 0;
@@ -1056,6 +1060,16 @@ static int luauF_tunpack(lua_State* L, StkId res, TValue* arg0, int nresults, St
             expandstacklimit(L, res + n);
             return n;
         }
+
+        if (n >= 0 && ispacked(t) && n <= gpacked(t)->size && cast_int(L->stack_last - res) >= n && n + nparams <= LUAI_MAXCSTACK)
+        {
+            double* values = gpacked(t)->values;
+            for (int i = 0; i < n; ++i)
+                setnvalue(res + i, values[i]);
+        	luaunlock_table(t);
+            expandstacklimit(L, res + n);
+            return n;
+        }
     	luaunlock_table(t);
     }
 
@@ -5,10 +5,15 @@
 #include "lstate.h"
 #include "lmem.h"
 #include "lgc.h"
+#include "lbytecode.h"
+
+#include "Luau/BytecodeUtils.h"
+
+#include <string.h>
 
 Proto* luaF_newproto(lua_State* L)
 {
-    Proto* f = luaM_newgco(L, Proto, sizeof(Proto), L->activememcat);
+    Proto* f = luaM_newgco(L, Proto, sizeof(Proto), L->activememcat, LUA_TPROTO);
 
     luaC_init(L, f, LUA_TPROTO);
 
@@ -40,6 +45,8 @@ Proto* luaF_newproto(lua_State* L)
 
     f->userdata = NULL;
 
+    f->icache = NULL;
+
     f->gclist = NULL;
 
     f->sizecode = 0;
@@ -58,7 +65,7 @@ Proto* luaF_newproto(lua_State* L)
 
 Closure* luaF_newLclosure(lua_State* L, int nelems, LuaTable* e, Proto* p)
 {
-    Closure* c = luaM_newgco(L, Closure, sizeLclosure(nelems), L->activememcat);
+    Closure* c = luaM_newgco(L, Closure, sizeLclosure(nelems), L->activememcat, LUA_TFUNCTION);
     luaC_init(L, c, LUA_TFUNCTION);
     c->isC = 0;
     c->env = e;
@@ -73,7 +80,7 @@ Closure* luaF_newLclosure(lua_State* L, int nelems, LuaTable* e, Proto* p)
 
 Closure* luaF_newCclosure(lua_State* L, int nelems, LuaTable* e)
 {
-    Closure* c = luaM_newgco(L, Closure, sizeCclosure(nelems), L->activememcat);
+    Closure* c = luaM_newgco(L, Closure, sizeCclosure(nelems), L->activememcat, LUA_TFUNCTION);
     luaC_init(L, c, LUA_TFUNCTION);
     c->isC = 1;
     c->env = e;
@@ -104,7 +111,7 @@ UpVal* luaF_findupval(lua_State* L, StkId level)
     LUAU_ASSERT(L->isactive);
     LUAU_ASSERT(!isblack(obj2gco(L))); // we don't use luaC_threadbarrier because active threads never turn black
 
-    UpVal* uv = luaM_newgco(L, UpVal, sizeof(UpVal), L->activememcat); // not found: create a new one
+    UpVal* uv = luaM_newgco(L, UpVal, sizeof(UpVal), L->activememcat, LUA_TUPVAL); // not found: create a new one
     luaC_init(L, uv, LUA_TUPVAL);
     uv->markedopen = 0;
     uv->v = level; // current value lives in the stack
@@ -113,14 +120,14 @@ UpVal* luaF_findupval(lua_State* L, StkId level)
     uv->u.open.threadnext = *pp;
     *pp = uv;
 
-    // double link the upvalue in the global open upvalue list
-    lualock_global();
-    uv->u.open.prev = &g->uvhead;
-    uv->u.open.next = g->uvhead.u.open.next;
-    uv->u.open.next->u.open.prev = uv;
-    g->uvhead.u.open.next = uv;
-    LUAU_ASSERT(uv->u.open.next->u.open.prev == uv && uv->u.open.prev->u.open.next == uv);
-    luaunlock_global();
+    // link the thread in the list of threads with open upvalues; it stays there until the GC finds it without any
+    if (L->twups == L)
+    {
+        lualock_global();
+        L->twups = g->twups;
+        g->twups = L;
+        luaunlock_global();
+    }
 
     return uv;
 }
@@ -149,13 +156,7 @@ void luaF_close(lua_State* L, StkId level)
 
 void luaF_closeupval(lua_State* L, UpVal* uv, bool dead)
 {
-    lualock_global();
-    // unlink value from all lists *before* closing it since value storage overlaps
-    LUAU_ASSERT(uv->u.open.next->u.open.prev == uv && uv->u.open.prev->u.open.next == uv);
-    uv->u.open.next->u.open.prev = uv->u.open.prev;
-    uv->u.open.prev->u.open.next = uv->u.open.next;
-    luaunlock_global();
-
+    // the caller has unlinked the value from its thread list, which overlaps with value storage
     if (dead)
         return;
 
@@ -182,6 +183,9 @@ void luaF_freeproto(lua_State* L, Proto* f, lua_Page* page)
     if (f->typeinfo)
         luaM_freearray(L, f->typeinfo, f->sizetypeinfo, uint8_t, f->memcat);
 
+    if (LuaProtoCache* cache = f->icache.load(std::memory_order_relaxed))
+        luaM_free_(L, cache, luaF_sizeinlinecaches(f), f->memcat);
+
     luaM_freegco(L, f, sizeof(Proto), f->memcat, page);
 }
 
@@ -191,6 +195,78 @@ void luaF_freeclosure(lua_State* L, Closure* c, lua_Page* page)
     luaM_freegco(L, c, size, c->memcat, page);
 }
 
+static size_t sizeprotocache(int sizeic, int sizecode)
+{
+    return offsetof(LuaProtoCache, ic) + sizeof(LuaInlineCache) * sizeic + sizeof(uint16_t) * sizecode;
+}
+
+// opcode of the instruction, which might be patched with a breakpoint
+static uint8_t getop(Proto* p, int pc)
+{
+    return p->debuginsn ? p->debuginsn[pc] : LUAU_INSN_OP(p->code[pc]);
+}
+
+static bool hasinlinecache(uint8_t op)
+{
+    return op == LOP_GETTABLEKS || op == LOP_SETTABLEKS || op == LOP_NAMECALL;
+}
+
+static LuaProtoCache* newprotocache(lua_State* L, Proto* p)
+{
+    int sizeic = 0;
+    for (int i = 0; i < p->sizecode; i += Luau::getOpLength(LuauOpcode(getop(p, i))))
+        if (hasinlinecache(getop(p, i)) && sizeic < UINT16_MAX)
+            sizeic++;
+
+    LuaProtoCache* cache = (LuaProtoCache*)luaM_new_(L, sizeprotocache(sizeic, p->sizecode), p->memcat);
+    cache->map = (uint16_t*)&cache->ic[sizeic];
+    cache->sizeic = sizeic;
+
+    for (int i = 0; i < sizeic; i++)
+    {
+        for (int j = 0; j < LUA_INLINECACHESIZE; j++)
+            cache->ic[i].entries[j].slot = -1;
+        cache->ic[i].next = 0;
+    }
+
+    memset(cache->map, 0, sizeof(uint16_t) * p->sizecode);
+
+    int ic = 0;
+    for (int i = 0; i < p->sizecode; i += Luau::getOpLength(LuauOpcode(getop(p, i))))
+        if (hasinlinecache(getop(p, i)) && ic < sizeic)
+            cache->map[i] = uint16_t(++ic);
+
+    return cache;
+}
+
+LuaInlineCache* luaF_getinlinecache(Proto* p, const Instruction* pc)
+{
+    // pairs with the release in luaF_newinlinecache, the cache is initialized before it's published
+    LuaProtoCache* cache = p->icache.load(std::memory_order_acquire);
+
+    if (!cache)
+        return NULL;
+
+    int index = cache->map[pc - p->code];
+    return index ? &cache->ic[index - 1] : NULL;
+}
+
+void luaF_newinlinecache(lua_State* L, Proto* p)
+{
+    LuaProtoCache* cache = newprotocache(L, p);
+    LuaProtoCache* expected = NULL;
+
+    // another thread may have published a cache since the caller checked
+    if (!p->icache.compare_exchange_strong(expected, cache, std::memory_order_release, std::memory_order_relaxed))
+        luaM_free_(L, cache, sizeprotocache(cache->sizeic, p->sizecode), p->memcat);
+}
+
+size_t luaF_sizeinlinecaches(Proto* p)
+{
+    LuaProtoCache* cache = p->icache.load(std::memory_order_relaxed);
+    return cache ? sizeprotocache(cache->sizeic, p->sizecode) : 0;
+}
+
 const LocVar* luaF_getlocal(const Proto* f, int local_number, int pc)
 {
     for (int i = 0; i < f->sizelocvars; i++)
@@ -15,7 +15,7 @@
 #include <string.h>
 
 /*
- * Luau uses an incremental non-generational non-moving mark&sweep garbage collector.
+ * Luau uses an incremental non-moving mark&sweep garbage collector, with an optional generational mode described at the end.
  *
  * The collector runs in three stages: mark, atomic and sweep. Mark and sweep are incremental and try to do a limited amount
  * of work every GC step; atomic is ran once per the GC cycle and is indivisible. In either case, the work happens during GC
@@ -112,9 +112,45 @@
  * Upvalues are special objects that can be closed, in which case they contain the value (acting as a reference cell) and can be dealt
  * with using the regular algorithm, or open, in which case they refer to a stack slot in some other thread. These are difficult to deal
  * with because the stack writes are not monitored. Because of this open upvalues are treated in a somewhat special way: they are never marked
- * as black (doing so would violate the GC invariant), and they are kept in a special global list (global_State::uvhead) which is traversed
- * during atomic phase. This is needed because an open upvalue might point to a stack location in a dead thread that never marked the stack
- * slot - upvalues like this are identified since they don't have `markedopen` bit set during thread traversal and closed in `clearupvals`.
+ * as black (doing so would violate the GC invariant), and the threads that have open upvalues are kept in a special global list
+ * (global_State::twups) whose upvalue lists are traversed during atomic phase. This is needed because an open upvalue might point to a stack
+ * location in a dead thread that never marked the stack slot - upvalues like this are identified since they don't have `markedopen` bit set
+ * during thread traversal and closed in `clearupvals`.
+ *
+ * In generational mode (selected with lua_gc), objects that survive a collection become old: the sweep keeps their marks instead of
+ * turning them white (`gcsticky`) and sets their OLDBIT. Since old objects stay black between cycles, the tri-color invariant
+ * is kept outside of the mark stage as well: barriers on old objects either mark the new referent (forward) or turn the old object
+ * gray again and queue it on `grayagain` (backward). The objects queued this way, together with the gray threads and weak tables
+ * that are kept on `grayagain` at the end of the cycle, form the remembered set.
+ *
+ * A minor collection (`gcminor`) runs through the same stages as a regular cycle, but the mark doesn't go past old objects - it
+ * only reaches objects allocated since the last cycle, starting from the roots and the remembered set. Old objects can't die in a
+ * minor collection, so the sweep only needs to visit pages that received new objects since they were last swept (see
+ * `lua_Page::young`). Open upvalues of old threads that weren't traversed are kept open, as these threads are alive by definition.
+ *
+ * Once the heap grows beyond the size left by the last major collection by the major multiplier, the sweep of the next minor
+ * collection turns all objects white like in incremental mode, and the following cycle is a major collection that marks the whole
+ * heap; its survivors become old again.
+ *
+ * When LUAU_MULTITHREAD is enabled, the sweep of an incremental cycle can run on a helper thread instead (see LUA_GCSWEEPTHREAD).
+ * At the end of atomic stage, all GCO pages are detached from the heap and handed to the helper thread, so that the mutator keeps
+ * allocating from new pages without ever looking at the pages being swept. The helper thread frees dead objects and recolors
+ * live ones under the global lock, and hands swept pages back through a list that GC steps link into the heap again; this page
+ * handoff is the only point where the mutator synchronizes with the sweep. Barriers that recolor objects take the global lock
+ * anyway, and so do the other writers of the mark bits (luaC_setbit). Dead strings are removed from the string table under the
+ * shard lock before the global lock is taken, and lock-free string lookups are disabled while the sweep runs since they could
+ * reach a string that is being freed. Objects that need the mutator to be freed (threads, userdata with destructors and functions
+ * with native code) are left in place, and their pages are swept again by GC steps once they are handed back. The helper thread is
+ * counted as a suspended attached thread, which makes allocations and string table updates take their locks, and the sweep only
+ * starts while no other thread is attached; a thread attaching in the middle of it waits for the helper thread to finish.
+ *
+ * Objects never move during a cycle, but an explicit compacting pass (luaC_compact, see LUA_GCCOMPACT) can move strings and tables
+ * out of sparsely populated pages right after a full collection, when every reference in the heap is known to point to a live object.
+ * The pass first pins (PINNEDBIT) objects whose address may be held outside of the heap or matters for their identity: values
+ * in the frames and upvalues of C functions, tables used as keys (which are hashed by address), shared tables (whose locks are
+ * picked by address) and constants of functions with native code. The page allocator then copies the objects of sparse pages and
+ * leaves forwarding copies behind (MOVEDBIT), and a stop-the-world walk over the heap and the roots redirects every reference to
+ * them before the old pages are freed.
  */
 
 #define GC_SWEEPPAGESTEPCOST 16
@@ -126,7 +162,7 @@
             interrupt(L, state); \
     }
 
-#define maskmarks cast_byte(~(bitmask(BLACKBIT) | WHITEBITS))
+#define maskmarks cast_byte(~(bitmask(BLACKBIT) | WHITEBITS | bitmask(OLDBIT)))
 
 #define makewhite(g, x) ((x)->gch.marked = cast_byte(((x)->gch.marked & maskmarks) | luaC_white(g)))
 
@@ -322,6 +358,14 @@ static int traversetable(global_State* g, LuaTable* h)
         }
     }
 
+    if (isshaped(h))
+    {
+        LuaShapedNode* sn = gshaped(h);
+        // shape keys are kept alive by the shape table (see markshapes); slots are cleared like values
+        if (!weakvalue)
+            for (i = 0; i < sn->shape->count; i++)
+                markvalue(g, &sn->slots[i]);
+    }
     if (weakkey && weakvalue)
         return 1;
     if (!weakvalue)
@@ -480,7 +524,7 @@ static size_t propagatemark(global_State* g)
         g->gray = h->gclist;
         if (traversetable(g, h)) // table is weak?
             black2gray(o);       // keep it gray
-        return sizeof(LuaTable) + sizeof(TValue) * h->sizearray + sizeof(LuaNode) * sizenode(h);
+        return sizeof(LuaTable) + sizeof(TValue) * h->sizearray + sizeof(LuaNode) * sizenode(h) + (isshaped(h) ? sizeof(TValue) * gshaped(h)->shape->count : 0);
     }
     case LUA_TFUNCTION:
     {
@@ -591,7 +635,7 @@ static size_t cleartable(lua_State* L, GCObject* l)
     while (l)
     {
         LuaTable* h = gco2h(l);
-        work += sizeof(LuaTable) + sizeof(TValue) * h->sizearray + sizeof(LuaNode) * sizenode(h);
+        work += sizeof(LuaTable) + sizeof(TValue) * h->sizearray + sizeof(LuaNode) * sizenode(h) + (isshaped(h) ? sizeof(TValue) * gshaped(h)->shape->count : 0);
 
         int i = h->sizearray;
         while (i--)
@@ -600,6 +644,16 @@ static size_t cleartable(lua_State* L, GCObject* l)
             if (iscleared(o))   // value was collected?
                 setnilvalue(o); // remove value
         }
+        if (isshaped(h))
+        {
+            LuaShapedNode* sn = gshaped(h);
+            for (i = 0; i < sn->shape->count; i++)
+            {
+                TValue* o = &sn->slots[i];
+                if (iscleared(o))   // value was collected?
+                    setnilvalue(o); // remove value
+            }
+        }
         i = sizenode(h);
         int activevalues = 0;
         while (i--)
@@ -672,19 +726,20 @@ static void freeobj(lua_State* L, GCObject* o, lua_Page* page)
     }
 }
 
-static void stringresizeprotected(lua_State* L, int newsize)
+static void stringresizeprotected(lua_State* L, stringtable* tb, int newsize)
 {
     struct CallContext
     {
+        stringtable* tb;
         int newsize;
 
         static void run(lua_State* L, void* ud)
         {
             CallContext* ctx = (CallContext*)ud;
 
-            luaS_resize(L, ctx->newsize);
+            luaS_resize(L, ctx->tb, ctx->newsize);
         }
-    } ctx = {newsize};
+    } ctx = {tb, newsize};
 
     // the resize call can fail on exception, in which case we will continue with original size
     int status = luaD_rawrunprotected(L, &CallContext::run, &ctx);
@@ -694,22 +749,37 @@ static void stringresizeprotected(lua_State* L, int newsize)
 static void shrinkbuffers(lua_State* L)
 {
     global_State* g = L->global;
-    // check size of string hash
-    if (g->strt.nuse < cast_to(uint32_t, g->strt.size / 4) && g->strt.size > LUA_MINSTRTABSIZE * 2)
-        stringresizeprotected(L, g->strt.size / 2); // table is too big
+    for (int i = 0; i < LUA_STRSHARDS; i++)
+    {
+        stringtable* tb = &g->strt[i];
+        // all threads are suspended during GC, so there are no readers left for arrays replaced by earlier resizes
+        luaS_freeretired(L, tb);
+        // check size of string hash
+        if (tb->nuse < cast_to(uint32_t, tb->size / 4) && tb->size > LUA_MINSTRTABSIZE * 2)
+            stringresizeprotected(L, tb, tb->size / 2); // table is too big
+    }
 }
 
 static void shrinkbuffersfull(lua_State* L)
 {
     global_State* g = L->global;
-    // check size of string hash
-    int hashsize = g->strt.size;
-    while (g->strt.nuse < cast_to(uint32_t, hashsize / 4) && hashsize > LUA_MINSTRTABSIZE * 2)
-        hashsize /= 2;
-    if (hashsize != g->strt.size)
-        stringresizeprotected(L, hashsize); // table is too big
+    for (int i = 0; i < LUA_STRSHARDS; i++)
+    {
+        stringtable* tb = &g->strt[i];
+        luaS_freeretired(L, tb);
+        // check size of string hash
+        int hashsize = tb->size;
+        while (tb->nuse < cast_to(uint32_t, hashsize / 4) && hashsize > LUA_MINSTRTABSIZE * 2)
+            hashsize /= 2;
+        if (hashsize != tb->size)
+            stringresizeprotected(L, tb, hashsize); // table is too big
+    }
 }
 
+#ifdef LUAU_MULTITHREAD
+static void stopsweeper(lua_State* L);
+#endif
+
 static bool deletegco(void* context, lua_Page* page, GCObject* gco)
 {
     lua_State* L = (lua_State*)context;
@@ -723,14 +793,21 @@ void luaC_freeall(lua_State* L)
 
     LUAU_ASSERT(L == g->mainthread);
 
+#ifdef LUAU_MULTITHREAD
+    stopsweeper(L);
+#endif
+
     luaM_visitgco(L, L, deletegco);
 
     luaC_postgc(L);
 
-    for (int i = 0; i < g->strt.size; i++) // free all string lists
-        LUAU_ASSERT(g->strt.hash[i] == NULL);
+    for (int i = 0; i < LUA_STRSHARDS; i++)
+    {
+        for (int j = 0; j < g->strt[i].size; j++) // free all string lists
+            LUAU_ASSERT(g->strt[i].hash[j] == NULL);
 
-    LUAU_ASSERT(L->global->strt.nuse == 0);
+        LUAU_ASSERT(g->strt[i].nuse == 0);
+    }
 }
 
 static void markmt(global_State* g)
@@ -741,12 +818,28 @@ static void markmt(global_State* g)
             markobject(g, g->mt[i]);
 }
 
+// shapes stay in the shape table after the last table using them is collected, and transitions find them by key address, so
+// their keys live as long as the VM; every key of a shape is the last key of the shape itself or of one of its ancestors
+static void markshapes(global_State* g)
+{
+    shapetable* tb = &g->shapes;
+
+    for (int i = 0; i < tb->size; i++)
+        for (LuaShape* p = tb->hash[i]; p; p = p->hashnext)
+            stringmark(p->keys[p->count - 1]);
+}
+
 // mark root set
 static void markroot(lua_State* L)
 {
     global_State* g = L->global;
-    g->gray = NULL;
-    g->grayagain = NULL;
+    // when old objects kept their marks, the gray lists hold the remembered set that the minor collection starts from
+    g->gcminor = g->gcsticky;
+    if (!g->gcminor)
+    {
+        g->gray = NULL;
+        g->grayagain = NULL;
+    }
     g->weak = NULL;
     markobject(g, g->mainthread);
     // make global table be traversed before main stack
@@ -760,16 +853,20 @@ static size_t remarkupvals(global_State* g)
 {
     size_t work = 0;
 
-    for (UpVal* uv = g->uvhead.u.open.next; uv != &g->uvhead; uv = uv->u.open.next)
+    for (lua_State* th = g->twups; th; th = th->twups)
     {
-        work += sizeof(UpVal);
+        work += sizeof(lua_State);
 
-        LUAU_ASSERT(upisopen(uv));
-        LUAU_ASSERT(uv->u.open.next->u.open.prev == uv && uv->u.open.prev->u.open.next == uv);
-        LUAU_ASSERT(!isblack(obj2gco(uv))); // open upvalues are never black
+        for (UpVal* uv = th->openupval; uv; uv = uv->u.open.threadnext)
+        {
+            work += sizeof(UpVal);
 
-        if (isgray(obj2gco(uv)))
-            markvalue(g, uv->v);
+            LUAU_ASSERT(upisopen(uv));
+            LUAU_ASSERT(!isblack(obj2gco(uv))); // open upvalues are never black
+
+            if (isgray(obj2gco(uv)))
+                markvalue(g, uv->v);
+        }
     }
 
     return work;
@@ -781,34 +878,66 @@ static size_t clearupvals(lua_State* L)
 
     size_t work = 0;
 
-    for (UpVal* uv = g->uvhead.u.open.next; uv != &g->uvhead;)
+    for (lua_State** pth = &g->twups; *pth;)
     {
-        work += sizeof(UpVal);
+        lua_State* th = *pth;
 
-        LUAU_ASSERT(upisopen(uv));
-        LUAU_ASSERT(uv->u.open.next->u.open.prev == uv && uv->u.open.prev->u.open.next == uv);
-        LUAU_ASSERT(!isblack(obj2gco(uv))); // open upvalues are never black
-        LUAU_ASSERT(iswhite(obj2gco(uv)) || !iscollectable(uv->v) || !iswhite(gcvalue(uv->v)));
+        work += sizeof(lua_State);
+
+        for (UpVal** puv = &th->openupval; *puv;)
+        {
+            UpVal* uv = *puv;
+
+            work += sizeof(UpVal);
+
+            LUAU_ASSERT(upisopen(uv));
+            LUAU_ASSERT(!isblack(obj2gco(uv))); // open upvalues are never black
+            LUAU_ASSERT(iswhite(obj2gco(uv)) || !iscollectable(uv->v) || !iswhite(gcvalue(uv->v)));
+
+            // in a minor collection, old threads might not be traversed, but they are alive along with their upvalues
+            if (uv->markedopen || (g->gcminor && !iswhite(obj2gco(th))))
+            {
+                // upvalue is still open (belongs to alive thread)
+                LUAU_ASSERT(isgray(obj2gco(uv)));
+                uv->markedopen = 0; // for next cycle
+                puv = &uv->u.open.threadnext;
+            }
+            else
+            {
+                // upvalue is either dead, or alive but the thread is dead; unlink and close
+                *puv = uv->u.open.threadnext;
+                luaF_closeupval(L, uv, /* dead= */ iswhite(obj2gco(uv)));
+            }
+        }
 
-        if (uv->markedopen)
+        // threads without open upvalues leave the list, dead threads have just lost all of theirs
+        if (th->openupval)
         {
-            // upvalue is still open (belongs to alive thread)
-            LUAU_ASSERT(isgray(obj2gco(uv)));
-            uv->markedopen = 0; // for next cycle
-            uv = uv->u.open.next;
+            pth = &th->twups;
         }
         else
         {
-            // upvalue is either dead, or alive but the thread is dead; unlink and close
-            UpVal* next = uv->u.open.next;
-            luaF_closeupval(L, uv, /* dead= */ iswhite(obj2gco(uv)));
-            uv = next;
+            *pth = th->twups;
+            th->twups = th;
         }
     }
 
     return work;
 }
 
+static void rememberweak(global_State* g)
+{
+    for (GCObject* o = g->weak; o;)
+    {
+        LuaTable* h = gco2h(o);
+        o = h->gclist;
+
+        LUAU_ASSERT(isgray(obj2gco(h)));
+        h->gclist = g->grayagain;
+        g->grayagain = obj2gco(h);
+    }
+}
+
 static size_t atomic(lua_State* L)
 {
     global_State* g = L->global;
@@ -835,6 +964,7 @@ static size_t atomic(lua_State* L)
     LUAU_ASSERT(!iswhite(obj2gco(g->mainthread)));
     markobject(g, L); // mark running thread
     markmt(g);        // mark basic metatables (again)
+    markshapes(g);    // shapes can be created at any point of the cycle
     work += propagateall(g);
 
 #ifdef LUAI_GCMETRICS
@@ -852,8 +982,28 @@ static size_t atomic(lua_State* L)
 
     // remove collected objects from weak tables
     work += cleartable(L, g->weak);
+
+    // cached __index chains may refer to objects that are about to be freed
+    g->indexchains.gen++;
+
+    // in generational mode, survivors keep their marks unless the heap outgrew the last major collection, in which case this
+    // sweep turns them white for the next cycle to trace the whole heap
+    bool major = g->gcminor && g->gcstats.endtotalsizebytes > g->gcstats.majorbasebytes / 100 * (100 + g->gcgenmajormul);
+    g->gcsticky = g->gckind == GCKgenerational && !major;
+
+    // weak tables stay gray, so old ones have to be rescanned and cleared by every minor collection
+    if (g->gcsticky)
+        rememberweak(g);
+
     g->weak = NULL;
 
+    if (g->gcminor)
+        g->gcstats.minorcollections++;
+    else
+        g->gcstats.majorcollections++;
+
+    g->gcstats.promotedbytes = 0;
+
 #ifdef LUAI_GCMETRICS
     g->gcmetrics.currcycle.atomictimeclear += recordGcDeltaTime(currts);
 #endif
@@ -891,6 +1041,14 @@ static int sweepgcopage(lua_State* L, lua_Page* page)
 
     int newwhite = luaC_white(g);
 
+    bool sticky = g->gcsticky;
+    int alive = 0;
+    int young = 0;
+
+    // dead userdata with batch destructors stay busy until their batch is freed
+    Udata* batch[UDATA_BATCH];
+    int batched = 0;
+
     for (char* pos = start; pos != end; pos += blockSize)
     {
         GCObject* gco = (GCObject*)pos;
@@ -903,8 +1061,39 @@ static int sweepgcopage(lua_State* L, lua_Page* page)
         if ((gco->gch.marked ^ WHITEBITS) & deadmask)
         {
             LUAU_ASSERT(!isdead(g, gco));
-            // make it white (for next cycle)
-            gco->gch.marked = cast_byte((gco->gch.marked & maskmarks) | newwhite);
+            alive++;
+
+            if (!sticky)
+            {
+                // make it white (for next cycle)
+                gco->gch.marked = cast_byte((gco->gch.marked & maskmarks) | newwhite);
+            }
+            else if (iswhite(gco))
+            {
+                // allocated after the atomic stage
+                young++;
+            }
+            else if (!isold(gco))
+            {
+                // keep the mark and make it old
+                l_setbit(gco->gch.marked, OLDBIT);
+                g->gcstats.promotedbytes += blockSize;
+            }
+        }
+        else if (gco->gch.tt == LUA_TUSERDATA && udatabatched(g, gco2u(gco)))
+        {
+            LUAU_ASSERT(isdead(g, gco));
+            batch[batched++] = gco2u(gco);
+
+            if (batched == UDATA_BATCH)
+            {
+                busyBlocks -= batched;
+                luaU_freeudatabatch(L, batch, batched, page);
+                batched = 0;
+
+                if (busyBlocks == 0)
+                    return int(pos - start) / blockSize + 1;
+            }
         }
         else
         {
@@ -917,298 +1106,1302 @@ static int sweepgcopage(lua_State* L, lua_Page* page)
         }
     }
 
+    if (batched)
+    {
+        busyBlocks -= batched;
+        luaU_freeudatabatch(L, batch, batched, page);
+
+        if (busyBlocks == 0)
+            return int(end - start) / blockSize;
+    }
+
+    // busy blocks that weren't visited are held by allocation caches and will become young objects later
+    luaM_setyoungpage(page, !sticky || young != 0 || alive != busyBlocks);
+
     return int(end - start) / blockSize;
 }
 
-static size_t gcstep(lua_State* L, size_t limit)
+#ifdef LUAU_MULTITHREAD
+// destructors and execution callbacks may run arbitrary code, and threads own stacks, upvalues and allocation caches, so these objects
+// are always freed by the mutator
+static bool needsmutator(global_State* g, GCObject* o)
 {
-    size_t cost = 0;
-    global_State* g = L->global;
-    switch (g->gcstate)
+    switch (o->gch.tt)
     {
-    case GCSpause:
+    case LUA_TTHREAD:
+        return true;
+    case LUA_TPROTO:
+        return gco2p(o)->execdata != NULL;
+    case LUA_TUSERDATA:
     {
-        markroot(L); // start a new collection
-        LUAU_ASSERT(g->gcstate == GCSpropagate);
-        break;
+        Udata* u = gco2u(o);
+        return u->tag == UTAG_IDTOR || (u->tag < LUA_UTAG_LIMIT && (g->udatagc[u->tag] || g->udatagcbatch[u->tag]));
     }
-    case GCSpropagate:
-    {
-        while (g->gray && cost < limit)
-        {
-            cost += propagatemark(g);
-        }
+    default:
+        return false;
+    }
+}
 
-        if (!g->gray)
-        {
-#ifdef LUAI_GCMETRICS
-            g->gcmetrics.currcycle.propagatework = g->gcmetrics.currcycle.explicitwork + g->gcmetrics.currcycle.assistwork;
-#endif
+// a version of sweepgcopage that runs on the helper thread, see the background sweeping section above
+static void sweepbgpage(lua_State* L, lua_Page* page)
+{
+    char* start;
+    char* end;
+    int busyBlocks;
+    int blockSize;
+    luaM_getpagewalkinfo(page, &start, &end, &busyBlocks, &blockSize);
 
-            // perform one iteration over 'gray again' list
-            g->gray = g->grayagain;
-            g->grayagain = NULL;
+    LUAU_ASSERT(busyBlocks > 0);
 
-            g->gcstate = GCSpropagateagain;
-        }
-        break;
-    }
-    case GCSpropagateagain:
-    {
-        while (g->gray && cost < limit)
-        {
-            cost += propagatemark(g);
-        }
+    global_State* g = L->global;
+    sweepstate* ss = &g->sweeper;
 
-        if (!g->gray) // no more `gray' objects
-        {
-#ifdef LUAI_GCMETRICS
-            g->gcmetrics.currcycle.propagateagainwork =
-                g->gcmetrics.currcycle.explicitwork + g->gcmetrics.currcycle.assistwork - g->gcmetrics.currcycle.propagatework;
-#endif
+    int deadmask = otherwhite(g);
+    int newwhite = luaC_white(g);
 
-            g->gcstate = GCSatomic;
-        }
-        break;
-    }
-    case GCSatomic:
+    // dead strings have to leave the string table before the global lock is taken, as the mutator takes the shard lock first
+    for (char* pos = start; pos != end; pos += blockSize)
     {
-#ifdef LUAI_GCMETRICS
-        g->gcmetrics.currcycle.atomicstarttimestamp = lua_clock();
-        g->gcmetrics.currcycle.atomicstarttotalsizebytes = g->totalbytes;
-#endif
+        GCObject* gco = (GCObject*)pos;
 
-        g->gcstats.atomicstarttimestamp = lua_clock();
-        g->gcstats.atomicstarttotalsizebytes = g->totalbytes;
+        if (gco->gch.tt == LUA_TSTRING && isdead(g, gco))
+            luaS_unlinkdead(L, gco2ts(gco)); // the string stays alive if it was resurrected by a lookup
+    }
 
-        cost = atomic(L); // finish mark phase
+    bool deferred = false;
 
-        LUAU_ASSERT(g->gcstate == GCSsweep);
-        break;
-    }
-    case GCSsweep:
+    lualock_global();
+
+    for (char* pos = start; pos != end; pos += blockSize)
     {
-        while (g->sweepgcopage && cost < limit)
-        {
-            lua_Page* next = luaM_getnextpage(g->sweepgcopage); // page sweep might destroy the page
+        GCObject* gco = (GCObject*)pos;
 
-            int steps = sweepgcopage(L, g->sweepgcopage);
+        // skip memory blocks that are already freed
+        if (gco->gch.tt == LUA_TNIL)
+            continue;
 
-            g->sweepgcopage = next;
-            cost += steps * GC_SWEEPPAGESTEPCOST;
+        // is the object alive?
+        if ((gco->gch.marked ^ WHITEBITS) & deadmask)
+        {
+            // make it white (for next cycle)
+            gco->gch.marked = cast_byte((gco->gch.marked & maskmarks) | newwhite);
         }
-
-        // nothing more to sweep?
-        if (g->sweepgcopage == NULL)
+        else if (needsmutator(g, gco))
         {
-            // don't forget to visit main thread, it's the only object not allocated in GCO pages
-            LUAU_ASSERT(!isdead(g, obj2gco(g->mainthread)));
-            makewhite(g, obj2gco(g->mainthread)); // make it white (for next cycle)
-
-            shrinkbuffers(L);
+            deferred = true;
+        }
+        else
+        {
+            // strings were unlinked above
+            if (gco->gch.tt == LUA_TSTRING)
+            {
+                TString* ts = gco2ts(gco);
+                luaM_freegco(L, ts, sizestring(ts->len), ts->memcat, page);
+            }
+            else
+                freeobj(L, gco, page);
 
-            g->gcstate = GCSpause; // end collection
+            // if the last block was removed, page would be removed as well
+            if (--busyBlocks == 0)
+            {
+                luaunlock_global();
+                return;
+            }
         }
-        break;
-    }
-    default:
-        LUAU_ASSERT(!"Unexpected GC state");
     }
-    return cost;
-}
-
-static int64_t getheaptriggererroroffset(global_State* g)
-{
-    // adjust for error using Proportional-Integral controller
-    // https://en.wikipedia.org/wiki/PID_controller
-    int32_t errorKb = int32_t((g->gcstats.atomicstarttotalsizebytes - g->gcstats.heapgoalsizebytes) / 1024);
-
-    // we use sliding window for the error integral to avoid error sum 'windup' when the desired target cannot be reached
-    const size_t triggertermcount = sizeof(g->gcstats.triggerterms) / sizeof(g->gcstats.triggerterms[0]);
 
-    int32_t* slot = &g->gcstats.triggerterms[g->gcstats.triggertermpos % triggertermcount];
-    int32_t prev = *slot;
-    *slot = errorKb;
-    g->gcstats.triggerintegral += errorKb - prev;
-    g->gcstats.triggertermpos++;
+    luaM_setyoungpage(page, true);
+    luaM_pushgcopage(deferred ? &ss->deferred : &ss->swept, page);
 
-    // controller tuning
-    // https://en.wikipedia.org/wiki/Ziegler%E2%80%93Nichols_method
-    const double Ku = 0.9; // ultimate gain (measured)
-    const double Tu = 2.5; // oscillation period (measured)
+    luaunlock_global();
+}
 
-    const double Kp = 0.45 * Ku; // proportional gain
-    const double Ti = 0.8 * Tu;
-    const double Ki = 0.54 * Ku / Ti; // integral gain
+static void sweeperthread(global_State* g)
+{
+    sweepstate* ss = &g->sweeper;
 
-    double proportionalTerm = Kp * errorKb;
-    double integralTerm = Ki * g->gcstats.triggerintegral;
+    std::unique_lock<std::mutex> guard(ss->mutex);
 
-    double totalTerm = proportionalTerm + integralTerm;
+    for (;;)
+    {
+        while (!ss->pages && !ss->quit)
+            ss->cond.wait(guard);
 
-    return int64_t(totalTerm * 1024);
-}
+        if (!ss->pages)
+            break;
 
-static size_t getheaptrigger(global_State* g, size_t heapgoal)
-{
-    // adjust threshold based on a guess of how many bytes will be allocated between the cycle start and sweep phase
-    // our goal is to begin the sweep when used memory has reached the heap goal
-    const double durationthreshold = 1e-3;
-    double allocationduration = g->gcstats.atomicstarttimestamp - g->gcstats.endtimestamp;
+        lua_Page* pages = ss->pages;
+        ss->pages = NULL;
 
-    // avoid measuring intervals smaller than 1ms
-    if (allocationduration < durationthreshold)
-        return heapgoal;
+        guard.unlock();
 
-    double allocationrate = (g->gcstats.atomicstarttotalsizebytes - g->gcstats.endtotalsizebytes) / allocationduration;
-    double markduration = g->gcstats.atomicstarttimestamp - g->gcstats.starttimestamp;
+        while (lua_Page* page = luaM_takegcopage(&pages))
+            sweepbgpage(ss->state, page);
 
-    int64_t expectedgrowth = int64_t(markduration * allocationrate);
-    int64_t offset = getheaptriggererroroffset(g);
-    int64_t heaptrigger = heapgoal - (expectedgrowth + offset);
+        guard.lock();
 
-    // clamp the trigger between memory use at the end of the cycle and the heap goal
-    return heaptrigger < int64_t(g->totalbytes) ? g->totalbytes : (heaptrigger > int64_t(heapgoal) ? heapgoal : size_t(heaptrigger));
+        ss->busy = false;
+        ss->cond.notify_all();
+    }
 }
 
-size_t luaC_step(lua_State* L, bool assist)
+static bool startbgsweep(lua_State* L)
 {
     global_State* g = L->global;
+    sweepstate* ss = &g->sweeper;
 
-    int lim = g->gcstepsize * g->gcstepmul / 100; // how much to work
-    LUAU_ASSERT(g->totalbytes >= g->GCthreshold);
-    size_t debt = g->totalbytes - g->GCthreshold;
+    // generational sweeps keep the marks and track young pages, which is left to the mutator
+    // region pages have to stay with the mutator, since they are released whenever the region is popped
+    // heap queries keep cursors into the list of pages, which the sweeper takes apart
+    if (!g->gcbgsweep || g->gcsticky || g->region.owner || g->heapcursors)
+        return false;
 
-    GC_INTERRUPT(0);
+    if (!ss->state)
+    {
+        lua_State* helper = (lua_State*)(*g->frealloc)(g->ud, NULL, 0, sizeof(lua_State));
+        if (!helper)
+            return false;
 
-    if (!lualock_gcstep()) return 0;
-    // at the start of the new cycle
-    if (g->gcstate == GCSpause)
-        g->gcstats.starttimestamp = lua_clock();
+        luaE_inithelper(L, helper);
+        ss->state = helper;
+    }
 
-#ifdef LUAI_GCMETRICS
-    if (g->gcstate == GCSpause)
-        startGcCycleMetrics(g);
+    if (!ss->thread.joinable())
+    {
+        ss->quit = false;
+
+        try
+        {
+            ss->thread = std::thread(sweeperthread, g);
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    // a thread that is being attached waits for the sweep as soon as the helper is attached, so the sweep has to be marked as started first
+    {
+        std::unique_lock<std::mutex> guard(ss->mutex);
+        ss->busy = true;
+    }
+
+    if (!luaE_attachhelper(L, 1))
+    {
+        std::unique_lock<std::mutex> guard(ss->mutex);
+        ss->busy = false;
+        ss->cond.notify_all();
+        return false;
+    }
+
+    ss->active = true;
+    g->sweepgcopage = NULL;
+
+    std::unique_lock<std::mutex> guard(ss->mutex);
+    ss->pages = luaM_detachgcopages(L);
+    ss->cond.notify_all();
+
+    return true;
+}
+
+static void stopsweeperthread(global_State* g)
+{
+    sweepstate* ss = &g->sweeper;
+
+    if (ss->thread.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> guard(ss->mutex);
+            ss->quit = true;
+            ss->cond.notify_all();
+        }
+
+        ss->thread.join();
+    }
+
+    if (ss->state)
+    {
+        (*g->frealloc)(g->ud, ss->state, sizeof(lua_State), 0);
+        ss->state = NULL;
+    }
+}
+
+// links the pages the helper thread is done with back into the heap; pages with objects left for the mutator are queued for sweepbgstep
+static void takesweptpages(lua_State* L)
+{
+    sweepstate* ss = &L->global->sweeper;
+
+    lualock_global();
+
+    while (lua_Page* page = luaM_popgcopage(&ss->swept))
+    {
+        luaM_linkgcopage(L, page);
+        luaM_releasegcopage(L, page);
+    }
+
+    while (lua_Page* page = luaM_popgcopage(&ss->deferred))
+    {
+        luaM_linkgcopage(L, page);
+        luaM_pushgcopage(&ss->pending, page);
+    }
+
+    luaunlock_global();
+}
+
+// mutator side of the background sweep, returns true once the entire heap is swept
+static bool sweepbgstep(lua_State* L, size_t limit, size_t* cost)
+{
+    global_State* g = L->global;
+    sweepstate* ss = &g->sweeper;
+
+    // a full collection can't leave the sweep unfinished
+    if (limit == SIZE_MAX)
+        luaC_waitsweep(L);
+
+    bool busy;
+
+    {
+        std::unique_lock<std::mutex> guard(ss->mutex);
+        busy = ss->busy;
+    }
+
+    takesweptpages(L);
+
+    while (ss->pending && *cost < limit)
+    {
+        lualock_global();
+        lua_Page* page = luaM_popgcopage(&ss->pending);
+        luaM_releasegcopage(L, page);
+        luaunlock_global();
+
+        *cost += sweepgcopage(L, page) * GC_SWEEPPAGESTEPCOST;
+    }
+
+    if (busy || ss->pending)
+    {
+        // sweeping happens on the helper thread, the step is accounted for as if it did the work so that the pacer doesn't call it again right away
+        if (*cost < limit)
+            *cost = limit;
+
+        return false;
+    }
+
+    ss->active = false;
+    luaE_attachhelper(L, -1);
+
+    return true;
+}
+
+void luaC_waitsweep(lua_State* L)
+{
+    sweepstate* ss = &L->global->sweeper;
+
+    std::unique_lock<std::mutex> guard(ss->mutex);
+
+    while (ss->busy)
+        ss->cond.wait(guard);
+}
+
+void luaC_syncsweep(lua_State* L)
+{
+    if (!luaC_bgsweeping(L->global))
+        return;
+
+    // objects left for the mutator stay in the heap until the sweep finishes, like objects in pages that a regular sweep didn't reach yet
+    luaC_waitsweep(L);
+    takesweptpages(L);
+}
+
+void luaC_finishsweep(lua_State* L)
+{
+    size_t cost = 0;
+
+    if (luaC_bgsweeping(L->global))
+        sweepbgstep(L, SIZE_MAX, &cost);
+}
+
+static void stopsweeper(lua_State* L)
+{
+    global_State* g = L->global;
+    sweepstate* ss = &g->sweeper;
+
+    if (ss->active)
+    {
+        luaC_syncsweep(L);
+
+        // the remaining objects are freed by the caller
+        while (lua_Page* page = luaM_popgcopage(&ss->pending))
+            luaM_releasegcopage(L, page);
+
+        ss->active = false;
+        luaE_attachhelper(L, -1);
+    }
+
+    stopsweeperthread(g);
+}
+#endif
+
+// the end of a cycle closes the window over which allocation counters report per-cycle values
+static void marktypecounters(global_State* g)
+{
+    for (int memcat = 0; memcat < LUA_MEMORY_CATEGORIES; ++memcat)
+    {
+        for (int slot = 0; slot < LUA_TYPECOUNTERS; ++slot)
+        {
+            lua_TypeCounters* c = &g->typecounters[memcat][slot];
+
+            uint64_t allocbytes = c->allocbytes;
+            uint64_t freebytes = c->freebytes;
+
+            c->cycleallocbytes = allocbytes - c->markallocbytes;
+            c->cyclefreebytes = freebytes - c->markfreebytes;
+            c->markallocbytes = allocbytes;
+            c->markfreebytes = freebytes;
+        }
+    }
+
+    double now = lua_clock();
+
+    g->typecounterscycle = now - g->typecountersmark;
+    g->typecountersmark = now;
+}
+
+static size_t gcstep(lua_State* L, size_t limit)
+{
+    size_t cost = 0;
+    global_State* g = L->global;
+    switch (g->gcstate)
+    {
+    case GCSpause:
+    {
+#ifdef LUAU_MULTITHREAD
+        // background sweeping was turned off
+        if (!g->gcbgsweep && g->sweeper.thread.joinable())
+            stopsweeperthread(g);
+#endif
+
+        if (g->gcsticky && g->gckind != GCKgenerational)
+        {
+            // leaving generational mode, old objects need to be made white before the next cycle can mark them
+            g->gcsticky = false;
+            g->gcminor = false;
+            g->sweepgcopage = g->allgcopages;
+            g->gcstate = GCSsweep;
+            break;
+        }
+
+        markroot(L); // start a new collection
+        LUAU_ASSERT(g->gcstate == GCSpropagate);
+        break;
+    }
+    case GCSpropagate:
+    {
+        while (g->gray && cost < limit)
+        {
+            cost += propagatemark(g);
+        }
+
+        if (!g->gray)
+        {
+#ifdef LUAI_GCMETRICS
+            g->gcmetrics.currcycle.propagatework = g->gcmetrics.currcycle.explicitwork + g->gcmetrics.currcycle.assistwork;
+#endif
+
+            // perform one iteration over 'gray again' list
+            g->gray = g->grayagain;
+            g->grayagain = NULL;
+
+            g->gcstate = GCSpropagateagain;
+        }
+        break;
+    }
+    case GCSpropagateagain:
+    {
+        while (g->gray && cost < limit)
+        {
+            cost += propagatemark(g);
+        }
+
+        if (!g->gray) // no more `gray' objects
+        {
+#ifdef LUAI_GCMETRICS
+            g->gcmetrics.currcycle.propagateagainwork =
+                g->gcmetrics.currcycle.explicitwork + g->gcmetrics.currcycle.assistwork - g->gcmetrics.currcycle.propagatework;
+#endif
+
+            g->gcstate = GCSatomic;
+        }
+        break;
+    }
+    case GCSatomic:
+    {
+#ifdef LUAI_GCMETRICS
+        g->gcmetrics.currcycle.atomicstarttimestamp = lua_clock();
+        g->gcmetrics.currcycle.atomicstarttotalsizebytes = g->totalbytes;
+#endif
+
+        g->gcstats.atomicstarttimestamp = lua_clock();
+        g->gcstats.atomicstarttotalsizebytes = g->totalbytes;
+
+        cost = atomic(L); // finish mark phase
+
+        LUAU_ASSERT(g->gcstate == GCSsweep);
+
+#ifdef LUAU_MULTITHREAD
+        // a full collection sweeps right away, so there is nothing to gain from the helper thread
+        if (limit != SIZE_MAX)
+            startbgsweep(L);
+#endif
+        break;
+    }
+    case GCSsweep:
+    {
+#ifdef LUAU_MULTITHREAD
+        if (luaC_bgsweeping(g) && !sweepbgstep(L, limit, &cost))
+            break;
+#endif
+
+        // after a minor collection, dead objects can only be found in pages with young objects
+        bool youngonly = g->gcminor && g->gcsticky;
+
+        while (g->sweepgcopage && cost < limit)
+        {
+            lua_Page* next = luaM_getnextpage(g->sweepgcopage); // page sweep might destroy the page
+
+            int steps = youngonly && !luaM_isyoungpage(g->sweepgcopage) ? 1 : sweepgcopage(L, g->sweepgcopage);
+
+            g->sweepgcopage = next;
+            cost += steps * GC_SWEEPPAGESTEPCOST;
+        }
+
+        // nothing more to sweep?
+        if (g->sweepgcopage == NULL)
+        {
+            // don't forget to visit main thread, it's the only object not allocated in GCO pages
+            LUAU_ASSERT(!isdead(g, obj2gco(g->mainthread)));
+            if (g->gcsticky)
+                l_setbit(g->mainthread->marked, OLDBIT);
+            else
+                makewhite(g, obj2gco(g->mainthread)); // make it white (for next cycle)
+
+            if (g->gcsticky && !g->gcminor)
+                g->gcstats.majorbasebytes = g->totalbytes;
+
+            shrinkbuffers(L);
+
+            if (g->typecounters)
+                marktypecounters(g);
+
+            g->gcstate = GCSpause; // end collection
+        }
+        break;
+    }
+    default:
+        LUAU_ASSERT(!"Unexpected GC state");
+    }
+    return cost;
+}
+
+static int64_t getheaptriggererroroffset(global_State* g)
+{
+    // adjust for error using Proportional-Integral controller
+    // https://en.wikipedia.org/wiki/PID_controller
+    int32_t errorKb = int32_t((g->gcstats.atomicstarttotalsizebytes - g->gcstats.heapgoalsizebytes) / 1024);
+
+    // we use sliding window for the error integral to avoid error sum 'windup' when the desired target cannot be reached
+    const size_t triggertermcount = sizeof(g->gcstats.triggerterms) / sizeof(g->gcstats.triggerterms[0]);
+
+    int32_t* slot = &g->gcstats.triggerterms[g->gcstats.triggertermpos % triggertermcount];
+    int32_t prev = *slot;
+    *slot = errorKb;
+    g->gcstats.triggerintegral += errorKb - prev;
+    g->gcstats.triggertermpos++;
+
+    // controller tuning
+    // https://en.wikipedia.org/wiki/Ziegler%E2%80%93Nichols_method
+    const double Ku = 0.9; // ultimate gain (measured)
+    const double Tu = 2.5; // oscillation period (measured)
+
+    const double Kp = 0.45 * Ku; // proportional gain
+    const double Ti = 0.8 * Tu;
+    const double Ki = 0.54 * Ku / Ti; // integral gain
+
+    double proportionalTerm = Kp * errorKb;
+    double integralTerm = Ki * g->gcstats.triggerintegral;
+
+    double totalTerm = proportionalTerm + integralTerm;
+
+    return int64_t(totalTerm * 1024);
+}
+
+static size_t getheaptrigger(global_State* g, size_t heapgoal)
+{
+    // adjust threshold based on a guess of how many bytes will be allocated between the cycle start and sweep phase
+    // our goal is to begin the sweep when used memory has reached the heap goal
+    const double durationthreshold = 1e-3;
+    double allocationduration = g->gcstats.atomicstarttimestamp - g->gcstats.endtimestamp;
+
+    // avoid measuring intervals smaller than 1ms
+    if (allocationduration < durationthreshold)
+        return heapgoal;
+
+    double allocationrate = (g->gcstats.atomicstarttotalsizebytes - g->gcstats.endtotalsizebytes) / allocationduration;
+    double markduration = g->gcstats.atomicstarttimestamp - g->gcstats.starttimestamp;
+
+    int64_t expectedgrowth = int64_t(markduration * allocationrate);
+    int64_t offset = getheaptriggererroroffset(g);
+    int64_t heaptrigger = heapgoal - (expectedgrowth + offset);
+
+    // clamp the trigger between memory use at the end of the cycle and the heap goal
+    return heaptrigger < int64_t(g->totalbytes) ? g->totalbytes : (heaptrigger > int64_t(heapgoal) ? heapgoal : size_t(heaptrigger));
+}
+
+// in generational mode, the next minor collection starts once the application allocates a fraction of the heap
+static size_t getminorthreshold(global_State* g)
+{
+    return g->totalbytes + g->totalbytes / 100 * g->gcgenminormul;
+}
+
+size_t luaC_step(lua_State* L, bool assist)
+{
+    global_State* g = L->global;
+
+    int lim = g->gcstepsize * g->gcstepmul / 100; // how much to work
+
+    GC_INTERRUPT(0);
+
+    if (!lualock_gcstep())
+    {
+        // another thread ran the step, or the running threads couldn't be stopped in time; retry after some more allocations
+        if (g->GCthreshold <= g->totalbytes)
+            g->GCthreshold = g->totalbytes + g->gcstepsize;
+        return 0;
+    }
+
+    // with threads, another thread may have run a step since our caller checked the threshold
+    if (g->totalbytes < g->GCthreshold)
+    {
+        luaunlock_gcstep();
+        return 0;
+    }
+
+    size_t debt = g->totalbytes - g->GCthreshold;
+    // at the start of the new cycle
+    if (g->gcstate == GCSpause)
+        g->gcstats.starttimestamp = lua_clock();
+
+#ifdef LUAI_GCMETRICS
+    if (g->gcstate == GCSpause)
+        startGcCycleMetrics(g);
 
     double lasttimestamp = lua_clock();
 #endif
 
-    int lastgcstate = g->gcstate;
+    int lastgcstate = g->gcstate;
+
+    size_t work = gcstep(L, lim);
+
+#ifdef LUAI_GCMETRICS
+    recordGcStateStep(g, lastgcstate, lua_clock() - lasttimestamp, assist, work);
+#endif
+
+    size_t actualstepsize = work * 100 / g->gcstepmul;
+
+    // at the end of the last cycle
+    if (g->gcstate == GCSpause)
+    {
+        if (g->gcsticky)
+        {
+            size_t heapgoal = getminorthreshold(g);
+
+            g->GCthreshold = heapgoal;
+
+            g->gcstats.heapgoalsizebytes = heapgoal;
+        }
+        else if (g->gckind == GCKgenerational)
+        {
+            // the heap was made white for a major collection, which starts right away
+            g->GCthreshold = g->totalbytes;
+
+            g->gcstats.heapgoalsizebytes = g->totalbytes;
+        }
+        else
+        {
+            // at the end of a collection cycle, set goal based on gcgoal setting
+            size_t heapgoal = (g->totalbytes / 100) * g->gcgoal;
+            size_t heaptrigger = getheaptrigger(g, heapgoal);
+
+            g->GCthreshold = heaptrigger;
+
+            g->gcstats.heapgoalsizebytes = heapgoal;
+        }
+        g->gcstats.endtimestamp = lua_clock();
+        g->gcstats.endtotalsizebytes = g->totalbytes;
+
+#ifdef LUAI_GCMETRICS
+        finishGcCycleMetrics(g);
+#endif
+    }
+    else
+    {
+        g->GCthreshold = g->totalbytes + actualstepsize;
+
+        // compensate if GC is "behind schedule" (has some debt to pay)
+        if (g->GCthreshold >= debt)
+            g->GCthreshold -= debt;
+    }
+
+    luaunlock_gcstep();
+
+    GC_INTERRUPT(lastgcstate);
+    luaC_postgc(L);
+
+    return actualstepsize;
+}
+
+static void fullgc(lua_State* L)
+{
+    global_State* g = L->global;
+
+#ifdef LUAI_GCMETRICS
+    if (g->gcstate == GCSpause)
+        startGcCycleMetrics(g);
+#endif
+
+    if (keepinvariant(g))
+    {
+        // reset sweep marks to sweep all elements (returning them to white)
+        g->sweepgcopage = g->allgcopages;
+        // reset other collector lists
+        g->gray = NULL;
+        g->grayagain = NULL;
+        g->weak = NULL;
+        g->gcstate = GCSsweep;
+        // old objects have to be made white as well
+        g->gcsticky = false;
+        g->gcminor = false;
+    }
+    LUAU_ASSERT(g->gcstate == GCSpause || g->gcstate == GCSsweep);
+    // finish any pending sweep phase
+    while (g->gcstate != GCSpause)
+    {
+        LUAU_ASSERT(g->gcstate == GCSsweep);
+        gcstep(L, SIZE_MAX);
+    }
+
+    // clear markedopen bits for all open upvalues; these might be stuck from half-finished mark prior to full gc
+    for (lua_State* th = g->twups; th; th = th->twups)
+    {
+        for (UpVal* uv = th->openupval; uv; uv = uv->u.open.threadnext)
+        {
+            LUAU_ASSERT(upisopen(uv));
+            uv->markedopen = 0;
+        }
+    }
+
+#ifdef LUAI_GCMETRICS
+    finishGcCycleMetrics(g);
+    startGcCycleMetrics(g);
+#endif
+
+    // run a full collection cycle
+    markroot(L);
+    while (g->gcstate != GCSpause)
+    {
+        gcstep(L, SIZE_MAX);
+    }
+    // reclaim as much buffer memory as possible (shrinkbuffers() called during sweep is incremental)
+    shrinkbuffersfull(L);
+
+    size_t heapgoalsizebytes = (g->totalbytes / 100) * g->gcgoal;
+
+    if (g->gcsticky)
+    {
+        g->GCthreshold = getminorthreshold(g);
+    }
+    else
+    {
+        // trigger cannot be correctly adjusted after a forced full GC.
+        // we will try to place it so that we can reach the goal based on
+        // the rate at which we run the GC relative to allocation rate
+        // and on amount of bytes we need to traverse in propagation stage.
+        // goal and stepmul are defined in percents
+        g->GCthreshold = g->totalbytes * (g->gcgoal * g->gcstepmul / 100 - 100) / g->gcstepmul;
+
+        // but it might be impossible to satisfy that directly
+        if (g->GCthreshold < g->totalbytes)
+            g->GCthreshold = g->totalbytes;
+    }
+
+    g->gcstats.heapgoalsizebytes = heapgoalsizebytes;
+
+#ifdef LUAI_GCMETRICS
+    finishGcCycleMetrics(g);
+#endif
+}
+
+void luaC_fullgc(lua_State* L)
+{
+    if (!lualock_gcstep())
+        return;
+
+    fullgc(L);
+
+    luaunlock_gcstep();
+
+    // a full collection is how applications give memory back, which includes the pages kept for reuse
+    luaM_trimlargepool(L, 0);
+    luaM_trimregion(L);
+
+    luaC_postgc(L);
+}
+
+static void pinvalue(TValue* o)
+{
+    if (ttisstring(o) || ttistable(o))
+        l_setbit(gcvalue(o)->gch.marked, PINNEDBIT);
+}
+
+static void pinstack(lua_State* l)
+{
+    for (CallInfo* ci = l->base_ci; ci <= l->ci; ci++)
+    {
+        if (isLua(ci))
+            continue;
+
+        // C functions may hold pointers into the strings and tables of their frame and of their upvalues
+        StkId top = ci == l->ci ? l->top : (ci + 1)->func;
+        for (StkId o = ci->base; o < top; o++)
+            pinvalue(o);
+
+        if (ttisfunction(ci->func) && clvalue(ci->func)->isC)
+        {
+            Closure* cl = clvalue(ci->func);
+            for (int i = 0; i < cl->nupvalues; i++)
+                pinvalue(&cl->c.upvals[i]);
+        }
+    }
+}
+
+static bool pinobject(void* context, lua_Page* page, GCObject* gco)
+{
+    switch (gco->gch.tt)
+    {
+    case LUA_TTABLE:
+    {
+        LuaTable* h = gco2h(gco);
+
+        // shared tables are locked by address
+        if (testbit(h->marked, SHAREDBIT))
+            l_setbit(h->marked, PINNEDBIT);
+
+        // tables used as keys are hashed by address
+        for (int i = 0; i < sizenode(h); i++)
+        {
+            LuaNode* n = gnode(h, i);
+            if (n->key.tt == LUA_TTABLE && !ttisnil(gval(n)))
+                l_setbit(n->key.value.gc->gch.marked, PINNEDBIT);
+        }
+
+        break;
+    }
+    case LUA_TTHREAD:
+        pinstack(gco2th(gco));
+        break;
+    case LUA_TPROTO:
+    {
+        Proto* p = gco2p(gco);
+
+        // native code may refer to the constants directly
+        if (p->execdata)
+            for (int i = 0; i < p->sizek; i++)
+                pinvalue(&p->k[i]);
+        break;
+    }
+    }
+
+    return false;
+}
+
+static bool canmove(GCObject* gco)
+{
+    return (gco->gch.tt == LUA_TSTRING || gco->gch.tt == LUA_TTABLE) && !testbits(gco->gch.marked, bitmask(FIXEDBIT) | bitmask(PINNEDBIT));
+}
+
+#define forwardobject(t, p) \
+    { \
+        if ((p) && testbit(cast_to(GCObject*, p)->gch.marked, MOVEDBIT)) \
+            (p) = cast_to(t*, luaM_forwardgco(cast_to(GCObject*, p))); \
+    }
+
+static void forwardvalue(TValue* o)
+{
+    if (iscollectable(o) && testbit(gcvalue(o)->gch.marked, MOVEDBIT))
+        o->value.gc = luaM_forwardgco(gcvalue(o));
+}
+
+static void forwardvalues(TValue* o, int size)
+{
+    for (int i = 0; i < size; i++)
+        forwardvalue(&o[i]);
+}
+
+static void forwardtable(LuaTable* h)
+{
+    forwardobject(LuaTable, h->metatable);
+    forwardvalues(h->array, h->sizearray);
+
+    for (int i = 0; i < sizenode(h); i++)
+    {
+        LuaNode* n = gnode(h, i);
+
+        // keys of removed entries may refer to objects that are already freed, they are only ever compared by address
+        if (ttisnil(gval(n)))
+            continue;
 
-    size_t work = gcstep(L, lim);
+        forwardvalue(gval(n));
 
-#ifdef LUAI_GCMETRICS
-    recordGcStateStep(g, lastgcstate, lua_clock() - lasttimestamp, assist, work);
-#endif
+        if (n->key.tt >= LUA_TSTRING && n->key.tt != LUA_TDEADKEY && testbit(n->key.value.gc->gch.marked, MOVEDBIT))
+            n->key.value.gc = luaM_forwardgco(n->key.value.gc);
+    }
 
-    size_t actualstepsize = work * 100 / g->gcstepmul;
+    if (isshaped(h))
+        forwardvalues(gshaped(h)->slots, gshaped(h)->shape->count);
+}
 
-    // at the end of the last cycle
-    if (g->gcstate == GCSpause)
-    {
-        // at the end of a collection cycle, set goal based on gcgoal setting
-        size_t heapgoal = (g->totalbytes / 100) * g->gcgoal;
-        size_t heaptrigger = getheaptrigger(g, heapgoal);
+static void forwardthread(lua_State* l)
+{
+    forwardobject(LuaTable, l->gt);
+    forwardobject(TString, l->namecall);
+
+    // stack slots past the top are not marked, so they may refer to objects that are already freed
+    for (StkId o = l->stack; o < l->top; o++)
+        forwardvalue(o);
+}
 
-        g->GCthreshold = heaptrigger;
+static void forwardproto(Proto* p)
+{
+    forwardobject(TString, p->source);
+    forwardobject(TString, p->debugname);
+    forwardobject(TString, p->pseudocode);
+    forwardvalues(p->k, p->sizek);
 
-        g->gcstats.heapgoalsizebytes = heapgoal;
-        g->gcstats.endtimestamp = lua_clock();
-        g->gcstats.endtotalsizebytes = g->totalbytes;
+    for (int i = 0; i < p->sizeupvalues; i++)
+        forwardobject(TString, p->upvalues[i]);
 
-#ifdef LUAI_GCMETRICS
-        finishGcCycleMetrics(g);
-#endif
+    for (int i = 0; i < p->sizelocvars; i++)
+        forwardobject(TString, p->locvars[i].varname);
+}
+
+static bool forwardrefs(void* context, lua_Page* page, GCObject* gco)
+{
+    resetbit(gco->gch.marked, PINNEDBIT);
+
+    switch (gco->gch.tt)
+    {
+    case LUA_TTABLE:
+        forwardtable(gco2h(gco));
+        break;
+    case LUA_TFUNCTION:
+    {
+        Closure* cl = gco2cl(gco);
+        forwardobject(LuaTable, cl->env);
+        forwardvalues(cl->isC ? cl->c.upvals : cl->l.uprefs, cl->nupvalues);
+        break;
     }
-    else
+    case LUA_TUSERDATA:
+        forwardobject(LuaTable, gco2u(gco)->metatable);
+        break;
+    case LUA_TTHREAD:
+        forwardthread(gco2th(gco));
+        break;
+    case LUA_TPROTO:
+        forwardproto(gco2p(gco));
+        break;
+    case LUA_TUPVAL:
     {
-        g->GCthreshold = g->totalbytes + actualstepsize;
+        UpVal* uv = gco2uv(gco);
+        if (!upisopen(uv))
+            forwardvalue(&uv->u.value);
+        break;
+    }
+    }
 
-        // compensate if GC is "behind schedule" (has some debt to pay)
-        if (g->GCthreshold >= debt)
-            g->GCthreshold -= debt;
+    return false;
+}
+
+static GCObject** gclistof(GCObject* o)
+{
+    switch (o->gch.tt)
+    {
+    case LUA_TTABLE:
+        return &gco2h(o)->gclist;
+    case LUA_TFUNCTION:
+        return &gco2cl(o)->gclist;
+    case LUA_TTHREAD:
+        return &gco2th(o)->gclist;
+    case LUA_TPROTO:
+        return &gco2p(o)->gclist;
+    default:
+        LUAU_ASSERT(!"Unexpected object in gray list");
+        return NULL;
+    }
+}
+
+static void forwardlist(GCObject** l)
+{
+    for (; *l; l = gclistof(*l))
+        forwardobject(GCObject, *l);
+}
+
+static void forwardroots(lua_State* L)
+{
+    global_State* g = L->global;
+
+    for (int i = 0; i < LUA_STRSHARDS; i++)
+    {
+        stringtable* tb = &g->strt[i];
+
+        for (int j = 0; j < tb->size; j++)
+            for (TString** p = &tb->hash[j]; *p; p = &(*p)->next)
+                forwardobject(TString, *p);
+    }
+
+    for (int i = 0; i < LUA_T_COUNT; i++)
+    {
+        forwardobject(LuaTable, g->mt[i]);
+        forwardobject(TString, g->ttname[i]);
     }
 
+    for (int i = 0; i < TM_N; i++)
+        forwardobject(TString, g->tmname[i]);
+
+    for (int i = 0; i < LUA_UTAG_LIMIT; i++)
+        forwardobject(LuaTable, g->udatamt[i]);
+
+    for (int i = 0; i < LUA_LUTAG_LIMIT; i++)
+        forwardobject(TString, g->lightuserdataname[i]);
+
+    for (size_t i = 0; i < g->ttoken.size(); i++)
+        forwardobject(TString, g->ttoken[i]);
+
+    // every shape has its own copy of the keys of its parent
+    for (int i = 0; i < g->shapes.size; i++)
+        for (LuaShape* p = g->shapes.hash[i]; p; p = p->hashnext)
+            for (int j = 0; j < p->count; j++)
+                forwardobject(TString, p->keys[j]);
+
+    forwardvalue(&g->registry);
+    forwardthread(g->mainthread);
+
+    // in generational mode, the remembered set is kept between cycles
+    forwardlist(&g->gray);
+    forwardlist(&g->grayagain);
+    forwardlist(&g->weak);
+}
+
+size_t luaC_compact(lua_State* L, int occupancy)
+{
+    global_State* g = L->global;
+
+    // heap queries refer to objects by address
+    if (g->heapcursors)
+        return 0;
+
+    if (!lualock_gcstep())
+        return 0;
+
+    // only objects that survive a full collection are worth moving, and no collection is in progress once it's done
+    fullgc(L);
+
+    LUAU_ASSERT(g->gcstate == GCSpause);
+
+    // objects that C code may still refer to by address stay in place
+    luaM_visitgco(L, NULL, pinobject);
+    pinstack(g->mainthread);
+
+    size_t movedbytes = 0;
+    lua_Page* evacuated = luaM_evacuategcopages(L, occupancy, canmove, &movedbytes);
+
+    // redirect all references to the objects that were moved, pinned objects are unpinned on the way
+    luaM_visitgco(L, NULL, forwardrefs);
+    forwardroots(L);
+
+    size_t releasedbytes = luaM_freeevacuatedpages(L, evacuated);
+
+    // cached __index chains refer to tables by address
+    g->indexchains.gen++;
+
+    g->gcstats.compactions++;
+    g->gcstats.compactmovedbytes = movedbytes;
+    g->gcstats.compactreleasedbytes = releasedbytes;
+
     luaunlock_gcstep();
 
-    GC_INTERRUPT(lastgcstate);
     luaC_postgc(L);
 
-    return actualstepsize;
+    return releasedbytes;
 }
 
-void luaC_fullgc(lua_State* L)
+static size_t gcosize(GCObject* o)
+{
+    switch (o->gch.tt)
+    {
+    case LUA_TSTRING:
+        return sizestring(gco2ts(o)->len);
+    case LUA_TTABLE:
+        return sizeof(LuaTable);
+    case LUA_TFUNCTION:
+        return gco2cl(o)->isC ? sizeCclosure(gco2cl(o)->nupvalues) : sizeLclosure(gco2cl(o)->nupvalues);
+    case LUA_TUSERDATA:
+        return sizeudata(gco2u(o)->len);
+    case LUA_TTHREAD:
+        return sizeof(lua_State);
+    case LUA_TBUFFER:
+        return sizebuffer(gco2buf(o)->len);
+    case LUA_TPROTO:
+        return sizeof(Proto);
+    case LUA_TUPVAL:
+        return sizeof(UpVal);
+    default:
+        LUAU_ASSERT(!"Unexpected object type");
+        return 0;
+    }
+}
+
+static bool counttypes(void* context, lua_Page* page, GCObject* gco)
+{
+    global_State* g = (global_State*)context;
+    lua_TypeCounters* c = &g->typecounters[gco->gch.memcat][typecounterslot(gco->gch.tt)];
+
+    c->allocs += 1;
+    c->allocbytes += gcosize(gco);
+
+    return false;
+}
+
+bool luaC_settypecounters(lua_State* L, bool enable)
 {
     global_State* g = L->global;
 
-    if (!lualock_gcstep()) return;
+    // other threads update the counters as they allocate, so they can only be replaced while the world is stopped
+    while (!lualock_gcstep())
+    {
+    }
 
-#ifdef LUAI_GCMETRICS
-    if (g->gcstate == GCSpause)
-        startGcCycleMetrics(g);
+#ifdef LUAU_MULTITHREAD
+    // the background sweeper counts the objects it frees
+    luaC_waitsweep(L);
 #endif
 
-    if (keepinvariant(g))
+    bool enabled = g->typecounters != NULL;
+
+    if (enabled && !enable)
     {
-        // reset sweep marks to sweep all elements (returning them to white)
-        g->sweepgcopage = g->allgcopages;
-        // reset other collector lists
-        g->gray = NULL;
-        g->grayagain = NULL;
-        g->weak = NULL;
-        g->gcstate = GCSsweep;
+        (*g->frealloc)(g->ud, g->typecounters, sizeof(lua_TypeCounters) * LUA_MEMORY_CATEGORIES * LUA_TYPECOUNTERS, 0);
+        g->typecounters = NULL;
     }
-    LUAU_ASSERT(g->gcstate == GCSpause || g->gcstate == GCSsweep);
-    // finish any pending sweep phase
-    while (g->gcstate != GCSpause)
+    else if (!enabled && enable)
     {
-        LUAU_ASSERT(g->gcstate == GCSsweep);
-        gcstep(L, SIZE_MAX);
+        size_t size = sizeof(lua_TypeCounters) * LUA_MEMORY_CATEGORIES * LUA_TYPECOUNTERS;
+        lua_TypeCounters(*counters)[LUA_TYPECOUNTERS] = (lua_TypeCounters(*)[LUA_TYPECOUNTERS])(*g->frealloc)(g->ud, NULL, 0, size);
+
+        if (!counters)
+        {
+            luaunlock_gcstep();
+            luaD_throw(L, LUA_ERRMEM);
+        }
+
+        memset(counters, 0, size);
+        g->typecounters = counters;
+
+        // objects that are already allocated are counted, so that live counts stay correct when they are freed
+        luaM_visitgco(L, g, counttypes);
+
+        // the remaining memory of each category is made of blocks that are not objects; the main thread is not in the heap
+        for (int memcat = 0; memcat < LUA_MEMORY_CATEGORIES; ++memcat)
+        {
+            uint64_t objectbytes = 0;
+            for (int slot = 0; slot < LUA_TYPECOUNTERS; ++slot)
+                objectbytes += counters[memcat][slot].allocbytes;
+
+            if (g->memcatbytes[memcat] > objectbytes)
+                counters[memcat][typecounterdata].allocbytes = g->memcatbytes[memcat] - objectbytes;
+        }
+
+        for (int memcat = 0; memcat < LUA_MEMORY_CATEGORIES; ++memcat)
+        {
+            for (int slot = 0; slot < LUA_TYPECOUNTERS; ++slot)
+            {
+                lua_TypeCounters* c = &counters[memcat][slot];
+
+                c->markallocbytes = c->allocbytes;
+                c->markfreebytes = c->freebytes;
+            }
+        }
+
+        g->typecountersmark = lua_clock();
+        g->typecounterscycle = 0;
     }
 
-    // clear markedopen bits for all open upvalues; these might be stuck from half-finished mark prior to full gc
-    for (UpVal* uv = g->uvhead.u.open.next; uv != &g->uvhead; uv = uv->u.open.next)
+    luaunlock_gcstep();
+
+    return enabled;
+}
+
+/*
+ * Allocation regions
+ *
+ * Tables created by the region owner between lua_pushregion and lua_popregion are allocated in LUA_REGIONMEMCAT, out of memory that
+ * lmem.cpp releases all at once. While the region is active, region tables are regular objects that the collector marks and sweeps.
+ *
+ * A region table escapes when a reference to it is stored somewhere that can outlive the region: the write barriers flag stores into
+ * objects outside of the region, and roots, other threads and closures are checked where values are copied into them. Whatever is left
+ * on the stack of the owner is checked when the region is popped.
+ *
+ * When nothing escaped, no object outside of the region can reach region objects, so the region is released without traversing it;
+ * the collector only needs to forget the region objects it has queued. Otherwise region tables are moved to regular memory and the
+ * region pages become regular pages, which leaves the tables to the collector.
+ */
+static bool regiononstack(lua_State* L)
+{
+    for (StkId o = L->stack; o < L->top; o++)
+        if (iscollectable(o) && isregion(gcvalue(o)))
+            return true;
+
+    return false;
+}
+
+static void unlinkregion(GCObject** l)
+{
+    while (*l)
     {
-        LUAU_ASSERT(upisopen(uv));
-        uv->markedopen = 0;
+        if (isregion(*l))
+            *l = *gclistof(*l);
+        else
+            l = gclistof(*l);
     }
+}
 
-#ifdef LUAI_GCMETRICS
-    finishGcCycleMetrics(g);
-    startGcCycleMetrics(g);
-#endif
+static void adoptregionprotected(lua_State* L)
+{
+    struct CallContext
+    {
+        // the array part of the table that is being moved, so that it isn't lost if the hash part can't be allocated
+        TValue* array;
+        int sizearray;
 
-    // run a full collection cycle
-    markroot(L);
-    while (g->gcstate != GCSpause)
+        static bool adopt(void* context, lua_Page* page, GCObject* gco)
+        {
+            CallContext* ctx = (CallContext*)context;
+            lua_State* L = ctx->L;
+            global_State* g = L->global;
+            uint8_t memcat = g->region.memcat;
+
+            // tables that were moved before an earlier attempt failed are left alone
+            if (!isregion(gco))
+                return false;
+
+            LUAU_ASSERT(gco->gch.tt == LUA_TTABLE);
+            LuaTable* h = gco2h(gco);
+
+            if (h->array)
+            {
+                ctx->array = luaM_newarray(L, h->sizearray, TValue, memcat);
+                ctx->sizearray = h->sizearray;
+            }
+
+            LuaNode* node = h->node;
+
+            if (node != &luaH_dummynode)
+            {
+                // probed hash parts are moved with their control bytes
+                node = (LuaNode*)luaM_new_(L, luaH_sizenodes(h), memcat);
+                memcpy(node, h->node, luaH_sizenodes(h));
+                luaM_free_(L, h->node, luaH_sizenodes(h), LUA_REGIONMEMCAT);
+            }
+
+            if (h->array)
+            {
+                memcpy(ctx->array, h->array, h->sizearray * sizeof(TValue));
+                luaM_freearray(L, h->array, h->sizearray, TValue, LUA_REGIONMEMCAT);
+            }
+
+            h->node = node;
+            h->array = ctx->array;
+            ctx->array = NULL;
+
+            // the header stays where it is, only its accounting moves
+            luaM_setgcomemcat(L, gco, sizeof(LuaTable), memcat);
+
+            return false;
+        }
+
+        static void run(lua_State* L, void* ud)
+        {
+            luaM_visitregion(L, ud, adopt);
+        }
+
+        lua_State* L;
+    } ctx = {};
+
+    ctx.L = L;
+
+    int status = luaD_rawrunprotected(L, &CallContext::run, &ctx);
+
+    if (status != LUA_OK)
     {
-        gcstep(L, SIZE_MAX);
+        if (ctx.array)
+            luaM_freearray(L, ctx.array, ctx.sizearray, TValue, L->global->region.memcat);
+
+        // the region stays active, popping it again picks up where this attempt stopped
+        L->global->region.depth = 1;
+        luaunlock_gcstep();
+        luaD_throw(L, status);
     }
-    // reclaim as much buffer memory as possible (shrinkbuffers() called during sweep is incremental)
-    shrinkbuffersfull(L);
+}
 
-    size_t heapgoalsizebytes = (g->totalbytes / 100) * g->gcgoal;
+int luaC_popregion(lua_State* L)
+{
+    global_State* g = L->global;
+    lua_Region* r = &g->region;
 
-    // trigger cannot be correctly adjusted after a forced full GC.
-    // we will try to place it so that we can reach the goal based on
-    // the rate at which we run the GC relative to allocation rate
-    // and on amount of bytes we need to traverse in propagation stage.
-    // goal and stepmul are defined in percents
-    g->GCthreshold = g->totalbytes * (g->gcgoal * g->gcstepmul / 100 - 100) / g->gcstepmul;
+    LUAU_ASSERT(r->owner == L && r->depth > 0);
 
-    // but it might be impossible to satisfy that directly
-    if (g->GCthreshold < g->totalbytes)
-        g->GCthreshold = g->totalbytes;
+    if (--r->depth > 0)
+        return 0;
 
-    g->gcstats.heapgoalsizebytes = heapgoalsizebytes;
+    // threads that were started during the region can't run while its pages change hands
+    while (!lualock_gcstep())
+    {
+    }
 
-#ifdef LUAI_GCMETRICS
-    finishGcCycleMetrics(g);
-#endif
+    bool released = !r->escaped && !regiononstack(L);
+
+    if (released)
+    {
+        unlinkregion(&g->gray);
+        unlinkregion(&g->grayagain);
+        unlinkregion(&g->weak);
+
+        // stale slots above the top are normally cleared by the collector, but they can't outlive the objects they point to
+        clearstack(L);
+
+        luaM_freeregion(L);
+    }
+    else
+    {
+        adoptregionprotected(L);
+
+        luaM_adoptregion(L);
+    }
+
+    r->owner = NULL;
+    r->escaped = false;
 
     luaunlock_gcstep();
 
-    luaC_postgc(L);
+    return released;
 }
 
 void luaC_postgc(lua_State *L)
@@ -1237,61 +2430,86 @@ void luaC_addpostgc(lua_State *L,int (*dtor)(lua_State *L,void*),void *data)
 void luaC_barrierf(lua_State* L, GCObject* o, GCObject* v)
 {
     global_State* g = L->global;
-    lualock_gc();
+    lualock_global();
+    // another thread may have handled this barrier while we waited for the lock
+    if (!isblack(o) || !iswhite(v))
+    {
+        luaunlock_global();
+        return;
+    }
     LUAU_ASSERT(isblack(o) && iswhite(v) && !isdead(g, v) && !isdead(g, o));
-    LUAU_ASSERT(g->gcstate != GCSpause);
+    LUAU_ASSERT(g->gcstate != GCSpause || g->gcsticky);
     // must keep invariant?
     if (keepinvariant(g))
         reallymarkobject(g, v); // restore invariant
     else                        // don't mind
         makewhite(g, o);        // mark as white just to avoid other barriers
-    luaunlock_gc();
+    luaunlock_global();
 }
 
 void luaC_barriertable(lua_State* L, LuaTable* t, GCObject* v)
 {
     global_State* g = L->global;
-    lualock_gc();
+    lualock_global();
     GCObject* o = obj2gco(t);
 
+    // another thread may have handled this barrier while we waited for the lock
+    if (!isblack(o) || !iswhite(v))
+    {
+        luaunlock_global();
+        return;
+    }
+
     // in the second propagation stage, table assignment barrier works as a forward barrier
     if (g->gcstate == GCSpropagateagain)
     {
         LUAU_ASSERT(isblack(o) && iswhite(v) && !isdead(g, v) && !isdead(g, o));
         reallymarkobject(g, v);
-        luaunlock_gc();
+        luaunlock_global();
         return;
     }
 
     LUAU_ASSERT(isblack(o) && !isdead(g, o));
-    LUAU_ASSERT(g->gcstate != GCSpause);
+    LUAU_ASSERT(g->gcstate != GCSpause || g->gcsticky);
     black2gray(o); // make table gray (again)
     t->gclist = g->grayagain;
     g->grayagain = o;
-    luaunlock_gc();
+    luaunlock_global();
 }
 
 void luaC_barrierback(lua_State* L, GCObject* o, GCObject** gclist)
 {
     global_State* g = L->global;
-    lualock_gc();
+    lualock_global();
+    // another thread may have handled this barrier while we waited for the lock
+    if (!isblack(o))
+    {
+        luaunlock_global();
+        return;
+    }
     LUAU_ASSERT(isblack(o) && !isdead(g, o));
-    LUAU_ASSERT(g->gcstate != GCSpause);
+    LUAU_ASSERT(g->gcstate != GCSpause || g->gcsticky);
 
     black2gray(o); // make object gray (again)
     *gclist = g->grayagain;
     g->grayagain = o;
-    luaunlock_gc();
+    luaunlock_global();
 }
 
 void luaC_upvalclosed(lua_State* L, UpVal* uv)
 {
     global_State* g = L->global;
-    lualock_gc();
+    luaC_regionescape(L, uv->v);
     GCObject* o = obj2gco(uv);
 
     LUAU_ASSERT(!upisopen(uv)); // upvalue was closed but needs GC state fixup
 
+    // most upvalues are closed while they aren't gray, which needs no fixup and so no lock
+    if (!isgray(o))
+        return;
+
+    lualock_global();
+    // another thread may have run a GC step that changed the color while we waited for the lock
     if (isgray(o))
     {
         if (keepinvariant(g))
@@ -1305,7 +2523,7 @@ void luaC_upvalclosed(lua_State* L, UpVal* uv)
             LUAU_ASSERT(g->gcstate != GCSpause);
         }
     }
-    luaunlock_gc();
+    luaunlock_global();
 }
 
 // measure the allocation rate in bytes/sec
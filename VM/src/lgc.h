@@ -13,6 +13,28 @@
 #define LUAI_GCSTEPMUL 200 // GC runs 'twice the speed' of memory allocation
 #define LUAI_GCSTEPSIZE 1  // GC runs every KB of memory allocation
 
+/*
+** Default settings for generational mode tunables (settable via lua_gc)
+*/
+#define LUAI_GCGENMINORMUL 20  // minor collection runs after the application allocates 20% of the heap size
+#define LUAI_GCGENMAJORMUL 100 // major collection runs once the heap doubles compared to the last major collection
+
+/*
+** Default settings for the compacting pass (LUA_GCCOMPACT)
+*/
+#define LUAI_GCCOMPACTOCCUPANCY 50 // pages that are at most 50% full are evacuated
+
+/*
+** Default settings for the large page pool (settable via lua_gc)
+*/
+#define LUAI_GCLARGEPOOL 1024 // up to 1 MB of free large pages are kept for reuse
+
+/*
+** Possible modes of the Garbage Collector
+*/
+#define GCKincremental 0
+#define GCKgenerational 1
+
 /*
 ** Possible states of the Garbage Collector
 */
@@ -26,9 +48,10 @@
 ** The main invariant of the garbage collector, while marking objects,
 ** is that a black object can never point to a white one. This invariant
 ** is not being enforced during a sweep phase, and is restored when sweep
-** ends.
+** ends, unless the sweep keeps the marks of surviving objects (generational
+** mode), in which case it holds until the next sweep that turns them white.
 */
-#define keepinvariant(g) ((g)->gcstate == GCSpropagate || (g)->gcstate == GCSpropagateagain || (g)->gcstate == GCSatomic)
+#define keepinvariant(g) ((g)->gcstate == GCSpropagate || (g)->gcstate == GCSpropagateagain || (g)->gcstate == GCSatomic || (g)->gcsticky)
 
 /*
 ** some useful bit tricks
@@ -51,18 +74,28 @@
 ** bit 1 - object is white (type 1)
 ** bit 2 - object is black
 ** bit 3 - object is fixed (should not be collected)
+** bit 4 - table is shared between threads (LUAU_MULTITHREAD only)
+** bit 5 - object is old (survived a collection in generational mode)
+** bit 6 - object can't be moved by the compacting pass (only set while it runs)
+** bit 7 - object was moved by the compacting pass, this copy is left behind until references to it are fixed up
 */
 
 #define WHITE0BIT 0
 #define WHITE1BIT 1
 #define BLACKBIT 2
 #define FIXEDBIT 3
+#define SHAREDBIT 4
+#define OLDBIT 5
+#define PINNEDBIT 6
+#define MOVEDBIT 7
 #define WHITEBITS bit2mask(WHITE0BIT, WHITE1BIT)
 
 #define iswhite(x) test2bits((x)->gch.marked, WHITE0BIT, WHITE1BIT)
 #define isblack(x) testbit((x)->gch.marked, BLACKBIT)
 #define isgray(x) (!testbits((x)->gch.marked, WHITEBITS | bitmask(BLACKBIT)))
 #define isfixed(x) testbit((x)->gch.marked, FIXEDBIT)
+#define isold(x) testbit((x)->gch.marked, OLDBIT)
+#define isregion(x) ((x)->gch.memcat == LUA_REGIONMEMCAT)
 
 #define otherwhite(g) (g->currentwhite ^ WHITEBITS)
 #define isdead(g, v) (((v)->gch.marked & (WHITEBITS | bitmask(FIXEDBIT))) == (otherwhite(g) & WHITEBITS))
@@ -72,6 +105,22 @@
 
 #define luaC_white(g) cast_to(uint8_t, ((g)->currentwhite) & WHITEBITS)
 
+#ifdef LUAU_MULTITHREAD
+// the background sweeper recolors objects under the global lock, so other changes to the mark bits have to take it as well
+#define luaC_setbit(o, b) \
+    { \
+        lualock_global(); \
+        l_setbit((o)->marked, b); \
+        luaunlock_global(); \
+    }
+
+#define luaC_bgsweeping(g) ((g)->sweeper.active)
+#else
+#define luaC_setbit(o, b) l_setbit((o)->marked, b)
+
+#define luaC_bgsweeping(g) false
+#endif
+
 #define luaC_needsGC(L) (L->global->totalbytes >= L->global->GCthreshold)
 
 #define luaC_checkGC(L) \
@@ -88,28 +137,56 @@
         } \
     }
 
+// while a region is active, write barriers also catch region objects that are stored into objects outside of the region
+#define luaC_regionactive(L) (LUAU_UNLIKELY((L)->global->region.owner != NULL))
+
+#define luaC_regionbarrier(L, p, o) \
+    { \
+        if (luaC_regionactive(L) && isregion(o) && !isregion(obj2gco(p))) \
+            (L)->global->region.escaped = true; \
+    }
+
+// a region object that becomes reachable from a root or from another thread escapes as well
+#define luaC_regionescape(L, v) \
+    { \
+        if (luaC_regionactive(L) && iscollectable(v) && isregion(gcvalue(v))) \
+            (L)->global->region.escaped = true; \
+    }
+
 #define luaC_barrier(L, p, v) \
     { \
-        if (iscollectable(v) && isblack(obj2gco(p)) && iswhite(gcvalue(v))) \
-            luaC_barrierf(L, obj2gco(p), gcvalue(v)); \
+        if (iscollectable(v)) \
+        { \
+            if (isblack(obj2gco(p)) && iswhite(gcvalue(v))) \
+                luaC_barrierf(L, obj2gco(p), gcvalue(v)); \
+            luaC_regionbarrier(L, p, gcvalue(v)); \
+        } \
     }
 
 #define luaC_barriert(L, t, v) \
     { \
-        if (iscollectable(v) && isblack(obj2gco(t)) && iswhite(gcvalue(v))) \
-            luaC_barriertable(L, t, gcvalue(v)); \
+        if (iscollectable(v)) \
+        { \
+            if (isblack(obj2gco(t)) && iswhite(gcvalue(v))) \
+                luaC_barriertable(L, t, gcvalue(v)); \
+            luaC_regionbarrier(L, t, gcvalue(v)); \
+        } \
     }
 
+// values copied in bulk are not checked individually, so any bulk store into a table outside of the region counts as an escape
 #define luaC_barrierfast(L, t) \
     { \
         if (isblack(obj2gco(t))) \
             luaC_barrierback(L, obj2gco(t), &t->gclist); \
+        if (luaC_regionactive(L) && !isregion(obj2gco(t))) \
+            (L)->global->region.escaped = true; \
     }
 
 #define luaC_objbarrier(L, p, o) \
     { \
         if (isblack(obj2gco(p)) && iswhite(obj2gco(o))) \
             luaC_barrierf(L, obj2gco(p), obj2gco(o)); \
+        luaC_regionbarrier(L, p, obj2gco(o)); \
     }
 
 #define luaC_threadbarrier(L) \
@@ -118,6 +195,9 @@
             luaC_barrierback(L, obj2gco(L), &L->gclist); \
     }
 
+// tables created by the owner of the active region are allocated in the region
+#define luaC_tablememcat(L) (luaC_regionactive(L) && (L)->global->region.owner == (L) ? uint8_t(LUA_REGIONMEMCAT) : (L)->activememcat)
+
 #define luaC_init(L, o, tt_) \
     { \
         o->marked = luaC_white(L->global); \
@@ -128,12 +208,21 @@
 LUAI_FUNC void luaC_freeall(lua_State* L);
 LUAI_FUNC size_t luaC_step(lua_State* L, bool assist);
 LUAI_FUNC void luaC_fullgc(lua_State* L);
+LUAI_FUNC size_t luaC_compact(lua_State* L, int occupancy);
+LUAI_FUNC bool luaC_settypecounters(lua_State* L, bool enable);
+LUAI_FUNC int luaC_popregion(lua_State* L);
+#ifdef LUAU_MULTITHREAD
+LUAI_FUNC void luaC_waitsweep(lua_State* L);
+LUAI_FUNC void luaC_syncsweep(lua_State* L);
+LUAI_FUNC void luaC_finishsweep(lua_State* L);
+#endif
 LUAI_FUNC void luaC_initobj(lua_State* L, GCObject* o, uint8_t tt);
 LUAI_FUNC void luaC_upvalclosed(lua_State* L, UpVal* uv);
 LUAI_FUNC void luaC_barrierf(lua_State* L, GCObject* o, GCObject* v);
 LUAI_FUNC void luaC_barriertable(lua_State* L, LuaTable* t, GCObject* v);
 LUAI_FUNC void luaC_barrierback(lua_State* L, GCObject* o, GCObject** gclist);
 LUAI_FUNC void luaC_validate(lua_State* L);
+LUAI_FUNC void luaC_freeheapqueries(lua_State* L);
 LUAI_FUNC void luaC_dump(lua_State* L, void* file, const char* (*categoryName)(lua_State* L, uint8_t memcat));
 LUAI_FUNC void luaC_enumheap(
     lua_State* L,
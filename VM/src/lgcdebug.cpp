@@ -2,6 +2,8 @@
 // This code is based on Lua 5.x implementation licensed under MIT License; see lua_LICENSE.txt for details
 #include "lgc.h"
 
+#include "lapi.h"
+#include "ldo.h"
 #include "lfunc.h"
 #include "lmem.h"
 #include "lobject.h"
@@ -11,9 +13,15 @@
 #include "ludata.h"
 #include "lbuffer.h"
 
+#include "Luau/HeapSnapshot.h"
+
 #include <string.h>
 #include <stdio.h>
 
+#include <new>
+#include <string>
+#include <unordered_map>
+
 static void validateobjref(global_State* g, GCObject* f, GCObject* t)
 {
     LUAU_ASSERT(!isdead(g, t));
@@ -39,6 +47,7 @@ static void validatetable(global_State* g, LuaTable* h)
     int sizenode = 1 << h->lsizenode;
 
     LUAU_ASSERT(h->lastfree <= sizenode);
+    LUAU_ASSERT(!isprobed(h) || h->node != &luaH_dummynode);
 
     if (h->metatable)
         validateobjref(g, obj2gco(h), obj2gco(h->metatable));
@@ -46,12 +55,35 @@ static void validatetable(global_State* g, LuaTable* h)
     for (int i = 0; i < h->sizearray; ++i)
         validateref(g, obj2gco(h), &h->array[i]);
 
+    if (isshaped(h))
+    {
+        LuaShapedNode* sn = gshaped(h);
+
+        LUAU_ASSERT(sn->shape->count <= LUA_MAXSHAPEKEYS);
+        LUAU_ASSERT(ttisnil(gval(&sn->sentinel)) && ttisnil(gkey(&sn->sentinel)));
+
+        for (int i = 0; i < sn->shape->count; ++i)
+        {
+            validateobjref(g, obj2gco(h), obj2gco(sn->shape->keys[i]));
+            validateref(g, obj2gco(h), &sn->slots[i]);
+        }
+        return;
+    }
+
     for (int i = 0; i < sizenode; ++i)
     {
         LuaNode* n = &h->node[i];
 
         LUAU_ASSERT(ttype(gkey(n)) != LUA_TDEADKEY || ttisnil(gval(n)));
-        LUAU_ASSERT(i + gnext(n) >= 0 && i + gnext(n) < sizenode);
+        if (isprobed(h))
+        {
+            LUAU_ASSERT(gnext(n) != 0);
+            LUAU_ASSERT((gctrl(h)[i] == CTRL_EMPTY) == ttisnil(gkey(n)));
+        }
+        else
+        {
+            LUAU_ASSERT(i + gnext(n) >= 0 && i + gnext(n) < sizenode);
+        }
 
         if (!ttisnil(gval(n)))
         {
@@ -107,9 +139,11 @@ static void validatestack(global_State* g, lua_State* l)
     {
         LUAU_ASSERT(uv->tt == LUA_TUPVAL);
         LUAU_ASSERT(upisopen(uv));
-        LUAU_ASSERT(uv->u.open.next->u.open.prev == uv && uv->u.open.prev->u.open.next == uv);
         LUAU_ASSERT(!isblack(obj2gco(uv))); // open upvalues are never black
     }
+
+    // threads with open upvalues have to be in the global list for atomic phase to find them
+    LUAU_ASSERT(!l->openupval || l->twups != l);
 }
 
 static void validateproto(global_State* g, Proto* f)
@@ -225,7 +259,7 @@ static bool validategco(void* context, lua_Page* page, GCObject* gco)
     return false;
 }
 
-void luaC_validate(lua_State* L)
+static void validateheap(lua_State* L)
 {
     global_State* g = L->global;
 
@@ -244,13 +278,35 @@ void luaC_validate(lua_State* L)
 
     luaM_visitgco(L, L, validategco);
 
-    for (UpVal* uv = g->uvhead.u.open.next; uv != &g->uvhead; uv = uv->u.open.next)
+    for (lua_State* th = g->twups; th; th = th->twups)
     {
-        LUAU_ASSERT(uv->tt == LUA_TUPVAL);
-        LUAU_ASSERT(upisopen(uv));
-        LUAU_ASSERT(uv->u.open.next->u.open.prev == uv && uv->u.open.prev->u.open.next == uv);
-        LUAU_ASSERT(!isblack(obj2gco(uv))); // open upvalues are never black
+        LUAU_ASSERT(th->tt == LUA_TTHREAD);
+
+        for (UpVal* uv = th->openupval; uv; uv = uv->u.open.threadnext)
+        {
+            LUAU_ASSERT(uv->tt == LUA_TUPVAL);
+            LUAU_ASSERT(upisopen(uv));
+            LUAU_ASSERT(!isblack(obj2gco(uv))); // open upvalues are never black
+        }
+    }
+}
+
+void luaC_validate(lua_State* L)
+{
+#ifdef LUAU_MULTITHREAD
+    // other threads mutate the heap while they run, so it can only be checked once they are stopped
+    if (!L->global->threads.stopped)
+    {
+        if (lualock_gcstep())
+        {
+            validateheap(L);
+            luaunlock_gcstep();
+        }
+        return;
     }
+#endif
+
+    validateheap(L);
 }
 
 inline bool safejson(char ch)
@@ -295,11 +351,39 @@ static void dumpstring(FILE* f, TString* ts)
 
 static void dumptable(FILE* f, LuaTable* h)
 {
-    size_t size = sizeof(LuaTable) + (h->node == &luaH_dummynode ? 0 : sizenode(h) * sizeof(LuaNode)) + h->sizearray * sizeof(TValue);
+    size_t size = sizeof(LuaTable) + luaH_sizenodes(h) + luaH_sizearray(h);
 
     fprintf(f, "{\"type\":\"table\",\"cat\":%d,\"size\":%d", h->memcat, int(size));
 
-    if (h->node != &luaH_dummynode)
+    if (isshaped(h))
+    {
+        LuaShapedNode* sn = gshaped(h);
+
+        fprintf(f, ",\"pairs\":[");
+
+        bool first = true;
+
+        for (int i = 0; i < sn->shape->count; ++i)
+        {
+            if (!ttisnil(&sn->slots[i]))
+            {
+                if (!first)
+                    fputc(',', f);
+                first = false;
+
+                dumpref(f, obj2gco(sn->shape->keys[i]));
+                fputc(',', f);
+
+                if (iscollectable(&sn->slots[i]))
+                    dumpref(f, gcvalue(&sn->slots[i]));
+                else
+                    fprintf(f, "null");
+            }
+        }
+
+        fprintf(f, "]");
+    }
+    else if (h->node != &luaH_dummynode)
     {
         fprintf(f, ",\"pairs\":[");
 
@@ -489,7 +573,7 @@ static void dumpbuffer(FILE* f, Buffer* b)
 static void dumpproto(FILE* f, Proto* p)
 {
     size_t size = sizeof(Proto) + sizeof(Instruction) * p->sizecode + sizeof(Proto*) * p->sizep + sizeof(TValue) * p->sizek + p->sizelineinfo +
-                  sizeof(LocVar) * p->sizelocvars + sizeof(TString*) * p->sizeupvalues;
+                  sizeof(LocVar) * p->sizelocvars + sizeof(TString*) * p->sizeupvalues + luaF_sizeinlinecaches(p);
 
     fprintf(f, "{\"type\":\"proto\",\"cat\":%d,\"size\":%d", p->memcat, int(size));
 
@@ -659,25 +743,41 @@ static void enumstring(EnumContext* ctx, TString* ts)
 
 static void enumtable(EnumContext* ctx, LuaTable* h)
 {
-    size_t size = sizeof(LuaTable) + (h->node == &luaH_dummynode ? 0 : sizenode(h) * sizeof(LuaNode)) + h->sizearray * sizeof(TValue);
+    size_t size = sizeof(LuaTable) + luaH_sizenodes(h) + luaH_sizearray(h);
 
     // Provide a name for a special registry table
     enumnode(ctx, obj2gco(h), size, h == hvalue(registry(ctx->L)) ? "registry" : NULL);
 
-    if (h->node != &luaH_dummynode)
+    bool weakkey = false;
+    bool weakvalue = false;
+
+    if (const TValue* mode = gfasttm(ctx->L->global, h->metatable, TM_MODE))
+    {
+        if (ttisstring(mode))
+        {
+            weakkey = strchr(svalue(mode), 'k') != NULL;
+            weakvalue = strchr(svalue(mode), 'v') != NULL;
+        }
+    }
+
+    if (isshaped(h))
     {
-        bool weakkey = false;
-        bool weakvalue = false;
+        LuaShapedNode* sn = gshaped(h);
 
-        if (const TValue* mode = gfasttm(ctx->L->global, h->metatable, TM_MODE))
+        for (int i = 0; i < sn->shape->count; ++i)
         {
-            if (ttisstring(mode))
+            if (!ttisnil(&sn->slots[i]))
             {
-                weakkey = strchr(svalue(mode), 'k') != NULL;
-                weakvalue = strchr(svalue(mode), 'v') != NULL;
+                if (!weakkey)
+                    enumedge(ctx, obj2gco(h), obj2gco(sn->shape->keys[i]), "[key]");
+
+                if (!weakvalue && iscollectable(&sn->slots[i]))
+                    enumedge(ctx, obj2gco(h), gcvalue(&sn->slots[i]), getstr(sn->shape->keys[i]));
             }
         }
-
+    }
+    else if (h->node != &luaH_dummynode)
+    {
         for (int i = 0; i < sizenode(h); ++i)
         {
             const LuaNode& n = h->node[i];
@@ -759,7 +859,20 @@ static void enumudata(EnumContext* ctx, Udata* u)
 
     if (LuaTable* h = u->metatable)
     {
-        if (h->node != &luaH_dummynode)
+        if (isshaped(h))
+        {
+            LuaShapedNode* sn = gshaped(h);
+
+            for (int i = 0; i < sn->shape->count; ++i)
+            {
+                if (ttisstring(&sn->slots[i]) && strcmp(getstr(sn->shape->keys[i]), "__type") == 0)
+                {
+                    name = svalue(&sn->slots[i]);
+                    break;
+                }
+            }
+        }
+        else if (h->node != &luaH_dummynode)
         {
             for (int i = 0; i < sizenode(h); ++i)
             {
@@ -826,7 +939,7 @@ static void enumbuffer(EnumContext* ctx, Buffer* b)
 static void enumproto(EnumContext* ctx, Proto* p)
 {
     size_t size = sizeof(Proto) + sizeof(Instruction) * p->sizecode + sizeof(Proto*) * p->sizep + sizeof(TValue) * p->sizek + p->sizelineinfo +
-                  sizeof(LocVar) * p->sizelocvars + sizeof(TString*) * p->sizeupvalues;
+                  sizeof(LocVar) * p->sizelocvars + sizeof(TString*) * p->sizeupvalues + luaF_sizeinlinecaches(p);
 
     if (p->execdata && ctx->L->global->ecb.getmemorysize)
     {
@@ -919,20 +1032,214 @@ void luaC_enumheap(
     luaM_visitgco(L, &ctx, enumgco);
 }
 
-struct searchState {
-    GCObject *obj;
-    lua_State *L;
-    global_State *g;
-    TValue parent;
-    std::vector<TValue> refs;
+// heap snapshots use a compact binary format, see Luau/HeapSnapshot.h
+struct SnapshotWriter
+{
+    void* context;
+    void (*write)(void* context, const void* data, size_t size);
+
+    char buffer[16384];
+    size_t pos;
+
+    std::unordered_map<std::string, uint32_t> names;
+    void* source; // source of the edges that follow
+};
+
+static void snapshotflush(SnapshotWriter* w)
+{
+    if (w->pos)
+        w->write(w->context, w->buffer, w->pos);
+
+    w->pos = 0;
+}
+
+static void snapshotbyte(SnapshotWriter* w, uint8_t value)
+{
+    if (w->pos == sizeof(w->buffer))
+        snapshotflush(w);
+
+    w->buffer[w->pos++] = char(value);
+}
+
+static void snapshotvarint(SnapshotWriter* w, uint64_t value)
+{
+    do
+    {
+        uint8_t byte = value & 127;
+        value >>= 7;
+        snapshotbyte(w, byte | (value ? 128 : 0));
+    } while (value);
+}
+
+static void snapshotstring(SnapshotWriter* w, const char* data, size_t size)
+{
+    snapshotvarint(w, size);
+
+    for (size_t i = 0; i < size; ++i)
+        snapshotbyte(w, uint8_t(data[i]));
+}
+
+// names are interned, so that each name is written once
+static uint32_t snapshotname(SnapshotWriter* w, const char* name)
+{
+    if (!name)
+        return 0;
+
+    auto [it, inserted] = w->names.try_emplace(name, uint32_t(w->names.size() + 1));
+
+    if (inserted)
+    {
+        snapshotbyte(w, LHS_NAME);
+        snapshotstring(w, name, strlen(name));
+    }
+
+    return it->second;
+}
+
+static void snapshotnode(void* context, void* ptr, uint8_t tt, uint8_t memcat, size_t size, const char* name)
+{
+    SnapshotWriter* w = (SnapshotWriter*)context;
+    uint32_t nameindex = snapshotname(w, name);
+
+    snapshotbyte(w, LHS_OBJECT);
+    snapshotvarint(w, uintptr_t(ptr));
+    snapshotbyte(w, tt);
+    snapshotbyte(w, memcat);
+    snapshotvarint(w, size);
+    snapshotvarint(w, nameindex);
+
+    w->source = ptr;
+}
+
+static void snapshotedge(void* context, void* from, void* to, const char* name)
+{
+    SnapshotWriter* w = (SnapshotWriter*)context;
+    uint32_t nameindex = snapshotname(w, name);
+
+    if (from != w->source)
+    {
+        snapshotbyte(w, LHS_SOURCE);
+        snapshotvarint(w, uintptr_t(from));
+
+        w->source = from;
+    }
+
+    snapshotbyte(w, LHS_EDGE);
+    snapshotvarint(w, uintptr_t(to));
+    snapshotvarint(w, nameindex);
+}
+
+static void snapshotroot(SnapshotWriter* w, GCObject* o, const char* name)
+{
+    uint32_t nameindex = snapshotname(w, name);
+
+    snapshotbyte(w, LHS_ROOT);
+    snapshotvarint(w, uintptr_t(enumtopointer(o)));
+    snapshotvarint(w, nameindex);
+}
+
+static bool snapshotgco(void* context, lua_Page* page, GCObject* gco)
+{
+    EnumContext* ctx = (EnumContext*)context;
+
+    // objects waiting to be swept are not part of the heap any more
+    if (!isdead(ctx->L->global, gco))
+        enumobj(ctx, gco);
+
+    return false;
+}
+
+void lua_heapsnapshot(
+    lua_State* L,
+    void* context,
+    void (*write)(void* context, const void* data, size_t size),
+    const char* (*categoryname)(lua_State* L, uint8_t memcat)
+)
+{
+    global_State* g = L->global;
+
+    SnapshotWriter w;
+    w.context = context;
+    w.write = write;
+    w.pos = 0;
+    w.source = NULL;
+
+    EnumContext ctx;
+    ctx.L = L;
+    ctx.context = &w;
+    ctx.node = snapshotnode;
+    ctx.edge = snapshotedge;
+
+    for (const char* magic = LHS_MAGIC; *magic; ++magic)
+        snapshotbyte(&w, uint8_t(*magic));
+    snapshotbyte(&w, LHS_VERSION);
+
+    // the heap can't change while it's written, and objects are visited one page at a time
+    while (!lualock_gcstep())
+    {
+    }
+
+    enumgco(&ctx, NULL, obj2gco(g->mainthread));
+
+    luaM_visitgco(L, &ctx, snapshotgco);
+
+    snapshotroot(&w, obj2gco(g->mainthread), "mainthread");
+    snapshotroot(&w, gcvalue(&g->registry), "registry");
+
+    for (int i = 0; i < LUA_MEMORY_CATEGORIES; i++)
+    {
+        if (size_t bytes = g->memcatbytes[i])
+        {
+            uint32_t nameindex = snapshotname(&w, categoryname ? categoryname(L, uint8_t(i)) : NULL);
+
+            snapshotbyte(&w, LHS_CATEGORY);
+            snapshotbyte(&w, uint8_t(i));
+            snapshotvarint(&w, bytes);
+            snapshotvarint(&w, nameindex);
+        }
+    }
+
+    snapshotbyte(&w, LHS_END);
+    snapshotvarint(&w, g->totalbytes);
+
+    luaunlock_gcstep();
+
+    snapshotflush(&w);
+}
+
+struct lua_HeapQuery
+{
+    lua_HeapCursor cursor; // first member, so that the query can be found from the list of cursors
+
+    bool started; // the main thread, which isn't in the heap, was visited
+    bool done;
+
+    GCObject* target; // object whose referrers are searched, NULL for a reverse index
+
+    int anchor; // registry reference of anchortable, which holds the found table and the target
+    LuaTable* anchortable;
+    LuaTable* found; // referrers found so far; for an index, every indexed object as a weak key
+
+    std::unordered_map<GCObject*, std::vector<GCObject*>> referrers; // reverse index, from each object to its referrers
 };
 
+struct searchState
+{
+    global_State* g;
+    lua_HeapQuery* q;
+    GCObject* parent;
+    std::vector<GCObject*> found; // referrers of the target; for an index, pairs of referrer and referenced object
+};
 
 static void searchref(searchState* f, GCObject* o)
 {
-    if (f->obj==o) {
-        f->refs.push_back(f->parent);
+    if (!f->q->target)
+    {
+        f->found.push_back(f->parent);
+        f->found.push_back(o);
     }
+    else if (f->q->target == o)
+        f->found.push_back(f->parent);
 }
 
 static void searchrefs(searchState* f, TValue* data, size_t size)
@@ -966,7 +1273,23 @@ static void searchtable(searchState* f, LuaTable* h)
         weakvalue = (strchr(modev, 'v') != NULL);
     }
 
-    if (h->node != &luaH_dummynode)
+    if (isshaped(h))
+    {
+        LuaShapedNode* sn = gshaped(h);
+
+        for (int i = 0; i < sn->shape->count; ++i)
+        {
+            if (!ttisnil(&sn->slots[i]))
+            {
+                if (!weakkey)
+                    searchref(f, obj2gco(sn->shape->keys[i]));
+
+                if ((!weakvalue)&&iscollectable(&sn->slots[i]))
+                    searchref(f, gcvalue(&sn->slots[i]));
+            }
+        }
+    }
+    else if (h->node != &luaH_dummynode)
     {
         for (int i = 0; i < sizenode(h); ++i)
         {
@@ -1029,12 +1352,20 @@ static void searchupval(searchState* f, UpVal* uv)
 static bool searchgco(void* context, lua_Page* /*page*/, GCObject* o)
 {
     searchState* f = (searchState*)context;
-    f->parent.value.gc=o;
-    f->parent.tt=o->gch.tt;
+    lua_HeapQuery* q = f->q;
+
+    // objects that are waiting to be swept may refer to objects that are already freed
+    if (isdead(f->g, o))
+        return false;
+
+    // the query doesn't report its own tables
+    if (o == obj2gco(q->anchortable) || o == obj2gco(q->found) || (q->found->metatable && o == obj2gco(q->found->metatable)))
+        return false;
+
+    f->parent = o;
 
     switch (o->gch.tt)
     {
-
     case LUA_TTABLE:
         searchtable(f, gco2h(o));
         break;
@@ -1048,8 +1379,6 @@ static bool searchgco(void* context, lua_Page* /*page*/, GCObject* o)
         break;
 
     case LUA_TTHREAD:
-        if (gco2th(o)==f->L)
-            break;
         searchthread(f, gco2th(o));
         break;
 
@@ -1061,40 +1390,317 @@ static bool searchgco(void* context, lua_Page* /*page*/, GCObject* o)
     return false;
 }
 
-int lua_findreferences(lua_State* L)
+static void pinobject(lua_State* L, LuaTable* h, GCObject* o)
+{
+    TValue key;
+    key.value.gc = o;
+    key.tt = o->gch.tt;
+
+    setbvalue(luaH_set(L, h, &key), 1);
+    luaC_barriert(L, h, &key);
+}
+
+static bool ispinned(LuaTable* h, GCObject* o)
+{
+    TValue key;
+    key.value.gc = o;
+    key.tt = o->gch.tt;
+
+    return !ttisnil(luaH_get(h, &key));
+}
+
+static void recordrefs(lua_State* L, lua_HeapQuery* q, const std::vector<GCObject*>& found)
+{
+    if (q->target)
+    {
+        for (GCObject* referrer : found)
+            pinobject(L, q->found, referrer);
+    }
+    else
+    {
+        // both ends of each edge are kept as weak keys; a lookup ignores objects that were collected since, even if their address was reused
+        for (size_t i = 0; i < found.size(); i += 2)
+        {
+            q->referrers[found[i + 1]].push_back(found[i]);
+
+            pinobject(L, q->found, found[i]);
+            pinobject(L, q->found, found[i + 1]);
+        }
+    }
+}
+
+// sets t[referrer] to true, or to a description of the function for functions; the table is at the top of the stack
+static void pushreferrer(lua_State* L, GCObject* referrer)
+{
+    TValue key;
+    key.value.gc = referrer;
+    key.tt = referrer->gch.tt;
+    luaA_pushobject(L, &key);
+
+    if (ttisfunction(L->top - 1))
+    {
+        Closure* cl = gco2cl(referrer);
+        if (cl->isC)
+        {
+            if (cl->c.debugname)
+                lua_pushfstring(L, "=[C] %p(%s)", cl->c.f, cl->c.debugname);
+            else
+                lua_pushfstring(L, "=[C] %p", cl->c.f);
+        }
+        else
+            lua_pushfstring(L, "%s:%d:%p", getstr(cl->l.p->source), luaG_getline(cl->l.p, 0), cl->l.p);
+    }
+    else
+        lua_pushboolean(L, true);
+
+    lua_rawset(L, -3);
+}
+
+static lua_HeapQuery* newquery(lua_State* L, bool index)
+{
+    global_State* g = L->global;
+
+    // the anchor keeps the table of results, and the target of a search, alive for as long as the query exists
+    lua_createtable(L, 2, 0);
+    lua_newtable(L);
+    if (index)
+    {
+        lua_createtable(L, 0, 1);
+        lua_pushstring(L, "k");
+        lua_setfield(L, -2, "__mode");
+        lua_setmetatable(L, -2);
+    }
+    LuaTable* found = hvalue(L->top - 1);
+    lua_rawseti(L, -2, 1);
+    if (!index)
+    {
+        lua_pushvalue(L, -2);
+        lua_rawseti(L, -2, 2);
+    }
+    LuaTable* anchortable = hvalue(L->top - 1);
+
+    void* block = (*g->frealloc)(g->ud, NULL, 0, sizeof(lua_HeapQuery));
+    if (!block)
+        luaD_throw(L, LUA_ERRMEM);
+
+    lua_HeapQuery* q = new (block) lua_HeapQuery();
+    q->started = false;
+    q->done = false;
+    q->target = index ? NULL : gcvalue(L->top - 2);
+    q->anchor = lua_ref(L, -1);
+    q->anchortable = anchortable;
+    q->found = found;
+
+    lua_pop(L, index ? 1 : 2);
+
+    while (!lualock_gcstep())
+    {
+    }
+
+#ifdef LUAU_MULTITHREAD
+    // the background sweeper takes pages out of the heap, so it can't run while queries walk the pages
+    luaC_finishsweep(L);
+#endif
+
+    q->cursor.page = g->allgcopages;
+    q->cursor.next = g->heapcursors;
+    g->heapcursors = &q->cursor;
+
+    luaunlock_gcstep();
+
+    return q;
+}
+
+static void freequery(global_State* g, lua_HeapQuery* q)
+{
+    q->~lua_HeapQuery();
+    (*g->frealloc)(g->ud, q, sizeof(lua_HeapQuery), 0);
+}
+
+lua_HeapQuery* lua_newrefsearch(lua_State* L)
+{
+    api_check(L, L->top > L->base && iscollectable(L->top - 1));
+
+    return newquery(L, false);
+}
+
+lua_HeapQuery* lua_newrefindex(lua_State* L)
+{
+    return newquery(L, true);
+}
+
+int lua_heapquerystep(lua_State* L, lua_HeapQuery* q, int stepsize)
 {
     global_State* g = L->global;
+
+    if (q->done)
+        return 1;
+
+    // like a GC step, the query waits for its turn instead of blocking the caller
+    if (!lualock_gcstep())
+        return 0;
+
     searchState st;
-    st.obj=(L->top-1)->value.gc;
-    st.g=g;
-    st.L=L;
+    st.g = g;
+    st.q = q;
+    st.parent = NULL;
 
-    searchgco(&st, NULL, obj2gco(g->mainthread));
-    luaM_visitgco(L, &st, searchgco);
+    if (!q->started)
+    {
+        searchgco(&st, NULL, obj2gco(g->mainthread));
+        q->started = true;
+    }
 
-    lua_pop(L,1);
-    lua_newtable(L);
-    for (size_t k=0;k<st.refs.size();k++) {
+    // the budget is the size of the pages visited, in KB
+    size_t limit = stepsize > 0 ? size_t(stepsize) << 10 : SIZE_MAX;
+    size_t work = 0;
+
+    while (q->cursor.page && work < limit)
+    {
+        lua_Page* page = q->cursor.page;
+        q->cursor.page = luaM_getnextpage(page);
+
+        int pageBlocks, busyBlocks, blockSize, pageSize;
+        luaM_getpageinfo(page, &pageBlocks, &busyBlocks, &blockSize, &pageSize);
+
+        luaM_visitpage(page, &st, searchgco);
+
+        work += pageSize;
+    }
+
+    // the objects are recorded before the world resumes, since some of them might not be reachable any more afterwards
+    try
+    {
+        recordrefs(L, q, st.found);
+    }
+    catch (...)
+    {
+        luaunlock_gcstep();
+        throw;
+    }
+
+    q->done = q->cursor.page == NULL;
+
+    luaunlock_gcstep();
+
+    return q->done;
+}
+
+void lua_refsearchresult(lua_State* L, lua_HeapQuery* q)
+{
+    api_check(L, q->target);
+
+    std::vector<GCObject*> referrers;
+
+    LuaTable* h = q->found;
+    for (int i = 0; i < sizenode(h); ++i)
+    {
+        const LuaNode& n = h->node[i];
+
+        if (!ttisnil(&n.val) && iscollectable(&n.key))
+            referrers.push_back(gcvalue(&n.key));
+    }
+
+    lua_createtable(L, 0, int(referrers.size()));
+
+    for (GCObject* referrer : referrers)
+        pushreferrer(L, referrer);
+}
+
+int lua_refindexlookup(lua_State* L, lua_HeapQuery* q)
+{
+    api_check(L, !q->target);
+    api_check(L, L->top > L->base);
+
+    GCObject* o = iscollectable(L->top - 1) ? gcvalue(L->top - 1) : NULL;
+    lua_pop(L, 1);
+
+    // objects that weren't alive when they were indexed, or that were collected since, aren't known to the index
+    if (!o || !ispinned(q->found, o))
+    {
         lua_pushnil(L);
-        luaC_threadbarrier(L);
-        setobj2s(L, L->top-1, &st.refs[k]);
-        if(ttisfunction(L->top-1))
+        return 0;
+    }
+
+    std::vector<GCObject*> referrers;
+
+    auto it = q->referrers.find(o);
+    if (it != q->referrers.end())
+    {
+        for (GCObject* referrer : it->second)
+            if (ispinned(q->found, referrer))
+                referrers.push_back(referrer);
+    }
+
+    lua_createtable(L, 0, int(referrers.size()));
+
+    // building the table can run the collector, which clears the referrers that became unreachable
+    for (GCObject* referrer : referrers)
+        if (ispinned(q->found, referrer))
+            pushreferrer(L, referrer);
+
+    return 1;
+}
+
+void lua_freeheapquery(lua_State* L, lua_HeapQuery* q)
+{
+    global_State* g = L->global;
+
+    while (!lualock_gcstep())
+    {
+    }
+
+    for (lua_HeapCursor** link = &g->heapcursors; *link; link = &(*link)->next)
+    {
+        if (*link == &q->cursor)
         {
-            Closure *cl=&((L->top-1)->value.gc->cl);
-            if (cl->isC)
-            {
-                if (cl->c.debugname)
-                    lua_pushfstring(L,"=[C] %p(%s)",cl->c.f,cl->c.debugname);
-                else
-                    lua_pushfstring(L,"=[C] %p",cl->c.f);
-            }
-            else {
-                lua_pushfstring(L,"%s:%d:%p",getstr(cl->l.p->source),luaG_getline(cl->l.p, 0),cl->l.p);
-            }
+            *link = q->cursor.next;
+            break;
         }
-        else
-            lua_pushboolean(L,true);
-        lua_rawset(L,-3);
     }
+
+    luaunlock_gcstep();
+
+    // the anchor stays in the heap until it's collected, and mustn't show up as a referrer of the target meanwhile
+    lua_getref(L, q->anchor);
+    lua_pushnil(L);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 1);
+
+    lua_unref(L, q->anchor);
+    freequery(g, q);
+}
+
+void luaC_freeheapqueries(lua_State* L)
+{
+    global_State* g = L->global;
+
+    // queries that are still open when the state is closed are freed with it; their anchors go away with the registry
+    while (lua_HeapCursor* cursor = g->heapcursors)
+    {
+        g->heapcursors = cursor->next;
+        freequery(g, (lua_HeapQuery*)cursor);
+    }
+}
+
+int lua_findreferences(lua_State* L)
+{
+    lua_HeapQuery* q = lua_newrefsearch(L);
+
+    try
+    {
+        while (!lua_heapquerystep(L, q, 0))
+        {
+        }
+
+        lua_refsearchresult(L, q);
+    }
+    catch (...)
+    {
+        lua_freeheapquery(L, q);
+        throw;
+    }
+
+    lua_freeheapquery(L, q);
     return 1;
 }
@@ -18,6 +18,7 @@ static const luaL_Reg lualibs[] = {
     {LUA_IOLIBNAME, luaopen_io},
     {LUA_INT64LIBNAME, luaopen_int64},
     {LUA_VECLIBNAME, luaopen_vector},
+    {LUA_TASKLIBNAME, luaopen_task},
     {NULL, NULL},
 };
 
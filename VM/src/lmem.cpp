@@ -3,6 +3,7 @@
 #include "lmem.h"
 
 #include "lstate.h"
+#include "lgc.h"
 #include "ldo.h"
 #include "ldebug.h"
 
@@ -72,14 +73,45 @@
  * class strategy is determined by SizeClassConfig constructor.
  *
  * Note that when the last block in a page is freed, we immediately free the page with frealloc - the
- * memory manager doesn't currently attempt to keep unused memory around. This can result in excessive
- * allocation traffic and can be mitigated by adding a page cache in the future.
+ * memory manager doesn't attempt to keep unused small pages around.
+ *
+ * Blocks that are too large for the size classes above but still below a few hundred KB (table arrays and
+ * hash parts, buffers, large strings) are frequently allocated and freed in bulk, which is slow for many
+ * system allocators. These blocks are placed in dedicated single block pages whose size is rounded up to
+ * a large size class; each power of two interval is split into 4 classes, so at most 20% of the page is
+ * wasted. When such a page is freed, it's kept in a per-class pool (global_State::largepool) instead of
+ * being returned to frealloc, as long as the pool stays below global_State::largepoollimit. Pooled pages
+ * are released by full collections, when the limit is lowered, or when frealloc fails. Non-GCO large
+ * blocks don't need block metadata since the page header is right before the block; blocks above the
+ * largest large size class are still allocated directly using frealloc.
  *
  * For both GCO and non-GCO pages, the per-page block allocation combines bump pointer style allocation
  * (lua_Page::freeNext) and per-page free list (lua_Page::freeList). We use the bump allocator to allocate
  * the contents of the page, and the free list for further reuse; this allows shorter page setup times
  * which results in less variance between allocation cost, as well as tighter sweep bounds for newly
  * allocated pages.
+ *
+ * When LUAU_MULTITHREAD is enabled and worker threads are registered, page sets are shared between all
+ * threads and have to be protected by the global lock. To keep allocation off that lock, each lua_State
+ * owns an allocation cache (lua_AllocCache) with a free block list per size class. Cache lists are
+ * refilled from the page sets in batches, and non-GCO blocks freed by the thread are kept in the cache
+ * until the list grows past two batches, at which point one batch is drained back to the pages. Cached
+ * blocks stay allocated from the page's point of view (busyBlocks includes them), so the pages can't be
+ * released while a cache still references them; cached GCO blocks have their type set to TNIL so that
+ * the sweeper and heap walkers skip them. GCO blocks are only freed by the sweeper, so they never enter
+ * a cache on free. totalbytes/memcatbytes deltas are accumulated in the cache and folded into the
+ * global state when the cache takes the lock anyway, or when the accumulated delta grows too large.
+ *
+ * The background sweeper (see lgc.cpp) takes all GCO pages out of the page sets for the duration of a sweep.
+ * Detached pages are flagged with lua_Page::sweeping, which keeps blocks freed by the sweeper from being
+ * published in the page free list; the pages are linked back into allgcopages, and into freegcopages if they
+ * have free blocks, once the mutator takes them back.
+ *
+ * Since GCO blocks never move on their own, a long running application can be left with many sparsely populated pages after its
+ * live heap shrinks. The compacting pass (see luaC_compact) evacuates such pages when all objects in them can be moved: the objects
+ * are copied into other pages of the same size class, the old copies are flagged with MOVEDBIT and their free list link points to
+ * the new copy. Once the collector has redirected all references, the evacuated pages are returned to frealloc. Pages that receive
+ * the objects are allocated before anything is moved, so the pass either moves all objects of a size class or none of them.
  */
 
 #ifndef __has_feature
@@ -127,6 +159,9 @@ static_assert(sizeof(LuaTable) == ABISWITCH(48, 32, 32), "size mismatch for tabl
 static_assert(offsetof(Buffer, data) == ABISWITCH(8, 8, 8), "size mismatch for buffer header");
 #endif
 
+// locks of shared tables live outside of the table (see LuaTableLock), keep the upstream header size at least on 64-bit targets
+static_assert(sizeof(void*) != 8 || sizeof(LuaTable) == 48, "size mismatch for table header");
+
 // The userdata is designed to provide 16 byte alignment for 16 byte and larger userdata sizes
 static_assert(offsetof(Udata, data) == 16, "data must be at precise offset provide proper alignment");
 
@@ -149,14 +184,38 @@ const size_t kExternalAllocatorMetaDataReduction = 24;
 const size_t kSmallPageSize = 16 * 1024 - kExternalAllocatorMetaDataReduction;
 const size_t kLargePageSize = 32 * 1024 - kExternalAllocatorMetaDataReduction;
 
+// blocks above kMaxSmallSizeUsed and up to kMaxLargeSize are allocated in single block pages from the large page pool
+// each power of two interval is split into kLargeClassSteps size classes; the first interval starts at kMaxSmallSizeUsed
+const int kLargeClassSteps = 4;
+const int kLargeClassShift = 8; // log2(kMaxSmallSizeUsed / kLargeClassSteps)
+const size_t kMaxLargeSize = kMaxSmallSizeUsed << (LUA_LARGESIZECLASSES / kLargeClassSteps);
+
+static_assert(size_t(kLargeClassSteps) << kLargeClassShift == kMaxSmallSizeUsed, "large size classes must start right after small size classes");
+static_assert(LUA_LARGESIZECLASSES % kLargeClassSteps == 0, "large size classes must cover whole power of two intervals");
+
 const size_t kBlockHeader = sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*); // suitable for aligning double & void* on all platforms
 const size_t kGCOLinkOffset = (sizeof(GCheader) + sizeof(void*) - 1) & ~(sizeof(void*) - 1); // GCO pages contain freelist links after the GC header
 
+#ifdef LUAU_MULTITHREAD
+// per-thread allocation caches move blocks to and from the page sets in batches of up to this many bytes
+const int kCacheBatchBytes = 4096;
+const int kCacheMaxBatch = 32;
+
+// allocation cache accounting is folded into global_State once the accumulated delta exceeds this value
+const ptrdiff_t kCacheMaxDelta = 64 * 1024;
+
+// number of distinct memory categories with pending accounting that an allocation cache can track
+const int kCacheMemcatSlots = 4;
+#endif
+
 struct SizeClassConfig
 {
     int sizeOfClass[kSizeClasses];
     int8_t classForSize[kMaxSmallSize + 1];
     int classCount = 0;
+#ifdef LUAU_MULTITHREAD
+    int batchOfClass[kSizeClasses];
+#endif
 
     SizeClassConfig()
     {
@@ -192,6 +251,15 @@ struct SizeClassConfig
         for (int size = kMaxSmallSize - 1; size >= 0; --size)
             if (classForSize[size] < 0)
                 classForSize[size] = classForSize[size + 1];
+
+#ifdef LUAU_MULTITHREAD
+        // small blocks are moved between the caches and the pages in larger batches
+        for (int klass = 0; klass < classCount; ++klass)
+        {
+            int batch = kCacheBatchBytes / sizeOfClass[klass];
+            batchOfClass[klass] = batch < 1 ? 1 : batch > kCacheMaxBatch ? kCacheMaxBatch : batch;
+        }
+#endif
     }
 };
 
@@ -200,6 +268,25 @@ const SizeClassConfig kSizeClassConfig;
 // size class for a block of size sz; returns -1 for size=0 because empty allocations take no space
 #define sizeclass(sz) (size_t((sz) - 1) < kMaxSmallSizeUsed ? kSizeClassConfig.classForSize[sz] : -1)
 
+// large size class for a block of size sz; returns -1 for blocks that are not pooled
+#define largesizeclass(sz) (size_t((sz) - kMaxSmallSizeUsed - 1) < kMaxLargeSize - kMaxSmallSizeUsed ? largeclassforsize(sz) : -1)
+
+static int largeclassforsize(size_t size)
+{
+    size_t last = size - 1;
+    int shift = kLargeClassShift;
+
+    while ((last >> shift) >= size_t(2 * kLargeClassSteps))
+        shift++;
+
+    return (shift - kLargeClassShift) * kLargeClassSteps + int(last >> shift) - kLargeClassSteps;
+}
+
+static size_t sizeoflargeclass(int largeClass)
+{
+    return size_t(kLargeClassSteps + 1 + largeClass % kLargeClassSteps) << (kLargeClassShift + largeClass / kLargeClassSteps);
+}
+
 // metadata for a block is stored in the first pointer of the block
 #define metadata(block) (*(void**)(block))
 #define freegcolink(block) (*(void**)((char*)block + kGCOLinkOffset))
@@ -227,9 +314,13 @@ struct lua_Page
     int freeNext;   // next free block offset in this page, in bytes; when negative, freeList is used instead
     int busyBlocks; // number of blocks allocated out of this page
 
+    uint8_t young;    // page may contain objects that are not old yet, see generational mode in lgc.cpp
+    uint8_t sweeping; // page is detached from the heap and swept by the background sweeper, see lgc.cpp
+    uint8_t region;   // page holds objects of the active allocation region and is not in the page free lists, see lua_Region
+
     // provide additional padding based on current object size to provide 16 byte alignment of data
     // later static_assert checks that this requirement is held
-    char padding[sizeof(void*) == 8 ? 8 : 12];
+    char padding[sizeof(void*) == 8 ? 5 : 9];
 
     char data[1];
 };
@@ -241,16 +332,10 @@ l_noret luaM_toobig(lua_State* L)
     luaG_runerror(L, "memory allocation error: block too big");
 }
 
-static lua_Page* newpage(lua_State* L, lua_Page** pageset, int pageSize, int blockSize, int blockCount)
+static lua_Page* initpage(lua_Page* page, lua_Page** pageset, int pageSize, int blockSize, int blockCount)
 {
-    global_State* g = L->global;
-
     LUAU_ASSERT(pageSize - int(offsetof(lua_Page, data)) >= blockSize * blockCount);
 
-    lua_Page* page = (lua_Page*)(*g->frealloc)(g->ud, NULL, 0, pageSize);
-    if (!page)
-        luaD_throw(L, LUA_ERRMEM);
-
     ASAN_POISON_MEMORY_REGION(page->data, blockSize * blockCount);
 
     // setup page header
@@ -269,6 +354,9 @@ static lua_Page* newpage(lua_State* L, lua_Page** pageset, int pageSize, int blo
     page->freeList = NULL;
     page->freeNext = (blockCount - 1) * blockSize;
     page->busyBlocks = 0;
+    page->young = 1;
+    page->sweeping = 0;
+    page->region = 0;
 
     if (pageset)
     {
@@ -281,13 +369,61 @@ static lua_Page* newpage(lua_State* L, lua_Page** pageset, int pageSize, int blo
     return page;
 }
 
+// releases pooled pages, starting from the largest ones, until the pool is not larger than limit
+static void releaselargepool(global_State* g, size_t limit)
+{
+    for (int largeClass = LUA_LARGESIZECLASSES - 1; largeClass >= 0 && g->largepoolbytes > limit; --largeClass)
+    {
+        while (lua_Page* page = g->largepool[largeClass])
+        {
+            g->largepool[largeClass] = page->next;
+            g->largepoolbytes -= page->pageSize;
+
+            (*g->frealloc)(g->ud, page, page->pageSize, 0);
+
+            if (g->largepoolbytes <= limit)
+                break;
+        }
+    }
+}
+
+// frealloc that gives the memory held by the large page pool back to the allocator before failing
+static void* poolrealloc(global_State* g, void* block, size_t osize, size_t nsize)
+{
+    void* result = (*g->frealloc)(g->ud, block, osize, nsize);
+
+    if (!result && nsize > 0 && g->largepoolbytes)
+    {
+        releaselargepool(g, 0);
+        result = (*g->frealloc)(g->ud, block, osize, nsize);
+    }
+
+    return result;
+}
+
+static lua_Page* newpage(lua_State* L, lua_Page** pageset, int pageSize, int blockSize, int blockCount)
+{
+    global_State* g = L->global;
+
+    lua_Page* page = (lua_Page*)poolrealloc(g, NULL, 0, pageSize);
+    if (!page)
+        luaD_throw(L, LUA_ERRMEM);
+
+    return initpage(page, pageset, pageSize, blockSize, blockCount);
+}
+
 // this is part of a cold path in newblock and newgcoblock
 // it is marked as noinline to prevent it from being inlined into those functions
 // if it is inlined, then the compiler may determine those functions are "too big" to be profitably inlined, which results in reduced performance
+static int classpagesize(uint8_t sizeClass)
+{
+    return kSizeClassConfig.sizeOfClass[sizeClass] > int(kLargePageThreshold) ? kLargePageSize : kSmallPageSize;
+}
+
 LUAU_NOINLINE static lua_Page* newclasspage(lua_State* L, lua_Page** freepageset, lua_Page** pageset, uint8_t sizeClass, bool storeMetadata)
 {
     int sizeOfClass = kSizeClassConfig.sizeOfClass[sizeClass];
-    int pageSize = sizeOfClass > int(kLargePageThreshold) ? kLargePageSize : kSmallPageSize;
+    int pageSize = classpagesize(sizeClass);
     int blockSize = sizeOfClass + (storeMetadata ? kBlockHeader : 0);
     int blockCount = (pageSize - offsetof(lua_Page, data)) / blockSize;
 
@@ -300,10 +436,8 @@ LUAU_NOINLINE static lua_Page* newclasspage(lua_State* L, lua_Page** freepageset
     return page;
 }
 
-static void freepage(lua_State* L, lua_Page** pageset, lua_Page* page)
+static void unlinkpage(lua_Page** pageset, lua_Page* page)
 {
-    global_State* g = L->global;
-
     if (pageset)
     {
         // remove page from alllist
@@ -315,6 +449,24 @@ static void freepage(lua_State* L, lua_Page** pageset, lua_Page* page)
         else if (*pageset == page)
             *pageset = page->listnext;
     }
+}
+
+// incremental heap queries (see lgcdebug.cpp) keep cursors into allgcopages, which can't be left on a page that leaves the list
+static void skipgcopage(global_State* g, lua_Page* page)
+{
+    for (lua_HeapCursor* cursor = g->heapcursors; cursor; cursor = cursor->next)
+        if (cursor->page == page)
+            cursor->page = page->listnext;
+}
+
+static void freepage(lua_State* L, lua_Page** pageset, lua_Page* page)
+{
+    global_State* g = L->global;
+
+    if (pageset == &g->allgcopages)
+        skipgcopage(g, page);
+
+    unlinkpage(pageset, page);
 
     // so long
     (*g->frealloc)(g->ud, page, page->pageSize, 0);
@@ -334,6 +486,98 @@ static void freeclasspage(lua_State* L, lua_Page** freepageset, lua_Page** pages
     freepage(L, pageset, page);
 }
 
+// allocates a single block page for a block that is too large for size classes, with the block already allocated out of it
+// returns NULL when the page can't be allocated so that the callers can release the global lock before throwing
+static lua_Page* newlargepage(lua_State* L, lua_Page** pageset, int blockSize)
+{
+    global_State* g = L->global;
+
+    int largeClass = largesizeclass(blockSize);
+    int pageSize = int(offsetof(lua_Page, data)) + (largeClass >= 0 ? int(sizeoflargeclass(largeClass)) : blockSize);
+
+    lua_Page* page = largeClass >= 0 ? g->largepool[largeClass] : NULL;
+
+    if (page)
+    {
+        g->largepool[largeClass] = page->next;
+        g->largepoolbytes -= pageSize;
+        g->largepoolhits++;
+    }
+    else
+    {
+        page = (lua_Page*)poolrealloc(g, NULL, 0, pageSize);
+        if (!page)
+            return NULL;
+
+        if (largeClass >= 0)
+            g->largepoolmisses++;
+    }
+
+    initpage(page, pageset, pageSize, blockSize, 1);
+
+    ASAN_UNPOISON_MEMORY_REGION(page->data, blockSize);
+
+    page->freeNext -= blockSize;
+    page->busyBlocks++;
+
+    return page;
+}
+
+static void freelargepage(lua_State* L, lua_Page** pageset, lua_Page* page)
+{
+    global_State* g = L->global;
+
+    LUAU_ASSERT(page->busyBlocks == 1);
+
+    int largeClass = largesizeclass(page->blockSize);
+
+    if (largeClass < 0 || g->largepoolbytes + page->pageSize > g->largepoollimit)
+    {
+        freepage(L, pageset, page);
+        return;
+    }
+
+    if (pageset == &g->allgcopages)
+        skipgcopage(g, page);
+
+    unlinkpage(pageset, page);
+
+    page->next = g->largepool[largeClass];
+    g->largepool[largeClass] = page;
+    g->largepoolbytes += page->pageSize;
+
+    ASAN_POISON_MEMORY_REGION(page->data, page->pageSize - offsetof(lua_Page, data));
+}
+
+// non-GCO large blocks are stored right after the page header; blocks above kMaxLargeSize are allocated with frealloc
+static void* newlargeblock(lua_State* L, size_t nsize)
+{
+    global_State* g = L->global;
+
+    if (largesizeclass(nsize) < 0)
+        return poolrealloc(g, NULL, 0, nsize);
+
+    lua_Page* page = newlargepage(L, NULL, int(nsize));
+
+    return page ? page->data : NULL;
+}
+
+static void freelargeblock(lua_State* L, void* block, size_t osize)
+{
+    global_State* g = L->global;
+
+    if (largesizeclass(osize) < 0)
+    {
+        (*g->frealloc)(g->ud, block, osize, 0);
+        return;
+    }
+
+    lua_Page* page = (lua_Page*)((char*)block - offsetof(lua_Page, data));
+    LUAU_ASSERT(size_t(page->blockSize) == osize);
+
+    freelargepage(L, NULL, page);
+}
+
 static void* newblock(lua_State* L, int sizeClass)
 {
     global_State* g = L->global;
@@ -415,6 +659,8 @@ static void* newgcoblock(lua_State* L, int sizeClass)
         page->busyBlocks++;
     }
 
+    page->young = 1;
+
     // if we allocate the last block out of a page, we need to remove it from free list
     if (!page->freeList && page->freeNext < 0)
     {
@@ -473,8 +719,21 @@ static void freegcoblock(lua_State* L, int sizeClass, void* block, lua_Page* pag
 
     global_State* g = L->global;
 
+    // region pages keep their free blocks to themselves and stay around until the region is popped
+    if (page->region)
+    {
+        freegcolink(block) = page->freeList;
+        page->freeList = block;
+
+        ASAN_POISON_MEMORY_REGION((char*)block + sizeof(GCheader), page->blockSize - sizeof(GCheader));
+
+        page->busyBlocks--;
+        return;
+    }
+
     // if the page wasn't in the page free list, it should be now since it got a block!
-    if (!page->freeList && page->freeNext < 0)
+    // pages owned by the background sweeper are only published once they are linked back into the heap
+    if (!page->freeList && page->freeNext < 0 && !page->sweeping)
     {
         LUAU_ASSERT(!page->prev);
         LUAU_ASSERT(!page->next);
@@ -498,123 +757,716 @@ static void freegcoblock(lua_State* L, int sizeClass, void* block, lua_Page* pag
         freeclasspage(L, g->freegcopages, &g->allgcopages, page, sizeClass);
 }
 
-void* luaM_new_(lua_State* L, size_t nsize, uint8_t memcat)
+/*
+ * Allocation regions (see lua_pushregion) bump allocate tables out of memory that is only released when the region is popped.
+ *
+ * Region objects live on dedicated GCO pages that are linked into the list of all pages, so that the collector marks and sweeps them
+ * like any other object while the region is active, but are never published in the page free lists. Each size class allocates from
+ * the most recent page only, blocks that the collector frees on older pages are simply left alone.
+ *
+ * Other blocks of region objects (table array and hash parts) are carved out of large chunks; freeing them only updates accounting.
+ *
+ * When nothing escaped the region, all of its pages and chunks are released at once by luaM_freeregion, regardless of their contents.
+ * Otherwise luaM_adoptregion turns region pages into regular pages after the objects were moved out of the chunks.
+ *
+ * Regions usually follow each other with similar sizes (once per frame), so the memory of the last released region is kept for the
+ * next one; whatever the next region doesn't use by the time it's released goes back to the allocator.
+ */
+struct lua_RegionChunk
+{
+    lua_RegionChunk* next;
+
+    size_t size; // usable size of data in bytes
+    size_t used; // bytes allocated out of data so far
+
+    char padding[sizeof(void*) == 8 ? 8 : 4];
+
+    char data[1];
+};
+
+static_assert(offsetof(lua_RegionChunk, data) % 16 == 0, "data must be 16 byte aligned");
+
+const size_t kRegionChunkSize = 64 * 1024 - kExternalAllocatorMetaDataReduction;
+
+static void* newregiongcoblock(lua_State* L, int sizeClass)
 {
     global_State* g = L->global;
+    lua_Page* page = g->region.gcopages[sizeClass];
 
-    int nclass = sizeclass(nsize);
+    if (!page || (!page->freeList && page->freeNext < 0))
+    {
+        int pageSize = classpagesize(uint8_t(sizeClass));
+        int blockSize = kSizeClassConfig.sizeOfClass[sizeClass];
 
-    lualock_global();
-    void* block = nclass >= 0 ? newblock(L, nclass) : (*g->frealloc)(g->ud, NULL, 0, nsize);
-    if (block == NULL && nsize > 0) {
-        luaunlock_global();
-        luaD_throw(L, LUA_ERRMEM);
+        lua_Page* fresh = NULL;
+
+        for (lua_Page** spare = &g->region.sparepages; *spare; spare = &(*spare)->next)
+        {
+            if ((*spare)->pageSize == pageSize)
+            {
+                fresh = *spare;
+                *spare = fresh->next;
+                break;
+            }
+        }
+
+        if (!fresh)
+            fresh = (lua_Page*)poolrealloc(g, NULL, 0, pageSize);
+
+        if (!fresh)
+            return NULL;
+
+        initpage(fresh, &g->allgcopages, pageSize, blockSize, (pageSize - offsetof(lua_Page, data)) / blockSize);
+        fresh->region = 1;
+
+        // region pages of a size class are chained with the free list links
+        fresh->next = page;
+        g->region.gcopages[sizeClass] = page = fresh;
     }
 
-    g->totalbytes += nsize;
-    g->memcatbytes[memcat] += nsize;
-    luaunlock_global();
+    void* block;
 
-    if (LUAU_UNLIKELY(!!g->cb.onallocate))
+    if (page->freeNext >= 0)
     {
-        g->cb.onallocate(L, 0, nsize);
+        block = &page->data + page->freeNext;
+        ASAN_UNPOISON_MEMORY_REGION(block, page->blockSize);
+
+        page->freeNext -= page->blockSize;
+    }
+    else
+    {
+        block = page->freeList;
+        ASAN_UNPOISON_MEMORY_REGION((char*)block + sizeof(GCheader), page->blockSize - sizeof(GCheader));
+
+        page->freeList = freegcolink(block);
     }
 
+    page->busyBlocks++;
+    page->young = 1;
+
     return block;
 }
 
-GCObject* luaM_newgco_(lua_State* L, size_t nsize, uint8_t memcat)
+static void* newregionblock(lua_State* L, size_t nsize)
 {
-    // we need to accommodate space for link for free blocks (freegcolink)
-    LUAU_ASSERT(nsize >= kGCOLinkOffset + sizeof(void*));
-
     global_State* g = L->global;
 
-    int nclass = sizeclass(nsize);
+    if (nsize == 0)
+        return NULL;
 
-    void* block = NULL;
-    lualock_global();
+    size_t asize = (nsize + kBlockHeader - 1) & ~(kBlockHeader - 1);
+    lua_RegionChunk* chunk = g->region.chunks;
 
-    if (nclass >= 0)
+    if (chunk && chunk->size - chunk->used >= asize)
     {
-        block = newgcoblock(L, nclass);
+        void* block = chunk->data + chunk->used;
+        ASAN_UNPOISON_MEMORY_REGION(block, nsize);
+
+        chunk->used += asize;
+        return block;
     }
+
+    size_t capacity = kRegionChunkSize - offsetof(lua_RegionChunk, data);
+    size_t size = asize > capacity ? asize : capacity;
+
+    lua_RegionChunk* fresh = size == capacity ? g->region.sparechunks : NULL;
+
+    if (fresh)
+        g->region.sparechunks = fresh->next;
     else
-    {
-        lua_Page* page = newpage(L, &g->allgcopages, offsetof(lua_Page, data) + int(nsize), int(nsize), 1);
+        fresh = (lua_RegionChunk*)poolrealloc(g, NULL, 0, offsetof(lua_RegionChunk, data) + size);
 
-        block = &page->data;
-        ASAN_UNPOISON_MEMORY_REGION(block, page->blockSize);
+    if (!fresh)
+        return NULL;
 
-        page->freeNext -= page->blockSize;
-        page->busyBlocks++;
-    }
+    fresh->size = size;
+    fresh->used = asize;
 
-    if (block == NULL && nsize > 0)
+    ASAN_POISON_MEMORY_REGION(fresh->data + nsize, size - nsize);
+
+    // a block that doesn't fit into a regular chunk gets a chunk of its own, which goes behind the current one so that the current one stays in use
+    if (chunk && size > capacity)
     {
-        luaunlock_global();
-        luaD_throw(L, LUA_ERRMEM);
+        fresh->next = chunk->next;
+        chunk->next = fresh;
     }
-
-    g->totalbytes += nsize;
-    g->memcatbytes[memcat] += nsize;
-    luaunlock_global();
-
-    if (LUAU_UNLIKELY(!!g->cb.onallocate))
+    else
     {
-        g->cb.onallocate(L, 0, nsize);
+        fresh->next = chunk;
+        g->region.chunks = fresh;
     }
 
-    return (GCObject*)block;
+    return fresh->data;
 }
 
-void luaM_free_(lua_State* L, void* block, size_t osize, uint8_t memcat)
+static void freeregionchunks(global_State* g, lua_RegionChunk** chunks)
 {
-    global_State* g = L->global;
-    LUAU_ASSERT((osize == 0) == (block == NULL));
+    while (lua_RegionChunk* chunk = *chunks)
+    {
+        *chunks = chunk->next;
 
-    int oclass = sizeclass(osize);
-    lualock_global();
+        (*g->frealloc)(g->ud, chunk, offsetof(lua_RegionChunk, data) + chunk->size, 0);
+    }
+}
 
-    if (oclass >= 0)
-        freeblock(L, oclass, block);
-    else
-        (*g->frealloc)(g->ud, block, osize, 0);
+static void freeregionspare(global_State* g)
+{
+    while (lua_Page* page = g->region.sparepages)
+    {
+        g->region.sparepages = page->next;
 
-    g->totalbytes -= osize;
-    g->memcatbytes[memcat] -= osize;
-    luaunlock_global();
+        (*g->frealloc)(g->ud, page, page->pageSize, 0);
+    }
+
+    freeregionchunks(g, &g->region.sparechunks);
 }
 
-void luaM_freegco_(lua_State* L, GCObject* block, size_t osize, uint8_t memcat, lua_Page* page)
+// the sweep cursor can't be left on a page that is removed from the heap
+static void unlinkregionpage(global_State* g, lua_Page* page)
 {
-    global_State* g = L->global;
-    LUAU_ASSERT((osize == 0) == (block == NULL));
+    if (g->sweepgcopage == page)
+        g->sweepgcopage = page->listnext;
 
-    int oclass = sizeclass(osize);
-    lualock_global();
+    skipgcopage(g, page);
+    unlinkpage(&g->allgcopages, page);
+}
 
-    if (oclass >= 0)
-    {
-        block->gch.tt = LUA_TNIL;
+#ifdef LUAU_MULTITHREAD
+struct lua_AllocCache
+{
+    void* blocks[kSizeClasses];    // free non-GCO blocks (user data pointers), linked with cachelink()
+    void* gcoblocks[kSizeClasses]; // free GCO blocks with type set to TNIL, linked with freegcolink()
+    int count[kSizeClasses];       // number of blocks in `blocks'
+
+    ptrdiff_t totaldelta; // pending change to global_State::totalbytes
+    ptrdiff_t memcatdelta[kCacheMemcatSlots]; // pending change to global_State::memcatbytes
+    uint8_t memcat[kCacheMemcatSlots];
+    int memcatcount;
+};
 
-        freegcoblock(L, oclass, block, page);
-    }
-    else
-    {
-        LUAU_ASSERT(page->busyBlocks == 1);
-        LUAU_ASSERT(size_t(page->blockSize) == osize);
-        LUAU_ASSERT((void*)block == page->data);
+// free non-GCO blocks in the cache are linked through the first word of the user data; block metadata keeps pointing to the page
+#define cachelink(block) (*(void**)(block))
 
-        freepage(L, &g->allgcopages, page);
-    }
+// must be called with the global lock held
+static void foldcache(global_State* g, lua_AllocCache* cache)
+{
+    g->totalbytes += cache->totaldelta;
+    cache->totaldelta = 0;
 
-    g->totalbytes -= osize;
-    g->memcatbytes[memcat] -= osize;
+    for (int i = 0; i < cache->memcatcount; ++i)
+        g->memcatbytes[cache->memcat[i]] += cache->memcatdelta[i];
+    cache->memcatcount = 0;
+}
+
+LUAU_NOINLINE static void flushcache(lua_State* L, lua_AllocCache* cache)
+{
+    lualock_global();
+    foldcache(L->global, cache);
     luaunlock_global();
 }
 
-void* luaM_realloc_(lua_State* L, void* block, size_t osize, size_t nsize, uint8_t memcat)
+LUAU_NOINLINE static lua_AllocCache* newcache(lua_State* L)
+{
+    global_State* g = L->global;
+
+    lualock_global();
+    lua_AllocCache* cache = (lua_AllocCache*)(*g->frealloc)(g->ud, NULL, 0, sizeof(lua_AllocCache));
+    luaunlock_global();
+
+    if (!cache)
+        luaD_throw(L, LUA_ERRMEM);
+
+    memset(cache, 0, sizeof(lua_AllocCache));
+    L->alloccache = cache;
+    return cache;
+}
+
+static lua_AllocCache* getcache(lua_State* L)
+{
+    lua_AllocCache* cache = L->alloccache;
+    return LUAU_LIKELY(cache != NULL) ? cache : newcache(L);
+}
+
+static void cacheaccount(lua_State* L, lua_AllocCache* cache, uint8_t memcat, ptrdiff_t delta)
+{
+    int slot = 0;
+    while (slot < cache->memcatcount && cache->memcat[slot] != memcat)
+        slot++;
+
+    if (slot == cache->memcatcount)
+    {
+        if (slot == kCacheMemcatSlots)
+        {
+            flushcache(L, cache);
+            slot = 0;
+        }
+
+        cache->memcat[slot] = memcat;
+        cache->memcatdelta[slot] = 0;
+        cache->memcatcount = slot + 1;
+    }
+
+    cache->totaldelta += delta;
+    cache->memcatdelta[slot] += delta;
+
+    if (LUAU_UNLIKELY(cache->totaldelta > kCacheMaxDelta || cache->totaldelta < -kCacheMaxDelta))
+        flushcache(L, cache);
+}
+
+LUAU_NOINLINE static void* refillblocks(lua_State* L, lua_AllocCache* cache, int sizeClass)
+{
+    lualock_global();
+
+    // blocks are linked into the cache one at a time so that an allocation failure doesn't leak them
+    for (int i = 0; i < kSizeClassConfig.batchOfClass[sizeClass]; ++i)
+    {
+        void* block = newblock(L, sizeClass);
+
+        cachelink(block) = cache->blocks[sizeClass];
+        cache->blocks[sizeClass] = block;
+        cache->count[sizeClass]++;
+    }
+
+    foldcache(L->global, cache);
+    luaunlock_global();
+
+    return cache->blocks[sizeClass];
+}
+
+LUAU_NOINLINE static void drainblocks(lua_State* L, lua_AllocCache* cache, int sizeClass, int count)
+{
+    lualock_global();
+
+    for (int i = 0; i < count; ++i)
+    {
+        void* block = cache->blocks[sizeClass];
+        cache->blocks[sizeClass] = cachelink(block);
+        cache->count[sizeClass]--;
+
+        freeblock(L, sizeClass, block);
+    }
+
+    foldcache(L->global, cache);
+    luaunlock_global();
+}
+
+LUAU_NOINLINE static void* refillgcoblocks(lua_State* L, lua_AllocCache* cache, int sizeClass)
+{
+    global_State* g = L->global;
+
+    lualock_global();
+
+    // blocks left behind by dead threads are reused first
+    if (void* orphans = g->cachedgcoblocks[sizeClass])
+    {
+        cache->gcoblocks[sizeClass] = orphans;
+        g->cachedgcoblocks[sizeClass] = NULL;
+    }
+    else
+    {
+        for (int i = 0; i < kSizeClassConfig.batchOfClass[sizeClass]; ++i)
+        {
+            GCObject* block = (GCObject*)newgcoblock(L, sizeClass);
+
+            // the block is busy from the page point of view, but sweeper and heap walkers have to skip it
+            block->gch.tt = LUA_TNIL;
+
+            freegcolink(block) = cache->gcoblocks[sizeClass];
+            cache->gcoblocks[sizeClass] = block;
+        }
+    }
+
+    foldcache(g, cache);
+    luaunlock_global();
+
+    return cache->gcoblocks[sizeClass];
+}
+
+static void* cachenewblock(lua_State* L, int sizeClass, size_t nsize, uint8_t memcat)
+{
+    lua_AllocCache* cache = getcache(L);
+
+    void* block = cache->blocks[sizeClass];
+    if (LUAU_UNLIKELY(!block))
+        block = refillblocks(L, cache, sizeClass);
+
+    cache->blocks[sizeClass] = cachelink(block);
+    cache->count[sizeClass]--;
+
+    cacheaccount(L, cache, memcat, ptrdiff_t(nsize));
+    return block;
+}
+
+static void cachefreeblock(lua_State* L, lua_AllocCache* cache, int sizeClass, void* block, size_t osize, uint8_t memcat)
+{
+    cachelink(block) = cache->blocks[sizeClass];
+    cache->blocks[sizeClass] = block;
+
+    int batch = kSizeClassConfig.batchOfClass[sizeClass];
+    if (LUAU_UNLIKELY(++cache->count[sizeClass] > 2 * batch))
+        drainblocks(L, cache, sizeClass, batch);
+
+    cacheaccount(L, cache, memcat, -ptrdiff_t(osize));
+}
+
+static void* cachenewgcoblock(lua_State* L, int sizeClass, size_t nsize, uint8_t memcat)
+{
+    lua_AllocCache* cache = getcache(L);
+
+    void* block = cache->gcoblocks[sizeClass];
+    if (LUAU_UNLIKELY(!block))
+        block = refillgcoblocks(L, cache, sizeClass);
+
+    cache->gcoblocks[sizeClass] = freegcolink(block);
+
+    cacheaccount(L, cache, memcat, ptrdiff_t(nsize));
+    return block;
+}
+
+void luaM_releasecache(lua_State* L, lua_State* L1)
+{
+    lua_AllocCache* cache = L1->alloccache;
+    if (!cache)
+        return;
+
+    global_State* g = L->global;
+
+    lualock_global();
+
+    for (size_t sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass)
+    {
+        while (void* block = cache->blocks[sizeClass])
+        {
+            cache->blocks[sizeClass] = cachelink(block);
+            freeblock(L, int(sizeClass), block);
+        }
+
+        // GCO blocks don't know their page, and the sweeper may be walking GCO pages at this point (dead threads are freed by it)
+        // so instead of returning the blocks to their pages, they are handed over to the next cache refill
+        if (void* block = cache->gcoblocks[sizeClass])
+        {
+            void* last = block;
+            while (freegcolink(last))
+                last = freegcolink(last);
+
+            freegcolink(last) = g->cachedgcoblocks[sizeClass];
+            g->cachedgcoblocks[sizeClass] = block;
+        }
+    }
+
+    foldcache(g, cache);
+    (*g->frealloc)(g->ud, cache, sizeof(lua_AllocCache), 0);
+    L1->alloccache = NULL;
+
+    luaunlock_global();
+}
+
+void luaM_freecachedgco(lua_State* L)
+{
+    global_State* g = L->global;
+
+    // once all objects are freed, the remaining GCO pages only contain blocks that were held by allocation caches
+    for (lua_Page* curr = g->allgcopages; curr;)
+    {
+        lua_Page* next = curr->listnext;
+
+        freepage(L, &g->allgcopages, curr);
+
+        curr = next;
+    }
+
+    for (size_t sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass)
+    {
+        g->freegcopages[sizeClass] = NULL;
+        g->cachedgcoblocks[sizeClass] = NULL;
+    }
+}
+
+lua_Page* luaM_detachgcopages(lua_State* L)
+{
+    global_State* g = L->global;
+
+    // the background sweeper doesn't start while heap queries walk the page list
+    LUAU_ASSERT(!g->heapcursors);
+
+    lua_Page* pages = g->allgcopages;
+
+    // pages keep their free list links until they are taken from the detached list, nobody follows them in the meantime
+    g->allgcopages = NULL;
+
+    for (size_t sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass)
+        g->freegcopages[sizeClass] = NULL;
+
+    return pages;
+}
+
+lua_Page* luaM_takegcopage(lua_Page** pages)
+{
+    lua_Page* page = *pages;
+    if (!page)
+        return NULL;
+
+    *pages = page->listnext;
+    if (page->listnext)
+        page->listnext->listprev = NULL;
+
+    page->prev = NULL;
+    page->next = NULL;
+    page->listprev = NULL;
+    page->listnext = NULL;
+    page->sweeping = 1;
+
+    return page;
+}
+
+void luaM_pushgcopage(lua_Page** pages, lua_Page* page)
+{
+    LUAU_ASSERT(page->sweeping);
+
+    // detached pages are never in a page free list, so the free list links can chain them
+    page->next = *pages;
+    *pages = page;
+}
+
+lua_Page* luaM_popgcopage(lua_Page** pages)
+{
+    lua_Page* page = *pages;
+    if (!page)
+        return NULL;
+
+    LUAU_ASSERT(page->sweeping);
+
+    *pages = page->next;
+    page->next = NULL;
+
+    return page;
+}
+
+void luaM_linkgcopage(lua_State* L, lua_Page* page)
+{
+    global_State* g = L->global;
+
+    LUAU_ASSERT(page->sweeping && !page->listprev && !page->listnext);
+
+    page->listnext = g->allgcopages;
+    if (page->listnext)
+        page->listnext->listprev = page;
+    g->allgcopages = page;
+}
+
+void luaM_releasegcopage(lua_State* L, lua_Page* page)
+{
+    global_State* g = L->global;
+
+    LUAU_ASSERT(page->sweeping && !page->prev && !page->next);
+
+    page->sweeping = 0;
+
+    // publish the blocks that were freed while the page was detached; large object pages don't have a size class
+    int sizeClass = sizeclass(page->blockSize);
+
+    if (sizeClass >= 0 && (page->freeList || page->freeNext >= 0))
+    {
+        page->next = g->freegcopages[sizeClass];
+        if (page->next)
+            page->next->prev = page;
+        g->freegcopages[sizeClass] = page;
+    }
+}
+#endif
+
+// allocation counters are only kept when enabled with LUA_GCTYPESTATS, see luaC_settypecounters
+static void countalloc(global_State* g, uint8_t memcat, int slot, size_t nsize)
+{
+    if (LUAU_LIKELY(!g->typecounters))
+        return;
+
+    lua_TypeCounters* c = &g->typecounters[memcat][slot];
+
+    if (slot != typecounterdata)
+        c->allocs += 1;
+    c->allocbytes += nsize;
+}
+
+static void countfree(global_State* g, uint8_t memcat, int slot, size_t osize)
+{
+    if (LUAU_LIKELY(!g->typecounters))
+        return;
+
+    lua_TypeCounters* c = &g->typecounters[memcat][slot];
+
+    if (slot != typecounterdata)
+        c->frees += 1;
+    c->freebytes += osize;
+}
+
+void* luaM_new_(lua_State* L, size_t nsize, uint8_t memcat)
+{
+    global_State* g = L->global;
+
+    int nclass = sizeclass(nsize);
+
+#ifdef LUAU_MULTITHREAD
+    if (luaE_luathreads(L->global) && nclass >= 0 && memcat != LUA_REGIONMEMCAT)
+    {
+        void* block = cachenewblock(L, nclass, nsize, memcat);
+        countalloc(g, memcat, typecounterdata, nsize);
+
+        if (LUAU_UNLIKELY(!!g->cb.onallocate))
+        {
+            g->cb.onallocate(L, 0, nsize);
+        }
+
+        return block;
+    }
+#endif
+
+    lualock_global();
+    void* block = memcat == LUA_REGIONMEMCAT ? newregionblock(L, nsize) : nclass >= 0 ? newblock(L, nclass) : newlargeblock(L, nsize);
+    if (block == NULL && nsize > 0) {
+        luaunlock_global();
+        luaD_throw(L, LUA_ERRMEM);
+    }
+
+    g->totalbytes += nsize;
+    g->memcatbytes[memcat] += nsize;
+    countalloc(g, memcat, typecounterdata, nsize);
+    luaunlock_global();
+
+    if (LUAU_UNLIKELY(!!g->cb.onallocate))
+    {
+        g->cb.onallocate(L, 0, nsize);
+    }
+
+    return block;
+}
+
+GCObject* luaM_newgco_(lua_State* L, size_t nsize, uint8_t memcat, uint8_t tt)
+{
+    // we need to accommodate space for link for free blocks (freegcolink)
+    LUAU_ASSERT(nsize >= kGCOLinkOffset + sizeof(void*));
+
+    global_State* g = L->global;
+
+    int nclass = sizeclass(nsize);
+
+#ifdef LUAU_MULTITHREAD
+    if (luaE_luathreads(L->global) && nclass >= 0 && memcat != LUA_REGIONMEMCAT)
+    {
+        void* block = cachenewgcoblock(L, nclass, nsize, memcat);
+        countalloc(g, memcat, typecounterslot(tt), nsize);
+
+        if (LUAU_UNLIKELY(!!g->cb.onallocate))
+        {
+            g->cb.onallocate(L, 0, nsize);
+        }
+
+        return (GCObject*)block;
+    }
+#endif
+
+    void* block = NULL;
+    lualock_global();
+
+    if (memcat == LUA_REGIONMEMCAT)
+    {
+        LUAU_ASSERT(nclass >= 0);
+        block = newregiongcoblock(L, nclass);
+    }
+    else if (nclass >= 0)
+    {
+        block = newgcoblock(L, nclass);
+    }
+    else
+    {
+        lua_Page* page = newlargepage(L, &g->allgcopages, int(nsize));
+
+        block = page ? page->data : NULL;
+    }
+
+    if (block == NULL && nsize > 0)
+    {
+        luaunlock_global();
+        luaD_throw(L, LUA_ERRMEM);
+    }
+
+    g->totalbytes += nsize;
+    g->memcatbytes[memcat] += nsize;
+    countalloc(g, memcat, typecounterslot(tt), nsize);
+    luaunlock_global();
+
+    if (LUAU_UNLIKELY(!!g->cb.onallocate))
+    {
+        g->cb.onallocate(L, 0, nsize);
+    }
+
+    return (GCObject*)block;
+}
+
+void luaM_free_(lua_State* L, void* block, size_t osize, uint8_t memcat)
+{
+    global_State* g = L->global;
+    LUAU_ASSERT((osize == 0) == (block == NULL));
+
+    int oclass = sizeclass(osize);
+
+#ifdef LUAU_MULTITHREAD
+    // the cache is never created on the free path since that can fail
+    if (luaE_luathreads(L->global) && oclass >= 0 && L->alloccache && memcat != LUA_REGIONMEMCAT)
+    {
+        cachefreeblock(L, L->alloccache, oclass, block, osize, memcat);
+        countfree(g, memcat, typecounterdata, osize);
+        return;
+    }
+#endif
+
+    lualock_global();
+
+    // region blocks are released together with the region
+    if (memcat == LUA_REGIONMEMCAT)
+        ASAN_POISON_MEMORY_REGION(block, osize);
+    else if (oclass >= 0)
+        freeblock(L, oclass, block);
+    else
+        freelargeblock(L, block, osize);
+
+    g->totalbytes -= osize;
+    g->memcatbytes[memcat] -= osize;
+    countfree(g, memcat, typecounterdata, osize);
+    luaunlock_global();
+}
+
+void luaM_freegco_(lua_State* L, GCObject* block, size_t osize, uint8_t memcat, lua_Page* page)
+{
+    global_State* g = L->global;
+    LUAU_ASSERT((osize == 0) == (block == NULL));
+
+    int oclass = sizeclass(osize);
+    lualock_global();
+
+    countfree(g, memcat, typecounterslot(block->gch.tt), osize);
+
+    if (oclass >= 0)
+    {
+        block->gch.tt = LUA_TNIL;
+
+        freegcoblock(L, oclass, block, page);
+    }
+    else
+    {
+        LUAU_ASSERT(page->busyBlocks == 1);
+        LUAU_ASSERT(size_t(page->blockSize) == osize);
+        LUAU_ASSERT((void*)block == page->data);
+
+        freelargepage(L, &g->allgcopages, page);
+    }
+
+    g->totalbytes -= osize;
+    g->memcatbytes[memcat] -= osize;
+    luaunlock_global();
+}
+
+void* luaM_realloc_(lua_State* L, void* block, size_t osize, size_t nsize, uint8_t memcat)
 {
     global_State* g = L->global;
     LUAU_ASSERT((osize == 0) == (block == NULL));
@@ -623,11 +1475,58 @@ void* luaM_realloc_(lua_State* L, void* block, size_t osize, size_t nsize, uint8
     int oclass = sizeclass(osize);
     void* result;
 
+#ifdef LUAU_MULTITHREAD
+    if (luaE_luathreads(L->global) && nclass >= 0 && oclass >= 0 && memcat != LUA_REGIONMEMCAT)
+    {
+        lua_AllocCache* cache = getcache(L);
+
+        result = cachenewblock(L, nclass, nsize, memcat);
+        memcpy(result, block, osize < nsize ? osize : nsize);
+        cachefreeblock(L, cache, oclass, block, osize, memcat);
+        countfree(g, memcat, typecounterdata, osize);
+        countalloc(g, memcat, typecounterdata, nsize);
+
+        if (LUAU_UNLIKELY(!!g->cb.onallocate))
+        {
+            g->cb.onallocate(L, osize, nsize);
+        }
+
+        return result;
+    }
+#endif
+
+    int nlarge = largesizeclass(nsize);
+    int olarge = largesizeclass(osize);
+
     lualock_global();
+    if (memcat == LUA_REGIONMEMCAT)
+    {
+        result = newregionblock(L, nsize);
+        if (result == NULL && nsize > 0) {
+            luaunlock_global();
+            luaD_throw(L, LUA_ERRMEM);
+        }
+
+        if (osize > 0 && nsize > 0)
+            memcpy(result, block, osize < nsize ? osize : nsize);
+
+        ASAN_POISON_MEMORY_REGION(block, osize);
+    }
+    else if (nlarge >= 0 && nlarge == olarge)
+    {
+        // the page of a large block already has room for any size of its large size class
+        lua_Page* page = (lua_Page*)((char*)block - offsetof(lua_Page, data));
+        LUAU_ASSERT(size_t(page->blockSize) == osize);
+
+        ASAN_UNPOISON_MEMORY_REGION(page->data, nsize);
+
+        page->blockSize = int(nsize);
+        result = block;
+    }
     // if either block needs to be allocated using a block allocator, we can't use realloc directly
-    if (nclass >= 0 || oclass >= 0)
+    else if (nclass >= 0 || oclass >= 0 || nlarge >= 0 || olarge >= 0)
     {
-        result = nclass >= 0 ? newblock(L, nclass) : (*g->frealloc)(g->ud, NULL, 0, nsize);
+        result = nclass >= 0 ? newblock(L, nclass) : newlargeblock(L, nsize);
         if (result == NULL && nsize > 0) {
             luaunlock_global();
             luaD_throw(L, LUA_ERRMEM);
@@ -639,11 +1538,11 @@ void* luaM_realloc_(lua_State* L, void* block, size_t osize, size_t nsize, uint8
         if (oclass >= 0)
             freeblock(L, oclass, block);
         else
-            (*g->frealloc)(g->ud, block, osize, 0);
+            freelargeblock(L, block, osize);
     }
     else
     {
-        result = (*g->frealloc)(g->ud, block, osize, nsize);
+        result = poolrealloc(g, block, osize, nsize);
         if (result == NULL && nsize > 0) {
             luaunlock_global();
             luaD_throw(L, LUA_ERRMEM);
@@ -653,6 +1552,8 @@ void* luaM_realloc_(lua_State* L, void* block, size_t osize, size_t nsize, uint8
     LUAU_ASSERT((nsize == 0) == (result == NULL));
     g->totalbytes = (g->totalbytes - osize) + nsize;
     g->memcatbytes[memcat] += nsize - osize;
+    countfree(g, memcat, typecounterdata, osize);
+    countalloc(g, memcat, typecounterdata, nsize);
     
     if (LUAU_UNLIKELY(!!g->cb.onallocate))
     {
@@ -663,6 +1564,147 @@ void* luaM_realloc_(lua_State* L, void* block, size_t osize, size_t nsize, uint8
     return result;
 }
 
+void luaM_trimlargepool(lua_State* L, size_t limit)
+{
+    global_State* g = L->global;
+
+    lualock_global();
+    releaselargepool(g, limit);
+    luaunlock_global();
+}
+
+void luaM_setgcomemcat(lua_State* L, GCObject* gco, size_t size, uint8_t memcat)
+{
+    global_State* g = L->global;
+    uint8_t oldmemcat = gco->gch.memcat;
+
+    lualock_global();
+
+    g->memcatbytes[oldmemcat] -= size;
+    g->memcatbytes[memcat] += size;
+
+    countfree(g, oldmemcat, typecounterslot(gco->gch.tt), size);
+    countalloc(g, memcat, typecounterslot(gco->gch.tt), size);
+
+    gco->gch.memcat = memcat;
+
+    luaunlock_global();
+}
+
+void luaM_visitregion(lua_State* L, void* context, bool (*visitor)(void* context, lua_Page* page, GCObject* gco))
+{
+    global_State* g = L->global;
+
+    for (size_t sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass)
+        for (lua_Page* page = g->region.gcopages[sizeClass]; page; page = page->next)
+            luaM_visitpage(page, context, visitor);
+}
+
+void luaM_freeregion(lua_State* L)
+{
+    global_State* g = L->global;
+    size_t capacity = kRegionChunkSize - offsetof(lua_RegionChunk, data);
+
+    lualock_global();
+
+    // memory kept from the previous region that this one didn't need is released, and this region's memory is kept instead
+    freeregionspare(g);
+
+    for (size_t sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass)
+    {
+        while (lua_Page* page = g->region.gcopages[sizeClass])
+        {
+            g->region.gcopages[sizeClass] = page->next;
+
+            unlinkregionpage(g, page);
+
+            page->next = g->region.sparepages;
+            g->region.sparepages = page;
+        }
+    }
+
+    while (lua_RegionChunk* chunk = g->region.chunks)
+    {
+        g->region.chunks = chunk->next;
+
+        if (chunk->size == capacity)
+        {
+            ASAN_POISON_MEMORY_REGION(chunk->data, chunk->size);
+
+            chunk->used = 0;
+            chunk->next = g->region.sparechunks;
+            g->region.sparechunks = chunk;
+        }
+        else
+        {
+            (*g->frealloc)(g->ud, chunk, offsetof(lua_RegionChunk, data) + chunk->size, 0);
+        }
+    }
+
+    // objects that are still in the region are gone along with their pages
+    g->totalbytes -= g->memcatbytes[LUA_REGIONMEMCAT];
+    g->memcatbytes[LUA_REGIONMEMCAT] = 0;
+
+    if (g->typecounters)
+    {
+        for (int slot = 0; slot < LUA_TYPECOUNTERS; ++slot)
+        {
+            lua_TypeCounters* c = &g->typecounters[LUA_REGIONMEMCAT][slot];
+
+            c->frees = uint64_t(c->allocs);
+            c->freebytes = uint64_t(c->allocbytes);
+        }
+    }
+
+    luaunlock_global();
+}
+
+void luaM_adoptregion(lua_State* L)
+{
+    global_State* g = L->global;
+
+    lualock_global();
+
+    for (size_t sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass)
+    {
+        while (lua_Page* page = g->region.gcopages[sizeClass])
+        {
+            g->region.gcopages[sizeClass] = page->next;
+
+            page->next = NULL;
+            page->region = 0;
+
+            if (page->busyBlocks == 0)
+            {
+                unlinkregionpage(g, page);
+                (*g->frealloc)(g->ud, page, page->pageSize, 0);
+            }
+            else if (page->freeList || page->freeNext >= 0)
+            {
+                page->next = g->freegcopages[sizeClass];
+                if (page->next)
+                    page->next->prev = page;
+                g->freegcopages[sizeClass] = page;
+            }
+        }
+    }
+
+    // region objects have been moved out of the chunks by the caller
+    LUAU_ASSERT(g->memcatbytes[LUA_REGIONMEMCAT] == 0);
+    freeregionchunks(g, &g->region.chunks);
+
+    luaunlock_global();
+}
+
+void luaM_trimregion(lua_State* L)
+{
+    global_State* g = L->global;
+
+    lualock_global();
+    freeregionspare(g);
+    luaunlock_global();
+}
+
 void luaM_getpagewalkinfo(lua_Page* page, char** start, char** end, int* busyBlocks, int* blockSize)
 {
     int blockCount = (page->pageSize - offsetof(lua_Page, data)) / page->blockSize;
@@ -690,6 +1732,16 @@ lua_Page* luaM_getnextpage(lua_Page* page)
     return page->listnext;
 }
 
+bool luaM_isyoungpage(lua_Page* page)
+{
+    return page->young != 0;
+}
+
+void luaM_setyoungpage(lua_Page* page, bool young)
+{
+    page->young = young;
+}
+
 void luaM_visitpage(lua_Page* page, void* context, bool (*visitor)(void* context, lua_Page* page, GCObject* gco))
 {
     char* start;
@@ -722,6 +1774,11 @@ void luaM_visitgco(lua_State* L, void* context, bool (*visitor)(void* context, l
 {
     global_State* g = L->global;
 
+#ifdef LUAU_MULTITHREAD
+    // pages owned by the background sweeper have to be linked back first
+    luaC_syncsweep(L);
+#endif
+
     for (lua_Page* curr = g->allgcopages; curr;)
     {
         lua_Page* next = curr->listnext; // block visit might destroy the page
@@ -731,3 +1788,233 @@ void luaM_visitgco(lua_State* L, void* context, bool (*visitor)(void* context, l
         curr = next;
     }
 }
+
+static bool ismovablepage(lua_Page* page, bool (*canmove)(GCObject* gco))
+{
+    char* start;
+    char* end;
+    int busyBlocks;
+    int blockSize;
+    luaM_getpagewalkinfo(page, &start, &end, &busyBlocks, &blockSize);
+
+    int live = 0;
+
+    for (char* pos = start; pos != end; pos += blockSize)
+    {
+        GCObject* gco = (GCObject*)pos;
+
+        if (gco->gch.tt == LUA_TNIL)
+            continue;
+
+        if (!canmove(gco))
+            return false;
+
+        live++;
+    }
+
+    // blocks held by allocation caches are busy but have no object in them, a page with such blocks can't be released
+    return live == busyBlocks;
+}
+
+static void movepage(lua_State* L, lua_Page* page, int sizeClass, lua_Page** reserve)
+{
+    global_State* g = L->global;
+
+    char* start;
+    char* end;
+    int busyBlocks;
+    int blockSize;
+    luaM_getpagewalkinfo(page, &start, &end, &busyBlocks, &blockSize);
+
+    for (char* pos = start; pos != end; pos += blockSize)
+    {
+        GCObject* gco = (GCObject*)pos;
+
+        if (gco->gch.tt == LUA_TNIL)
+            continue;
+
+        // destination pages are reserved upfront so that the objects can be moved without running out of memory halfway
+        if (!g->freegcopages[sizeClass])
+        {
+            lua_Page* fresh = *reserve;
+            LUAU_ASSERT(fresh);
+            *reserve = fresh->next;
+
+            int pageSize = classpagesize(sizeClass);
+            initpage(fresh, &g->allgcopages, pageSize, blockSize, (pageSize - offsetof(lua_Page, data)) / blockSize);
+            g->freegcopages[sizeClass] = fresh;
+        }
+
+        void* block = newgcoblock(L, sizeClass);
+        memcpy(block, gco, blockSize);
+
+        // the old copy keeps its header, and the link that free blocks use points to the new copy
+        l_setbit(gco->gch.marked, MOVEDBIT);
+        freegcolink(gco) = block;
+    }
+
+    // remove page from alllist, references to the old copies are fixed up before the page is freed
+    skipgcopage(g, page);
+
+    if (page->listnext)
+        page->listnext->listprev = page->listprev;
+
+    if (page->listprev)
+        page->listprev->listnext = page->listnext;
+    else if (g->allgcopages == page)
+        g->allgcopages = page->listnext;
+
+    page->listprev = NULL;
+    page->listnext = NULL;
+}
+
+lua_Page* luaM_evacuategcopages(lua_State* L, int occupancy, bool (*canmove)(GCObject* gco), size_t* movedbytes)
+{
+    global_State* g = L->global;
+
+    lua_Page* candidates[kSizeClasses] = {};
+    int candidatecount[kSizeClasses] = {};
+    int candidateblocks[kSizeClasses] = {};
+
+    lua_Page* evacuated = NULL;
+
+    lualock_global();
+
+    // pages that are sparse enough and only hold objects that can move are taken out of the page free lists
+    for (lua_Page* page = g->allgcopages; page; page = page->listnext)
+    {
+        // large objects have a page of their own, there is nothing to gain by moving them; region pages are released with the region
+        int sizeClass = sizeclass(page->blockSize);
+        if (sizeClass < 0 || page->region)
+            continue;
+
+        int pageBlocks = (page->pageSize - offsetof(lua_Page, data)) / page->blockSize;
+
+        if (page->busyBlocks * 100 > pageBlocks * occupancy || !ismovablepage(page, canmove))
+            continue;
+
+        if (page->prev || g->freegcopages[sizeClass] == page)
+        {
+            if (page->next)
+                page->next->prev = page->prev;
+
+            if (page->prev)
+                page->prev->next = page->next;
+            else
+                g->freegcopages[sizeClass] = page->next;
+        }
+
+        // candidates are chained with the free list links, which are not used by pages outside of the free lists
+        page->prev = NULL;
+        page->next = candidates[sizeClass];
+        candidates[sizeClass] = page;
+
+        candidatecount[sizeClass]++;
+        candidateblocks[sizeClass] += page->busyBlocks;
+    }
+
+    for (int sizeClass = 0; sizeClass < int(kSizeClasses); ++sizeClass)
+    {
+        if (!candidates[sizeClass])
+            continue;
+
+        int sizeOfClass = kSizeClassConfig.sizeOfClass[sizeClass];
+        int pageSize = classpagesize(uint8_t(sizeClass));
+        int pageBlocks = (pageSize - offsetof(lua_Page, data)) / sizeOfClass;
+
+        // objects fill the free blocks of the remaining pages first, new pages are only needed for the rest
+        int freeBlocks = 0;
+        for (lua_Page* page = g->freegcopages[sizeClass]; page; page = page->next)
+            freeBlocks += pageBlocks - page->busyBlocks;
+
+        int extraBlocks = candidateblocks[sizeClass] - freeBlocks;
+        int needed = extraBlocks > 0 ? (extraBlocks + pageBlocks - 1) / pageBlocks : 0;
+
+        lua_Page* reserve = NULL;
+        int reserved = 0;
+
+        // moving is only worth it when it releases pages
+        if (needed < candidatecount[sizeClass])
+        {
+            for (; reserved < needed; ++reserved)
+            {
+                lua_Page* page = (lua_Page*)(*g->frealloc)(g->ud, NULL, 0, pageSize);
+                if (!page)
+                    break;
+
+                page->next = reserve;
+                reserve = page;
+            }
+        }
+
+        if (reserved == needed && needed < candidatecount[sizeClass])
+        {
+            while (lua_Page* page = candidates[sizeClass])
+            {
+                candidates[sizeClass] = page->next;
+
+                movepage(L, page, sizeClass, &reserve);
+                *movedbytes += size_t(page->busyBlocks) * sizeOfClass;
+
+                page->next = evacuated;
+                evacuated = page;
+            }
+
+            LUAU_ASSERT(!reserve);
+        }
+        else
+        {
+            while (lua_Page* page = reserve)
+            {
+                reserve = page->next;
+                (*g->frealloc)(g->ud, page, pageSize, 0);
+            }
+
+            // the pages stay where they are, and go back to the free list unless they are full
+            while (lua_Page* page = candidates[sizeClass])
+            {
+                candidates[sizeClass] = page->next;
+                page->next = NULL;
+
+                if (page->freeList || page->freeNext >= 0)
+                {
+                    page->next = g->freegcopages[sizeClass];
+                    if (page->next)
+                        page->next->prev = page;
+                    g->freegcopages[sizeClass] = page;
+                }
+            }
+        }
+    }
+
+    luaunlock_global();
+
+    return evacuated;
+}
+
+GCObject* luaM_forwardgco(GCObject* gco)
+{
+    LUAU_ASSERT(testbit(gco->gch.marked, MOVEDBIT));
+    return (GCObject*)freegcolink(gco);
+}
+
+size_t luaM_freeevacuatedpages(lua_State* L, lua_Page* pages)
+{
+    global_State* g = L->global;
+
+    size_t released = 0;
+
+    lualock_global();
+
+    while (lua_Page* page = pages)
+    {
+        pages = page->next;
+        released += page->pageSize;
+
+        freepage(L, NULL, page);
+    }
+
+    luaunlock_global();
+
+    return released;
+}
@@ -7,7 +7,7 @@
 struct lua_Page;
 union GCObject;
 
-#define luaM_newgco(L, t, size, memcat) cast_to(t*, luaM_newgco_(L, size, memcat))
+#define luaM_newgco(L, t, size, memcat, tt) cast_to(t*, luaM_newgco_(L, size, memcat, tt))
 #define luaM_freegco(L, p, size, memcat, page) luaM_freegco_(L, obj2gco(p), size, memcat, page)
 
 #define luaM_arraysize_(L, n, e) ((cast_to(size_t, (n)) <= SIZE_MAX / (e)) ? (n) * (e) : (luaM_toobig(L), SIZE_MAX))
@@ -18,16 +18,42 @@ union GCObject;
     ((v) = cast_to(t*, luaM_realloc_(L, v, (oldn) * sizeof(t), luaM_arraysize_(L, n, sizeof(t)), memcat)))
 
 LUAI_FUNC void* luaM_new_(lua_State* L, size_t nsize, uint8_t memcat);
-LUAI_FUNC GCObject* luaM_newgco_(lua_State* L, size_t nsize, uint8_t memcat);
+LUAI_FUNC GCObject* luaM_newgco_(lua_State* L, size_t nsize, uint8_t memcat, uint8_t tt);
 LUAI_FUNC void luaM_free_(lua_State* L, void* block, size_t osize, uint8_t memcat);
 LUAI_FUNC void luaM_freegco_(lua_State* L, GCObject* block, size_t osize, uint8_t memcat, lua_Page* page);
 LUAI_FUNC void* luaM_realloc_(lua_State* L, void* block, size_t osize, size_t nsize, uint8_t memcat);
 
 LUAI_FUNC l_noret luaM_toobig(lua_State* L);
 
+#ifdef LUAU_MULTITHREAD
+LUAI_FUNC void luaM_releasecache(lua_State* L, lua_State* L1);
+LUAI_FUNC void luaM_freecachedgco(lua_State* L);
+LUAI_FUNC lua_Page* luaM_detachgcopages(lua_State* L);
+LUAI_FUNC lua_Page* luaM_takegcopage(lua_Page** pages);
+LUAI_FUNC void luaM_pushgcopage(lua_Page** pages, lua_Page* page);
+LUAI_FUNC lua_Page* luaM_popgcopage(lua_Page** pages);
+LUAI_FUNC void luaM_linkgcopage(lua_State* L, lua_Page* page);
+LUAI_FUNC void luaM_releasegcopage(lua_State* L, lua_Page* page);
+#endif
+
+LUAI_FUNC void luaM_trimlargepool(lua_State* L, size_t limit);
+
+LUAI_FUNC void luaM_setgcomemcat(lua_State* L, GCObject* gco, size_t size, uint8_t memcat);
+
+LUAI_FUNC void luaM_visitregion(lua_State* L, void* context, bool (*visitor)(void* context, lua_Page* page, GCObject* gco));
+LUAI_FUNC void luaM_freeregion(lua_State* L);
+LUAI_FUNC void luaM_adoptregion(lua_State* L);
+LUAI_FUNC void luaM_trimregion(lua_State* L);
+
 LUAI_FUNC void luaM_getpagewalkinfo(lua_Page* page, char** start, char** end, int* busyBlocks, int* blockSize);
 LUAI_FUNC void luaM_getpageinfo(lua_Page* page, int* pageBlocks, int* busyBlocks, int* blockSize, int* pageSize);
 LUAI_FUNC lua_Page* luaM_getnextpage(lua_Page* page);
+LUAI_FUNC bool luaM_isyoungpage(lua_Page* page);
+LUAI_FUNC void luaM_setyoungpage(lua_Page* page, bool young);
+
+LUAI_FUNC lua_Page* luaM_evacuategcopages(lua_State* L, int occupancy, bool (*canmove)(GCObject* gco), size_t* movedbytes);
+LUAI_FUNC GCObject* luaM_forwardgco(GCObject* gco);
+LUAI_FUNC size_t luaM_freeevacuatedpages(lua_State* L, lua_Page* pages);
 
 LUAI_FUNC void luaM_visitpage(lua_Page* page, void* context, bool (*visitor)(void* context, lua_Page* page, GCObject* gco));
 LUAI_FUNC void luaM_visitgco(lua_State* L, void* context, bool (*visitor)(void* context, lua_Page* page, GCObject* gco));
@@ -14,9 +14,82 @@
 #include <stdlib.h>
 
 #ifdef LUAU_MULTITHREAD
-LuaSpinLock lua_globalLock;
-int lua_hasThreads=0;
-int lua_suspendedThreads=0;
+#include <condition_variable>
+#include <mutex>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define luai_cpurelax() _mm_pause()
+#elif defined(__i386__) || defined(__x86_64__)
+#define luai_cpurelax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define luai_cpurelax() __asm__ __volatile__("yield")
+#else
+#define luai_cpurelax() ((void)0)
+#endif
+
+LuaLockCounters lua_lockCounters;
+LuaTableLock lua_tableLocks[LUA_TABLELOCKS];
+
+// waiters spin for 1+2+4+...+kMaxSpinRound pauses before parking
+static const int kMaxSpinRound = 64;
+
+// parked threads wait on one of a fixed set of buckets selected by lock address, like a futex
+static const int kParkBuckets = 64;
+
+struct LuaParkBucket
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+static LuaParkBucket* parkbucket(const void* lock)
+{
+    static LuaParkBucket buckets[kParkBuckets];
+    uintptr_t h = uintptr_t(lock) >> 4;
+    return &buckets[(h ^ (h >> 6)) % kParkBuckets];
+}
+
+void LuaRWLock::lockslow(bool shared)
+{
+    (shared ? lua_lockCounters.sharedcontended : lua_lockCounters.exclusivecontended).fetch_add(1, std::memory_order_relaxed);
+
+    for (;;)
+    {
+        for (int round = 1; round <= kMaxSpinRound; round *= 2)
+        {
+            for (int i = 0; i < round; ++i)
+                luai_cpurelax();
+
+            lua_lockCounters.spins.fetch_add(1, std::memory_order_relaxed);
+
+            if (shared ? trylockshared() : trylockexclusive())
+                return;
+        }
+
+        LuaParkBucket* bucket = parkbucket(this);
+        std::unique_lock<std::mutex> guard(bucket->mutex);
+
+        // announce ourselves before the final check so that the releasing thread either sees kParked or we see the lock free
+        uint32_t s = state.fetch_or(kParked, std::memory_order_relaxed) | kParked;
+
+        if (shared ? (s & kWriter) == 0 : (s & (kWriter | kReaders)) == 0)
+            continue;
+
+        lua_lockCounters.parks.fetch_add(1, std::memory_order_relaxed);
+        bucket->cond.wait(guard);
+    }
+}
+
+void LuaRWLock::wake()
+{
+    LuaParkBucket* bucket = parkbucket(this);
+    std::lock_guard<std::mutex> guard(bucket->mutex);
+
+    // all waiters wake up and the ones that still can't get in set kParked again
+    state.fetch_and(~kParked, std::memory_order_relaxed);
+    bucket->cond.notify_all();
+}
 #endif
 
 const TValue luaO_nilobject_ = {{NULL}, {0}, LUA_TNIL};
@@ -15,69 +15,123 @@
 Luau wasn't designed with multi threading in mind, but as always making it work is just a matter of preventing
 concurrent accesses to structures. We do this here by:
 - (1) adding a mutex on global state
-- (2) adding a mutex on tables marked as 'shared'
+- (2) adding a reader/writer lock on tables marked as 'shared'
 - (3) controlling when the GC should run
 
-For (1) and (2), we use a spinlock if we detect threads are possibly active.
+Each VM keeps track of the OS threads attached to it (global_State::threads). A VM without attached threads takes no
+locks at all, whatever the other VMs in the process do.
+For (1) and (2), we use an adaptive lock if we detect threads are possibly active: it spins with exponential backoff
+for a short while, then parks the waiting thread until the lock is released. Table reads take the lock in shared mode,
+so concurrent readers never wait on each other.
 We need to ensure locks entered are always released, knowing that thread count may evolve. We assume that threads cannot be created or destroyed in whithin lockable sections.
-For (3), we prohibit GC unless all threads are suspended or yielded
+For (3), a thread that needs to run a GC step while other threads are running raises a GC request; running threads poll
+it at safepoints (the VM interrupt points: loop back edges, calls and returns) and park until the step is done. Each step
+is thus a short stop-the-world pause, and incremental marking carries on between steps with write barriers guarded by the
+global lock. While threads are enabled, every OS thread running Lua code must be attached with lua_threadattach (or
+accounted for in lua_enableThreads), and suspended with lua_threadsuspend while it blocks outside of Lua code.
  */
 
 #if 1
-class LuaSpinLock {
-    std::atomic_flag locked = ATOMIC_FLAG_INIT ;
+/* Reader/writer lock
+The low bits of 'state' count shared holders, kWriter is set while the lock is held exclusively and kParked is set
+while some thread is parked on it, telling the releasing thread to wake it.
+Exclusive ownership is recursive, keyed either on the OS thread (lock/unlock) or on the lua_State (lockt/unlockt).
+A lua_State holding the lock exclusively may also take it shared, which just counts as recursion.
+Shared ownership is not owned: new readers are admitted as long as there is no writer, so that a reader can re-enter
+the lock. The flip side is that a lua_State holding the lock shared must never try to take it exclusively.
+*/
+class LuaRWLock {
+    static const uint32_t kWriter = 1u << 31;
+    static const uint32_t kParked = 1u << 30;
+    static const uint32_t kReaders = kParked - 1;
+
+    std::atomic<uint32_t> state;
     std::thread::id lockedid;
     void * lid=nullptr;
     int lock_count = 0;
+
+    bool trylockexclusive() {
+        uint32_t s = state.load(std::memory_order_relaxed);
+        return (s & (kWriter | kReaders)) == 0 && state.compare_exchange_weak(s, s | kWriter, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    bool trylockshared() {
+        uint32_t s = state.load(std::memory_order_relaxed);
+        return (s & kWriter) == 0 && state.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    void lockslow(bool shared);
+    void wake();
+
+    void lockexclusive() {
+        if (!trylockexclusive())
+            lockslow(false);
+    }
+    void unlockexclusive() {
+        if (state.fetch_and(~kWriter, std::memory_order_release) & kParked)
+            wake();
+    }
 public:
+    LuaRWLock() : state(0) {}
+
     void lock() {
         if (lockedid==std::this_thread::get_id())
             lock_count++;
         else {
-            int i=0;
-            while (locked.test_and_set(std::memory_order_acquire)) {
-                if (++i % 10000 == 0) std::this_thread::yield();
-            }
+            lockexclusive();
             lockedid= std::this_thread::get_id();
         }
-
     }
     void unlock() {
         if (lock_count)
             lock_count--;
         else {
             lockedid=std::thread::id();
-            locked.clear(std::memory_order_release);
+            unlockexclusive();
         }
     }
     void lockt(void *L) {
         if (lid==L)
             lock_count++;
         else {
-            int i=0;
-            while (locked.test_and_set(std::memory_order_acquire)) {
-                if (++i % 10000 == 0) std::this_thread::yield();
-            }
+            lockexclusive();
             lid= L;
         }
-
     }
     void unlockt(void *L) {
         if (lock_count)
             lock_count--;
         else {
             lid=nullptr;
-            locked.clear(std::memory_order_release);
+            unlockexclusive();
+        }
+    }
+    void lockshared(void *L) {
+        if (lid==L)
+            lock_count++;
+        else if (!trylockshared())
+            lockslow(true);
+    }
+    void unlockshared(void *L) {
+        if (lid==L)
+            lock_count--;
+        else {
+            uint32_t s = state.fetch_sub(1, std::memory_order_release);
+            if ((s & kReaders) == 1 && (s & kParked))
+                wake();
         }
     }
 };
+
+/* Process-wide contention counters for all LuaRWLock instances, only updated on the slow path */
+struct LuaLockCounters {
+    std::atomic<uint64_t> exclusivecontended;
+    std::atomic<uint64_t> sharedcontended;
+    std::atomic<uint64_t> spins;
+    std::atomic<uint64_t> parks;
+};
+extern LuaLockCounters lua_lockCounters;
 #else
-#define LuaSpinLock sf::contention_free_shared_mutex<>
+#define LuaRWLock sf::contention_free_shared_mutex<>
 #endif
-
-extern LuaSpinLock lua_globalLock;
-extern int lua_hasThreads; //Total thread count
-extern int lua_suspendedThreads; //Suspended thread count
 #endif
 
 /*
@@ -386,6 +440,33 @@ typedef struct LuauBuffer
     alignas(8) char data[1];
 } Buffer;
 
+/*
+** Inline caches of table access instructions (GETTABLEKS, SETTABLEKS, NAMECALL), used when the slot hint of the instruction misses.
+** An entry either predicts the slot of the key in the table itself (mt is NULL), or, for keys that are found through the __index
+** table of a metatable, the __index table and the slots of "__index" in the metatable and of the key in the __index table.
+** Entries are hints: the tables they refer to may be dead, and every use checks the slots against the tables being accessed.
+*/
+typedef struct LuaCacheEntry
+{
+    struct LuaTable* mt;
+    struct LuaTable* h;
+    int mtslot;
+    int slot; // -1 for unused entries
+} LuaCacheEntry;
+
+typedef struct LuaInlineCache
+{
+    LuaCacheEntry entries[LUA_INLINECACHESIZE];
+    int next; // entry replaced next once all entries are used
+} LuaInlineCache;
+
+typedef struct LuaProtoCache
+{
+    uint16_t* map; // for each instruction, index of its inline cache plus one, or 0
+    int sizeic;
+    LuaInlineCache ic[1];
+} LuaProtoCache;
+
 /*
 ** Function Prototypes
 */
@@ -422,6 +503,8 @@ typedef struct Proto
 
     void* userdata;
 
+    std::atomic<LuaProtoCache*> icache; // allocated when an instruction misses a slot hint it already patched
+
     GCObject* gclist;
 
     int sizecode;
@@ -462,10 +545,6 @@ typedef struct UpVal
         TValue value; // the value (when closed)
         struct
         {
-            // global double linked list (when open)
-            struct UpVal* prev;
-            struct UpVal* next;
-
             // thread linked list (when open)
             struct UpVal* threadnext;
         } open;
@@ -552,13 +631,30 @@ typedef struct LuaNode
         checkliveness(L->global, i_o); \
     }
 
+/*
+** Table shapes
+** A table that only has string keys can keep them in a shape instead of a hash part: the shape maps each key to an index
+** in the 'slots' array of the table. Shapes are shared and immutable, tables that get the same keys in the same order end
+** up with the same shape, which is found through a transition from the previous one (see ltable.cpp).
+*/
+typedef struct LuaShape
+{
+    uint32_t id;               // unique id, the empty shape has id 0
+    int count;                 // number of keys
+    uint64_t keymask;          // bit (hash & 63) is set for every key, so that most absent keys are rejected without a scan
+    unsigned int keyhash;      // hash of the last key, which places the shape in the transition hash
+    struct LuaShape* parent;   // shape without the last key
+    struct LuaShape* hashnext; // chain in the transition hash
+    TString* keys[1];          // keys in slot order, the last one is the key of the transition from the parent
+} LuaShape;
+
 // clang-format off
 typedef struct LuaTable
 {
     CommonHeader;
 
     uint8_t tmcache;    // 1<<p means tagmethod(p) is not present
-    uint8_t readonly;   // sandboxing feature to prohibit writes to table
+    uint8_t readonly;   // sandboxing feature to prohibit writes to table, see READONLYFLAG
     uint8_t safeenv;    // environment doesn't share globals with other scripts
     uint8_t lsizenode;  // log2 of size of `node' array
     uint8_t nodemask8;  // (1<<lsizenode)-1, truncated to 8 bits
@@ -566,7 +662,7 @@ typedef struct LuaTable
     int sizearray; // size of `array' array
     union
     {
-        int lastfree;  // any free position is before this position
+        int lastfree;  // any free position is before this position; for probed hash parts, number of keys that can still be added
         int aboundary; // negated 'boundary' of `array' array; iff aboundary < 0
     };
 
@@ -574,20 +670,55 @@ typedef struct LuaTable
     TValue* array;  // array part
     LuaNode* node;
     GCObject* gclist;
-
-#ifdef LUAU_MULTITHREAD
-    uint8_t shared;
-    LuaSpinLock lock;
-#endif
 } LuaTable;
+
+// hash data of a shaped table; 'node' of the table points to it, and its first node is a sentinel (see ltable.cpp)
+typedef struct LuaShapedNode
+{
+    LuaNode sentinel;
+    LuaShape* shape;
+    int sizeslots;   // capacity of 'slots'
+    TValue slots[1]; // values of the shape keys, in slot order
+} LuaShapedNode;
+
+// number array of a packed table; 'array' of the table points to it while 'sizearray' is 0 (see ltable.cpp)
+typedef struct LuaPackedArray
+{
+    int size;          // number of elements, none of them is nil
+    int capacity;      // capacity of 'values'
+    double values[1];
+} LuaPackedArray;
 // clang-format on
 
 #ifdef LUAU_MULTITHREAD
-#define lualock_table(t) if (lua_hasThreads&&(t->shared)) t->lock.lockt(L)
-#define luaunlock_table(t) if (lua_hasThreads&&(t->shared)) t->lock.unlockt(L)
+/* Shared tables
+Most tables are never shared, so they don't carry a lock: a shared table is flagged with SHAREDBIT in its 'marked' field
+(see lgc.h) and guarded by one of a fixed pool of locks picked from its address. Two shared tables may end up on the
+same lock, which is harmless since table locks are recursive and a table lock is never taken while holding another
+table's lock for reading.
+*/
+#define LUA_TABLELOCKS 256
+
+struct alignas(64) LuaTableLock {
+    LuaRWLock lock;
+};
+
+extern LuaTableLock lua_tableLocks[LUA_TABLELOCKS];
+
+inline LuaRWLock& luaH_lockof(const void* t) {
+    uintptr_t h = uintptr_t(t) >> 4;
+    return lua_tableLocks[(h ^ (h >> 8)) % LUA_TABLELOCKS].lock;
+}
+
+#define lualock_table(t) if (luaE_luathreads(L->global)&&testbit((t)->marked, SHAREDBIT)) luaH_lockof(t).lockt(L)
+#define luaunlock_table(t) if (luaE_luathreads(L->global)&&testbit((t)->marked, SHAREDBIT)) luaH_lockof(t).unlockt(L)
+#define lualock_tableread(t) if (luaE_luathreads(L->global)&&testbit((t)->marked, SHAREDBIT)) luaH_lockof(t).lockshared(L)
+#define luaunlock_tableread(t) if (luaE_luathreads(L->global)&&testbit((t)->marked, SHAREDBIT)) luaH_lockof(t).unlockshared(L)
 #else
 #define lualock_table(t)
 #define luaunlock_table(t)
+#define lualock_tableread(t)
+#define luaunlock_tableread(t)
 #endif
 
 /*
@@ -12,6 +12,12 @@
 
 #include <string.h>
 
+#ifdef LUAU_MULTITHREAD
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
 /*
 ** Main thread combines a thread state and the global state
 */
@@ -58,12 +64,13 @@ static void f_luaopen(lua_State* L, void* ud)
     stack_init(L, L);                             // init stack
     L->gt = luaH_new(L, 0, 2);                    // table of globals
     sethvalue(L, registry(L), luaH_new(L, 0, 2)); // registry
-#ifdef LUAU_MULTITHREADING
+#ifdef LUAU_MULTITHREAD
     //Globals table and registry are shared by default
-    L->gt.shared=true;
-    registry(L)->value.gc->h.shared=true;
+    l_setbit(L->gt->marked, SHAREDBIT);
+    l_setbit(hvalue(registry(L))->marked, SHAREDBIT);
 #endif
-    luaS_resize(L, LUA_MINSTRTABSIZE);            // initial size of string table
+    for (int i = 0; i < LUA_STRSHARDS; i++)
+        luaS_resize(L, &g->strt[i], LUA_MINSTRTABSIZE); // initial size of string table
     luaT_init(L);
     luaS_fix(luaS_newliteral(L, LUA_MEMERRMSG)); // pin to make sure we can always throw this error
     luaS_fix(luaS_newliteral(L, LUA_ERRERRMSG)); // pin to make sure we can always throw this error
@@ -77,6 +84,7 @@ static void preinit_state(lua_State* L, global_State* g)
     L->stacksize = 0;
     L->gt = NULL;
     L->openupval = NULL;
+    L->twups = L;
     L->size_ci = 0;
     L->nCcalls = L->baseCcalls = 0;
     L->status = 0;
@@ -89,28 +97,56 @@ static void preinit_state(lua_State* L, global_State* g)
     L->userdata = NULL;
     L->profilerHook = NULL;
     L->profileTableAllocs = false;
+#ifdef LUAU_MULTITHREAD
+    L->alloccache = NULL;
+#endif
 }
 
 static void close_state(lua_State* L)
 {
     global_State* g = L->global;
     luaF_close(L, L->stack); // close all upvalues for this thread
+    luaC_freeheapqueries(L); // heap queries that were never released
     luaC_freeall(L);         // collect all objects
-    LUAU_ASSERT(g->strt.nuse == 0);
-    luaM_freearray(L, L->global->strt.hash, L->global->strt.size, TString*, 0);
+    luaM_freeregion(L);      // pages of a region that was never popped are empty by now
+    luaM_trimregion(L);
+    luaH_freeshapes(L);      // tables are gone, and with them all uses of the shapes
+    if (g->typecounters)
+    {
+        (*g->frealloc)(g->ud, g->typecounters, sizeof(lua_TypeCounters) * LUA_MEMORY_CATEGORIES * LUA_TYPECOUNTERS, 0);
+        g->typecounters = NULL;
+    }
+    for (int i = 0; i < LUA_STRSHARDS; i++)
+    {
+        LUAU_ASSERT(g->strt[i].nuse == 0);
+        luaS_freeretired(L, &g->strt[i]);
+        luaM_freearray(L, g->strt[i].hash, g->strt[i].size, TString*, 0);
+    }
     freestack(L, L);
+#ifdef LUAU_MULTITHREAD
+    luaE_freerefs(L);
+    luaM_releasecache(L, L);
+    luaM_freecachedgco(L);
+#endif
+    luaM_trimlargepool(L, 0);
     for (int i = 0; i < LUA_SIZECLASSES; i++)
     {
         LUAU_ASSERT(g->freepages[i] == NULL);
         LUAU_ASSERT(g->freegcopages[i] == NULL);
     }
     LUAU_ASSERT(g->allgcopages == NULL);
+    LUAU_ASSERT(g->largepoolbytes == 0);
     LUAU_ASSERT(g->totalbytes == sizeof(LG));
     LUAU_ASSERT(g->memcatbytes[0] == sizeof(LG));
     for (int i = 1; i < LUA_MEMORY_CATEGORIES; i++)
         LUAU_ASSERT(g->memcatbytes[i] == 0);
     g->destructors.~vector<global_State::gc_Destructor>();
     g->ttoken.~vector<TString *>();
+#ifdef LUAU_MULTITHREAD
+    LUAU_ASSERT(g->threads.count == 0);
+    g->threads.~threadstate();
+    g->sweeper.~sweepstate();
+#endif
 
     if (L->global->ecb.close)
         L->global->ecb.close(L);
@@ -120,7 +156,7 @@ static void close_state(lua_State* L)
 
 lua_State* luaE_newthread(lua_State* L)
 {
-    lua_State* L1 = luaM_newgco(L, lua_State, sizeof(lua_State), L->activememcat);
+    lua_State* L1 = luaM_newgco(L, lua_State, sizeof(lua_State), L->activememcat, LUA_TTHREAD);
     luaC_init(L, L1, LUA_TTHREAD);
     preinit_state(L1, L->global);
     L1->activememcat = L->activememcat; // inherit the active memory category
@@ -137,9 +173,234 @@ void luaE_freethread(lua_State* L, lua_State* L1, lua_Page* page)
     if (g->cb.userthread)
         g->cb.userthread(NULL, L1);
     freestack(L, L1);
+#ifdef LUAU_MULTITHREAD
+    luaM_releasecache(L, L1);
+#endif
     luaM_freegco(L, L1, sizeof(lua_State), L1->memcat, page);
 }
 
+#ifdef LUAU_MULTITHREAD
+/*
+** Stop-the-world handshake
+** A thread that wants to run a GC step while other threads run Lua code raises gcrequest and waits until all running
+** threads are parked, either at a VM safepoint or because they wanted to collect as well. Thread counts are only
+** changed under the same mutex, so suspending a thread lets a pending handshake complete, and a thread resuming while
+** the world is stopped waits for the step to finish.
+*/
+
+// how long a collector waits for the other threads before giving up on this step, and how long to wait before trying again
+static const std::chrono::milliseconds kStopWorldTimeout(10);
+static const std::chrono::milliseconds kStopWorldBackoff(100);
+
+static void parkworld(threadstate* ts, std::unique_lock<std::mutex>& guard)
+{
+    ts->parked++;
+    ts->cond.notify_all();
+
+    while (ts->gcrequest.load(std::memory_order_relaxed))
+        ts->cond.wait(guard);
+
+    ts->parked--;
+}
+
+void luaE_enablethreads(lua_State* L, int threadDiff, int suspendedDiff)
+{
+    threadstate* ts = &L->global->threads;
+    std::unique_lock<std::mutex> guard(ts->mutex);
+
+    // threads can't start running Lua code while a collector has the world stopped
+    if (threadDiff > suspendedDiff)
+        while (ts->stopped)
+            ts->cond.wait(guard);
+
+    ts->count += threadDiff;
+    ts->suspended += suspendedDiff;
+    LUAU_ASSERT(ts->count >= 0 && ts->suspended >= 0 && ts->suspended <= ts->count);
+
+    // fewer running threads may complete a pending handshake
+    ts->cond.notify_all();
+
+    guard.unlock();
+
+    // the background sweeper only runs while no other thread uses the heap, so a new thread waits for it to finish
+    if (threadDiff > 0)
+        luaC_waitsweep(L);
+}
+
+bool luaE_attachhelper(lua_State* L, int diff)
+{
+    threadstate* ts = &L->global->threads;
+    std::unique_lock<std::mutex> guard(ts->mutex);
+
+    // helpers are only started while no other thread is attached
+    if (diff > 0 && luaE_luathreads(L->global))
+        return false;
+
+    ts->count += diff;
+    ts->suspended += diff;
+    ts->helpers += diff;
+    LUAU_ASSERT(ts->helpers >= 0 && ts->suspended <= ts->count);
+
+    return true;
+}
+
+void luaE_inithelper(lua_State* L, lua_State* H)
+{
+    H->tt = LUA_TTHREAD;
+    H->marked = bitmask(FIXEDBIT);
+    H->memcat = 0;
+    preinit_state(H, L->global);
+}
+
+void luaE_safepoint(lua_State* L)
+{
+    threadstate* ts = &L->global->threads;
+    std::unique_lock<std::mutex> guard(ts->mutex);
+
+    if (ts->gcrequest.load(std::memory_order_relaxed))
+        parkworld(ts, guard);
+}
+
+bool luaE_stopworld(lua_State* L)
+{
+    threadstate* ts = &L->global->threads;
+
+    if (!ts->count)
+        return true;
+
+    std::unique_lock<std::mutex> guard(ts->mutex);
+
+    // another thread is collecting, let it do the work
+    if (ts->gcrequest.load(std::memory_order_relaxed))
+    {
+        parkworld(ts, guard);
+        return false;
+    }
+
+    // running threads are the ones attached and not suspended, the caller being one of them unless none are running
+    bool alone = ts->count - ts->suspended <= 1;
+    std::chrono::steady_clock::time_point now = alone ? std::chrono::steady_clock::time_point() : std::chrono::steady_clock::now();
+
+    // the last handshake timed out, the heap grows until it's time to try again
+    if (!alone && now < ts->retry)
+        return false;
+
+    ts->gcrequest.store(1, std::memory_order_relaxed);
+    ts->parked++;
+
+    std::chrono::steady_clock::time_point deadline = now + kStopWorldTimeout;
+
+    while (ts->parked < ts->count - ts->suspended)
+    {
+        // a thread that is blocked outside of Lua code without being suspended can't be waited for
+        if (ts->cond.wait_until(guard, deadline) == std::cv_status::timeout && ts->parked < ts->count - ts->suspended)
+        {
+            ts->retry = std::chrono::steady_clock::now() + kStopWorldBackoff;
+            ts->parked--;
+            ts->gcrequest.store(0, std::memory_order_relaxed);
+            ts->cond.notify_all();
+            return false;
+        }
+    }
+
+    ts->stopped = true;
+    return true;
+}
+
+void luaE_resumeworld(lua_State* L)
+{
+    threadstate* ts = &L->global->threads;
+
+    if (!ts->stopped)
+        return;
+
+    std::unique_lock<std::mutex> guard(ts->mutex);
+
+    ts->stopped = false;
+    ts->parked--;
+    ts->gcrequest.store(0, std::memory_order_relaxed);
+    ts->cond.notify_all();
+}
+
+static std::atomic<int>* refnext(lua_State* L, int ref)
+{
+    refslots* rs = &L->global->refs;
+    int k = luaO_log2(unsigned(ref / LUA_REFSEGMENTBASE + 1));
+    std::atomic<int>* segment = rs->next[k].load(std::memory_order_acquire);
+
+    if (!segment)
+    {
+        // segments are only needed once a slot is released, racing threads keep the first one installed
+        int size = LUA_REFSEGMENTBASE << k;
+        std::atomic<int>* fresh = luaM_newarray(L, size, std::atomic<int>, 0);
+
+        if (rs->next[k].compare_exchange_strong(segment, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+            segment = fresh;
+        else
+            luaM_freearray(L, fresh, size, std::atomic<int>, 0);
+    }
+
+    return &segment[ref - LUA_REFSEGMENTBASE * ((1 << k) - 1)];
+}
+
+static uint64_t reflink(uint64_t head, int ref)
+{
+    return (((head >> 32) + 1) << 32) | uint32_t(ref);
+}
+
+int luaE_allocref(lua_State* L)
+{
+    refslots* rs = &L->global->refs;
+    uint64_t head = rs->freelist.load(std::memory_order_acquire);
+
+    while (int ref = int(uint32_t(head)))
+    {
+        // if another thread pops 'ref' first, the link we read may be stale but the tag it bumped makes our exchange fail
+        int next = refnext(L, ref)->load(std::memory_order_relaxed);
+
+        if (rs->freelist.compare_exchange_weak(head, reflink(head, next), std::memory_order_acquire, std::memory_order_acquire))
+            return ref;
+    }
+
+    LuaTable* reg = hvalue(registry(L));
+
+    for (;;)
+    {
+        int top = rs->top.fetch_add(1, std::memory_order_relaxed);
+        if (unsigned(top) >= INT_MAX)
+            luaD_throw(L, LUA_ERRMEM);
+
+        // integer keys that the host stored in the registry itself are never handed out
+        lualock_tableread(reg);
+        bool used = !ttisnil(luaH_getnum(reg, top + 1));
+        luaunlock_tableread(reg);
+
+        if (!used)
+            return top + 1;
+    }
+}
+
+void luaE_freeref(lua_State* L, int ref)
+{
+    refslots* rs = &L->global->refs;
+    std::atomic<int>* next = refnext(L, ref);
+    uint64_t head = rs->freelist.load(std::memory_order_relaxed);
+
+    do
+        next->store(int(uint32_t(head)), std::memory_order_relaxed);
+    while (!rs->freelist.compare_exchange_weak(head, reflink(head, ref), std::memory_order_release, std::memory_order_relaxed));
+}
+
+void luaE_freerefs(lua_State* L)
+{
+    refslots* rs = &L->global->refs;
+
+    for (int k = 0; k < LUA_REFSEGMENTS; k++)
+        if (std::atomic<int>* segment = rs->next[k].load(std::memory_order_relaxed))
+            luaM_freearray(L, segment, LUA_REFSEGMENTBASE << k, std::atomic<int>, 0);
+}
+#endif
+
 void lua_resetthread(lua_State* L)
 {
     // close upvalues before clearing anything
@@ -186,23 +447,51 @@ lua_State* lua_newstate(lua_Alloc f, void* ud)
     preinit_state(L, g);
     g->frealloc = f;
     g->ud = ud;
+#ifdef LUAU_MULTITHREAD
+    new (&g->threads) threadstate();
+    new (&g->sweeper) sweepstate();
+#endif
     g->mainthread = L;
-    g->uvhead.u.open.prev = &g->uvhead;
-    g->uvhead.u.open.next = &g->uvhead;
+    g->twups = NULL;
     g->GCthreshold = 0; // mark it as unfinished state
-    g->registryfree = 0;
+#ifdef LUAU_MULTITHREAD
+    g->refs.freelist.store(0, std::memory_order_relaxed);
+    g->refs.top.store(0, std::memory_order_relaxed);
+    for (i = 0; i < LUA_REFSEGMENTS; i++)
+        g->refs.next[i].store(NULL, std::memory_order_relaxed);
+#endif
     g->errorjmp = NULL;
     g->rngstate = 0;
     g->ptrenckey[0] = 1;
     g->ptrenckey[1] = 0;
     g->ptrenckey[2] = 0;
     g->ptrenckey[3] = 0;
-    g->strt.size = 0;
-    g->strt.nuse = 0;
-    g->strt.hash = NULL;
+    for (i = 0; i < LUA_STRSHARDS; i++)
+    {
+        g->strt[i].size = 0;
+        g->strt[i].nuse = 0;
+        g->strt[i].hash = NULL;
+#ifdef LUAU_MULTITHREAD
+        g->strt[i].retired = NULL;
+        new (&g->strt[i].lock) LuaRWLock();
+#endif
+    }
+    g->shapes.hash = NULL;
+    g->shapes.nuse = 0;
+    g->shapes.size = 0;
+    g->shapes.enabled = false;
+#ifdef LUAU_MULTITHREAD
+    new (&g->shapes.lock) LuaRWLock();
+#endif
+    memset(g->indexchains.entries, 0, sizeof(g->indexchains.entries));
+    g->indexchains.gen = 1;
     setnilvalue(&g->pseudotemp);
     setnilvalue(registry(L));
     g->gcstate = GCSpause;
+    g->gckind = GCKincremental;
+    g->gcminor = false;
+    g->gcsticky = false;
+    g->gcbgsweep = false;
     g->gray = NULL;
     g->grayagain = NULL;
     g->weak = NULL;
@@ -210,11 +499,35 @@ lua_State* lua_newstate(lua_Alloc f, void* ud)
     g->gcgoal = LUAI_GCGOAL;
     g->gcstepmul = LUAI_GCSTEPMUL;
     g->gcstepsize = LUAI_GCSTEPSIZE << 10;
+    g->gcgenminormul = LUAI_GCGENMINORMUL;
+    g->gcgenmajormul = LUAI_GCGENMAJORMUL;
     for (i = 0; i < LUA_SIZECLASSES; i++)
     {
         g->freepages[i] = NULL;
         g->freegcopages[i] = NULL;
+#ifdef LUAU_MULTITHREAD
+        g->cachedgcoblocks[i] = NULL;
+#endif
     }
+    for (i = 0; i < LUA_LARGESIZECLASSES; i++)
+        g->largepool[i] = NULL;
+    g->largepoolbytes = 0;
+    g->largepoollimit = size_t(LUAI_GCLARGEPOOL) << 10;
+    g->largepoolhits = 0;
+    g->largepoolmisses = 0;
+    g->region.owner = NULL;
+    g->region.depth = 0;
+    g->region.escaped = false;
+    g->region.memcat = 0;
+    for (i = 0; i < LUA_SIZECLASSES; i++)
+        g->region.gcopages[i] = NULL;
+    g->region.chunks = NULL;
+    g->region.sparepages = NULL;
+    g->region.sparechunks = NULL;
+    g->typecounters = NULL;
+    g->typecountersmark = 0;
+    g->typecounterscycle = 0;
+    g->heapcursors = NULL;
     g->allpages = NULL;
     g->allgcopages = NULL;
     g->sweepgcopage = NULL;
@@ -223,6 +536,7 @@ lua_State* lua_newstate(lua_Alloc f, void* ud)
     for (i = 0; i < LUA_UTAG_LIMIT; i++)
     {
         g->udatagc[i] = NULL;
+        g->udatagcbatch[i] = NULL;
         g->udatamt[i] = NULL;
     }
     for (i = 0; i < LUA_LUTAG_LIMIT; i++)
@@ -6,6 +6,13 @@
 #include "ltm.h"
 #include <vector>
 
+#ifdef LUAU_MULTITHREAD
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 // registry
 #define registry(L) (&L->global->registry)
 
@@ -16,15 +23,159 @@
 
 #define BASIC_STACK_SIZE (2 * LUA_MINSTACK)
 
+// string table is split into shards selected by the high bits of the string hash, each shard has its own lock and resizes independently
+#ifdef LUAU_MULTITHREAD
+#define LUA_STRSHARDBITS 4
+#define strshardindex(h) ((h) >> (32 - LUA_STRSHARDBITS))
+#else
+#define LUA_STRSHARDBITS 0
+#define strshardindex(h) 0
+#endif
+
+#define LUA_STRSHARDS (1 << LUA_STRSHARDBITS)
+
 // clang-format off
 typedef struct stringtable
 {
     TString** hash;
     uint32_t nuse; // number of elements
     int size;
+#ifdef LUAU_MULTITHREAD
+    struct stringtableretired* retired; // hash arrays replaced while threads were enabled, lock-free readers may still be using them
+    LuaRWLock lock;
+#endif
 } stringtable;
+
+// table shapes, see ltable.cpp
+typedef struct shapetable
+{
+    LuaShape** hash; // shapes other than the empty one, hashed by parent shape and last key
+    uint32_t nuse;   // number of elements
+    int size;
+    bool enabled;    // new tables start with the empty shape, see lua_settableshapes
+#ifdef LUAU_MULTITHREAD
+    LuaRWLock lock;
+#endif
+} shapetable;
+
+// lookups through chains of __index tables, see luaV_getindexchain
+typedef struct indexcache
+{
+    struct Entry
+    {
+        LuaTable* mt;  // metatable the lookup starts from
+        TString* key;
+        LuaTable* h;   // table of the chain that has the key, NULL if no table of the chain has it
+        int slot;      // slot of the key in h
+        uint64_t gen;  // the entry is valid as long as 'gen' of the cache doesn't change
+    } entries[LUA_INDEXCACHESIZE];
+
+    uint64_t gen; // changed by writes to the tables of cached chains, and by garbage collection
+} indexcache;
+
+// allocation region started with lua_pushregion, see lgc.cpp
+typedef struct lua_Region
+{
+    struct lua_State* owner; // thread that allocates tables in the region, NULL when no region is active
+    int depth;               // number of lua_pushregion calls not matched by lua_popregion yet
+    bool escaped;            // a region table was stored where it can outlive the region
+    uint8_t memcat;          // memory category that escaped tables are moved to
+
+    struct lua_Page* gcopages[LUA_SIZECLASSES]; // pages of region objects for each size class, bump allocated from the first one; linked with lua_Page::next
+    struct lua_RegionChunk* chunks; // memory for non-GCO blocks of region objects, bump allocated from the first one
+
+    struct lua_Page* sparepages;         // pages of the last released region, reused by the next one; linked with lua_Page::next
+    struct lua_RegionChunk* sparechunks; // chunks of the last released region, reused by the next one
+} lua_Region;
+
+// position of a heap walk that spans several calls in the list of all GCO pages; pages that leave the list move cursors past them
+typedef struct lua_HeapCursor
+{
+    struct lua_Page* page;       // next page to visit, NULL once the walk reached the end of the list
+    struct lua_HeapCursor* next; // next cursor of the VM
+} lua_HeapCursor;
 // clang-format on
 
+// allocation counters are kept for each GC object type and for blocks that are not objects (array and hash parts, stacks, code...)
+#define LUA_TYPECOUNTERS (LUA_TUPVAL - LUA_TSTRING + 2)
+#define typecounterslot(tt) ((tt) - LUA_TSTRING + 1)
+#define typecounterdata 0
+
+#ifdef LUAU_MULTITHREAD
+// threads allocating from their caches update the counters without the global lock
+typedef std::atomic<uint64_t> lua_StatCounter;
+#else
+typedef uint64_t lua_StatCounter;
+#endif
+
+// allocation counters of a memory category and type, see LUA_GCTYPESTATS
+typedef struct lua_TypeCounters
+{
+    lua_StatCounter allocs;     // objects allocated; not counted for blocks that are not objects
+    lua_StatCounter frees;      // objects freed
+    lua_StatCounter allocbytes; // bytes allocated
+    lua_StatCounter freebytes;  // bytes freed
+
+    // updated at the end of each collection cycle
+    uint64_t markallocbytes;  // allocbytes at the end of the last cycle
+    uint64_t markfreebytes;   // freebytes at the end of the last cycle
+    uint64_t cycleallocbytes; // bytes allocated during the last cycle
+    uint64_t cyclefreebytes;  // bytes freed during the last cycle
+} lua_TypeCounters;
+
+#ifdef LUAU_MULTITHREAD
+// registry slots released by lua_unref are linked into a lock-free stack; the links live outside of the registry table,
+// in segments of doubling size (the first one holds LUA_REFSEGMENTBASE slots) that never move once allocated
+#define LUA_REFSEGMENTS 26
+#define LUA_REFSEGMENTBASE 64
+
+typedef struct refslots
+{
+    std::atomic<uint64_t> freelist; // ABA tag in the high 32 bits, first free slot (or 0) in the low 32 bits
+    std::atomic<int> top; // last slot handed out from the end of the registry
+    std::atomic<std::atomic<int>*> next[LUA_REFSEGMENTS]; // next free slot for each released slot
+} refslots;
+
+// OS threads running Lua code on a VM and the stop-the-world handshake between them, see lstate.cpp
+typedef struct threadstate
+{
+    int count; // attached threads, no locks are taken while this is 0
+    int suspended; // attached threads that don't run Lua code right now
+    int helpers; // attached threads that never run Lua code, such as the background sweeper; they are counted as suspended
+
+    LuaRWLock lock; // global lock
+    uint64_t acquired; // acquisitions of the global lock, only updated while holding it (see lua_getlockstats)
+
+    std::atomic<int> gcrequest; // set while a thread waits for the others to reach a safepoint so it can run a GC step
+    std::mutex mutex; // guards the counts and the handshake state
+    std::condition_variable cond;
+    int parked; // threads parked for the current request, the collector included
+    bool stopped; // a collector is running a GC step
+    std::chrono::steady_clock::time_point retry; // when to try again after a handshake timed out
+} threadstate;
+
+// attached threads that may run Lua code and allocate through their own caches
+#define luaE_luathreads(g) ((g)->threads.count - (g)->threads.helpers)
+
+// helper thread that sweeps the pages of a cycle while the mutator keeps running, see lgc.cpp
+typedef struct sweepstate
+{
+    bool active; // the pages of the current sweep belong to the helper thread until they are linked back into the heap
+    bool busy;   // the helper thread has pages left to sweep
+    bool quit;
+
+    struct lua_Page* pages;    // detached pages waiting to be swept
+    struct lua_Page* swept;    // pages the helper thread is done with, guarded by the global lock
+    struct lua_Page* deferred; // swept pages that still hold dead objects the mutator has to free, guarded by the global lock
+    struct lua_Page* pending;  // deferred pages taken back by the mutator that it hasn't swept yet
+
+    struct lua_State* state; // used by the helper thread to free objects, never runs Lua code
+    std::thread thread;
+    std::mutex mutex; // guards pages, busy and quit
+    std::condition_variable cond;
+} sweepstate;
+#endif
+
 /*
 ** informations about a call
 **
@@ -89,6 +240,24 @@ struct GCStats
     double starttimestamp = 0;
     double atomicstarttimestamp = 0;
     double endtimestamp = 0;
+
+    // generational mode; every cycle of the incremental mode counts as a major collection
+    uint64_t minorcollections = 0; // collections that only traced young objects and the remembered set
+    uint64_t majorcollections = 0; // collections that traced the whole heap
+    size_t promotedbytes = 0;      // size of the objects that became old during the last sweep
+    size_t majorbasebytes = 0;     // heap size at the end of the last major collection
+
+    // time-budgeted steps (LUA_GCSTEPTIME)
+    double steptime = 0;          // moving average of the time taken by a single step, in seconds
+    uint64_t timedsteps = 0;      // number of budgeted calls
+    uint64_t budgetoverruns = 0;  // calls that went over their budget
+    double overruntime = 0;       // total time spent over budget, in seconds
+    double maxoverruntime = 0;    // largest single overrun, in seconds
+
+    // compacting pass (LUA_GCCOMPACT)
+    uint64_t compactions = 0;         // number of compacting passes
+    size_t compactmovedbytes = 0;     // size of the objects moved by the last pass
+    size_t compactreleasedbytes = 0;  // size of the pages released by the last pass
 };
 
 #ifdef LUAI_GCMETRICS
@@ -164,13 +333,17 @@ struct lua_ExecutionCallbacks
 // clang-format off
 typedef struct global_State
 {
-    stringtable strt; // hash table for strings
+    shapetable shapes;               // transitions between table shapes
 
     lua_Alloc frealloc;   // function to reallocate memory
     void* ud;             // auxiliary data to `frealloc'
 
     uint8_t currentwhite;
     uint8_t gcstate; // state of garbage collector
+    uint8_t gckind;  // mode of garbage collector, GCKincremental or GCKgenerational
+    bool gcminor;    // current cycle is a minor collection: old objects keep their marks from earlier cycles
+    bool gcsticky;   // objects surviving the current (or last) sweep keep their marks and become old
+    bool gcbgsweep;  // sweep on a helper thread when possible, see LUA_GCSWEEPTHREAD
 
     GCObject* gray;      // list of gray objects
     GCObject* grayagain; // list of objects to be traversed atomically
@@ -182,15 +355,29 @@ typedef struct global_State
     int gcgoal;                               // see LUAI_GCGOAL
     int gcstepmul;                            // see LUAI_GCSTEPMUL
     int gcstepsize;                           // see LUAI_GCSTEPSIZE
+    int gcgenminormul;                        // see LUAI_GCGENMINORMUL
+    int gcgenmajormul;                        // see LUAI_GCGENMAJORMUL
 
     struct lua_Page* freepages[LUA_SIZECLASSES]; // free page linked list for each size class for non-collectable objects
     struct lua_Page* freegcopages[LUA_SIZECLASSES]; // free page linked list for each size class for collectable objects
     struct lua_Page* allpages; // page linked list with all pages for all non-collectable object classes (available with LUAU_ASSERTENABLED)
     struct lua_Page* allgcopages; // page linked list with all pages for all collectable object classes
     struct lua_Page* sweepgcopage; // position of the sweep in `allgcopages'
+#ifdef LUAU_MULTITHREAD
+    void* cachedgcoblocks[LUA_SIZECLASSES]; // GCO blocks taken from allocation caches of dead threads, reused by the next cache refill
+#endif
+    struct lua_Page* largepool[LUA_LARGESIZECLASSES]; // free large pages for each large size class, linked through lua_Page::next
+    size_t largepoolbytes; // size of all pages in `largepool'
+    size_t largepoollimit; // largepoolbytes never exceeds this value, see LUAI_GCLARGEPOOL
+    uint64_t largepoolhits; // large blocks allocated from a pooled page
+    uint64_t largepoolmisses; // large blocks that needed a new page
+
+    lua_Region region; // allocation region, see lua_pushregion
+
+    lua_HeapCursor* heapcursors; // cursors of incremental heap queries, see lua_newrefsearch
 
     struct lua_State* mainthread;
-    UpVal uvhead; // head of double-linked list of all open upvalues
+    struct lua_State* twups; // list of threads with open upvalues
     struct LuaTable* mt[LUA_T_COUNT]; // metatables for basic types
     TString* ttname[LUA_T_COUNT]; // names for basic types
     TString* tmname[TM_N]; // array with tag-method names
@@ -198,7 +385,11 @@ typedef struct global_State
     TValue pseudotemp; // storage for temporary values used in pseudo2addr
 
     TValue registry; // registry table, used by lua_ref and LUA_REGISTRYINDEX
-    int registryfree; // next free slot in registry
+#ifdef LUAU_MULTITHREAD
+    threadstate threads; // threads attached to this VM
+    refslots refs; // slots allocator for lua_ref
+    sweepstate sweeper; // background sweeper
+#endif
 
     struct lua_jmpbuf* errorjmp; // jump buffer data for longjmp-style error handling
 
@@ -214,12 +405,21 @@ typedef struct global_State
     size_t memcatbytes[LUA_MEMORY_CATEGORIES]; // total amount of memory used by each memory category
 
     void (*udatagc[LUA_UTAG_LIMIT])(lua_State*, void*); // for each userdata tag, a gc callback to be called immediately before freeing memory
+    void (*udatagcbatch[LUA_UTAG_LIMIT])(lua_State*, void**, int); // for each userdata tag, a gc callback that receives batches of userdata about to be freed
     LuaTable* udatamt[LUA_UTAG_LIMIT]; // metatables for tagged userdata
 
     TString* lightuserdataname[LUA_LUTAG_LIMIT]; // names for tagged lightuserdata
 
     GCStats gcstats;
 
+    lua_TypeCounters (*typecounters)[LUA_TYPECOUNTERS]; // allocation counters for each memory category, NULL unless enabled with LUA_GCTYPESTATS
+    double typecountersmark;  // end of the last collection cycle, or the time the counters were enabled
+    double typecounterscycle; // duration of the last collection cycle (from the end of the previous one) in seconds
+
+    // kept after the fields native code reads, since A64 loads only encode small offsets from the start of the state
+    stringtable strt[LUA_STRSHARDS]; // hash table for strings
+    indexcache indexchains;          // cached __index chain lookups
+
     //GIDEROS
     lua_PrintFunc printfunc;
     void* printfuncdata;
@@ -239,13 +439,19 @@ typedef struct global_State
 
 #ifdef LUAU_MULTITHREAD
 //Acquire/Release a lock on global state
-#define lualock_global() if (lua_hasThreads) lua_globalLock.lock()
-#define luaunlock_global() if (lua_hasThreads) lua_globalLock.unlock()
+#define lualock_global() if (L->global->threads.count) L->global->threads.lock.lock(), L->global->threads.acquired++
+#define luaunlock_global() if (L->global->threads.count) L->global->threads.lock.unlock()
 //Acquire/Release a lock on GC. This should be very fast as this will be run often
 #define lualock_gc() //lualock_global()
 #define luaunlock_gc() //luaunlock_global()
-#define lualock_gcstep() (lua_hasThreads==lua_suspendedThreads)
-#define luaunlock_gcstep()
+#define lualock_gcstep() luaE_stopworld(L)
+#define luaunlock_gcstep() luaE_resumeworld(L)
+//Acquire/Release a lock on a string table shard
+#define lualock_strt(tb) if (L->global->threads.count) (tb)->lock.lock()
+#define luaunlock_strt(tb) if (L->global->threads.count) (tb)->lock.unlock()
+//Acquire/Release the lock on table shape transitions
+#define lualock_shapes() if (L->global->threads.count) L->global->shapes.lock.lock()
+#define luaunlock_shapes() if (L->global->threads.count) L->global->shapes.lock.unlock()
 
 #else
 
@@ -255,8 +461,14 @@ typedef struct global_State
 //Acquire/Release a lock on GC. This should be very fast as this will be run often
 #define lualock_gc()
 #define luaunlock_gc()
-#define lualock_gcstep()
+#define lualock_gcstep() true
 #define luaunlock_gcstep()
+//Acquire/Release a lock on a string table shard
+#define lualock_strt(tb)
+#define luaunlock_strt(tb)
+//Acquire/Release the lock on table shape transitions
+#define lualock_shapes()
+#define luaunlock_shapes()
 
 #endif
 
@@ -294,6 +506,7 @@ struct lua_State
 
     LuaTable* gt;           // table of globals
     UpVal* openupval;       // list of open upvalues in this stack
+    struct lua_State* twups; // next thread in the list of threads with open upvalues, or itself when not in the list
     GCObject* gclist;
 
     TString* namecall; // when invoked from Luau using NAMECALL, what method do we need to invoke?
@@ -302,6 +515,10 @@ struct lua_State
     void (*profilerHook)(lua_State*,int);
 
     bool profileTableAllocs; //enable gathering table allocations in a global weak table called '__tableAllocationProfiler__'
+
+#ifdef LUAU_MULTITHREAD
+    struct lua_AllocCache* alloccache; // per-thread free block cache, created on first allocation while threads are enabled
+#endif
 };
 // clang-format on
 
@@ -336,6 +553,17 @@ union GCObject
 
 LUAI_FUNC lua_State* luaE_newthread(lua_State* L);
 LUAI_FUNC void luaE_freethread(lua_State* L, lua_State* L1, struct lua_Page* page);
+#ifdef LUAU_MULTITHREAD
+LUAI_FUNC void luaE_enablethreads(lua_State* L, int threadDiff, int suspendedDiff);
+LUAI_FUNC bool luaE_attachhelper(lua_State* L, int diff);
+LUAI_FUNC void luaE_inithelper(lua_State* L, lua_State* H);
+LUAI_FUNC void luaE_safepoint(lua_State* L);
+LUAI_FUNC bool luaE_stopworld(lua_State* L);
+LUAI_FUNC void luaE_resumeworld(lua_State* L);
+LUAI_FUNC int luaE_allocref(lua_State* L);
+LUAI_FUNC void luaE_freeref(lua_State* L, int ref);
+LUAI_FUNC void luaE_freerefs(lua_State* L);
+#endif
 
 LUAI_FUNC void lua_profileTableAllocation(lua_State *L,LuaTable *t, const uint32_t *pc);
 #define profiletable(L,t,pc) if (L->profileTableAllocs) lua_profileTableAllocation(L,t,pc);
@@ -42,11 +42,21 @@ unsigned int luaS_hash(const char* str, size_t len)
     return h;
 }
 
-void luaS_resize(lua_State* L, int newsize)
+#ifdef LUAU_MULTITHREAD
+// strings are looked up without taking the shard lock, so a hash array that was replaced by a resize can't be freed until all threads are known to
+// be outside of the lookup; retired arrays are kept on a list and freed by luaS_freeretired when the GC runs, which requires all threads to be suspended
+struct stringtableretired
 {
-    lualock_global();
+    TString** hash;
+    int size;
+    stringtableretired* next;
+};
+#endif
+
+void luaS_resize(lua_State* L, stringtable* tb, int newsize)
+{
+    lualock_strt(tb);
     TString** newhash = luaM_newarray(L, newsize, TString*, 0);
-    stringtable* tb = &L->global->strt;
     for (int i = 0; i < newsize; i++)
         newhash[i] = NULL;
     // rehash
@@ -64,18 +74,81 @@ void luaS_resize(lua_State* L, int newsize)
             p = next;
         }
     }
+#ifdef LUAU_MULTITHREAD
+    if (L->global->threads.count && tb->hash)
+    {
+        stringtableretired* retired = luaM_newarray(L, 1, stringtableretired, 0);
+        retired->hash = tb->hash;
+        retired->size = tb->size;
+        retired->next = tb->retired;
+        tb->retired = retired;
+    }
+    else
+        luaM_freearray(L, tb->hash, tb->size, TString*, 0);
+
+    // lock-free readers load the size first, so the new array has to be visible before the new size is
+    // shrinking only happens during GC while all threads are suspended, so a reader can't see a size that is larger than its array
+    tb->hash = newhash;
+    std::atomic_thread_fence(std::memory_order_release);
+    tb->size = newsize;
+#else
     luaM_freearray(L, tb->hash, tb->size, TString*, 0);
     tb->size = newsize;
     tb->hash = newhash;
-    luaunlock_global();
+#endif
+    luaunlock_strt(tb);
 }
 
-static TString* newlstr(lua_State* L, const char* str, size_t l, unsigned int h)
+void luaS_freeretired(lua_State* L, stringtable* tb)
+{
+#ifdef LUAU_MULTITHREAD
+    while (stringtableretired* retired = tb->retired)
+    {
+        tb->retired = retired->next;
+        luaM_freearray(L, retired->hash, retired->size, TString*, 0);
+        luaM_freearray(L, retired, 1, stringtableretired, 0);
+    }
+#endif
+}
+
+// looks up an interned string; when threads are enabled this can run concurrently with insertions and resizes of the shard
+// in which case it may miss a string that is present, but it never returns a string with different contents
+static TString* findstr(stringtable* tb, const char* str, size_t l, unsigned int h)
+{
+    int size = tb->size;
+#ifdef LUAU_MULTITHREAD
+    std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+    for (TString* el = tb->hash[lmod(h, size)]; el != NULL; el = el->next)
+    {
+        if (el->len == l && (memcmp(str, getstr(el), l) == 0))
+            return el;
+    }
+
+    return NULL;
+}
+
+static void linkstr(lua_State* L, stringtable* tb, TString* ts, unsigned int h)
+{
+    h = lmod(h, tb->size);
+    ts->next = tb->hash[h]; // chain new entry
+#ifdef LUAU_MULTITHREAD
+    // string contents have to be visible to lock-free readers before the string is
+    std::atomic_thread_fence(std::memory_order_release);
+#endif
+    tb->hash[h] = ts;
+
+    tb->nuse++;
+    if (tb->nuse > cast_to(uint32_t, tb->size) && tb->size <= INT_MAX / 2)
+        luaS_resize(L, tb, tb->size * 2); // too crowded
+}
+
+static TString* newlstr(lua_State* L, stringtable* tb, const char* str, size_t l, unsigned int h)
 {
     if (l > MAXSSIZE)
         luaM_toobig(L);
 
-    TString* ts = luaM_newgco(L, TString, sizestring(l), L->activememcat);
+    TString* ts = luaM_newgco(L, TString, sizestring(l), L->activememcat, LUA_TSTRING);
     luaC_init(L, ts, LUA_TSTRING);
     ts->atom = ATOM_UNDEF;
     ts->hash = h;
@@ -84,14 +157,7 @@ static TString* newlstr(lua_State* L, const char* str, size_t l, unsigned int h)
     memcpy(ts->data, str, l);
     ts->data[l] = '\0'; // ending 0
 
-    stringtable* tb = &L->global->strt;
-    h = lmod(h, tb->size);
-    ts->next = tb->hash[h]; // chain new entry
-    tb->hash[h] = ts;
-
-    tb->nuse++;
-    if (tb->nuse > cast_to(uint32_t, tb->size) && tb->size <= INT_MAX / 2)
-        luaS_resize(L, tb->size * 2); // too crowded
+    linkstr(L, tb, ts, h);
 
     return ts;
 }
@@ -101,16 +167,12 @@ TString* luaS_bufstart(lua_State* L, size_t size)
     if (size > MAXSSIZE)
         luaM_toobig(L);
 
-    global_State* g = L->global;
-
-    lualock_global();
-    TString* ts = luaM_newgco(L, TString, sizestring(size), L->activememcat);
+    TString* ts = luaM_newgco(L, TString, sizestring(size), L->activememcat, LUA_TSTRING);
     luaC_init(L, ts, LUA_TSTRING);
     ts->atom = ATOM_UNDEF;
     ts->hash = 0; // computed in luaS_buffinish
     ts->len = unsigned(size);
-	ts->next = NULL;
-    luaunlock_global();
+    ts->next = NULL;
 
     return ts;
 }
@@ -118,22 +180,30 @@ TString* luaS_bufstart(lua_State* L, size_t size)
 TString* luaS_buffinish(lua_State* L, TString* ts)
 {
     unsigned int h = luaS_hash(ts->data, ts->len);
-    stringtable* tb = &L->global->strt;
-    lualock_global();
-    int bucket = lmod(h, tb->size);
+    stringtable* tb = &L->global->strt[strshardindex(h)];
 
     // search if we already have this string in the hash table
-    for (TString* el = tb->hash[bucket]; el != NULL; el = el->next)
+    // string may be dead, in which case it has to be resurrected under the lock
+    // the background sweeper frees dead strings without stopping the world, so lock-free lookups are off while it runs
+    TString* el = luaC_bgsweeping(L->global) ? NULL : findstr(tb, ts->data, ts->len, h);
+    if (el && !isdead(L->global, obj2gco(el)))
+        return el;
+
+    lualock_strt(tb);
+
+#ifdef LUAU_MULTITHREAD
+    // lock-free lookup above could have missed a string added concurrently
+    if (L->global->threads.count)
+        el = findstr(tb, ts->data, ts->len, h);
+#endif
+
+    if (el)
     {
-        if (el->len == ts->len && memcmp(el->data, ts->data, ts->len) == 0)
-        {
-            // string may be dead
-            if (isdead(L->global, obj2gco(el)))
-                changewhite(obj2gco(el));
+        if (isdead(L->global, obj2gco(el)))
+            changewhite(obj2gco(el));
 
-            luaunlock_global();
-            return el;
-        }
+        luaunlock_strt(tb);
+        return el;
     }
 
     LUAU_ASSERT(ts->next == NULL);
@@ -141,42 +211,48 @@ TString* luaS_buffinish(lua_State* L, TString* ts)
     ts->hash = h;
     ts->data[ts->len] = '\0'; // ending 0
     ts->atom = ATOM_UNDEF;
-    ts->next = tb->hash[bucket]; // chain new entry
-    tb->hash[bucket] = ts;
 
-    tb->nuse++;
-    if (tb->nuse > cast_to(uint32_t, tb->size) && tb->size <= INT_MAX / 2)
-        luaS_resize(L, tb->size * 2); // too crowded
+    linkstr(L, tb, ts, h);
 
-    luaunlock_global();
+    luaunlock_strt(tb);
     return ts;
 }
 
 TString* luaS_newlstr(lua_State* L, const char* str, size_t l)
 {
     unsigned int h = luaS_hash(str, l);
-    lualock_global();
-    for (TString* el = L->global->strt.hash[lmod(h, L->global->strt.size)]; el != NULL; el = el->next)
+    stringtable* tb = &L->global->strt[strshardindex(h)];
+
+    // string may be dead, in which case it has to be resurrected under the lock
+    TString* el = luaC_bgsweeping(L->global) ? NULL : findstr(tb, str, l, h);
+    if (el && !isdead(L->global, obj2gco(el)))
+        return el;
+
+    lualock_strt(tb);
+
+#ifdef LUAU_MULTITHREAD
+    // lock-free lookup above could have missed a string added concurrently
+    if (L->global->threads.count)
+        el = findstr(tb, str, l, h);
+#endif
+
+    if (el)
     {
-        if (el->len == l && (memcmp(str, getstr(el), l) == 0))
-        {
-            // string may be dead
-            if (isdead(L->global, obj2gco(el)))
-                changewhite(obj2gco(el));
-            luaunlock_global();
-            return el;
-        }
+        if (isdead(L->global, obj2gco(el)))
+            changewhite(obj2gco(el));
+
+        luaunlock_strt(tb);
+        return el;
     }
-    TString *ts=newlstr(L, str, l, h); // not found
-    luaunlock_global();
+
+    TString* ts = newlstr(L, tb, str, l, h); // not found
+    luaunlock_strt(tb);
     return ts;
 }
 
-static bool unlinkstr(lua_State* L, TString* ts)
+static bool unlinkstr(stringtable* tb, TString* ts)
 {
-    global_State* g = L->global;
-
-    TString** p = &g->strt.hash[lmod(ts->hash, g->strt.size)];
+    TString** p = &tb->hash[lmod(ts->hash, tb->size)];
 
     while (TString* curr = *p)
     {
@@ -196,12 +272,36 @@ static bool unlinkstr(lua_State* L, TString* ts)
 
 void luaS_free(lua_State* L, TString* ts, lua_Page* page)
 {
-    lualock_global();
-    if (unlinkstr(L, ts))
-        L->global->strt.nuse--;
+    stringtable* tb = &L->global->strt[strshardindex(ts->hash)];
+
+    lualock_strt(tb);
+    if (unlinkstr(tb, ts))
+        tb->nuse--;
     else
         LUAU_ASSERT(ts->next == NULL); // orphaned string buffer
+    luaunlock_strt(tb);
 
     luaM_freegco(L, ts, sizestring(ts->len), ts->memcat, page);
-    luaunlock_global();
 }
+
+#ifdef LUAU_MULTITHREAD
+// used by the background sweeper to remove a dead string from the string table before freeing it
+// returns false if the string was resurrected by a lookup in the meantime
+bool luaS_unlinkdead(lua_State* L, TString* ts)
+{
+    stringtable* tb = &L->global->strt[strshardindex(ts->hash)];
+
+    lualock_strt(tb);
+    bool dead = isdead(L->global, obj2gco(ts));
+    if (dead)
+    {
+        if (unlinkstr(tb, ts))
+            tb->nuse--;
+        else
+            LUAU_ASSERT(ts->next == NULL); // orphaned string buffer
+    }
+    luaunlock_strt(tb);
+
+    return dead;
+}
+#endif
@@ -16,14 +16,18 @@
 #define luaS_new(L, s) (luaS_newlstr(L, s, strlen(s)))
 #define luaS_newliteral(L, s) (luaS_newlstr(L, "" s, (sizeof(s) / sizeof(char)) - 1))
 
-#define luaS_fix(s) l_setbit((s)->marked, FIXEDBIT)
+#define luaS_fix(s) luaC_setbit(s, FIXEDBIT)
 
 LUAI_FUNC unsigned int luaS_hash(const char* str, size_t len);
 
-LUAI_FUNC void luaS_resize(lua_State* L, int newsize);
+LUAI_FUNC void luaS_resize(lua_State* L, stringtable* tb, int newsize);
+LUAI_FUNC void luaS_freeretired(lua_State* L, stringtable* tb);
 
 LUAI_FUNC TString* luaS_newlstr(lua_State* L, const char* str, size_t l);
 LUAI_FUNC void luaS_free(lua_State* L, TString* ts, struct lua_Page* page);
+#ifdef LUAU_MULTITHREAD
+LUAI_FUNC bool luaS_unlinkdead(lua_State* L, TString* ts);
+#endif
 
 LUAI_FUNC TString* luaS_bufstart(lua_State* L, size_t size);
 LUAI_FUNC TString* luaS_buffinish(lua_State* L, TString* ts);
@@ -16,6 +16,34 @@
  * Table keys can be arbitrary values unless they contain NaN. Keys are hashed and compared using raw equality,
  * so even if the key is a userdata with an overridden __eq, it's not used during hash lookups.
  *
+ * Tables that only have string keys can use a shape instead of a hash part (see lua_settableshapes). A shape is a shared and
+ * immutable list of keys, and the table keeps the values of these keys in a dense array of slots, in the same order. Adding
+ * a key to a shaped table follows a transition to the shape with one more key, so all tables that get the same keys in the
+ * same order share one shape. Shapes are kept until the state is closed; the number of shapes and the number of keys in a
+ * shape are limited, and a table that needs more keys, or a key that isn't a string, moves its keys to a hash part.
+ * The slots live in a LuaShapedNode that the table uses as its hash part of size 1: its node is a sentinel that never
+ * matches a key and doesn't terminate its chain (no real hash part of size 1 can have a chain), which identifies shaped
+ * tables, and makes code that predicts node slots or relies on an empty chain to prove that a key is absent take the slow path.
+ *
+ * Large hash parts (2^LUA_PROBEDLSIZE nodes and more) use open addressing instead of chaining, since following a chain
+ * jumps between unrelated nodes, and misses the cache at every hop once the table is larger than the cache. A probed hash
+ * part keeps a control byte per node after the nodes, either CTRL_EMPTY or 7 bits of the hash of the key of the node, and
+ * lookups compare a group of control bytes at once (using SSE2 or NEON when available) to find the few nodes worth comparing
+ * keys with. Groups are probed in triangular order starting from the group of the hash, which visits every group, and the
+ * hash part grows before it's 7/8 full, so a probe always ends at a group with an empty node. Nodes don't move until the
+ * table is resized and removed keys keep their node, like in chained hash parts, so traversals aren't affected by the layout.
+ * Nodes of probed hash parts aren't chained, and their 'next' is never 0 so that code proving that a key is absent from
+ * a table by looking at the chain of its main position takes the slow path.
+ *
+ * Array parts that only hold numbers are packed once they reach LUA_PACKEDMINSIZE elements and a number is appended to them:
+ * the numbers move to a LuaPackedArray, a dense array of doubles that takes half the memory or less, and 'sizearray' becomes 0
+ * while 'array' points to the packed array, so that all code that reads or writes the array part directly takes the slow path
+ * for packed tables. The packed array has no holes and its size is the boundary of the table; a store that would break this,
+ * like a value that isn't a number, moves the elements back to an array part of the same size, so that traversals number the
+ * keys the same way. A packed element has no TValue slot, so readers that can meet one use luaH_getnumcopy or luaH_getcopy,
+ * which copy it to a TValue of the caller; lookups never write to the table. Shared tables aren't packed, since packing
+ * or unpacking replaces the array part while other threads may be reading it.
+ *
  * Each table has a "boundary", defined as the index k where t[k] ~= nil and t[k+1] == nil. The boundary can be
  * computed using a binary search and can be adjusted when the table is modified; crucially, Luau enforces an
  * invariant where the boundary must be in the array part - this enforces a consistent iteration order through the
@@ -33,6 +61,18 @@
 
 #include <string.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LUAU_PROBE_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LUAU_PROBE_NEON
+#endif
+
 // max size of both array and hash part is 2^MAXBITS
 #define MAXBITS 26
 #define MAXSIZE (1 << MAXBITS)
@@ -52,13 +92,27 @@ const LuaNode luaH_dummynode = {
 
 #define dummynode (&luaH_dummynode)
 
+static LuaShape emptyshape = {};
+
+// hash data of tables that have the empty shape; slots are allocated when the first key is added
+static const LuaShapedNode emptyshapednode = {
+    {
+        {{NULL}, {0}, LUA_TNIL},   // value
+        {{NULL}, {0}, LUA_TNIL, 1} // key
+    },
+    &emptyshape,
+    0,
+};
+
+// table doesn't have a hash part of its own
+#define isdummy(t) ((t)->node == dummynode || isshaped(t))
+
 // hash is always reduced mod 2^k
 #define hashpow2(t, n) (gnode(t, lmod((n), sizenode(t))))
 
 #define hashstr(t, str) hashpow2(t, (str)->hash)
-#define hashboolean(t, p) hashpow2(t, p)
 
-static LuaNode* hashpointer(const LuaTable* t, const void* p)
+static unsigned int hashpointer(const void* p)
 {
     // we discard the high 32-bit portion of the pointer on 64-bit platforms as it doesn't carry much entropy anyway
     unsigned int h = unsigned(uintptr_t(p));
@@ -70,10 +124,10 @@ static LuaNode* hashpointer(const LuaTable* t, const void* p)
     h *= 0xc2b2ae35u;
     h ^= h >> 16;
 
-    return hashpow2(t, h);
+    return h;
 }
 
-static LuaNode* hashnum(const LuaTable* t, double n)
+static unsigned int hashnum(double n)
 {
     static_assert(sizeof(double) == sizeof(unsigned int) * 2, "expected a 8-byte double");
     unsigned int i[2];
@@ -96,10 +150,10 @@ static LuaNode* hashnum(const LuaTable* t, double n)
     h2 *= m;
 
     // ... truncated to 32-bit output (normally hash is equal to (uint64_t(h1) << 32) | h2, but we only really need the lower 32-bit half)
-    return hashpow2(t, h2);
+    return h2;
 }
 
-static LuaNode* hashvec(const LuaTable* t, const float* v)
+static unsigned int hashvec(const float* v)
 {
     unsigned int i[LUA_VECTOR_SIZE];
     memcpy(i, v, sizeof(i));
@@ -123,39 +177,242 @@ static LuaNode* hashvec(const LuaTable* t, const float* v)
     h ^= i[3] * 39916801;
 #endif
 
-    return hashpow2(t, h);
+    return h;
 }
 
-static LuaNode* hashcol(const LuaTable* t, const unsigned char* v)
+static unsigned int hashcol(const unsigned char* v)
 {
 	uint32_t h=(v[3]<<24)|(v[2]<<16)|(v[1]<<8)|(v[0]);
-    return hashpow2(t, h);
+    return h;
 }
-/*
-** returns the `main' position of an element in a table (that is, the index
-** of its hash value)
-*/
-static LuaNode* mainposition(const LuaTable* t, const TValue* key)
+
+static unsigned int hashkey(const TValue* key)
 {
     switch (ttype(key))
     {
     case LUA_TNUMBER:
-        return hashnum(t, nvalue(key));
+        return hashnum(nvalue(key));
     case LUA_TVECTOR:
-        return hashvec(t, vvalue(key));
+        return hashvec(vvalue(key));
     case LUA_TCOLOR:
-        return hashcol(t, colvalue(key));
+        return hashcol(colvalue(key));
     case LUA_TSTRING:
-        return hashstr(t, tsvalue(key));
+        return tsvalue(key)->hash;
     case LUA_TBOOLEAN:
-        return hashboolean(t, bvalue(key));
+        return bvalue(key);
     case LUA_TLIGHTUSERDATA:
-        return hashpointer(t, pvalue(key));
+        return hashpointer(pvalue(key));
     default:
-        return hashpointer(t, gcvalue(key));
+        return hashpointer(gcvalue(key));
+    }
+}
+
+/*
+** returns the `main' position of an element in a table (that is, the index
+** of its hash value)
+*/
+static LuaNode* mainposition(const LuaTable* t, const TValue* key)
+{
+    return hashpow2(t, hashkey(key));
+}
+
+/*
+** {=============================================================
+** Probed hash parts
+** ==============================================================
+*/
+
+// control bytes are matched a group at a time; a match mask has PROBESTRIDE bits per control byte, and only the lowest one is set
+#if defined(LUAU_PROBE_SSE2)
+#define PROBEGROUP 16
+#define PROBESTRIDE 1
+
+static uint64_t probematch(const uint8_t* group, uint8_t c)
+{
+    __m128i g = _mm_loadu_si128((const __m128i*)group);
+    return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(char(c)))));
+}
+
+static uint64_t probeempty(const uint8_t* group)
+{
+    // only CTRL_EMPTY has the top bit set
+    return unsigned(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group)));
+}
+#elif defined(LUAU_PROBE_NEON)
+#define PROBEGROUP 16
+#define PROBESTRIDE 4
+
+static uint64_t probematch(const uint8_t* group, uint8_t c)
+{
+    // NEON has no movemask; narrowing the 16 comparison bytes to 4 bits each gives a 64-bit mask
+    uint8x16_t eq = vceqq_u8(vld1q_u8(group), vdupq_n_u8(c));
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0) & 0x1111111111111111ull;
+}
+
+static uint64_t probeempty(const uint8_t* group)
+{
+    return probematch(group, CTRL_EMPTY);
+}
+#else
+#define PROBEGROUP 8
+#define PROBESTRIDE 8
+
+static uint64_t probeload(const uint8_t* group)
+{
+    uint64_t g;
+    memcpy(&g, group, sizeof(g));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    g = __builtin_bswap64(g);
+#endif
+    return g;
+}
+
+static uint64_t probematch(const uint8_t* group, uint8_t c)
+{
+    // sets the top bit of the bytes that are equal to c; a borrow can also flag the byte after a match, which only costs a key comparison
+    uint64_t x = probeload(group) ^ (0x0101010101010101ull * c);
+    return (x - 0x0101010101010101ull) & ~x & 0x8080808080808080ull;
+}
+
+static uint64_t probeempty(const uint8_t* group)
+{
+    return probeload(group) & 0x8080808080808080ull;
+}
+#endif
+
+static_assert(LUA_PROBEDLSIZE >= 4 && (1 << LUA_PROBEDLSIZE) >= PROBEGROUP && LUA_PROBEDLSIZE <= MAXBITS, "invalid LUA_PROBEDLSIZE");
+
+static int probeindex(uint64_t mask)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long r;
+    _BitScanForward64(&r, mask);
+    return int(r) / PROBESTRIDE;
+#elif defined(_MSC_VER)
+    unsigned long r;
+    if (!_BitScanForward(&r, unsigned(mask)))
+    {
+        _BitScanForward(&r, unsigned(mask >> 32));
+        r += 32;
+    }
+    return int(r) / PROBESTRIDE;
+#else
+    return __builtin_ctzll(mask) / PROBESTRIDE;
+#endif
+}
+
+// low bits of the hash pick the first group, and the top 7 bits are kept in the control byte
+#define probectrl(h) uint8_t((h) >> 25)
+
+/*
+** finds the node of a key in a probed hash part; 'eq' compares the key of a node with the key
+*/
+template<typename Eq>
+static LuaNode* probefind(const LuaTable* t, unsigned int h, const Eq& eq)
+{
+    const uint8_t* ctrl = gctrl(t);
+    unsigned int mask = sizenode(t) - 1;
+    unsigned int pos = h & mask & ~(PROBEGROUP - 1);
+    uint8_t c = probectrl(h);
+
+    for (unsigned int step = PROBEGROUP;; step += PROBEGROUP)
+    {
+        for (uint64_t m = probematch(ctrl + pos, c); m; m &= m - 1)
+        {
+            LuaNode* n = gnode(t, pos + probeindex(m));
+            if (eq(gkey(n)))
+                return n;
+        }
+
+        // the key would have been inserted in the first group with an empty node
+        if (probeempty(ctrl + pos))
+            return NULL;
+
+        pos = (pos + step) & mask;
     }
 }
 
+/*
+** finds an empty node for a new key in a probed hash part; the hash part is never full
+*/
+static LuaNode* probeinsert(LuaTable* t, unsigned int h)
+{
+    uint8_t* ctrl = gctrl(t);
+    unsigned int mask = sizenode(t) - 1;
+    unsigned int pos = h & mask & ~(PROBEGROUP - 1);
+
+    for (unsigned int step = PROBEGROUP;; step += PROBEGROUP)
+    {
+        if (uint64_t m = probeempty(ctrl + pos))
+        {
+            int i = pos + probeindex(m);
+            ctrl[i] = probectrl(h);
+            return gnode(t, i);
+        }
+
+        pos = (pos + step) & mask;
+    }
+}
+
+// number of keys that can be added to a probed hash part of a given size before it has to grow
+#define probecapacity(size) ((size) / 8 * 7)
+
+struct ProbeNum
+{
+    double key;
+
+    bool operator()(const TKey* k) const
+    {
+        return ttisnumber(k) && luai_numeq(nvalue(k), key);
+    }
+};
+
+struct ProbeStr
+{
+    TString* key;
+
+    bool operator()(const TKey* k) const
+    {
+        return ttisstring(k) && tsvalue(k) == key;
+    }
+};
+
+struct ProbeP
+{
+    void* key;
+    int tag;
+
+    bool operator()(const TKey* k) const
+    {
+        return ttislightuserdata(k) && pvalue(k) == key && lightuserdatatag(k) == tag;
+    }
+};
+
+struct ProbeKey
+{
+    const TValue* key;
+
+    bool operator()(const TKey* k) const
+    {
+        return luaO_rawequalKey(k, key);
+    }
+};
+
+// also matches the dead key of a collected object, which 'next' can be called with
+struct ProbeNextKey
+{
+    const TValue* key;
+
+    bool operator()(const TKey* k) const
+    {
+        return luaO_rawequalKey(k, key) || (ttype(k) == LUA_TDEADKEY && iscollectable(key) && gcvalue(k) == gcvalue(key));
+    }
+};
+
+/*
+** }=============================================================
+*/
+
 /*
 ** returns the index for `key' if `key' is an appropriate key to live in
 ** the array part of the table, -1 otherwise.
@@ -168,6 +425,379 @@ static int arrayindex(double key)
     return luai_numeq(cast_num(i), key) ? i : -1;
 }
 
+/*
+** {=============================================================
+** Shapes
+** ==============================================================
+*/
+
+static size_t sizeshape(int count)
+{
+    return offsetof(LuaShape, keys) + sizeof(TString*) * (count > 0 ? count : 1);
+}
+
+static size_t sizeshapednode(int sizeslots)
+{
+    return offsetof(LuaShapedNode, slots) + sizeof(TValue) * sizeslots;
+}
+
+static unsigned int hashtransition(const LuaShape* parent, unsigned int keyhash)
+{
+    return (parent->id * 0x9e3779b1u) ^ keyhash;
+}
+
+static void resizeshapes(lua_State* L, shapetable* tb, int newsize)
+{
+    LuaShape** newhash = luaM_newarray(L, newsize, LuaShape*, 0);
+    for (int i = 0; i < newsize; i++)
+        newhash[i] = NULL;
+    // rehash
+    for (int i = 0; i < tb->size; i++)
+    {
+        LuaShape* p = tb->hash[i];
+        while (p)
+        {
+            LuaShape* next = p->hashnext;
+            int h1 = lmod(hashtransition(p->parent, p->keyhash), newsize);
+            p->hashnext = newhash[h1];
+            newhash[h1] = p;
+            p = next;
+        }
+    }
+    luaM_freearray(L, tb->hash, tb->size, LuaShape*, 0);
+    tb->size = newsize;
+    tb->hash = newhash;
+}
+
+// returns the shape that extends 'parent' with 'key', or NULL when the shape limit is reached
+static LuaShape* shapetransition(lua_State* L, LuaShape* parent, TString* key)
+{
+    shapetable* tb = &L->global->shapes;
+    LuaShape* shape = NULL;
+
+    lualock_shapes();
+
+    if (tb->size)
+    {
+        for (LuaShape* p = tb->hash[lmod(hashtransition(parent, key->hash), tb->size)]; p; p = p->hashnext)
+        {
+            if (p->parent == parent && p->keys[p->count - 1] == key)
+            {
+                shape = p;
+                break;
+            }
+        }
+    }
+
+    if (!shape && tb->nuse < LUA_MAXSHAPES)
+    {
+        if (tb->nuse >= uint32_t(tb->size))
+            resizeshapes(L, tb, tb->size ? tb->size * 2 : LUA_MINSTRTABSIZE);
+
+        int count = parent->count + 1;
+        shape = cast_to(LuaShape*, luaM_new_(L, sizeshape(count), 0));
+        shape->id = ++tb->nuse;
+        shape->count = count;
+        shape->keymask = parent->keymask | (uint64_t(1) << (key->hash & 63));
+        shape->keyhash = key->hash;
+        shape->parent = parent;
+        memcpy(shape->keys, parent->keys, parent->count * sizeof(TString*));
+        shape->keys[count - 1] = key;
+
+        int h = lmod(hashtransition(parent, key->hash), tb->size);
+        shape->hashnext = tb->hash[h];
+        tb->hash[h] = shape;
+    }
+
+    luaunlock_shapes();
+
+    return shape;
+}
+
+void luaH_freeshapes(lua_State* L)
+{
+    shapetable* tb = &L->global->shapes;
+
+    for (int i = 0; i < tb->size; i++)
+    {
+        LuaShape* p = tb->hash[i];
+        while (p)
+        {
+            LuaShape* next = p->hashnext;
+            luaM_free_(L, p, sizeshape(p->count), 0);
+            p = next;
+        }
+    }
+
+    luaM_freearray(L, tb->hash, tb->size, LuaShape*, 0);
+    tb->hash = NULL;
+    tb->size = 0;
+    tb->nuse = 0;
+}
+
+static LuaShapedNode* newshapednode(lua_State* L, LuaTable* t, LuaShape* shape, int sizeslots)
+{
+    LuaShapedNode* sn = cast_to(LuaShapedNode*, luaM_new_(L, sizeshapednode(sizeslots), t->memcat));
+    sn->sentinel = emptyshapednode.sentinel;
+    sn->shape = shape;
+    sn->sizeslots = sizeslots;
+    return sn;
+}
+
+static void freeshapednode(lua_State* L, LuaTable* t, LuaShapedNode* sn)
+{
+    if (sn != &emptyshapednode)
+        luaM_free_(L, sn, sizeshapednode(sn->sizeslots), t->memcat);
+}
+
+// adds a string key to a shaped table, returns NULL if the table can't have a shape with the key
+static TValue* shapenewkey(lua_State* L, LuaTable* t, const TValue* key)
+{
+    LuaShapedNode* sn = gshaped(t);
+    int count = sn->shape->count;
+
+    if (count >= LUA_MAXSHAPEKEYS)
+        return NULL;
+
+    LuaShape* shape = shapetransition(L, sn->shape, tsvalue(key));
+
+    if (!shape)
+        return NULL;
+
+    if (count == sn->sizeslots)
+    {
+        LuaShapedNode* nsn = newshapednode(L, t, sn->shape, count < 4 ? 4 : count * 2);
+        memcpy(nsn->slots, sn->slots, count * sizeof(TValue));
+        freeshapednode(L, t, sn);
+        t->node = &nsn->sentinel;
+        sn = nsn;
+    }
+
+    TValue* slot = &sn->slots[count];
+    setnilvalue(slot);
+    sn->shape = shape;
+    luaC_barriert(L, t, key);
+    return slot;
+}
+
+static TValue* newkey(lua_State* L, LuaTable* t, const TValue* key);
+static void setnodevector(lua_State* L, LuaTable* t, int size);
+
+// moves the keys of a shaped table to a hash part with room for 'extra' more keys
+static void unshape(lua_State* L, LuaTable* t, int extra)
+{
+    LuaShapedNode* sn = gshaped(t);
+    LuaShape* shape = sn->shape;
+
+    int used = 0;
+    for (int i = 0; i < shape->count; i++)
+    {
+        if (!ttisnil(&sn->slots[i]))
+            used++;
+    }
+
+    // the hash part is allocated before the slots are released, so that the table is left intact if the allocation fails
+    setnodevector(L, t, used + extra);
+
+    for (int i = 0; i < shape->count; i++)
+    {
+        if (!ttisnil(&sn->slots[i]))
+        {
+            TValue k;
+            setsvalue(L, &k, shape->keys[i]);
+            setobjt2t(L, newkey(L, t, &k), &sn->slots[i]);
+        }
+    }
+
+    freeshapednode(L, t, sn);
+}
+
+size_t luaH_sizenodes(LuaTable* t)
+{
+    if (t->node == dummynode)
+        return 0;
+    else if (isshaped(t))
+        return gshaped(t) == &emptyshapednode ? 0 : sizeshapednode(gshaped(t)->sizeslots);
+    else
+        return sizenode(t) * sizeof(LuaNode) + (isprobed(t) ? sizenode(t) : 0);
+}
+
+/*
+** }=============================================================
+*/
+
+/*
+** {=============================================================
+** Packed arrays
+** ==============================================================
+*/
+
+static size_t sizepacked(int capacity)
+{
+    return offsetof(LuaPackedArray, values) + sizeof(double) * capacity;
+}
+
+size_t luaH_sizearray(LuaTable* t)
+{
+    return ispacked(t) ? sizepacked(gpacked(t)->capacity) : t->sizearray * sizeof(TValue);
+}
+
+static LuaPackedArray* newpacked(lua_State* L, LuaTable* t, int capacity)
+{
+    if (capacity > MAXSIZE)
+        luaG_runerror(L, "table overflow");
+    LuaPackedArray* pa = (LuaPackedArray*)luaM_new_(L, sizepacked(capacity), t->memcat);
+    pa->size = 0;
+    pa->capacity = capacity;
+    return pa;
+}
+
+// returns the number of elements of an array part that only holds numbers followed by nils, or -1 if it can't be packed;
+// tables allocated in a region keep the simplest layout, like for shapes, and shared tables are read concurrently with
+// stores that would replace the array part
+static int packedsize(LuaTable* t)
+{
+    if (t->sizearray < LUA_PACKEDMINSIZE || t->memcat == LUA_REGIONMEMCAT || testbit(t->marked, SHAREDBIT))
+        return -1;
+
+    int size = 0;
+    while (size < t->sizearray && ttisnumber(&t->array[size]))
+        size++;
+
+    for (int i = size; i < t->sizearray; i++)
+    {
+        if (!ttisnil(&t->array[i]))
+            return -1;
+    }
+
+    return size;
+}
+
+static void setpackedarray(LuaTable* t, TValue* array, int sizearray)
+{
+    t->array = array;
+    t->sizearray = sizearray;
+    // the field is only a boundary once the hash part is full, in which case the table knows that 'lastfree' is 0 (see aboundary)
+    if (t->aboundary < 0)
+        t->aboundary = 0;
+}
+
+static void pack(lua_State* L, LuaTable* t, int size, int capacity)
+{
+    LuaPackedArray* pa = newpacked(L, t, capacity);
+    for (int i = 0; i < size; i++)
+        pa->values[i] = nvalue(&t->array[i]);
+    pa->size = size;
+
+    luaM_freearray(L, t->array, t->sizearray, TValue, t->memcat);
+    setpackedarray(t, cast_to(TValue*, pa), 0);
+}
+
+void luaH_packarray(lua_State* L, LuaTable* t)
+{
+    int size = ispacked(t) ? -1 : packedsize(t);
+    if (size >= 0)
+        pack(L, t, size, t->sizearray);
+}
+
+static void unpack(lua_State* L, LuaTable* t, int size)
+{
+    LuaPackedArray* pa = gpacked(t);
+    TValue* array = size ? luaM_newarray(L, size, TValue, t->memcat) : NULL;
+    for (int i = 0; i < pa->size; i++)
+        setnvalue(&array[i], pa->values[i]);
+    for (int i = pa->size; i < size; i++)
+        setnilvalue(&array[i]);
+
+    luaM_free_(L, pa, sizepacked(pa->capacity), t->memcat);
+    setpackedarray(t, array, size);
+}
+
+void luaH_unpackarray(lua_State* L, LuaTable* t)
+{
+    // the array part keeps the capacity when nothing follows it; otherwise it gets exactly one slot per element, so that the
+    // keys after the elements keep their traversal index during a traversal in progress
+    unpack(L, t, t->node == dummynode ? gpacked(t)->capacity : gpacked(t)->size);
+}
+
+/*
+** stores a number key of a packed table, or packs the array part when a number is appended to it; returns false if the
+** store has to go through the array or the hash part instead, after unpacking the table if the key was in the packed array
+*/
+bool luaH_setpacked(lua_State* L, LuaTable* t, const TValue* key, const TValue* val)
+{
+    int k = arrayindex(nvalue(key));
+
+    if (!ispacked(t))
+    {
+        // the array part is full, so this key would grow it with a rehash
+        if (k != t->sizearray + 1 || !ttisnumber(val) || packedsize(t) != t->sizearray)
+            return false;
+
+        pack(L, t, t->sizearray, t->sizearray < MAXSIZE / 2 ? t->sizearray * 2 : MAXSIZE);
+    }
+
+    LuaPackedArray* pa = gpacked(t);
+
+    if (unsigned(k) - 1 < unsigned(pa->size))
+    {
+        if (ttisnumber(val))
+        {
+            pa->values[k - 1] = nvalue(val);
+            return true;
+        }
+
+        // removing the last element keeps the array dense, but it would renumber the keys that follow it for traversals
+        if (ttisnil(val) && k == pa->size && t->node == dummynode)
+        {
+            pa->size--;
+            return true;
+        }
+    }
+    else if (k == pa->size + 1)
+    {
+        if (ttisnil(val))
+            return true; // nothing to remove
+
+        // the key that follows can't be in the hash part past the end of the array
+        if (ttisnumber(val) && ttisnil(luaH_getnum(t, k + 1)))
+        {
+            // the new key may shadow the key of a cached lookup further down an __index chain
+            if (t->readonly & WATCHEDFLAG)
+                L->global->indexchains.gen++;
+
+            if (pa->size == pa->capacity)
+            {
+                if (pa->capacity >= MAXSIZE)
+                    luaG_runerror(L, "table overflow");
+
+                int capacity = pa->capacity == 0 ? 4 : pa->capacity < MAXSIZE / 2 ? pa->capacity * 2 : MAXSIZE;
+                pa = (LuaPackedArray*)luaM_realloc_(L, pa, sizepacked(pa->capacity), sizepacked(capacity), t->memcat);
+                pa->capacity = capacity;
+                t->array = cast_to(TValue*, pa);
+            }
+
+            pa->values[pa->size++] = nvalue(val);
+            return true;
+        }
+    }
+    else if (ttisnil(val) || unsigned(k) - 1 >= unsigned(pa->capacity) || !isdummy(t))
+    {
+        return false; // other keys are in the hash part
+    }
+
+    // a new key past the end can use the capacity of the array part when no hash part holds the keys after the elements
+    if (k > pa->size && isdummy(t))
+        unpack(L, t, pa->capacity);
+    else
+        luaH_unpackarray(L, t);
+    return false;
+}
+
+/*
+** }=============================================================
+*/
+
 /*
 ** returns the index of a `key' for table traversals. First goes all
 ** elements in the array part, then elements in the hash part. The
@@ -178,9 +808,29 @@ static int findindex(lua_State* L, LuaTable* t, StkId key)
     int i;
     if (ttisnil(key))
         return -1; // first iteration
+    int asize = sizearraykeys(t);
     i = ttisnumber(key) ? arrayindex(nvalue(key)) : -1;
-    if (0 < i && i <= t->sizearray) // is `key' inside array part?
-        return i - 1;               // yes; that's the index (corrected to C)
+    if (0 < i && i <= asize) // is `key' inside array part?
+        return i - 1;        // yes; that's the index (corrected to C)
+    else if (ispacked(t) && t->node == dummynode && 0 < i && i <= gpacked(t)->capacity)
+        return asize - 1; // last elements of a packed array that were removed during traversal; continue after the array
+    else if (isshaped(t))
+    {
+        // keys stay in the shape when their value is removed, so this also finds keys that were removed during traversal
+        int slot = ttisstring(key) ? luaH_shapefind(gshaped(t)->shape, tsvalue(key)) : -1;
+        if (slot < 0)
+            luaG_runerror(L, "invalid key to 'next'"); // key not found
+        // slots are numbered after the sentinel node
+        return slot + asize + sizenode(t);
+    }
+    else if (isprobed(t))
+    {
+        LuaNode* n = probefind(t, hashkey(key), ProbeNextKey{key});
+        if (n == NULL)
+            luaG_runerror(L, "invalid key to 'next'"); // key not found
+        // hash elements are numbered after array ones
+        return cast_int(n - gnode(t, 0)) + asize;
+    }
     else
     {
         LuaNode* n = mainposition(t, key);
@@ -191,7 +841,7 @@ static int findindex(lua_State* L, LuaTable* t, StkId key)
             {
                 i = cast_int(n - gnode(t, 0)); // key index in hash table
                 // hash elements are numbered after array ones
-                return i + t->sizearray;
+                return i + asize;
             }
             if (gnext(n) == 0)
                 break;
@@ -204,6 +854,7 @@ static int findindex(lua_State* L, LuaTable* t, StkId key)
 int luaH_next(lua_State* L, LuaTable* t, StkId key)
 {
     int i = findindex(L, t, key); // find original element
+    int asize = sizearraykeys(t);
     for (i++; i < t->sizearray; i++)
     { // try first array part
         if (!ttisnil(&t->array[i]))
@@ -213,7 +864,13 @@ int luaH_next(lua_State* L, LuaTable* t, StkId key)
             return 1;
         }
     }
-    for (i -= t->sizearray; i < sizenode(t); i++)
+    if (i < asize)
+    { // or the packed array, which has no nil values
+        setnvalue(key, cast_num(i + 1));
+        setnvalue(key + 1, gpacked(t)->values[i]);
+        return 1;
+    }
+    for (i -= asize; i < sizenode(t); i++)
     { // then hash part
         if (!ttisnil(gval(gnode(t, i))))
         { // a non-nil value?
@@ -222,6 +879,19 @@ int luaH_next(lua_State* L, LuaTable* t, StkId key)
             return 1;
         }
     }
+    if (isshaped(t))
+    {
+        LuaShapedNode* sn = gshaped(t);
+        for (i -= sizenode(t); i < sn->shape->count; i++)
+        { // then slots of a shaped table
+            if (!ttisnil(&sn->slots[i]))
+            {
+                setsvalue(L, key, sn->shape->keys[i]);
+                setobj2s(L, key + 1, &sn->slots[i]);
+                return 1;
+            }
+        }
+    }
     return 0; // no more elements
 }
 
@@ -347,25 +1017,29 @@ static void setnodevector(lua_State* L, LuaTable* t, int size)
     {
         int i;
         lsize = ceillog2(size);
+        // probed hash parts can't be filled completely
+        if (lsize >= LUA_PROBEDLSIZE && probecapacity(twoto(lsize)) < size)
+            lsize++;
         if (lsize > MAXBITS)
             luaG_runerror(L, "table overflow");
         size = twoto(lsize);
-        t->node = luaM_newarray(L, size, LuaNode, t->memcat);
+        bool probed = lsize >= LUA_PROBEDLSIZE;
+        t->node = (LuaNode*)luaM_new_(L, size * sizeof(LuaNode) + (probed ? size : 0), t->memcat);
         for (i = 0; i < size; i++)
         {
             LuaNode* n = gnode(t, i);
-            gnext(n) = 0;
+            gnext(n) = probed;
             setnilvalue(gkey(n));
             setnilvalue(gval(n));
         }
+        if (probed)
+            memset(t->node + size, CTRL_EMPTY, size);
     }
     t->lsizenode = cast_byte(lsize);
     t->nodemask8 = cast_byte((1 << lsize) - 1);
-    t->lastfree = size; // all positions are free
+    t->lastfree = isprobed(t) ? probecapacity(size) : size; // all positions are free
 }
 
-static TValue* newkey(lua_State* L, LuaTable* t, const TValue* key);
-
 static TValue* arrayornewkey(lua_State* L, LuaTable* t, const TValue* key)
 {
     if (ttisnumber(key))
@@ -384,9 +1058,11 @@ static void resize(lua_State* L, LuaTable* t, int nasize, int nhsize)
 {
     if (nasize > MAXSIZE || nhsize > MAXSIZE)
         luaG_runerror(L, "table overflow");
+    LUAU_ASSERT(!isshaped(t));
     int oldasize = t->sizearray;
     int oldhsize = t->lsizenode;
     LuaNode* nold = t->node; // save old hash ...
+    size_t nsizeold = luaH_sizenodes(t);
     if (nasize > oldasize)   // array part must grow?
         setarrayvector(L, t, nasize);
     // create new hash part with appropriate size
@@ -428,12 +1104,12 @@ static void resize(lua_State* L, LuaTable* t, int nasize, int nhsize)
     LUAU_ASSERT(anew == t->array);
 
     if (nold != dummynode)
-        luaM_freearray(L, nold, twoto(oldhsize), LuaNode, t->memcat); // free old array
+        luaM_free_(L, nold, nsizeold, t->memcat); // free old array
 }
 
 static int adjustasize(LuaTable* t, int size, const TValue* ek)
 {
-    bool tbound = t->node != dummynode || size < t->sizearray;
+    bool tbound = !isdummy(t) || size < t->sizearray;
     int ekindex = ek && ttisnumber(ek) ? arrayindex(nvalue(ek)) : -1;
     // move the array size up until the boundary is guaranteed to be inside the array part
     while (size + 1 == ekindex || (tbound && !ttisnil(luaH_getnum(t, size + 1))))
@@ -443,13 +1119,24 @@ static int adjustasize(LuaTable* t, int size, const TValue* ek)
 
 void luaH_resizearray(lua_State* L, LuaTable* t, int nasize)
 {
-    int nsize = (t->node == dummynode) ? 0 : sizenode(t);
+    if (ispacked(t))
+        luaH_unpackarray(L, t);
+    int nsize = isdummy(t) ? 0 : sizenode(t);
     int asize = adjustasize(t, nasize, NULL);
+    if (isshaped(t))
+    {
+        // there is no hash part to move the elements of a shrinking array part to, so the array part of a shaped table only grows
+        if (asize > t->sizearray)
+            setarrayvector(L, t, asize);
+        return;
+    }
     resize(L, t, asize, nsize);
 }
 
 void luaH_resizehash(lua_State* L, LuaTable* t, int nhsize)
 {
+    if (isshaped(t))
+        unshape(L, t, 0);
     resize(L, t, t->sizearray, nhsize);
 }
 
@@ -458,6 +1145,15 @@ static void rehash(lua_State* L, LuaTable* t, const TValue* ek)
     int nums[MAXBITS + 1]; // nums[i] = number of keys between 2^(i-1) and 2^i
     for (int i = 0; i <= MAXBITS; i++)
         nums[i] = 0;                          // reset counts
+
+    // keys of the hash part of a packed table all follow the packed array, which stays as it is
+    if (ispacked(t))
+    {
+        int nhasize = 0;
+        resize(L, t, 0, numusehash(t, nums, &nhasize) + 1);
+        return;
+    }
+
     int nasize = numusearray(t, nums);        // count keys in array part
     int totaluse = nasize;                    // all those keys are integer keys
     totaluse += numusehash(t, nums, &nasize); // count keys in hash part
@@ -500,8 +1196,10 @@ static void rehash(lua_State* L, LuaTable* t, const TValue* ek)
 
 LuaTable* luaH_new(lua_State* L, int narray, int nhash)
 {
-    LuaTable* t = luaM_newgco(L, LuaTable, sizeof(LuaTable), L->activememcat);
+    uint8_t memcat = luaC_tablememcat(L);
+    LuaTable* t = luaM_newgco(L, LuaTable, sizeof(LuaTable), memcat, LUA_TTABLE);
     luaC_init(L, t, LUA_TTABLE);
+    t->memcat = memcat;
     t->metatable = NULL;
     t->tmcache = cast_byte(~0);
     t->array = NULL;
@@ -514,20 +1212,23 @@ LuaTable* luaH_new(lua_State* L, int narray, int nhash)
     t->node = cast_to(LuaNode*, dummynode);
     if (narray > 0)
         setarrayvector(L, t, narray);
-    if (nhash > 0)
+    // tables allocated in a region keep the simplest layout, since their hash part has to be moved when they escape
+    if (L->global->shapes.enabled && nhash <= LUA_MAXSHAPEKEYS && memcat != LUA_REGIONMEMCAT)
+        t->node = cast_to(LuaNode*, &emptyshapednode.sentinel);
+    else if (nhash > 0)
         setnodevector(L, t, nhash);
-#ifdef LUAU_MULTITHREAD
-    t->shared=0;
-    new (&t->lock) LuaSpinLock();
-#endif
     return t;
 }
 
 void luaH_free(lua_State* L, LuaTable* t, lua_Page* page)
 {
-    if (t->node != dummynode)
-        luaM_freearray(L, t->node, sizenode(t), LuaNode, t->memcat);
-    if (t->array)
+    if (isshaped(t))
+        freeshapednode(L, t, gshaped(t));
+    else if (t->node != dummynode)
+        luaM_free_(L, t->node, luaH_sizenodes(t), t->memcat);
+    if (ispacked(t))
+        luaM_free_(L, t->array, luaH_sizearray(t), t->memcat);
+    else if (t->array)
         luaM_freearray(L, t->array, t->sizearray, TValue, t->memcat);
     luaM_freegco(L, t, sizeof(LuaTable), t->memcat, page);
 }
@@ -554,6 +1255,37 @@ static LuaNode* getfreepos(LuaTable* t)
 */
 static TValue* newkey(lua_State* L, LuaTable* t, const TValue* key)
 {
+    // the new key may shadow the key of a cached lookup further down an __index chain
+    if (t->readonly & WATCHEDFLAG)
+        L->global->indexchains.gen++;
+
+    if (isshaped(t))
+    {
+        if (ttisstring(key))
+        {
+            if (TValue* slot = shapenewkey(L, t, key))
+                return slot;
+        }
+        else if (ttisnumber(key) && nvalue(key) == t->sizearray + 1)
+        {
+            // grow the array part like rehash would, as long as it stays more than half full
+            int used = 1;
+            for (int i = 0; i < t->sizearray; i++)
+                used += !ttisnil(&t->array[i]);
+
+            int oldasize = t->sizearray;
+            int nasize = oldasize ? oldasize * 2 : 1;
+            if (used > nasize / 2)
+            {
+                setarrayvector(L, t, nasize);
+                return &t->array[oldasize];
+            }
+        }
+
+        // key can't be added to the shape, the table switches to a hash part
+        unshape(L, t, 1);
+    }
+
     // enforce boundary invariant
     if (ttisnumber(key) && nvalue(key) == t->sizearray + 1)
     {
@@ -563,6 +1295,26 @@ static TValue* newkey(lua_State* L, LuaTable* t, const TValue* key)
         return arrayornewkey(L, t, key);
     }
 
+    if (isprobed(t))
+    {
+        // removed keys keep their node, so the hash part grows when the keys that were ever added reach its capacity
+        // note: once the capacity is exhausted, the field may hold the array boundary instead (see aboundary)
+        if (t->lastfree <= 0)
+        {
+            rehash(L, t, key); // grow table
+
+            // after rehash, numeric keys might be located in the new array part, but won't be found in the node part
+            return arrayornewkey(L, t, key);
+        }
+
+        LuaNode* n = probeinsert(t, hashkey(key));
+        t->lastfree--;
+        setnodekey(L, n, key);
+        luaC_barriert(L, t, key);
+        LUAU_ASSERT(ttisnil(gval(n)));
+        return gval(n);
+    }
+
     LuaNode* mp = mainposition(t, key);
     if (!ttisnil(gval(mp)) || mp == dummynode)
     {
@@ -617,10 +1369,18 @@ const TValue* luaH_getnum(LuaTable* t, int key)
     // (1 <= key && key <= t->sizearray)
     if (unsigned(key) - 1 < unsigned(t->sizearray))
         return &t->array[key - 1];
-    else if (t->node != dummynode)
+    // packed elements have no slot and are read through luaH_getnumcopy
+    LUAU_ASSERT(!ispacked(t) || unsigned(key) - 1 >= unsigned(gpacked(t)->size));
+    if (isprobed(t))
     {
         double nk = cast_num(key);
-        LuaNode* n = hashnum(t, nk);
+        LuaNode* n = probefind(t, hashnum(nk), ProbeNum{nk});
+        return n ? gval(n) : luaO_nilobject;
+    }
+    else if (!isdummy(t))
+    {
+        double nk = cast_num(key);
+        LuaNode* n = hashpow2(t, hashnum(nk));
         for (;;)
         { // check whether `key' is somewhere in the chain
             if (ttisnumber(gkey(n)) && luai_numeq(nvalue(gkey(n)), nk))
@@ -640,6 +1400,18 @@ const TValue* luaH_getnum(LuaTable* t, int key)
 */
 const TValue* luaH_getstr(LuaTable* t, TString* key)
 {
+    if (isshaped(t))
+    {
+        LuaShapedNode* sn = gshaped(t);
+        int slot = luaH_shapefind(sn->shape, key);
+        return slot >= 0 ? &sn->slots[slot] : luaO_nilobject;
+    }
+    else if (isprobed(t))
+    {
+        LuaNode* n = probefind(t, key->hash, ProbeStr{key});
+        return n ? gval(n) : luaO_nilobject;
+    }
+
     LuaNode* n = hashstr(t, key);
     for (;;)
     { // check whether `key' is somewhere in the chain
@@ -657,7 +1429,15 @@ const TValue* luaH_getstr(LuaTable* t, TString* key)
 */
 const TValue* luaH_getp(LuaTable* t, void* key, int tag)
 {
-    LuaNode* n = hashpointer(t, key);
+    if (isshaped(t))
+        return luaO_nilobject;
+    else if (isprobed(t))
+    {
+        LuaNode* n = probefind(t, hashpointer(key), ProbeP{key, tag});
+        return n ? gval(n) : luaO_nilobject;
+    }
+
+    LuaNode* n = hashpow2(t, hashpointer(key));
     for (;;)
     { // check whether `key' is somewhere in the chain
         const TKey* nk = gkey(n);
@@ -692,6 +1472,14 @@ const TValue* luaH_get(LuaTable* t, const TValue* key)
     }
     default:
     {
+        if (isshaped(t))
+            return luaO_nilobject;
+        else if (isprobed(t))
+        {
+            LuaNode* n = probefind(t, hashkey(key), ProbeKey{key});
+            return n ? gval(n) : luaO_nilobject;
+        }
+
         LuaNode* n = mainposition(t, key);
         for (;;)
         { // check whether `key' is somewhere in the chain
@@ -706,8 +1494,35 @@ const TValue* luaH_get(LuaTable* t, const TValue* key)
     }
 }
 
+const TValue* luaH_getnumcopy(LuaTable* t, int key, TValue* copy)
+{
+    if (ispacked(t) && unsigned(key) - 1 < unsigned(gpacked(t)->size))
+    {
+        setnvalue(copy, gpacked(t)->values[key - 1]);
+        return copy;
+    }
+    return luaH_getnum(t, key);
+}
+
+const TValue* luaH_getcopy(LuaTable* t, const TValue* key, TValue* copy)
+{
+    if (ispacked(t) && ttisnumber(key))
+    {
+        int k = arrayindex(nvalue(key));
+        if (unsigned(k) - 1 < unsigned(gpacked(t)->size))
+        {
+            setnvalue(copy, gpacked(t)->values[k - 1]);
+            return copy;
+        }
+    }
+    return luaH_get(t, key);
+}
+
 TValue* luaH_set(lua_State* L, LuaTable* t, const TValue* key)
 {
+    // packed elements can only be written by luaH_setpacked, and the key after them can't go to the hash part
+    if (ispacked(t) && ttisnumber(key) && unsigned(arrayindex(nvalue(key))) - 1 <= unsigned(gpacked(t)->size))
+        luaH_unpackarray(L, t);
     const TValue* p = luaH_get(t, key);
     invalidateTMcache(t);
     if (p != luaO_nilobject)
@@ -727,11 +1542,27 @@ TValue* luaH_newkey(lua_State* L, LuaTable* t, const TValue* key)
     return newkey(L, t, key);
 }
 
+void luaH_flaggedwrite(lua_State* L, LuaTable* t)
+{
+    if (isreadonly(t))
+        luaG_readonlyerror(L);
+
+    LUAU_ASSERT(t->readonly & WATCHEDFLAG);
+    L->global->indexchains.gen++;
+}
+
 TValue* luaH_setnum(lua_State* L, LuaTable* t, int key)
 {
     // (1 <= key && key <= t->sizearray)
     if (unsigned(key) - 1 < unsigned(t->sizearray))
         return &t->array[key - 1];
+    // packed elements can only be written by luaH_setpacked, and the key after them can't go to the hash part
+    if (ispacked(t) && unsigned(key) - 1 <= unsigned(gpacked(t)->size))
+    {
+        luaH_unpackarray(L, t);
+        if (unsigned(key) - 1 < unsigned(t->sizearray))
+            return &t->array[key - 1];
+    }
     // hash fallback
     const TValue* p = luaH_getnum(t, key);
     if (p != luaO_nilobject)
@@ -800,7 +1631,7 @@ int luaH_getn(LuaTable* t)
 
     if (boundary > 0)
     {
-        if (!ttisnil(&t->array[t->sizearray - 1]) && t->node == dummynode)
+        if (!ttisnil(&t->array[t->sizearray - 1]) && isdummy(t))
             return t->sizearray; // fast-path: the end of the array in `t' already refers to a boundary
         if (boundary < t->sizearray && !ttisnil(&t->array[boundary - 1]) && ttisnil(&t->array[boundary]))
             return boundary; // fast-path: boundary already refers to a boundary in `t'
@@ -827,18 +1658,25 @@ int luaH_getn(LuaTable* t)
         maybesetaboundary(t, boundary);
         return boundary;
     }
+    else if (ispacked(t))
+    {
+        // packed arrays have no nil values
+        return gpacked(t)->size;
+    }
     else
     {
         // validate boundary invariant
-        LUAU_ASSERT(t->node == dummynode || ttisnil(luaH_getnum(t, j + 1)));
+        LUAU_ASSERT(isdummy(t) || ttisnil(luaH_getnum(t, j + 1)));
         return j;
     }
 }
 
 LuaTable* luaH_clone(lua_State* L, LuaTable* tt)
 {
-    LuaTable* t = luaM_newgco(L, LuaTable, sizeof(LuaTable), L->activememcat);
+    uint8_t memcat = luaC_tablememcat(L);
+    LuaTable* t = luaM_newgco(L, LuaTable, sizeof(LuaTable), memcat, LUA_TTABLE);
     luaC_init(L, t, LUA_TTABLE);
+    t->memcat = memcat;
     t->metatable = tt->metatable;
     t->tmcache = tt->tmcache;
     t->array = NULL;
@@ -849,10 +1687,6 @@ LuaTable* luaH_clone(lua_State* L, LuaTable* tt)
     t->safeenv = 0;
     t->node = cast_to(LuaNode*, dummynode);
     t->lastfree = 0;
-#ifdef LUAU_MULTITHREAD
-    t->shared=0;
-    new (&t->lock) LuaSpinLock();
-#endif
 
     if (tt->sizearray)
     {
@@ -862,14 +1696,68 @@ LuaTable* luaH_clone(lua_State* L, LuaTable* tt)
 
         memcpy(t->array, tt->array, t->sizearray * sizeof(TValue));
     }
+    else if (ispacked(tt) && memcat == LUA_REGIONMEMCAT)
+    {
+        LuaPackedArray* pa = gpacked(tt);
+
+        if (pa->size)
+        {
+            t->array = luaM_newarray(L, pa->size, TValue, t->memcat);
+            t->sizearray = pa->size;
+
+            for (int i = 0; i < pa->size; i++)
+                setnvalue(&t->array[i], pa->values[i]);
+        }
+    }
+    else if (ispacked(tt))
+    {
+        LuaPackedArray* pa = gpacked(tt);
+
+        // copies only get the elements they use
+        LuaPackedArray* npa = newpacked(L, t, pa->size);
+        memcpy(npa->values, pa->values, pa->size * sizeof(double));
+        npa->size = pa->size;
+        t->array = cast_to(TValue*, npa);
+    }
+
+    if (isshaped(tt) && memcat == LUA_REGIONMEMCAT)
+    {
+        LuaShapedNode* sn = gshaped(tt);
+
+        // keys of removed values are kept as well, like the hash part of a copy does
+        setnodevector(L, t, sn->shape->count);
+
+        for (int i = 0; i < sn->shape->count; i++)
+        {
+            TValue k;
+            setsvalue(L, &k, sn->shape->keys[i]);
+            setobjt2t(L, newkey(L, t, &k), &sn->slots[i]);
+        }
+    }
+    else if (isshaped(tt))
+    {
+        LuaShapedNode* sn = gshaped(tt);
 
-    if (tt->node != dummynode)
+        if (sn == &emptyshapednode)
+        {
+            t->node = tt->node;
+        }
+        else
+        {
+            // copies only get the slots they use
+            LuaShapedNode* nsn = newshapednode(L, t, sn->shape, sn->shape->count);
+            memcpy(nsn->slots, sn->slots, sn->shape->count * sizeof(TValue));
+            t->node = &nsn->sentinel;
+        }
+    }
+    else if (tt->node != dummynode)
     {
-        int size = 1 << tt->lsizenode;
-        t->node = luaM_newarray(L, size, LuaNode, t->memcat);
+        // probed hash parts are copied with their control bytes
+        size_t size = luaH_sizenodes(tt);
+        t->node = (LuaNode*)luaM_new_(L, size, t->memcat);
         t->lsizenode = tt->lsizenode;
         t->nodemask8 = tt->nodemask8;
-        memcpy(t->node, tt->node, size * sizeof(LuaNode));
+        memcpy(t->node, tt->node, size);
         t->lastfree = tt->lastfree;
     }
 
@@ -878,20 +1766,30 @@ LuaTable* luaH_clone(lua_State* L, LuaTable* tt)
 
 void luaH_remaptable(LuaTable* t, LuaTable *lt)
 {
+    TValue copy;
     if (t->sizearray)
     {
         for (int k=0;k<t->sizearray;k++) {
-            const TValue *m=luaH_get(lt,t->array+k);
+            const TValue *m=luaH_getcopy(lt,t->array+k,&copy);
             if (m!=luaO_nilobject)
                 t->array[k]=*m;
         }
     }
 
-    if (t->node != dummynode)
+    if (isshaped(t))
+    {
+        LuaShapedNode* sn = gshaped(t);
+        for (int k=0;k<sn->shape->count;k++) {
+            const TValue *m=luaH_getcopy(lt,sn->slots+k,&copy);
+            if (m!=luaO_nilobject)
+                sn->slots[k]=*m;
+        }
+    }
+    else if (t->node != dummynode)
     {
         int size = 1 << t->lsizenode;
         for (int k=0;k<size;k++) {
-            const TValue *m=luaH_get(lt,&((t->node+k)->val));
+            const TValue *m=luaH_getcopy(lt,&((t->node+k)->val),&copy);
             if (m!=luaO_nilobject)
                 (t->node+k)->val=*m;
         }
@@ -906,20 +1804,34 @@ void luaH_clear(LuaTable* tt)
         setnilvalue(&tt->array[i]);
     }
 
+    // packed arrays keep their capacity, like array parts
+    if (ispacked(tt))
+        gpacked(tt)->size = 0;
+
     maybesetaboundary(tt, 0);
 
+    // clear slots, the table keeps its shape
+    if (isshaped(tt))
+    {
+        LuaShapedNode* sn = gshaped(tt);
+        for (int i = 0; i < sn->shape->count; ++i)
+            setnilvalue(&sn->slots[i]);
+    }
     // clear hash part
-    if (tt->node != dummynode)
+    else if (tt->node != dummynode)
     {
         int size = sizenode(tt);
-        tt->lastfree = size;
+        bool probed = isprobed(tt);
+        tt->lastfree = probed ? probecapacity(size) : size;
         for (int i = 0; i < size; ++i)
         {
             LuaNode* n = gnode(tt, i);
             setnilvalue(gkey(n));
             setnilvalue(gval(n));
-            gnext(n) = 0;
+            gnext(n) = probed;
         }
+        if (probed)
+            memset(gctrl(tt), CTRL_EMPTY, size);
     }
 
     // back to empty -> no tag methods present
@@ -929,7 +1841,9 @@ void luaH_clear(LuaTable* tt)
 int luaH_getsize(LuaTable* t)
 {
     int count=0;
-    if (t->sizearray)
+    if (ispacked(t))
+        count += gpacked(t)->size;
+    else if (t->sizearray)
     {
         for (int k=0;k<t->sizearray;k++) {
             if (!ttisnil(&t->array[k]))
@@ -937,7 +1851,16 @@ int luaH_getsize(LuaTable* t)
         }
     }
 
-    if (t->node != dummynode)
+    if (isshaped(t))
+    {
+        LuaShapedNode* sn = gshaped(t);
+        for (int i=0; i < sn->shape->count; i++)
+        { // then slots
+            if (!ttisnil(&sn->slots[i]))
+                count++;
+        }
+    }
+    else if (t->node != dummynode)
     {
         for (int i=0; i < sizenode(t); i++)
         { // then hash part
@@ -10,11 +10,43 @@
 #define gval(n) (&(n)->val)
 #define gnext(n) ((n)->key.next)
 
-#define gval2slot(t, v) int(cast_to(LuaNode*, static_cast<const TValue*>(v)) - t->node)
+// shaped tables have a single node, and its chain doesn't end there (see ltable.cpp)
+#define isshaped(t) ((t)->lsizenode == 0 && gnext((t)->node) != 0)
+#define gshaped(t) cast_to(LuaShapedNode*, (t)->node)
+
+// large hash parts use open addressing; a control byte per node follows the nodes, with CTRL_EMPTY or 7 bits of the hash of the key
+#define isprobed(t) ((t)->lsizenode >= LUA_PROBEDLSIZE)
+#define gctrl(t) cast_to(uint8_t*, (t)->node + sizenode(t))
+#define CTRL_EMPTY 0x80
+
+// array parts of numbers may be packed; the table keeps no array part, and 'array' points to a LuaPackedArray instead (see ltable.cpp)
+#define ispacked(t) ((t)->sizearray == 0 && (t)->array != NULL)
+#define gpacked(t) cast_to(LuaPackedArray*, (t)->array)
+
+// number of keys that traversals visit before the hash part
+#define sizearraykeys(t) (ispacked(t) ? gpacked(t)->size : (t)->sizearray)
+
+// stores that go through luaH_setpacked: number keys of a packed table, and numbers appended to a large enough array part
+#define luaH_ispackedstore(t, key, val) \
+    (ispacked(t) ? ttisnumber(key) \
+                 : ttisnumber(val) && ttisnumber(key) && (t)->sizearray >= LUA_PACKEDMINSIZE && nvalue(key) == (t)->sizearray + 1)
+
+// slot hint for a value found in the table; string keys of a shaped table are predicted by their index in the slot array
+#define gval2slot(t, v) \
+    (isshaped(t) ? int(static_cast<const TValue*>(v) - gshaped(t)->slots) : int(cast_to(LuaNode*, static_cast<const TValue*>(v)) - t->node))
 
 // reset cache of absent metamethods, cache is updated in luaT_gettm
 #define invalidateTMcache(t) t->tmcache = 0
 
+// flags of LuaTable::readonly; the fast paths of the VM only write to tables without flags
+#define READONLYFLAG 1 // writes raise an error, see lua_setreadonly
+#define WATCHEDFLAG 2  // the table is part of a cached __index chain, writes invalidate the cache (see luaV_getindexchain)
+
+#define isreadonly(t) ((t)->readonly & READONLYFLAG)
+
+// slow paths check tables before writing to them: read-only tables raise an error, and watched ones invalidate cached __index chains
+#define luaH_checkwrite(L, t) ((t)->readonly ? luaH_flaggedwrite(L, t) : (void)0)
+
 LUAI_FUNC const TValue* luaH_getnum(LuaTable* t, int key);
 LUAI_FUNC TValue* luaH_setnum(lua_State* L, LuaTable* t, int key);
 LUAI_FUNC const TValue* luaH_getstr(LuaTable* t, TString* key);
@@ -22,6 +54,9 @@ LUAI_FUNC TValue* luaH_setstr(lua_State* L, LuaTable* t, TString* key);
 LUAI_FUNC const TValue* luaH_getp(LuaTable* t, void* key, int tag);
 LUAI_FUNC TValue* luaH_setp(lua_State* L, LuaTable* t, void* key, int tag);
 LUAI_FUNC const TValue* luaH_get(LuaTable* t, const TValue* key);
+// lookups that can meet packed elements, which are copied to 'copy' since they have no slot
+LUAI_FUNC const TValue* luaH_getnumcopy(LuaTable* t, int key, TValue* copy);
+LUAI_FUNC const TValue* luaH_getcopy(LuaTable* t, const TValue* key, TValue* copy);
 LUAI_FUNC TValue* luaH_set(lua_State* L, LuaTable* t, const TValue* key);
 LUAI_FUNC TValue* luaH_newkey(lua_State* L, LuaTable* t, const TValue* key);
 LUAI_FUNC LuaTable* luaH_new(lua_State* L, int narray, int lnhash);
@@ -34,7 +69,69 @@ LUAI_FUNC LuaTable* luaH_clone(lua_State* L, LuaTable* tt);
 LUAI_FUNC void luaH_clear(LuaTable* tt);
 LUAI_FUNC void luaH_remaptable(LuaTable* t, LuaTable *lt);
 LUAI_FUNC int luaH_getsize(LuaTable* tt);
+LUAI_FUNC size_t luaH_sizenodes(LuaTable* t);
+LUAI_FUNC void luaH_freeshapes(lua_State* L);
+LUAI_FUNC void luaH_flaggedwrite(lua_State* L, LuaTable* t);
+LUAI_FUNC bool luaH_setpacked(lua_State* L, LuaTable* t, const TValue* key, const TValue* val);
+LUAI_FUNC void luaH_packarray(lua_State* L, LuaTable* t);
+LUAI_FUNC void luaH_unpackarray(lua_State* L, LuaTable* t);
+LUAI_FUNC size_t luaH_sizearray(LuaTable* t);
 
 #define luaH_setslot(L, t, slot, key) (invalidateTMcache(t), (slot == luaO_nilobject ? luaH_newkey(L, t, key) : cast_to(TValue*, slot)))
 
 extern const LuaNode luaH_dummynode;
+
+// index of the slot of a key in a shape, or -1 if the shape doesn't have the key
+inline int luaH_shapefind(const LuaShape* shape, const TString* key)
+{
+    if (shape->keymask & (uint64_t(1) << (key->hash & 63)))
+    {
+        for (int i = 0; i < shape->count; i++)
+            if (shape->keys[i] == key)
+                return i;
+    }
+
+    return -1;
+}
+
+// value of a key of a shaped table if it's in the predicted slot and isn't nil, NULL otherwise
+inline TValue* luaH_getshapeslot(LuaTable* t, int slot, const TString* key)
+{
+    if (!isshaped(t))
+        return NULL;
+
+    LuaShapedNode* sn = gshaped(t);
+
+    if (unsigned(slot) < unsigned(sn->shape->count) && sn->shape->keys[slot] == key && !ttisnil(&sn->slots[slot]))
+        return &sn->slots[slot];
+
+    return NULL;
+}
+
+// value of a string key if it's in the slot returned by gval2slot and isn't nil, NULL otherwise; unlike slot hints, slots aren't truncated
+inline const TValue* luaH_getslot(LuaTable* t, int slot, const TString* key)
+{
+    if (isshaped(t))
+        return luaH_getshapeslot(t, slot, key);
+
+    if (unsigned(slot) < unsigned(sizenode(t)))
+    {
+        LuaNode* n = &t->node[slot];
+
+        if (ttisstring(gkey(n)) && gkey(n)->value.gc == (GCObject*)key && !ttisnil(gval(n)))
+            return gval(n);
+    }
+
+    return NULL;
+}
+
+// value of a string key if it's in the predicted slot and isn't nil, NULL otherwise
+inline const TValue* luaH_getslothint(LuaTable* t, int slot, const TString* key)
+{
+    LuaNode* n = &t->node[slot & t->nodemask8];
+
+    if (ttisstring(gkey(n)) && gkey(n)->value.gc == (GCObject*)key && !ttisnil(gval(n)))
+        return gval(n);
+
+    return luaH_getshapeslot(t, slot, key);
+}
@@ -11,6 +11,8 @@
 #include "ldebug.h"
 #include "lvm.h"
 
+#include <string.h>
+
 static int foreachi(lua_State* L)
 {
     luaL_checktype(L, 1, LUA_TTABLE);
@@ -55,6 +57,9 @@ static int maxn(lua_State* L)
 
     LuaTable* t = hvalue(L->base);
 
+    if (ispacked(t))
+        max = gpacked(t)->size;
+
     for (int i = 0; i < t->sizearray; i++)
     {
         if (!ttisnil(&t->array[i]))
@@ -90,8 +95,7 @@ static void moveelements(lua_State* L, int srct, int dstt, int f, int e, int t)
     LuaTable* src = hvalue(L->base + (srct - 1));
     LuaTable* dst = hvalue(L->base + (dstt - 1));
 
-    if (dst->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, dst);
 
     int n = e - f + 1; // number of elements to move
 
@@ -122,6 +126,12 @@ static void moveelements(lua_State* L, int srct, int dstt, int f, int e, int t)
 
         luaC_barrierfast(L, dst);
     }
+    else if (ispacked(src) && ispacked(dst) && unsigned(f) - 1 < unsigned(gpacked(src)->size) && unsigned(t) - 1 < unsigned(gpacked(dst)->size) &&
+             unsigned(f) - 1 + unsigned(n) <= unsigned(gpacked(src)->size) && unsigned(t) - 1 + unsigned(n) <= unsigned(gpacked(dst)->size))
+    {
+        // numbers only need to be copied, and memmove handles overlapping ranges of the same table
+        memmove(&gpacked(dst)->values[t - 1], &gpacked(src)->values[f - 1], n * sizeof(double));
+    }
     else
     {
         if (t > e || t <= f || dst != src)
@@ -221,12 +231,12 @@ static int tmove(lua_State* L)
 
         LuaTable* dst = hvalue(L->base + (tt - 1));
 
-        if (dst->readonly) // also checked in moveelements, but this blocks resizes of r/o tables
-            luaG_readonlyerror(L);
+        luaH_checkwrite(L, dst); // also checked in moveelements, but this blocks resizes of r/o tables
 
     	lualock_table(dst);
     	lualock_table(hvalue(L->base));
-        if (t > 0 && (t - 1) <= dst->sizearray && (t - 1 + n) > dst->sizearray)
+        // packed arrays grow as the elements are appended
+        if (t > 0 && (t - 1) <= dst->sizearray && (t - 1 + n) > dst->sizearray && !ispacked(dst))
         { // grow the destination table array
             luaH_resizearray(L, dst, t - 1 + n);
         }
@@ -246,6 +256,13 @@ static void addfield(lua_State* L, luaL_Strbuf* b, int i, LuaTable* t)
         TString* ts = tsvalue(&t->array[i - 1]);
         luaL_addlstring(b, getstr(ts), ts->len);
     }
+    else if (t && ispacked(t) && unsigned(i - 1) < unsigned(gpacked(t)->size))
+    {
+        // numbers are formatted like luaL_addvalue does, without converting them to strings first
+        char s[LUAI_MAXNUM2STR];
+        char* e = luai_num2str(s, gpacked(t)->values[i - 1]);
+        luaL_addlstring(b, s, e - s);
+    }
     else
     {
         int tt = lua_rawgeti(L, 1, i);
@@ -325,6 +342,13 @@ static int tunpack(lua_State* L)
     	luaunlock_table(t);
         L->top += n;
     }
+    else if (i == 1 && ispacked(t) && int(n) <= gpacked(t)->size)
+    {
+        for (i = 0; i < int(n); i++)
+            setnvalue(L->top + i, gpacked(t)->values[i]);
+    	luaunlock_table(t);
+        L->top += n;
+    }
     else
     {
         // push arg[i..e - 1] (to avoid overflows)
@@ -371,10 +395,14 @@ inline int sort_less(lua_State* L, LuaTable* t, int i, int j, SortPredicate pred
     int n = t->sizearray;
     LUAU_ASSERT(unsigned(i) < unsigned(n) && unsigned(j) < unsigned(n)); // contract maintained in sort_less after predicate call
 
+    // keys added to a shaped table change its shape instead of resizing it
+    LuaNode* node = t->node;
+    LuaShape* shape = isshaped(t) ? gshaped(t)->shape : NULL;
+
     int res = pred(L, &arr[i], &arr[j]);
 
-    // predicate call may resize the table, which is invalid
-    if (t->sizearray != n)
+    // predicate call may resize the table or add keys to it, which is invalid
+    if (t->sizearray != n || t->node != node || (isshaped(t) ? gshaped(t)->shape : NULL) != shape)
         luaL_error(L, "table modified during sorting");
 
     return res;
@@ -496,8 +524,7 @@ static int tsort(lua_State* L)
     luaL_checktype(L, 1, LUA_TTABLE);
     LuaTable* t = hvalue(L->base);
     int n = luaH_getn(t);
-    if (t->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, t);
 
     SortPredicate pred = luaV_lessthan;
     if (!lua_isnoneornil(L, 2)) // is there a 2nd argument?
@@ -507,8 +534,16 @@ static int tsort(lua_State* L)
     }
     lua_settop(L, 2); // make sure there are two arguments
 
+    // elements are sorted in the array part, and packed again once they are sorted
+    bool packed = ispacked(t);
+    if (packed)
+        luaH_unpackarray(L, t);
+
     if (n > 0)
         sort_rec(L, t, 0, n - 1, n, pred);
+
+    if (packed)
+        luaH_packarray(L, t);
     return 0;
 }
 
@@ -530,6 +565,9 @@ static int tcreate(lua_State* L)
             TValue* e = &t->array[i];
             setobj2t(L, e, v);
         }
+
+        if (ttisnumber(v))
+            luaH_packarray(L, t);
     }
     else
     {
@@ -549,11 +587,12 @@ static int tfind(lua_State* L)
 
     LuaTable* t = hvalue(L->base);
     StkId v = L->base + 1;
+    TValue copy;
 	lualock_table(t);
 
     for (int i = init;; ++i)
     {
-        const TValue* e = luaH_getnum(t, i);
+        const TValue* e = luaH_getnumcopy(t, i, &copy);
         if (ttisnil(e))
             break;
 
@@ -575,8 +614,7 @@ static int tclear(lua_State* L)
     luaL_checktype(L, 1, LUA_TTABLE);
 
     LuaTable* tt = hvalue(L->base);
-    if (tt->readonly)
-        luaG_readonlyerror(L);
+    luaH_checkwrite(L, tt);
 
 	lualock_table(tt);
     luaH_clear(tt);
@@ -629,9 +667,9 @@ static int tclone(lua_State* L)
     	deep=lua_toboolean(L,2);
         if (!deep) {
         	//Fast Path, use luau infra
-        	lualock_table(hvalue(L->base));
+        	lualock_tableread(hvalue(L->base));
         	LuaTable* tt = luaH_clone(L, hvalue(L->base));
-        	luaunlock_table(hvalue(L->base));
+        	luaunlock_tableread(hvalue(L->base));
 
             TValue v;
             sethvalue(L, &v, tt);
@@ -654,7 +692,12 @@ static int tclone(lua_State* L)
 static int tshare(lua_State* L)
 {
     luaL_checktype(L, 1, LUA_TTABLE);
-    hvalue(L->base)->shared=true;
+#ifdef LUAU_MULTITHREAD
+    // packed elements are read through a copy kept in the table, which concurrent readers would share
+    if (ispacked(hvalue(L->base)))
+        luaH_unpackarray(L, hvalue(L->base));
+    luaC_setbit(hvalue(L->base), SHAREDBIT);
+#endif
 
     lua_pushboolean(L, lua_getreadonly(L, 1));
     return 0;
@@ -0,0 +1,785 @@
+// This file is part of the Luau programming language and is licensed under MIT License; see LICENSE.txt for details
+#include "lualib.h"
+
+#include "lapi.h"
+#include "lgc.h"
+#include "lstate.h"
+#include "ltable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <string.h>
+
+/*
+** Task scheduler
+** task.spawn runs a function on a new coroutine, scheduled on a pool of native worker threads started by the first spawn.
+** Each worker owns a queue: tasks spawned by a worker go to its own queue and run newest first, while workers that run
+** out of work steal the oldest tasks of the others. Tasks spawned from other threads go to an extra queue that all
+** workers steal from.
+** A task gives its worker back with task.wait, or with task.join until the task it waits for is finished. A thread
+** that isn't running a task blocks in task.join instead, running queued tasks itself while it waits.
+**
+** Workers are attached to the VM for the lifetime of the pool and suspended while they have nothing to run, so that GC
+** steps never wait for them. The thread that starts the pool is attached as well, and must be suspended (see
+** luaL_ThreadSuspend) while it blocks outside of Lua code.
+*/
+
+#define TASK_RUNNING 0 // queued, running or waiting
+#define TASK_DONE 1
+#define TASK_ERROR 2
+
+// how long a blocked task.join sleeps before looking for queued tasks to run again
+static const std::chrono::milliseconds kJoinPoll(1);
+
+struct TaskPool;
+
+struct Task
+{
+    lua_State* co;
+    TaskPool* pool;
+    int ref;       // keeps the coroutine alive until the task is finished
+    int nargs;     // number of arguments for the next resume
+    Task* joining; // task this one yielded to wait for
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    int status;
+    std::vector<Task*> waiters; // tasks that yielded in task.join, requeued when this one is finished
+};
+
+struct TaskQueue
+{
+    std::mutex mutex;
+    std::deque<Task*> tasks;
+};
+
+struct TaskPool
+{
+    lua_State* L; // main thread
+    int size;     // number of workers
+
+    std::atomic<int> refs; // the library and every live task keep the pool alive
+
+    std::vector<std::unique_ptr<TaskQueue>> queues; // one per worker, the last one is for the threads that aren't workers
+    std::vector<std::thread> workers;
+    std::atomic<int> queued;
+
+    std::mutex mutex; // guards pool startup and shutdown, idle workers sleep on it
+    std::condition_variable wake;
+    std::atomic<int> sleeping;
+    std::atomic<bool> started;
+    bool stopping;
+
+    std::mutex tasksmutex;
+    std::unordered_set<Task*> tasks; // live tasks, to tell them apart from other threads
+};
+
+static thread_local TaskPool* currentpool; // pool of the worker running on this thread
+static thread_local int currentqueue;
+static thread_local Task* currenttask;
+
+static void releasepool(TaskPool* pool)
+{
+    if (pool->refs.fetch_sub(1) == 1)
+        delete pool;
+}
+
+static void pushtask(TaskPool* pool, Task* t)
+{
+    TaskQueue* q = pool->queues[currentpool == pool ? currentqueue : pool->size].get();
+
+    {
+        std::lock_guard<std::mutex> guard(q->mutex);
+        q->tasks.push_back(t);
+    }
+
+    // paired with the sleeping/queued checks in workerloop, one of the two sides sees the other's update
+    pool->queued.fetch_add(1);
+
+    if (pool->sleeping.load())
+    {
+        std::lock_guard<std::mutex> guard(pool->mutex);
+        pool->wake.notify_one();
+    }
+}
+
+static Task* poptask(TaskPool* pool)
+{
+    if (pool->queued.load(std::memory_order_relaxed) == 0)
+        return NULL;
+
+    int count = int(pool->queues.size());
+    int self = currentpool == pool ? currentqueue : pool->size;
+
+    // own queue newest first, then steal the oldest task of the others
+    for (int i = 0; i < count; i++)
+    {
+        TaskQueue* q = pool->queues[(self + i) % count].get();
+        std::lock_guard<std::mutex> guard(q->mutex);
+
+        if (!q->tasks.empty())
+        {
+            Task* t = i == 0 ? q->tasks.back() : q->tasks.front();
+            if (i == 0)
+                q->tasks.pop_back();
+            else
+                q->tasks.pop_front();
+
+            pool->queued.fetch_sub(1);
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+static void runtask(Task* t)
+{
+    lua_State* co = t->co;
+    int nargs = t->nargs;
+    t->nargs = 0;
+    t->joining = NULL;
+
+    Task* previous = currenttask;
+    currenttask = t;
+    int status = lua_resume(co, NULL, nargs);
+    currenttask = previous;
+
+    if (status == LUA_YIELD)
+    {
+        // values yielded with coroutine.yield are dropped, the task just gives its turn away
+        lua_settop(co, 0);
+
+        if (Task* target = t->joining)
+        {
+            std::lock_guard<std::mutex> guard(target->mutex);
+
+            if (target->status == TASK_RUNNING)
+            {
+                target->waiters.push_back(t);
+                return;
+            }
+        }
+
+        pushtask(t->pool, t);
+        return;
+    }
+
+    std::vector<Task*> waiters;
+
+    {
+        std::lock_guard<std::mutex> guard(t->mutex);
+        t->status = status == LUA_OK ? TASK_DONE : TASK_ERROR;
+        waiters.swap(t->waiters);
+    }
+
+    t->finished.notify_all();
+
+    for (Task* w : waiters)
+        pushtask(w->pool, w);
+
+    // nothing may touch the task past this point, unless it's referenced elsewhere it can be collected
+    lua_unref(co, t->ref);
+}
+
+static void workerloop(TaskPool* pool, int index)
+{
+    lua_State* L = pool->L;
+
+    currentpool = pool;
+    currentqueue = index;
+
+    // workers start out idle, GC steps don't need to wait for them
+    lua_enableThreads(L, 1, 1);
+    bool idle = true;
+
+    for (;;)
+    {
+        if (Task* t = poptask(pool))
+        {
+            if (idle)
+                lua_threadsuspend(L, 0);
+            idle = false;
+
+            runtask(t);
+            continue;
+        }
+
+        if (!idle)
+            lua_threadsuspend(L, 1);
+        idle = true;
+
+        std::unique_lock<std::mutex> guard(pool->mutex);
+        pool->sleeping.fetch_add(1);
+
+        while (!pool->stopping && pool->queued.load() == 0)
+            pool->wake.wait(guard);
+
+        pool->sleeping.fetch_sub(1);
+
+        if (pool->stopping)
+            break;
+    }
+
+    lua_enableThreads(L, -1, -1);
+}
+
+static void startpool(TaskPool* pool)
+{
+    std::lock_guard<std::mutex> guard(pool->mutex);
+
+    if (pool->started)
+        return;
+
+    // the thread starting the pool runs Lua code as well
+    if (pool->size)
+        lua_threadattach(pool->L);
+
+    for (int i = 0; i < pool->size; i++)
+        pool->workers.emplace_back(workerloop, pool, i);
+
+    pool->started = true;
+}
+
+static void stoppool(void* ud)
+{
+    TaskPool* pool = *(TaskPool**)ud;
+
+    {
+        std::lock_guard<std::mutex> guard(pool->mutex);
+        pool->stopping = true;
+        pool->wake.notify_all();
+    }
+
+    for (std::thread& worker : pool->workers)
+        worker.join();
+
+    if (pool->started && pool->size)
+        lua_threaddetach(pool->L);
+
+    releasepool(pool);
+}
+
+static void freetask(void* ud)
+{
+    Task* t = (Task*)ud;
+    TaskPool* pool = t->pool;
+
+    {
+        std::lock_guard<std::mutex> guard(pool->tasksmutex);
+        pool->tasks.erase(t);
+    }
+
+    t->~Task();
+    releasepool(pool);
+}
+
+static TaskPool* getpool(lua_State* L)
+{
+    return *(TaskPool**)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static Task* checktask(lua_State* L, int idx)
+{
+    lua_State* co = lua_tothread(L, idx);
+    Task* t = co ? (Task*)lua_getthreaddata(co) : NULL;
+
+    if (t)
+    {
+        TaskPool* pool = getpool(L);
+        std::lock_guard<std::mutex> guard(pool->tasksmutex);
+
+        if (!pool->tasks.count(t))
+            t = NULL;
+    }
+
+    luaL_argexpected(L, t, idx, "task");
+    return t;
+}
+
+static int taskresults(lua_State* L, Task* t)
+{
+    lua_State* co = t->co;
+
+    if (t->status == TASK_ERROR)
+    {
+        lua_xpush(co, L, -1);
+        lua_error(L);
+    }
+
+    // the task userdata sits below the results
+    int n = lua_gettop(co) - 1;
+    luaL_checkstack(L, n, "too many results to join");
+
+    for (int i = 2; i <= n + 1; i++)
+        lua_xpush(co, L, i);
+
+    return n;
+}
+
+static int task_spawn(lua_State* L)
+{
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    int nargs = lua_gettop(L) - 1;
+
+    TaskPool* pool = getpool(L);
+    if (!pool->started)
+        startpool(pool);
+
+    lua_State* co = lua_newthread(L);
+
+    Task* t = new (lua_newuserdatadtor(co, sizeof(Task), freetask)) Task();
+    t->co = co;
+    t->pool = pool;
+    t->nargs = nargs;
+    t->joining = NULL;
+    t->status = TASK_RUNNING;
+    pool->refs.fetch_add(1);
+
+    {
+        std::lock_guard<std::mutex> guard(pool->tasksmutex);
+        pool->tasks.insert(t);
+    }
+
+    lua_setthreaddata(co, t);
+
+    for (int i = 1; i <= nargs + 1; i++)
+        lua_pushvalue(L, i);
+    lua_xmove(L, co, nargs + 1);
+
+    t->ref = lua_ref(L, -1);
+    pushtask(pool, t);
+
+    return 1;
+}
+
+static int task_wait(lua_State* L)
+{
+    Task* self = currenttask;
+    if (!self || self->co != L || !lua_isyieldable(L))
+        luaL_error(L, "task.wait must be called from a task");
+
+    return lua_yield(L, 0);
+}
+
+static int task_join(lua_State* L)
+{
+    Task* t = checktask(L, 1);
+    Task* self = currenttask;
+
+    // a task yields until the other one is finished, see runtask
+    if (self && self->co == L && lua_isyieldable(L))
+    {
+        luaL_argcheck(L, t != self, 1, "task can't join itself");
+
+        bool running;
+
+        {
+            std::lock_guard<std::mutex> guard(t->mutex);
+            running = t->status == TASK_RUNNING;
+        }
+
+        if (!running)
+            return taskresults(L, t);
+
+        self->joining = t;
+        return lua_yield(L, 0);
+    }
+
+    // any other thread blocks, running queued tasks until the one it waits for is finished
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> guard(t->mutex);
+            if (t->status != TASK_RUNNING)
+                break;
+        }
+
+        if (Task* other = poptask(t->pool))
+        {
+            runtask(other);
+            continue;
+        }
+
+        lua_threadsuspend(L, 1);
+
+        {
+            std::unique_lock<std::mutex> guard(t->mutex);
+            t->finished.wait_for(guard, kJoinPoll);
+        }
+
+        lua_threadsuspend(L, 0);
+    }
+
+    return taskresults(L, t);
+}
+
+static int task_joincont(lua_State* L, int status, void* context)
+{
+    return taskresults(L, checktask(L, 1));
+}
+
+static int task_workers(lua_State* L)
+{
+    lua_pushinteger(L, getpool(L)->size);
+    return 1;
+}
+
+/*
+** Channels
+** A channel is a bounded ring of values sent from one lua_State to another without sharing anything: tables are deep
+** copied with luaH_clone on the sending side, so the receiver gets objects nobody else references. Strings are immutable
+** and buffers are handed over as is: the sender and the receiver share the same bytes, and scripts that keep writing to
+** a sent buffer have to synchronize themselves. Tables with metatables, functions, userdata and threads can't be sent,
+** since their metamethods and upvalues would be shared.
+** Ring positions are claimed with per-slot sequence numbers (or plain head/tail counters for a single producer and a
+** single consumer), and the values themselves live in the array part of the channel's own metatable, which the GC
+** traverses like any table. No table lock is involved: a slot is only touched by the thread that claimed it.
+*/
+
+struct Channel
+{
+    uint32_t mask; // capacity - 1
+    bool spsc;
+
+    char pad0[64];
+    std::atomic<uint32_t> head; // next position to send to
+    char pad1[64];
+    std::atomic<uint32_t> tail; // next position to receive from
+    char pad2[64];
+
+    std::atomic<uint32_t> seq[1]; // per slot sequence numbers for the MPMC ring
+};
+
+typedef std::unordered_map<LuaTable*, LuaTable*> ChannelCopies;
+
+static void copycontents(lua_State* L, LuaTable* t, ChannelCopies& copies, int depth);
+
+static void checksendable(lua_State* L, const TValue* o)
+{
+    // other values are either plain values, immutable strings or buffers that are shared
+    if (ttisfunction(o) || ttisuserdata(o) || ttisthread(o))
+        luaL_error(L, "cannot send %s through a channel", lua_typename(L, ttype(o)));
+}
+
+static LuaTable* clonesendable(lua_State* L, LuaTable* t)
+{
+    lualock_tableread(t);
+    LuaTable* c = t->metatable ? NULL : luaH_clone(L, t);
+    luaunlock_tableread(t);
+
+    if (!c)
+        luaL_error(L, "cannot send a table with a metatable through a channel");
+
+    return c;
+}
+
+static void copyvalue(lua_State* L, TValue* slot, LuaTable* owner, ChannelCopies& copies, int depth)
+{
+    switch (ttype(slot))
+    {
+    case LUA_TTABLE:
+    {
+        LuaTable* t = hvalue(slot);
+        ChannelCopies::iterator it = copies.find(t);
+
+        if (it != copies.end())
+        {
+            sethvalue(L, slot, it->second);
+            luaC_barriert(L, owner, slot);
+            break;
+        }
+
+        if (depth >= LUAI_MAXCCALLS)
+            luaL_error(L, "table is too deep to send");
+
+        LuaTable* c = clonesendable(L, t);
+        copies[t] = c;
+
+        // the copy is reachable from its owner before anything else is allocated
+        sethvalue(L, slot, c);
+        luaC_barriert(L, owner, slot);
+
+        copycontents(L, c, copies, depth + 1);
+        break;
+    }
+
+    default:
+        checksendable(L, slot);
+        break;
+    }
+}
+
+static void copycontents(lua_State* L, LuaTable* t, ChannelCopies& copies, int depth)
+{
+    for (int i = 0; i < t->sizearray; i++)
+        copyvalue(L, &t->array[i], t, copies, depth);
+
+    for (int i = 0; i < sizenode(t); i++)
+    {
+        LuaNode* n = gnode(t, i);
+
+        if (ttisnil(gval(n)))
+            continue;
+
+        // keys can't be replaced in place since their hash would change
+        if (iscollectable(gkey(n)) && ttype(gkey(n)) != LUA_TSTRING && ttype(gkey(n)) != LUA_TBUFFER)
+            luaL_error(L, "cannot send a table with %s keys", lua_typename(L, ttype(gkey(n))));
+
+        copyvalue(L, gval(n), t, copies, depth);
+    }
+
+    // keys of a shaped table are strings
+    if (isshaped(t))
+    {
+        LuaShapedNode* sn = gshaped(t);
+
+        for (int i = 0; i < sn->shape->count; i++)
+            copyvalue(L, &sn->slots[i], t, copies, depth);
+    }
+}
+
+static Channel* checkchannel(lua_State* L, int idx)
+{
+    const TValue* o = luaA_toobject(L, idx);
+    Udata* u = o && ttisuserdata(o) ? uvalue(o) : NULL;
+
+    // every channel metatable is tagged with the method table as its own metatable
+    if (!u || !u->metatable || u->metatable->metatable != hvalue(luaA_toobject(L, lua_upvalueindex(1))))
+        luaL_typeerror(L, idx, "channel");
+
+    return (Channel*)u->data;
+}
+
+static int channel_send(lua_State* L)
+{
+    Channel* ch = checkchannel(L, 1);
+    luaL_checkany(L, 2);
+    lua_settop(L, 2);
+
+    // the copy is made before claiming a slot, a full channel wastes it but never blocks the receivers
+    if (lua_istable(L, 2))
+    {
+        ChannelCopies copies;
+        LuaTable* t = hvalue(luaA_toobject(L, 2));
+
+        LuaTable* c = clonesendable(L, t);
+        copies[t] = c;
+
+        lua_pushnil(L);
+        sethvalue(L, L->top - 1, c);
+
+        copycontents(L, c, copies, 1);
+    }
+    else
+    {
+        checksendable(L, luaA_toobject(L, 2));
+        lua_pushvalue(L, 2);
+    }
+
+    uint32_t pos;
+
+    if (ch->spsc)
+    {
+        pos = ch->head.load(std::memory_order_relaxed);
+
+        if (pos - ch->tail.load(std::memory_order_acquire) > ch->mask)
+        {
+            lua_pushboolean(L, false);
+            return 1;
+        }
+    }
+    else
+    {
+        pos = ch->head.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            int32_t diff = int32_t(ch->seq[pos & ch->mask].load(std::memory_order_acquire) - pos);
+
+            if (diff == 0 && ch->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+            else if (diff < 0)
+            {
+                lua_pushboolean(L, false);
+                return 1;
+            }
+            else if (diff > 0)
+                pos = ch->head.load(std::memory_order_relaxed);
+        }
+    }
+
+    LuaTable* slots = uvalue(luaA_toobject(L, 1))->metatable;
+    TValue* slot = &slots->array[pos & ch->mask];
+    setobj2t(L, slot, L->top - 1);
+    luaC_barriert(L, slots, slot);
+
+    if (ch->spsc)
+        ch->head.store(pos + 1, std::memory_order_release);
+    else
+        ch->seq[pos & ch->mask].store(pos + 1, std::memory_order_release);
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+static int channel_receive(lua_State* L)
+{
+    Channel* ch = checkchannel(L, 1);
+    uint32_t pos;
+
+    if (ch->spsc)
+    {
+        pos = ch->tail.load(std::memory_order_relaxed);
+
+        if (ch->head.load(std::memory_order_acquire) == pos)
+        {
+            lua_pushboolean(L, false);
+            return 1;
+        }
+    }
+    else
+    {
+        pos = ch->tail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            int32_t diff = int32_t(ch->seq[pos & ch->mask].load(std::memory_order_acquire) - (pos + 1));
+
+            if (diff == 0 && ch->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+            else if (diff < 0)
+            {
+                lua_pushboolean(L, false);
+                return 1;
+            }
+            else if (diff > 0)
+                pos = ch->tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    LuaTable* slots = uvalue(luaA_toobject(L, 1))->metatable;
+    TValue* slot = &slots->array[pos & ch->mask];
+
+    lua_pushboolean(L, true);
+    lua_pushnil(L);
+    setobj2s(L, L->top - 1, slot);
+    setnilvalue(slot);
+
+    if (ch->spsc)
+        ch->tail.store(pos + 1, std::memory_order_release);
+    else
+        ch->seq[pos & ch->mask].store(pos + ch->mask + 1, std::memory_order_release);
+
+    return 2;
+}
+
+static int task_channel(lua_State* L)
+{
+    int capacity = luaL_checkinteger(L, 1);
+    const char* mode = luaL_optstring(L, 2, "mpmc");
+    luaL_argcheck(L, capacity > 0 && capacity <= (1 << 24), 1, "capacity out of range");
+
+    bool spsc = strcmp(mode, "spsc") == 0;
+    luaL_argcheck(L, spsc || strcmp(mode, "mpmc") == 0, 2, "invalid channel mode");
+
+    // round up to a power of two so that positions wrap around cleanly
+    uint32_t size = 1;
+    while (size < uint32_t(capacity))
+        size *= 2;
+
+    Channel* ch = (Channel*)lua_newuserdata(L, sizeof(Channel) + (size - 1) * sizeof(std::atomic<uint32_t>));
+    ch->mask = size - 1;
+    ch->spsc = spsc;
+    ch->head.store(0, std::memory_order_relaxed);
+    ch->tail.store(0, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < size; i++)
+        ch->seq[i].store(i, std::memory_order_relaxed);
+
+    lua_createtable(L, size, 2);
+
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_setfield(L, -2, "__index");
+    lua_pushliteral(L, "channel");
+    lua_setfield(L, -2, "__metatable");
+
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_setmetatable(L, -2);
+
+    lua_setmetatable(L, -2);
+    return 1;
+}
+
+int luaopen_task(lua_State* L)
+{
+    TaskPool* pool = new TaskPool();
+    pool->L = lua_mainthread(L);
+#ifdef LUAU_MULTITHREAD
+    pool->size = std::max(1, int(std::thread::hardware_concurrency()));
+#else
+    // without locks tasks can only run on the threads calling task.join
+    pool->size = 0;
+#endif
+    pool->refs = 1;
+    pool->queued = 0;
+    pool->sleeping = 0;
+    pool->started = false;
+    pool->stopping = false;
+
+    for (int i = 0; i <= pool->size; i++)
+        pool->queues.emplace_back(new TaskQueue());
+
+    // the pool is only shut down when the state is closed
+    *(TaskPool**)lua_newuserdatadtor(L, sizeof(TaskPool*), stoppool) = pool;
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, "_TASKPOOL");
+
+    lua_createtable(L, 0, 5);
+
+    lua_pushvalue(L, -2);
+    lua_pushcclosure(L, task_spawn, "spawn", 1);
+    lua_setfield(L, -2, "spawn");
+
+    lua_pushvalue(L, -2);
+    lua_pushcclosure(L, task_wait, "wait", 1);
+    lua_setfield(L, -2, "wait");
+
+    lua_pushvalue(L, -2);
+    lua_pushcclosurek(L, task_join, "join", 1, task_joincont);
+    lua_setfield(L, -2, "join");
+
+    lua_pushvalue(L, -2);
+    lua_pushcclosure(L, task_workers, "workers", 1);
+    lua_setfield(L, -2, "workers");
+
+    lua_createtable(L, 0, 2);
+
+    lua_pushvalue(L, -1);
+    lua_pushcclosure(L, channel_send, "send", 1);
+    lua_setfield(L, -2, "send");
+
+    lua_pushvalue(L, -1);
+    lua_pushcclosure(L, channel_receive, "receive", 1);
+    lua_setfield(L, -2, "receive");
+
+    lua_setreadonly(L, -1, true);
+    lua_pushcclosure(L, task_channel, "channel", 1);
+    lua_setfield(L, -2, "channel");
+
+    lua_pushvalue(L, -1);
+    lua_setglobal(L, LUA_TASKLIBNAME);
+
+    return 1;
+}
@@ -11,7 +11,7 @@ Udata* luaU_newudata(lua_State* L, size_t s, int tag)
 {
     if (s > INT_MAX - sizeof(Udata))
         luaM_toobig(L);
-    Udata* u = luaM_newgco(L, Udata, sizeudata(s), L->activememcat);
+    Udata* u = luaM_newgco(L, Udata, sizeudata(s), L->activememcat, LUA_TUSERDATA);
     luaC_init(L, u, LUA_TUSERDATA);
     u->len = int(s);
     u->metatable = NULL;
@@ -22,7 +22,12 @@ Udata* luaU_newudata(lua_State* L, size_t s, int tag)
 
 void luaU_freeudata(lua_State* L, Udata* u, lua_Page* page)
 {
-    if (u->tag < LUA_UTAG_LIMIT)
+    if (udatabatched(L->global, u))
+    {
+        void* data = u->data;
+        L->global->udatagcbatch[u->tag](L, &data, 1);
+    }
+    else if (u->tag < LUA_UTAG_LIMIT)
     {
         lua_Destructor dtor = L->global->udatagc[u->tag];
         // TODO: access to L here is highly unsafe since this is called during internal GC traversal
@@ -40,3 +45,38 @@ void luaU_freeudata(lua_State* L, Udata* u, lua_Page* page)
 
     luaM_freegco(L, u, sizeudata(u->len), u->memcat, page);
 }
+
+// all userdata of the list are in the same page; each tag gets one destructor call for all its userdata, before any of them is freed
+void luaU_freeudatabatch(lua_State* L, Udata** list, int count, lua_Page* page)
+{
+    global_State* g = L->global;
+    void* data[UDATA_BATCH];
+
+    LUAU_ASSERT(count <= UDATA_BATCH);
+
+    for (int i = 0; i < count; ++i)
+    {
+        // userdata of the tags that were already destroyed are freed
+        if (!list[i])
+            continue;
+
+        uint8_t tag = list[i]->tag;
+        int n = 0;
+
+        for (int j = i; j < count; ++j)
+            if (list[j] && list[j]->tag == tag)
+                data[n++] = list[j]->data;
+
+        if (lua_BatchDestructor dtor = g->udatagcbatch[tag])
+            dtor(L, data, n);
+
+        for (int j = i; j < count; ++j)
+        {
+            if (list[j] && list[j]->tag == tag)
+            {
+                luaM_freegco(L, list[j], sizeudata(list[j]->len), list[j]->memcat, page);
+                list[j] = NULL;
+            }
+        }
+    }
+}
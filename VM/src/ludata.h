@@ -13,5 +13,10 @@
 // userdata larger than 16 bytes will be extended to guarantee 16 byte alignment of subsequent blocks
 #define sizeudata(len) (offsetof(Udata, data) + (len > 16 ? ((len + 15) & ~15) : len))
 
+// userdata whose tag has a batch destructor are freed in batches by the sweep, at most UDATA_BATCH at a time
+#define udatabatched(g, u) ((u)->tag < LUA_UTAG_LIMIT && (g)->udatagcbatch[(u)->tag])
+#define UDATA_BATCH 128
+
 LUAI_FUNC Udata* luaU_newudata(lua_State* L, size_t s, int tag);
 LUAI_FUNC void luaU_freeudata(lua_State* L, Udata* u, struct lua_Page* page);
+LUAI_FUNC void luaU_freeudatabatch(lua_State* L, Udata** list, int count, struct lua_Page* page);
@@ -33,6 +33,14 @@ LUAI_FUNC lua_Number luaV_getbuffervec(lua_State* L, const TValue *tb, const flo
 LUAI_FUNC int luaV_tostring(lua_State* L, StkId obj);
 LUAI_FUNC void luaV_gettable(lua_State* L, const TValue* t, TValue* key, StkId val);
 LUAI_FUNC void luaV_settable(lua_State* L, const TValue* t, TValue* key, StkId val);
+// inline caches (see LuaInlineCache) for the slow paths of GETTABLEKS, SETTABLEKS and NAMECALL; luaV_getcached returns NULL when the
+// lookup needs metamethods, and sets L->cachedslot to the new slot hint of the instruction
+LUAI_FUNC const TValue* luaV_getcached(lua_State* L, LuaInlineCache* ic, LuaTable* h, LuaTable* mt, TString* key, int slot);
+LUAI_FUNC TValue* luaV_setcached(LuaInlineCache* ic, LuaTable* h, TString* key);
+LUAI_FUNC void luaV_cacheslot(LuaInlineCache* ic, LuaTable* h, const TValue* res);
+// looks a string key up through the __index table of a metatable, and through the __index tables of the metatables of that table and so on;
+// returns NULL when the lookup needs a metamethod call, lookups are cached in global_State::indexchains
+LUAI_FUNC const TValue* luaV_getindexchain(lua_State* L, LuaTable* mt, TString* key);
 LUAI_FUNC void luaV_concat(lua_State* L, int total, int last);
 LUAI_FUNC void luaV_getimport(lua_State* L, LuaTable* env, TValue* k, StkId res, uint32_t id, bool propagatenil);
 LUAI_FUNC void luaV_prepareFORN(lua_State* L, StkId plimit, StkId pstep, StkId pinit);
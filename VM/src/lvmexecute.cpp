@@ -64,6 +64,20 @@
 #define VM_KV(i) (LUAU_ASSERT(unsigned(i) < unsigned(cl->l.p->sizek)), &k[i])
 #define VM_UV(i) (LUAU_ASSERT(unsigned(i) < unsigned(cl->nupvalues)), &cl->l.uprefs[i])
 
+// inline cache of the table access instruction that is executing, since pc-2 rolls back two pc++, or NULL until the function has one
+#define VM_INLINECACHE() luaF_getinlinecache(cl->l.p, pc - 2)
+
+// slot hints start out as the hash of the key, so an instruction missing a hint that doesn't match it has been patched before
+// and sees more than one table layout; the caches of its function are allocated then, outside of table locks since it may fail
+#define VM_HINTMISSED(kv) \
+    { \
+        if (LUAU_UNLIKELY(LUAU_INSN_C(insn) != uint8_t(tsvalue(kv)->hash)) && !cl->l.p->icache.load(std::memory_order_relaxed)) \
+        { \
+            VM_PROTECT_PC(); \
+            luaF_newinlinecache(L, cl->l.p); \
+        } \
+    }
+
 #define VM_PATCH_C(pc, slot) *const_cast<Instruction*>(pc) = ((uint8_t(slot) << 24) | (0x00ffffffu & *(pc)))
 #define VM_PATCH_E(pc, slot) *const_cast<Instruction*>(pc) = ((uint32_t(slot) << 8) | (0x000000ffu & *(pc)))
 
@@ -79,8 +93,20 @@
                 goto exit; \
             } \
         } \
+        VM_SAFEPOINT(); \
     }
 
+#ifdef LUAU_MULTITHREAD
+// park here while another thread runs a GC step
+#define VM_SAFEPOINT() \
+    { \
+        if (LUAU_UNLIKELY(L->global->threads.gcrequest.load(std::memory_order_relaxed))) \
+            VM_PROTECT(luaE_safepoint(L)); \
+    }
+#else
+#define VM_SAFEPOINT()
+#endif
+
 #define VM_DISPATCH_OP(op) &&CASE_##op
 
 #define VM_DISPATCH_TABLE() \
@@ -346,6 +372,12 @@ reentry:
                     setobj2s(L, ra, gval(n));
                     VM_NEXT();
                 }
+                else if (TValue* res = luaH_getshapeslot(h, LUAU_INSN_C(insn), tsvalue(kv)))
+                {
+                    // fast-path: value is in expected slot of a shaped table
+                    setobj2s(L, ra, res);
+                    VM_NEXT();
+                }
                 else
                 {
                     // slow-path, may invoke Lua calls via __index metamethod
@@ -378,6 +410,13 @@ reentry:
                     luaC_barriert(L, h, ra);
                     VM_NEXT();
                 }
+                else if (TValue* res = h->readonly ? NULL : luaH_getshapeslot(h, LUAU_INSN_C(insn), tsvalue(kv)))
+                {
+                    // fast-path: value is in expected slot of a shaped table
+                    setobj2t(L, res, ra);
+                    luaC_barriert(L, h, ra);
+                    VM_NEXT();
+                }
                 else
                 {
                     // slow-path, may invoke Lua calls via __newindex metamethod
@@ -459,7 +498,7 @@ reentry:
                 if (LUAU_LIKELY(ttistable(rb)))
                 {
 					LuaTable* h = hvalue(rb);
-                    lualock_table(h);
+                    lualock_tableread(h);
 
                     int slot = LUAU_INSN_C(insn) & h->nodemask8;
                     LuaNode* n = &h->node[slot];
@@ -468,33 +507,36 @@ reentry:
                     if (LUAU_LIKELY(ttisstring(gkey(n)) && tsvalue(gkey(n)) == tsvalue(kv) && !ttisnil(gval(n))))
                     {
                         setobj2s(L, ra, gval(n));
-                        luaunlock_table(h);
+                        luaunlock_tableread(h);
                         VM_NEXT();
                     }
-                    else if (!h->metatable)
+                    else if (TValue* res = luaH_getshapeslot(h, LUAU_INSN_C(insn), tsvalue(kv)))
                     {
-                        // fast-path: value is not in expected slot, but the table lookup doesn't involve metatable
-                        const TValue* res = luaH_getstr(h, tsvalue(kv));
-
-                        if (res != luaO_nilobject)
-                        {
-                            int cachedslot = gval2slot(h, res);
-                            // save cachedslot to accelerate future lookups; patches currently executing instruction since pc-2 rolls back two pc++
-                            VM_PATCH_C(pc - 2, cachedslot);
-                        }
-
+                        // fast-path: value is in expected slot of a shaped table
                         setobj2s(L, ra, res);
-                        luaunlock_table(h);
+                        luaunlock_tableread(h);
                         VM_NEXT();
                     }
                     else
                     {
+                        // fast-path: value is in a slot predicted by the inline cache, or the lookup doesn't involve metamethods
+                        if (const TValue* res = luaV_getcached(L, VM_INLINECACHE(), h, NULL, tsvalue(kv), LUAU_INSN_C(insn)))
+                        {
+                            // save cachedslot to accelerate future lookups; patches currently executing instruction since pc-2 rolls back two pc++
+                            VM_PATCH_C(pc - 2, L->cachedslot);
+                            setobj2s(L, ra, res);
+                            luaunlock_tableread(h);
+                            VM_HINTMISSED(kv);
+                            VM_NEXT();
+                        }
+
                         // slow-path, may invoke Lua calls via __index metamethod
+                        // luaV_gettable takes the table lock itself and must not call metamethods with it held
+                        luaunlock_tableread(h);
                         L->cachedslot = slot;
                         VM_PROTECT(luaV_gettable(L, rb, kv, ra));
                         // save cachedslot to accelerate future lookups; patches currently executing instruction since pc-2 rolls back two pc++
                         VM_PATCH_C(pc - 2, L->cachedslot);
-                        luaunlock_table(h);
                         VM_NEXT();
                     }
                 }
@@ -623,6 +665,22 @@ reentry:
                         luaunlock_table(h);
                         VM_NEXT();
                     }
+                    else if (TValue* res = h->readonly ? NULL : luaH_getshapeslot(h, LUAU_INSN_C(insn), tsvalue(kv)))
+                    {
+                        // fast-path: value is in expected slot of a shaped table
+                        setobj2t(L, res, ra);
+                        luaC_barriert(L, h, ra);
+                        luaunlock_table(h);
+                        VM_NEXT();
+                    }
+                    else if (TValue* res = h->readonly ? NULL : luaV_setcached(VM_INLINECACHE(), h, tsvalue(kv)))
+                    {
+                        // fast-path: value is in a slot predicted by the inline cache
+                        setobj2t(L, res, ra);
+                        luaC_barriert(L, h, ra);
+                        luaunlock_table(h);
+                        VM_NEXT();
+                    }
                     else if (fastnotm(h->metatable, TM_NEWINDEX) && !h->readonly)
                     {
                         VM_PROTECT_PC(); // set may fail
@@ -631,9 +689,11 @@ reentry:
                         int cachedslot = gval2slot(h, res);
                         // save cachedslot to accelerate future lookups; patches currently executing instruction since pc-2 rolls back two pc++
                         VM_PATCH_C(pc - 2, cachedslot);
+                        luaV_cacheslot(VM_INLINECACHE(), h, res);
                         setobj2t(L, res, ra);
                         luaC_barriert(L, h, ra);
                         luaunlock_table(h);
+                        VM_HINTMISSED(kv);
                         VM_NEXT();
                     }
                     else
@@ -777,6 +837,13 @@ reentry:
                         VM_NEXT();
                     }
 
+                    // packed arrays have no nil values, so __index is never used for their elements
+                    if (ispacked(h) && unsigned(index) - 1 < unsigned(gpacked(h)->size) && double(index) == indexd)
+                    {
+                        setnvalue(ra, gpacked(h)->values[unsigned(index - 1)]);
+                        VM_NEXT();
+                    }
+
                     // fall through to slow path
                 }
                 else if (ttisbuffer(rb) && ttisnumber(rc)) {
@@ -834,6 +901,25 @@ reentry:
                         VM_NEXT();
                     }
 
+                    // packed elements are never nil, so __newindex is never used for them; numbers don't need a barrier
+                    if (ispacked(h) && ttisnumber(ra) && !h->readonly && double(index) == indexd)
+                    {
+                        LuaPackedArray* pa = gpacked(h);
+
+                        if (unsigned(index) - 1 < unsigned(pa->size))
+                        {
+                            pa->values[unsigned(index - 1)] = nvalue(ra);
+                            VM_NEXT();
+                        }
+
+                        // appending a number is only visible to __newindex, and to the hash part that could hold the key after it
+                        if (index == pa->size + 1 && pa->size < pa->capacity && !h->metatable && h->node == &luaH_dummynode)
+                        {
+                            pa->values[pa->size++] = nvalue(ra);
+                            VM_NEXT();
+                        }
+                    }
+
                     // fall through to slow path
                 }
                 else if (ttisbuffer(rb) && ttisnumber(rc) && ttisnumber(ra)) {
@@ -886,6 +972,13 @@ reentry:
                         VM_NEXT();
                     }
 
+                    // packed arrays have no nil values, so __index is never used for their elements
+                    if (ispacked(h) && unsigned(c) < unsigned(gpacked(h)->size))
+                    {
+                        setnvalue(ra, gpacked(h)->values[c]);
+                        VM_NEXT();
+                    }
+
                     // fall through to slow path
                 }
                 else if (ttisbuffer(rb)) {
@@ -927,6 +1020,13 @@ reentry:
                         VM_NEXT();
                     }
 
+                    // packed elements are never nil, so __newindex is never used for them; numbers don't need a barrier
+                    if (ispacked(h) && ttisnumber(ra) && unsigned(c) < unsigned(gpacked(h)->size) && !h->readonly)
+                    {
+                        gpacked(h)->values[c] = nvalue(ra);
+                        VM_NEXT();
+                    }
+
                     // fall through to slow path
                 }
                 else if (ttisbuffer(rb) && ttisnumber(ra)) {
@@ -973,6 +1073,7 @@ reentry:
                     {
                     case LCT_VAL:
                         setobj(L, &ncl->l.uprefs[ui], VM_REG(LUAU_INSN_B(uinsn)));
+                        luaC_regionescape(L, &ncl->l.uprefs[ui]);
                         break;
 
                     case LCT_REF:
@@ -981,6 +1082,7 @@ reentry:
 
                     case LCT_UPVAL:
                         setobj(L, &ncl->l.uprefs[ui], VM_UV(LUAU_INSN_B(uinsn)));
+                        luaC_regionescape(L, &ncl->l.uprefs[ui]);
                         break;
 
                     default:
@@ -1010,7 +1112,10 @@ reentry:
                     LuaNode* n = &h->node[tsvalue(kv)->hash & (sizenode(h) - 1)];
 
                     const TValue* mt = 0;
-                    const LuaNode* mtn = 0;
+                    const TValue* mtv = 0;
+                    // shaped tables keep their keys in slots, the sentinel node never matches
+                    LuaShapedNode* sn = isshaped(h) ? gshaped(h) : NULL;
+                    int shapeslot = sn ? luaH_shapefind(sn->shape, tsvalue(kv)) : -1;
 
                     // fast-path: key is in the table in expected slot
                     if (ttisstring(gkey(n)) && tsvalue(gkey(n)) == tsvalue(kv) && !ttisnil(gval(n)))
@@ -1019,14 +1124,32 @@ reentry:
                         setobj2s(L, ra + 1, rb);
                         setobj2s(L, ra, gval(n));
                     }
+                    // fast-path: key is in the slots of a shaped table
+                    else if (shapeslot >= 0 && !ttisnil(&sn->slots[shapeslot]))
+                    {
+                        // note: order of copies allows rb to alias ra+1 or ra
+                        setobj2s(L, ra + 1, rb);
+                        setobj2s(L, ra, &sn->slots[shapeslot]);
+                    }
                     // fast-path: key is absent from the base, table has an __index table, and it has the result in the expected slot
-                    else if (gnext(n) == 0 && (mt = fasttm(L, hvalue(rb)->metatable, TM_INDEX)) && ttistable(mt) &&
-                             (mtn = &hvalue(mt)->node[LUAU_INSN_C(insn) & hvalue(mt)->nodemask8]) && ttisstring(gkey(mtn)) &&
-                             tsvalue(gkey(mtn)) == tsvalue(kv) && !ttisnil(gval(mtn)))
+                    else if ((sn ? shapeslot < 0 : gnext(n) == 0) && (mt = fasttm(L, hvalue(rb)->metatable, TM_INDEX)) && ttistable(mt) &&
+                             (mtv = luaH_getslothint(hvalue(mt), LUAU_INSN_C(insn), tsvalue(kv))))
+                    {
+                        // note: order of copies allows rb to alias ra+1 or ra
+                        setobj2s(L, ra + 1, rb);
+                        setobj2s(L, ra, mtv);
+                    }
+                    // fast-path: key is in a slot predicted by the inline cache, or the lookup doesn't involve metamethods
+                    else if ((mtv = luaV_getcached(L, VM_INLINECACHE(), h, NULL, tsvalue(kv), LUAU_INSN_C(insn))))
                     {
+                        // save cachedslot to accelerate future lookups; patches currently executing instruction since pc-2 rolls back two pc++
+                        VM_PATCH_C(pc - 2, L->cachedslot);
                         // note: order of copies allows rb to alias ra+1 or ra
                         setobj2s(L, ra + 1, rb);
-                        setobj2s(L, ra, gval(mtn));
+                        setobj2s(L, ra, mtv);
+                        if (ttisnil(ra))
+                            luaG_methoderror(L, ra + 1, tsvalue(kv));
+                        VM_HINTMISSED(kv);
                     }
                     else
                     {
@@ -1069,6 +1192,24 @@ reentry:
                             setobj2s(L, ra + 1, rb);
                             setobj2s(L, ra, gval(n));
                         }
+                        else if (TValue* res = luaH_getshapeslot(h, LUAU_INSN_C(insn), tsvalue(kv)))
+                        {
+                            // note: order of copies allows rb to alias ra+1 or ra
+                            setobj2s(L, ra + 1, rb);
+                            setobj2s(L, ra, res);
+                        }
+                        // fast-path: method is in a slot predicted by the inline cache
+                        else if (const TValue* cres = luaV_getcached(L, VM_INLINECACHE(), NULL, mt, tsvalue(kv), slot))
+                        {
+                            // save cachedslot to accelerate future lookups; patches currently executing instruction since pc-2 rolls back two pc++
+                            VM_PATCH_C(pc - 2, L->cachedslot);
+                            // note: order of copies allows rb to alias ra+1 or ra
+                            setobj2s(L, ra + 1, rb);
+                            setobj2s(L, ra, cres);
+                            if (ttisnil(ra))
+                                luaG_methoderror(L, ra + 1, tsvalue(kv));
+                            VM_HINTMISSED(kv);
+                        }
                         else
                         {
                             // slow-path: handles slot mismatch
@@ -2413,10 +2554,10 @@ reentry:
                 TValue* kv = VM_KV(LUAU_INSN_D(insn));
 
 				VM_PROTECT_PC(); // luaH_clone may fail due to OOM
-                lualock_table(hvalue(kv));
+                lualock_tableread(hvalue(kv));
                 LuaTable *tnew = luaH_clone(L, hvalue(kv));
                 sethvalue(L, ra, tnew);
-                luaunlock_table(hvalue(kv));
+                luaunlock_tableread(hvalue(kv));
                 profiletable(L, tnew, pc);
                 if (L->profileTableAllocs)
                     base = L->base; // stack may have been reallocated, so we need to refresh base ptr
@@ -2595,6 +2736,26 @@ reentry:
                         for (int i = 2; i < int(aux); ++i)
                             setnilvalue(ra + 3 + i);
 
+                    // packed arrays have no nil values, and their keys are numbered like an array part
+                    if (ispacked(h))
+                    {
+                        LuaPackedArray* pa = gpacked(h);
+
+                        if (unsigned(index) < unsigned(pa->size))
+                        {
+                            setpvalue(ra + 2, reinterpret_cast<void*>(uintptr_t(index + 1)), LU_TAG_ITERATOR);
+                            setnvalue(ra + 3, double(index + 1));
+                            setnvalue(ra + 4, pa->values[index]);
+
+                            pc += LUAU_INSN_D(insn);
+                            LUAU_ASSERT(unsigned(pc - cl->l.p->code) < unsigned(cl->l.p->sizecode));
+                            VM_NEXT();
+                        }
+
+                        // ipairs-style traversal ends with the packed array, and there are no array elements to skip past it
+                        sizearray = pa->size;
+                    }
+
                     // terminate ipairs-style traversal early when encountering nil
                     if (int(aux) < 0 && (unsigned(index) >= unsigned(sizearray) || ttisnil(&h->array[index])))
                     {
@@ -2642,6 +2803,30 @@ reentry:
                         index++;
                     }
 
+                    // and finally through the slots of a shaped table
+                    if (isshaped(h))
+                    {
+                        LuaShapedNode* sn = gshaped(h);
+
+                        while (unsigned(index - sizearray - sizenode) < unsigned(sn->shape->count))
+                        {
+                            TValue* e = &sn->slots[index - sizearray - sizenode];
+
+                            if (!ttisnil(e))
+                            {
+                                setpvalue(ra + 2, reinterpret_cast<void*>(uintptr_t(index + 1)), LU_TAG_ITERATOR);
+                                setsvalue(L, ra + 3, sn->shape->keys[index - sizearray - sizenode]);
+                                setobj2s(L, ra + 4, e);
+
+                                pc += LUAU_INSN_D(insn);
+                                LUAU_ASSERT(unsigned(pc - cl->l.p->code) < unsigned(cl->l.p->sizecode));
+                                VM_NEXT();
+                            }
+
+                            index++;
+                        }
+                    }
+
                     // fallthrough to exit
                     pc++;
                     VM_NEXT();
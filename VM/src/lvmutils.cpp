@@ -164,6 +164,70 @@ static void callTM(lua_State* L, const TValue* f, const TValue* p1, const TValue
     luaD_call(L, L->top - 4, 0);
 }
 
+static indexcache::Entry* indexchainentry(global_State* g, LuaTable* mt, TString* key)
+{
+    uintptr_t h = uintptr_t(mt) >> 4;
+    return &g->indexchains.entries[(h ^ (h >> 8) ^ key->hash) & (LUA_INDEXCACHESIZE - 1)];
+}
+
+const TValue* luaV_getindexchain(lua_State* L, LuaTable* mt, TString* key)
+{
+    global_State* g = L->global;
+
+#ifdef LUAU_MULTITHREAD
+    // cache entries can't be updated atomically, and the tables of the chain may need locks
+    if (luaE_luathreads(g))
+        return NULL;
+#endif
+
+    indexcache::Entry* e = indexchainentry(g, mt, key);
+
+    if (e->mt == mt && e->key == key && e->gen == g->indexchains.gen)
+    {
+        if (!e->h)
+            return luaO_nilobject;
+
+        // the value may have been changed or removed in place since, only the shape of the chain is guaranteed by the generation
+        if (const TValue* res = luaH_getslot(e->h, e->slot, key))
+            return res;
+    }
+
+    // tables of the chain are flagged so that writes to them (and changes of their metatables) take the slow paths, which invalidate the cache
+    LuaTable* start = mt;
+
+    for (int loop = 0; loop < MAXTAGLOOP; loop++)
+    {
+        const TValue* index = mt ? fasttm(L, mt, TM_INDEX) : NULL;
+
+        if (index && !ttistable(index))
+            return NULL;
+
+        if (mt)
+            mt->readonly |= WATCHEDFLAG;
+
+        if (!index)
+        {
+            *e = {start, key, NULL, 0, g->indexchains.gen};
+            return luaO_nilobject;
+        }
+
+        LuaTable* h = hvalue(index);
+        h->readonly |= WATCHEDFLAG;
+
+        const TValue* res = luaH_getstr(h, key);
+
+        if (!ttisnil(res))
+        {
+            *e = {start, key, h, gval2slot(h, res), g->indexchains.gen};
+            return res;
+        }
+
+        mt = h->metatable;
+    }
+
+    return NULL; // luaV_gettable reports the loop
+}
+
 void luaV_gettable(lua_State* L, const TValue* t, TValue* key, StkId val)
 {
     int loop;
@@ -173,21 +237,31 @@ void luaV_gettable(lua_State* L, const TValue* t, TValue* key, StkId val)
         if (ttistable(t))
         { // `t' is a table?
             LuaTable* h = hvalue(t);
-			lualock_table(h);
+			lualock_tableread(h);
 
-            const TValue* res = luaH_get(h, key); // do a primitive get
+            TValue copy;
+            const TValue* res = luaH_getcopy(h, key, &copy); // do a primitive get
 
-            if (res != luaO_nilobject)
+            if (res != luaO_nilobject && res != &copy)
                 L->cachedslot = gval2slot(h, res); // remember slot to accelerate future lookups
 
             if (!ttisnil(res) // result is no nil?
                 || (tm = fasttm(L, h->metatable, TM_INDEX)) == NULL)
             { // or no TM?
                 setobj2s(L, val, res);
-                luaunlock_table(h);
+                luaunlock_tableread(h);
                 return;
             }
-            luaunlock_table(h);
+            luaunlock_tableread(h);
+
+            if (ttisstring(key) && ttistable(tm))
+            {
+                if (const TValue* cres = luaV_getindexchain(L, h->metatable, tsvalue(key)))
+                {
+                    setobj2s(L, val, cres);
+                    return;
+                }
+            }
             // t isn't a table, so see if it has an INDEX meta-method to look up the key with
         }
         else if (ttisbuffer(t) && ttisnumber(key)) {
@@ -222,16 +296,38 @@ void luaV_settable(lua_State* L, const TValue* t, TValue* key, StkId val)
             LuaTable* h = hvalue(t);
 			lualock_table(h);
 
-            const TValue* oldval = luaH_get(h, key);
+            TValue copy;
+            const TValue* oldval = luaH_getcopy(h, key, &copy);
 
             // should we assign the key? (if key is valid or __newindex is not set)
             if (!ttisnil(oldval) || (tm = fasttm(L, h->metatable, TM_NEWINDEX)) == NULL)
             {
                 if (h->readonly) {
-                    luaunlock_table(h);
-                    luaG_readonlyerror(L);
+                    if (isreadonly(h)) {
+                        luaunlock_table(h);
+                        luaG_readonlyerror(L);
+                    }
+
+                    // h is part of a cached __index chain; replacing a value only changes the chain if it's __index of a metatable
+                    if (ttisnil(oldval) || (ttisstring(key) && tsvalue(key) == L->global->tmname[TM_INDEX]))
+                        L->global->indexchains.gen++;
+                }
+
+                if (luaH_ispackedstore(h, key, val))
+                {
+                    if (luaH_setpacked(L, h, key, val))
+                    {
+                        luaunlock_table(h);
+                        return;
+                    }
+
+                    // the table may have been unpacked
+                    oldval = luaH_get(h, key);
                 }
 
+                // number keys of packed tables go through luaH_setpacked, so oldval is a slot of the table here
+                LUAU_ASSERT(oldval != &copy);
+
                 // luaH_set would work but would repeat the lookup so we use luaH_setslot that can reuse oldval if it's safe
                 TValue* newval = luaH_setslot(L, h, oldval, key);
 
@@ -277,6 +373,142 @@ void luaV_settable(lua_State* L, const TValue* t, TValue* key, StkId val)
     luaG_runerror(L, "'__newindex' chain too long; possible loop");
 }
 
+// proves that a string key isn't in the table using its main position, without following the chain
+static bool absentstr(LuaTable* h, TString* key)
+{
+    if (isshaped(h))
+    {
+        int slot = luaH_shapefind(gshaped(h)->shape, key);
+        return slot < 0 || ttisnil(&gshaped(h)->slots[slot]);
+    }
+
+    LuaNode* n = &h->node[key->hash & (sizenode(h) - 1)];
+
+    if (ttisstring(gkey(n)) && tsvalue(gkey(n)) == key)
+        return ttisnil(gval(n));
+
+    return gnext(n) == 0;
+}
+
+static void addcacheentry(LuaInlineCache* ic, LuaTable* mt, LuaTable* h, int mtslot, int slot)
+{
+    for (int i = 0; i < LUA_INLINECACHESIZE; i++)
+    {
+        LuaCacheEntry* e = &ic->entries[i];
+
+        if (e->slot < 0 || (e->mt == mt && e->h == h && e->mtslot == mtslot && e->slot == slot))
+        {
+            *e = {mt, h, mtslot, slot};
+            return;
+        }
+    }
+
+    ic->entries[ic->next] = {mt, h, mtslot, slot};
+    ic->next = (ic->next + 1) % LUA_INLINECACHESIZE;
+}
+
+static const TValue* probeslots(LuaInlineCache* ic, LuaTable* h, TString* key)
+{
+    for (int i = 0; i < LUA_INLINECACHESIZE && ic->entries[i].slot >= 0; i++)
+    {
+        LuaCacheEntry* e = &ic->entries[i];
+
+        if (!e->mt)
+            if (const TValue* res = luaH_getslot(h, e->slot, key))
+                return res;
+    }
+
+    return NULL;
+}
+
+// entries for lookups through __index are valid as long as __index of the metatable still refers to the same table
+static const TValue* probeindex(lua_State* L, LuaInlineCache* ic, LuaTable* mt, TString* key)
+{
+    TString* indexname = L->global->tmname[TM_INDEX];
+
+    for (int i = 0; i < LUA_INLINECACHESIZE && ic->entries[i].slot >= 0; i++)
+    {
+        LuaCacheEntry* e = &ic->entries[i];
+
+        if (e->mt == mt)
+        {
+            const TValue* index = luaH_getslot(mt, e->mtslot, indexname);
+
+            if (index && ttistable(index) && hvalue(index) == e->h)
+                if (const TValue* res = luaH_getslot(e->h, e->slot, key))
+                    return res;
+        }
+    }
+
+    return NULL;
+}
+
+const TValue* luaV_getcached(lua_State* L, LuaInlineCache* ic, LuaTable* h, LuaTable* mt, TString* key, int slot)
+{
+    // the slot hint of the instruction is kept on cache hits
+    L->cachedslot = slot;
+
+    if (h)
+        mt = h->metatable;
+
+    if (ic)
+    {
+        if (h)
+            if (const TValue* res = probeslots(ic, h, key))
+                return res;
+
+        if (mt && (!h || absentstr(h, key)))
+            if (const TValue* res = probeindex(L, ic, mt, key))
+                return res;
+    }
+
+    // cache miss: lookups that go further than the __index table of the metatable are left to luaV_getindexchain
+    const TValue* res = luaO_nilobject;
+
+    if (h)
+    {
+        res = luaH_getstr(h, key);
+
+        if (!ttisnil(res))
+        {
+            L->cachedslot = gval2slot(h, res);
+            if (ic)
+                addcacheentry(ic, NULL, NULL, 0, L->cachedslot);
+            return res;
+        }
+    }
+
+    const TValue* index = fasttm(L, mt, TM_INDEX);
+
+    if (!index)
+        return h ? res : NULL;
+
+    if (!ttistable(index))
+        return NULL;
+
+    LuaTable* ih = hvalue(index);
+    const TValue* ires = luaH_getstr(ih, key);
+
+    if (ttisnil(ires))
+        return ih->metatable ? luaV_getindexchain(L, ih->metatable, key) : ires;
+
+    L->cachedslot = gval2slot(ih, ires);
+    if (ic)
+        addcacheentry(ic, mt, ih, gval2slot(mt, index), L->cachedslot);
+    return ires;
+}
+
+TValue* luaV_setcached(LuaInlineCache* ic, LuaTable* h, TString* key)
+{
+    return ic ? const_cast<TValue*>(probeslots(ic, h, key)) : NULL;
+}
+
+void luaV_cacheslot(LuaInlineCache* ic, LuaTable* h, const TValue* res)
+{
+    if (ic)
+        addcacheentry(ic, NULL, NULL, 0, gval2slot(h, res));
+}
+
 static int call_binTM(lua_State* L, const TValue* p1, const TValue* p2, StkId res, TMS event)
 {
     const TValue* tm = luaT_gettmbyobj(L, p1, event); // try first operand
@@ -0,0 +1,27 @@
+local function prequire(name) local success, result = pcall(require, name); return success and result end
+local bench = script and require(script.Parent.bench_support) or prequire("bench_support") or require("../bench_support")
+
+function test()
+
+    -- all objects have the same keys, so the field is in the same slot for every object
+    local objects = {
+        {x = 1, y = 2, value = 1},
+        {x = 1, y = 2, value = 2},
+        {x = 1, y = 2, value = 3},
+        {x = 1, y = 2, value = 4},
+    }
+
+    local sum = 0
+
+    local ts0 = os.clock()
+    for i=1,1000000 do
+        local o = objects[i % 4 + 1]
+        sum += o.value
+        o.value = i
+    end
+    local ts1 = os.clock()
+
+    return ts1-ts0
+end
+
+bench.runCode(test, "FieldAccess: monomorphic")
@@ -0,0 +1,36 @@
+local function prequire(name) local success, result = pcall(require, name); return success and result end
+local bench = script and require(script.Parent.bench_support) or prequire("bench_support") or require("../bench_support")
+
+function test()
+
+    -- four classes with their methods in different slots, called from the same instruction
+    local function class(...)
+        local c = {}
+        for _, name in {...} do
+            c[name] = function(self) return 0 end
+        end
+        c.__index = c
+        function c:Get() return self.value end
+        return c
+    end
+
+    local objects = {
+        setmetatable({value = 1}, class()),
+        setmetatable({value = 2}, class("a")),
+        setmetatable({value = 3}, class("a", "b", "c")),
+        setmetatable({value = 4}, class("a", "b", "c", "d", "e")),
+    }
+
+    local sum = 0
+
+    local ts0 = os.clock()
+    for i=1,1000000 do
+        local o = objects[i % 4 + 1]
+        sum += o:Get()
+    end
+    local ts1 = os.clock()
+
+    return ts1-ts0
+end
+
+bench.runCode(test, "FieldAccess: polymorphic method")
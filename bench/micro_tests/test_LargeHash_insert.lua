@@ -0,0 +1,24 @@
+local function prequire(name) local success, result = pcall(require, name); return success and result end
+local bench = script and require(script.Parent.bench_support) or prequire("bench_support") or require("../bench_support")
+
+function test()
+
+    local keys = {}
+    for i=1,100000 do
+        keys[i] = "key" .. i
+    end
+
+    local ts0 = os.clock()
+    for j=1,10 do
+        local t = {}
+        for i=1,100000 do
+            t[keys[i]] = i
+            t[i * 1.5] = i
+        end
+    end
+    local ts1 = os.clock()
+
+    return ts1-ts0
+end
+
+bench.runCode(test, "LargeHash: insert")
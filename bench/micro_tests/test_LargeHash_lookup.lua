@@ -0,0 +1,28 @@
+local function prequire(name) local success, result = pcall(require, name); return success and result end
+local bench = script and require(script.Parent.bench_support) or prequire("bench_support") or require("../bench_support")
+
+function test()
+
+    local keys = {}
+    local t = {}
+    for i=1,100000 do
+        keys[i] = "key" .. i
+        t[keys[i]] = i
+        t[i * 1.5] = i
+    end
+
+    local ts0 = os.clock()
+    local sum = 0
+    for j=1,10 do
+        for i=1,100000 do
+            sum += t[keys[i]] + t[i * 1.5]
+        end
+    end
+    local ts1 = os.clock()
+
+    assert(sum == 10 * 100000 * 100001)
+
+    return ts1-ts0
+end
+
+bench.runCode(test, "LargeHash: lookup")
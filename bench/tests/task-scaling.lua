@@ -0,0 +1,42 @@
+local function prequire(name) local success, result = pcall(require, name); return success and result end
+local bench = script and require(script.Parent.bench_support) or prequire("bench_support") or require("../bench_support")
+
+-- N independent compute tasks on the task pool; with near-linear scaling the time stays flat up to the number of workers
+
+local function work(n)
+  local sum = 0
+  for i = 1, n do
+    sum += math.sqrt(i) * math.sin(i)
+  end
+  return sum
+end
+
+local function run(count)
+  local tasks = table.create(count)
+
+  local ts0 = os.clock()
+
+  for i = 1, count do
+    tasks[i] = task.spawn(work, 1000000)
+  end
+
+  for i = 1, count do
+    task.join(tasks[i])
+  end
+
+  local ts1 = os.clock()
+
+  return ts1 - ts0
+end
+
+local workers = task.workers()
+local count = 1
+
+while count <= workers do
+  bench.runCode(function() return run(count) end, "task-scaling: " .. count .. " tasks")
+  count *= 2
+end
+
+if count / 2 ~= workers then
+  bench.runCode(function() return run(workers) end, "task-scaling: " .. workers .. " tasks")
+end
@@ -0,0 +1,46 @@
+local function prequire(name) local success, result = pcall(require, name); return success and result end
+local bench = script and require(script.Parent.bench_support) or prequire("bench_support") or require("../bench_support")
+
+-- N tasks allocating tables and strings at a high rate; with per-thread allocation caches the time stays flat up to the number of workers
+
+local function work(n, id)
+  local keep = table.create(64)
+  local sum = 0
+  for i = 1, n do
+    local t = {i, i + 1, x = i}
+    local s = `k{i % 1000}_{id}`
+    keep[i % 64 + 1] = t
+    sum += #s + t[1]
+  end
+  return sum
+end
+
+local function run(count)
+  local tasks = table.create(count)
+
+  local ts0 = os.clock()
+
+  for i = 1, count do
+    tasks[i] = task.spawn(work, 200000, i)
+  end
+
+  for i = 1, count do
+    task.join(tasks[i])
+  end
+
+  local ts1 = os.clock()
+
+  return ts1 - ts0
+end
+
+local workers = task.workers()
+local count = 1
+
+while count <= workers do
+  bench.runCode(function() return run(count) end, "threaded-allocation: " .. count .. " tasks")
+  count *= 2
+end
+
+if count / 2 ~= workers then
+  bench.runCode(function() return run(workers) end, "threaded-allocation: " .. workers .. " tasks")
+end
@@ -18,7 +18,7 @@ LOCAL_C_INCLUDES += $(addprefix $(LOCAL_PATH)/../,VM/src VM/include Common/Inclu
 
 LOCAL_SRC_FILES += $(addsuffix .cpp, \
         $(addprefix ../VM/src/,lapi laux lbaselib lbitlib lbuffer lbuflib lbuiltins lcorolib ldblib ldebug ldo lfunc lgc lgcdebug linit lint64lib liolib lmathlib lmem lnumprint lobject loslib lperf lstate lstring lstrlib \
-         ltable ltablib ltm ludata lutf8lib lveclib lvmexecute lvmload lvmutils) \
+         ltable ltablib ltasklib ltm ludata lutf8lib lveclib lvmexecute lvmload lvmutils) \
         $(addprefix ../Compiler/src/,Builtins BuiltinFolding BytecodeBuilder ConstantFolding Compiler CostModel lcode PseudoCode TableShape Types ValueTracking) \
         $(addprefix ../Common/src/,StringUtils TimeTrace) \
         $(addprefix ../Ast/src/,Allocator Ast Confusables Cst Lexer Location Parser PrettyPrinter))
@@ -6,6 +6,7 @@
 
 #include "Luau/BuiltinDefinitions.h"
 #include "Luau/DenseHash.h"
+#include "Luau/HeapSnapshot.h"
 #include "Luau/ModuleResolver.h"
 #include "Luau/TypeInfer.h"
 #include "Luau/BytecodeBuilder.h"
@@ -18,10 +19,13 @@
 #include "ScopedFlags.h"
 #include "ConformanceIrHooks.h"
 
+#include <chrono>
 #include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <math.h>
+#include <string.h>
 
 extern bool verbose;
 extern bool codegen;
@@ -65,9 +69,24 @@ static Luau::CodeGen::CompilationOptions defaultCodegenOptions()
 
 static int lua_collectgarbage(lua_State* L)
 {
-    static const char* const opts[] = {"stop", "restart", "collect", "count", "isrunning", "step", "setgoal", "setstepmul", "setstepsize", nullptr};
+    static const char* const opts[] = {
+        "stop", "restart", "collect", "count", "isrunning", "step", "setgoal", "setstepmul", "setstepsize", "generational", "incremental", "sweepthread",
+        "compact", nullptr
+    };
     static const int optsnum[] = {
-        LUA_GCSTOP, LUA_GCRESTART, LUA_GCCOLLECT, LUA_GCCOUNT, LUA_GCISRUNNING, LUA_GCSTEP, LUA_GCSETGOAL, LUA_GCSETSTEPMUL, LUA_GCSETSTEPSIZE
+        LUA_GCSTOP,
+        LUA_GCRESTART,
+        LUA_GCCOLLECT,
+        LUA_GCCOUNT,
+        LUA_GCISRUNNING,
+        LUA_GCSTEP,
+        LUA_GCSETGOAL,
+        LUA_GCSETSTEPMUL,
+        LUA_GCSETSTEPSIZE,
+        LUA_GCGEN,
+        LUA_GCINC,
+        LUA_GCSWEEPTHREAD,
+        LUA_GCCOMPACT
     };
 
     int o = luaL_checkoption(L, 1, "collect", opts);
@@ -77,6 +96,7 @@ static int lua_collectgarbage(lua_State* L)
     {
     case LUA_GCSTEP:
     case LUA_GCISRUNNING:
+    case LUA_GCSWEEPTHREAD:
     {
         lua_pushboolean(L, res);
         return 1;
@@ -989,6 +1009,472 @@ TEST_CASE("GC")
     );
 }
 
+TEST_CASE("GCGenerational")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    CHECK(lua_gc(L, LUA_GCGEN, 0) == LUA_GCINC);
+    CHECK(lua_gc(L, LUA_GCGEN, 0) == LUA_GCGEN);
+    CHECK(lua_gc(L, LUA_GCSETGENMINORMUL, 5) == 20);
+    CHECK(lua_gc(L, LUA_GCSETGENMAJORMUL, 50) == 100);
+
+    // the table becomes old after the first collection, new entries are only reachable through it
+    lua_createtable(L, 1000, 0);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_createtable(L, 0, 0);
+        lua_pushinteger(L, i);
+        lua_rawseti(L, -2, 1);
+        lua_rawseti(L, -2, i);
+
+        for (int j = 0; j < 100; ++j)
+        {
+            lua_createtable(L, 4, 0);
+            lua_pop(L, 1);
+        }
+    }
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_rawgeti(L, -1, i);
+        lua_rawgeti(L, -1, 1);
+        CHECK(lua_tointeger(L, -1) == i);
+        lua_pop(L, 2);
+    }
+
+    CHECK(lua_gc(L, LUA_GCINC, 0) == LUA_GCGEN);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    lua_pop(L, 1);
+}
+
+TEST_CASE("GCSweepThread")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    CHECK(lua_gc(L, LUA_GCSWEEPTHREAD, 1) == 0);
+    CHECK(lua_gc(L, LUA_GCSWEEPTHREAD, 1) == 1);
+
+    static int destroyed = 0;
+    destroyed = 0;
+
+    lua_createtable(L, 1000, 0);
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_pushfstring(L, "value %d", i);
+        lua_rawseti(L, -2, i);
+
+        for (int j = 0; j < 100; ++j)
+        {
+            lua_newuserdatadtor(L, 16, [](void*) { destroyed++; });
+            lua_pushfstring(L, "garbage %d", j);
+            lua_createtable(L, 4, 0);
+            lua_pop(L, 3);
+        }
+    }
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_rawgeti(L, -1, i);
+        CHECK(strcmp(lua_tostring(L, -1), std::string("value " + std::to_string(i)).c_str()) == 0);
+        lua_pop(L, 1);
+    }
+
+    CHECK(lua_gc(L, LUA_GCSWEEPTHREAD, 0) == 1);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    CHECK(destroyed == 100000);
+    lua_pop(L, 1);
+}
+
+TEST_CASE("GCStepTime")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    lua_createtable(L, 1000, 0);
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_createtable(L, 4, 0);
+        lua_rawseti(L, -2, i);
+    }
+
+    lua_gc(L, LUA_GCSTOP, 0);
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        lua_createtable(L, 4, 0);
+        lua_pop(L, 1);
+    }
+
+    int before = lua_gc(L, LUA_GCCOUNT, 0);
+
+    // budgeted steps make progress until the cycle finishes
+    int calls = 0;
+    while (lua_gc(L, LUA_GCSTEPTIME, 200) == 0 && calls < 100000)
+        calls++;
+
+    CHECK(calls < 100000);
+    CHECK(lua_gc(L, LUA_GCCOUNT, 0) < before);
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_rawgeti(L, -1, i);
+        CHECK(lua_istable(L, -1));
+        lua_pop(L, 1);
+    }
+
+    lua_pop(L, 1);
+}
+
+TEST_CASE("GCCompact")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    lua_createtable(L, 1000, 0);
+
+    // keep every 16th table so that most pages end up sparse
+    for (int i = 1; i <= 16000; ++i)
+    {
+        lua_createtable(L, 1, 0);
+        lua_pushinteger(L, i);
+        lua_rawseti(L, -2, 1);
+
+        if (i % 16 == 0)
+            lua_rawseti(L, -2, i / 16);
+        else
+            lua_pop(L, 1);
+    }
+
+    CHECK(lua_gc(L, LUA_GCCOMPACT, 0) > 0);
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_rawgeti(L, -1, i);
+        REQUIRE(lua_istable(L, -1));
+        lua_rawgeti(L, -1, 1);
+        CHECK(lua_tointeger(L, -1) == i * 16);
+        lua_pop(L, 2);
+    }
+
+    lua_pop(L, 1);
+}
+
+TEST_CASE("GCLargePool")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    CHECK(lua_gc(L, LUA_GCLARGEPOOLCOUNT, 0) == 0);
+
+    int misses = lua_gc(L, LUA_GCLARGEPOOLMISSES, 0);
+
+    // freed buffers go to the pool and the next buffer of the same size reuses the page
+    for (int i = 0; i < 100; ++i)
+    {
+        lua_newbuffer(L, 16 * 1024);
+        lua_pop(L, 1);
+        lua_gc(L, LUA_GCSTEP, 64);
+    }
+
+    CHECK(lua_gc(L, LUA_GCLARGEPOOLHITS, 0) > 0);
+    CHECK(lua_gc(L, LUA_GCLARGEPOOLMISSES, 0) - misses < 100);
+
+    // lowering the limit releases pooled pages right away
+    CHECK(lua_gc(L, LUA_GCSETLARGEPOOL, 0) == 1024);
+    CHECK(lua_gc(L, LUA_GCLARGEPOOLCOUNT, 0) == 0);
+}
+
+TEST_CASE("GCTypeStats")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    lua_GCTypeStats stats = {};
+    CHECK(lua_gettypestats(L, 0, LUA_TTABLE, &stats) == 0);
+
+    // objects allocated before the counters are enabled are counted as well
+    CHECK(lua_gc(L, LUA_GCTYPESTATS, 1) == 0);
+    REQUIRE(lua_gettypestats(L, 0, LUA_TTABLE, &stats) == 1);
+    CHECK(stats.count > 0);
+
+    lua_setmemcat(L, 3);
+    lua_createtable(L, 100, 0);
+    for (int i = 1; i <= 100; ++i)
+    {
+        lua_newtable(L);
+        lua_rawseti(L, -2, i);
+    }
+    lua_setmemcat(L, 0);
+
+    lua_GCTypeStats data = {};
+    lua_gettypestats(L, 3, LUA_TTABLE, &stats);
+    lua_gettypestats(L, 3, LUA_TNIL, &data);
+
+    CHECK(stats.count == 101);
+    CHECK(stats.bytes == stats.allocated);
+    CHECK(data.bytes > 0);
+    CHECK(stats.bytes + data.bytes == lua_totalbytes(L, 3));
+
+    lua_pop(L, 1);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    lua_gettypestats(L, 3, LUA_TTABLE, &stats);
+    CHECK(stats.count == 0);
+    CHECK(stats.freed == stats.allocated);
+    CHECK(stats.cyclefreed > 0);
+
+    CHECK(lua_gc(L, LUA_GCTYPESTATS, 0) == 1);
+    CHECK(lua_gettypestats(L, 3, LUA_TTABLE, &stats) == 0);
+}
+
+TEST_CASE("GCHeapQuery")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    auto countKeys = [](lua_State* L) {
+        int count = 0;
+        for (lua_pushnil(L); lua_next(L, -2); lua_pop(L, 1))
+            count++;
+        return count;
+    };
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        lua_newtable(L);
+        lua_rawseti(L, LUA_REGISTRYINDEX, 1000 + i);
+    }
+
+    lua_newtable(L);
+    lua_setglobal(L, "target");
+
+    lua_newtable(L);
+    lua_getglobal(L, "target");
+    lua_setfield(L, -2, "field");
+    lua_setglobal(L, "holder");
+
+    // the search advances a few pages at a time, while the program keeps running
+    lua_getglobal(L, "target");
+    lua_HeapQuery* search = lua_newrefsearch(L);
+    CHECK(lua_gettop(L) == 0);
+
+    int steps = 0;
+    while (!lua_heapquerystep(L, search, 4))
+    {
+        lua_newtable(L);
+        lua_pop(L, 1);
+        steps++;
+    }
+    CHECK(steps > 1);
+
+    // globals and holder
+    lua_refsearchresult(L, search);
+    CHECK(countKeys(L) == 2);
+    lua_pop(L, 1);
+    lua_freeheapquery(L, search);
+
+    lua_getglobal(L, "target");
+    lua_findreferences(L);
+    CHECK(countKeys(L) == 2);
+    lua_pop(L, 1);
+
+    // the tables returned above refer to holder until they are collected
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    // the index answers for any object, and forgets objects that are collected
+    lua_HeapQuery* index = lua_newrefindex(L);
+    while (!lua_heapquerystep(L, index, 0))
+    {
+    }
+
+    lua_getglobal(L, "holder");
+    REQUIRE(lua_refindexlookup(L, index) == 1);
+    CHECK(countKeys(L) == 1);
+    lua_pop(L, 1);
+
+    lua_newtable(L);
+    CHECK(lua_refindexlookup(L, index) == 0);
+    CHECK(lua_isnil(L, -1));
+    lua_pop(L, 1);
+
+    lua_pushnil(L);
+    lua_setglobal(L, "holder");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    lua_getglobal(L, "target");
+    REQUIRE(lua_refindexlookup(L, index) == 1);
+    CHECK(countKeys(L) == 1);
+    lua_pop(L, 1);
+
+    lua_freeheapquery(L, index);
+}
+
+TEST_CASE("GCHeapSnapshot")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    struct Output
+    {
+        std::string data;
+        int writes = 0;
+    };
+
+    auto snapshot = [](lua_State* L) {
+        Output output;
+        lua_heapsnapshot(
+            L,
+            &output,
+            [](void* context, const void* data, size_t size)
+            {
+                Output* output = static_cast<Output*>(context);
+                output->data.append(static_cast<const char*>(data), size);
+                output->writes++;
+            },
+            [](lua_State* L, uint8_t memcat)
+            {
+                return memcat == 0 ? "main" : "other";
+            }
+        );
+        return output;
+    };
+
+    Output small = snapshot(L);
+
+    REQUIRE(small.data.size() > 5);
+    CHECK(small.data.compare(0, 4, LHS_MAGIC) == 0);
+    CHECK(small.data[4] == LHS_VERSION);
+
+    lua_createtable(L, 10000, 0);
+    for (int i = 1; i <= 10000; ++i)
+    {
+        lua_newtable(L);
+        lua_rawseti(L, -2, i);
+    }
+
+    // the snapshot is streamed in chunks, and grows with the heap
+    Output large = snapshot(L);
+
+    CHECK(large.writes > 1);
+    CHECK(large.data.size() > small.data.size() + 10000 * 2);
+
+    lua_pop(L, 1);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    CHECK(snapshot(L).data.size() < large.data.size());
+}
+
+TEST_CASE("GCRegion")
+{
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    // scratch tables that don't escape are released with the region
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        REQUIRE(lua_pushregion(L) == 1);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            lua_createtable(L, 4, 0);
+            lua_pushinteger(L, i);
+            lua_rawseti(L, -2, 1);
+            lua_pushinteger(L, i);
+            lua_setfield(L, -2, "x");
+            lua_pop(L, 1);
+
+            if (i % 100 == 0)
+                lua_gc(L, LUA_GCSTEP, 1);
+        }
+
+        CHECK(lua_totalbytes(L, LUA_REGIONMEMCAT) > 0);
+        CHECK(lua_popregion(L) == 1);
+        CHECK(lua_totalbytes(L, LUA_REGIONMEMCAT) == 0);
+    }
+
+    // tables stored into a table created before the region escape and are left to the collector
+    lua_newtable(L);
+    REQUIRE(lua_pushregion(L) == 1);
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        lua_createtable(L, 1, 0);
+        lua_pushinteger(L, i);
+        lua_rawseti(L, -2, 1);
+
+        if (i % 10 == 0)
+            lua_rawseti(L, -2, i / 10);
+        else
+            lua_pop(L, 1);
+    }
+
+    CHECK(lua_popregion(L) == 0);
+    CHECK(lua_totalbytes(L, LUA_REGIONMEMCAT) == 0);
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    for (int i = 1; i <= 100; ++i)
+    {
+        lua_rawgeti(L, -1, i);
+        REQUIRE(lua_istable(L, -1));
+        lua_rawgeti(L, -1, 1);
+        CHECK(lua_tointeger(L, -1) == i * 10);
+        lua_pop(L, 2);
+    }
+
+    lua_pop(L, 1);
+
+    // a table left on the stack escapes as well, and nested regions are joined with the outermost one
+    REQUIRE(lua_pushregion(L) == 1);
+    lua_newtable(L);
+    REQUIRE(lua_pushregion(L) == 1);
+    CHECK(lua_popregion(L) == 0);
+    CHECK(lua_popregion(L) == 0);
+    CHECK(lua_istable(L, -1));
+    lua_pop(L, 1);
+}
+
+TEST_CASE("TableShapes")
+{
+    StateRef globalState = runConformance(
+        "tableshapes.luau",
+        [](lua_State* L)
+        {
+            CHECK(lua_settableshapes(L, 1) == 0);
+        }
+    );
+
+    CHECK(lua_settableshapes(globalState.get(), 0) == 1);
+}
+
+TEST_CASE("InlineCaches")
+{
+    runConformance("inlinecaches.luau", setupNativeHelpers);
+}
+
+TEST_CASE("IndexChains")
+{
+    runConformance("indexchains.luau");
+}
+
+TEST_CASE("ProbedTables")
+{
+    runConformance("probedtables.luau");
+}
+
+TEST_CASE("PackedArrays")
+{
+    // native code reads and writes packed elements directly; runConformance compiles cold functions as well
+    runConformance("packedarrays.luau");
+}
+
 TEST_CASE("Bitwise")
 {
     runConformance("bitwise.luau");
@@ -1004,6 +1490,11 @@ TEST_CASE("Coroutine")
     runConformance("coroutine.luau");
 }
 
+TEST_CASE("Tasks")
+{
+    runConformance("tasks.luau");
+}
+
 static int cxxthrow(lua_State* L)
 {
 #if LUA_USE_LONGJMP
@@ -1882,6 +2373,27 @@ TEST_CASE("Reference")
 
     lua_gc(L, LUA_GCCOLLECT, 0);
     CHECK(dtorhits == 2);
+
+    // integer keys stored in the registry directly are never handed out as references
+    lua_pushstring(L, "host");
+    lua_rawseti(L, LUA_REGISTRYINDEX, 2);
+    lua_pushstring(L, "host");
+    lua_rawseti(L, LUA_REGISTRYINDEX, 4);
+
+    for (int i = 0; i < 4; i++)
+    {
+        lua_pushboolean(L, true);
+        int r = lua_ref(L, -1);
+        lua_pop(L, 1);
+        CHECK(r != 2);
+        CHECK(r != 4);
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, 2);
+    CHECK(strcmp(lua_tostring(L, -1), "host") == 0);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, 4);
+    CHECK(strcmp(lua_tostring(L, -1), "host") == 0);
+    lua_pop(L, 2);
 }
 
 TEST_CASE("NewUserdataOverflow")
@@ -2521,10 +3033,530 @@ TEST_CASE("ApiAlloc")
     CHECK(udCheck == &ud);
 }
 
-#if !LUA_USE_LONGJMP
-TEST_CASE("ExceptionObject")
+// runs the function returned by the chunk on each native thread with its own Luau thread, passing (iterations, thread index)
+// optional check callback is called for each thread with the function result on the thread stack, native compiles the chunk
+// with codegen if the state has it
+// returns the wall clock time it took for all threads to finish
+static double runThreadedChunk(
+    lua_State* L,
+    const char* source,
+    int threadCount,
+    int iterations,
+    void (*check)(lua_State* L, lua_State* T, int index) = nullptr,
+    bool native = false
+)
 {
-    struct ExceptionResult
+    // loading a single chunk leaves a table with the main function on the stack
+    REQUIRE(luaL_loadbuffer(L, source, strlen(source), "=threaded") == -1);
+    lua_rawgeti(L, -1, 1);
+    lua_remove(L, -2);
+
+    if (native)
+        luau_codegen_compile(L, -1);
+
+    lua_call(L, 0, 1);
+
+    int func = lua_gettop(L);
+    std::vector<lua_State*> threads;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        lua_State* T = lua_newthread(L);
+        lua_pushvalue(L, func);
+        lua_xmove(L, T, 1);
+        lua_pushinteger(T, iterations);
+        lua_pushinteger(T, i);
+
+        threads.push_back(T);
+    }
+
+    // worker threads can't run collection steps, start from a clean heap
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    std::vector<int> status(threadCount);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < threadCount; i++)
+        workers.emplace_back(
+            [&, i]()
+            {
+                // a finished worker detaches, GC steps of the others must not wait for it
+                luaL_ThreadAttach attach(threads[i]);
+                status[i] = lua_pcall(threads[i], 2, 1, 0);
+            }
+        );
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        std::string error = status[i] == LUA_OK ? "" : lua_tostring(threads[i], -1);
+        INFO(error);
+        CHECK(status[i] == LUA_OK);
+
+        if (check && status[i] == LUA_OK)
+            check(L, threads[i], i);
+    }
+
+    lua_pop(L, threadCount + 1);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    return duration;
+}
+
+TEST_CASE("ThreadedAllocation")
+{
+    // every worker allocates tables and strings through its allocation cache while the others do the same; throughput is
+    // measured by bench/tests/threaded-allocation.lua
+    const char* source = R"(
+return function(n, id)
+    local keep = table.create(64)
+    local sum = 0
+    for i = 1, n do
+        local t = {i, i + 1, x = i}
+        local s = `k{i % 1000}_{id}`
+        keep[i % 64 + 1] = t
+        sum += #s + t[1]
+    end
+    for _, t in keep do
+        assert(t[2] == t[1] + 1 and t.x == t[1])
+    end
+    return sum
+end
+)";
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    luaL_openlibs(L);
+
+    runThreadedChunk(
+        L,
+        source,
+        4,
+        100000,
+        [](lua_State* L, lua_State* T, int index)
+        {
+            double expected = 0;
+            for (int i = 1; i <= 100000; i++)
+                expected += double(std::to_string(i % 1000).size() + std::to_string(index).size() + 2 + i);
+
+            CHECK(lua_tonumber(T, -1) == expected);
+        }
+    );
+
+    luaC_validate(L);
+}
+
+TEST_CASE("ThreadedStringInterning")
+{
+    // all threads intern the same strings, growing the string table shards concurrently
+    const char* source = R"(
+return function(n, id)
+    local strings = table.create(n)
+    for i = 1, n do
+        strings[i] = `str{i}`
+    end
+    return strings
+end
+)";
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    luaL_openlibs(L);
+
+    runThreadedChunk(
+        L,
+        source,
+        8,
+        20000,
+        [](lua_State* L, lua_State* T, int index)
+        {
+            // interned strings are unique, so every thread has to get the same string object
+            for (int i = 1; i <= 20000; i += 97)
+            {
+                lua_rawgeti(T, -1, i);
+                lua_xmove(T, L, 1);
+                lua_pushfstring(L, "str%d", i);
+                CHECK(lua_rawequal(L, -1, -2));
+                lua_pop(L, 2);
+            }
+        }
+    );
+
+    luaC_validate(L);
+}
+
+TEST_CASE("ThreadedSharedTableReaders")
+{
+    // all threads read a shared table while the first one keeps inserting and overwriting keys in it
+    const char* source = R"(
+local shared = {x = 1, y = 2}
+table.share(shared)
+
+return function(n, id)
+    local sum = 0
+    for i = 1, n do
+        if id == 0 then
+            shared[`k{i % 500}`] = i
+        end
+        sum += shared.x + rawget(shared, "y")
+    end
+    return sum
+end
+)";
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    luaL_openlibs(L);
+
+    lua_resetlockstats(L);
+
+    lua_LockStats stats = {};
+    lua_getlockstats(L, &stats);
+    CHECK(stats.exclusivecontended == 0);
+    CHECK(stats.sharedcontended == 0);
+    CHECK(stats.parks == 0);
+
+    double duration = runThreadedChunk(
+        L,
+        source,
+        8,
+        100000,
+        [](lua_State* L, lua_State* T, int index)
+        {
+            CHECK(lua_tonumber(T, -1) == 300000);
+        }
+    );
+
+    lua_getlockstats(L, &stats);
+
+    if (verbose)
+        printf(
+            "ThreadedSharedTableReaders: %.3f ms, contended %llu exclusive %llu shared, %llu spins, %llu parks\n",
+            duration * 1000,
+            (unsigned long long)stats.exclusivecontended,
+            (unsigned long long)stats.sharedcontended,
+            (unsigned long long)stats.spins,
+            (unsigned long long)stats.parks
+        );
+
+    luaC_validate(L);
+}
+
+TEST_CASE("ThreadedCollection")
+{
+    // workers keep producing garbage without ever being suspended; GC steps have to stop them at safepoints
+    const char* source = R"(
+return function(n, id)
+    local keep = table.create(100)
+    local peak = 0
+    for i = 1, n do
+        keep[i % 100 + 1] = {i, tostring(i), {id}}
+        if i % 1000 == 0 then
+            peak = math.max(peak, collectgarbage("count"))
+        end
+    end
+    return peak
+end
+)";
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    luaL_openlibs(L);
+
+    double duration = runThreadedChunk(
+        L,
+        source,
+        4,
+        500000,
+        [](lua_State* L, lua_State* T, int index)
+        {
+            // 2M tables with their strings would need hundreds of megabytes without collection
+            CHECK(lua_tonumber(T, -1) < 64 * 1024);
+        }
+    );
+
+    if (verbose)
+        printf("ThreadedCollection: %.3f ms\n", duration * 1000);
+
+    luaC_validate(L);
+}
+
+TEST_CASE("ThreadedNativeSafepoint")
+{
+    // a thread spinning in native code without calls or allocations has to park at its loop back-edge; otherwise every
+    // handshake of the collecting thread times out and its garbage piles up
+    const char* source = R"(
+local state = {done = false}
+return function(n, id)
+    if id == 0 then
+        local spins = 0
+        while not state.done do
+            spins += 1
+        end
+        return spins
+    end
+    local keep = table.create(100)
+    local peak = 0
+    for i = 1, n do
+        keep[i % 100 + 1] = {i, tostring(i)}
+        if i % 1000 == 0 then
+            peak = math.max(peak, collectgarbage("count"))
+        end
+    end
+    state.done = true
+    return peak
+end
+)";
+
+    if (!codegen || !luau_codegen_supported())
+        return;
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    luau_codegen_create(L);
+    luaL_openlibs(L);
+
+    runThreadedChunk(
+        L,
+        source,
+        2,
+        200000,
+        [](lua_State* L, lua_State* T, int index)
+        {
+            if (index == 1)
+                CHECK(lua_tonumber(T, -1) < 4 * 1024);
+        },
+        true
+    );
+
+    luaC_validate(L);
+}
+
+TEST_CASE("ThreadedIndependentStates")
+{
+    // two VMs collect concurrently; each one only stops its own threads, and a VM left without threads takes no locks
+    const char* source = R"(
+return function(n, id)
+    local keep = table.create(100)
+    for i = 1, n do
+        keep[i % 100 + 1] = {i, tostring(i)}
+    end
+    return collectgarbage("count")
+end
+)";
+
+    StateRef stateA(luaL_newstate(), lua_close);
+    StateRef stateB(luaL_newstate(), lua_close);
+
+    luaL_openlibs(stateA.get());
+    luaL_openlibs(stateB.get());
+
+    std::thread other(
+        [&]()
+        {
+            runThreadedChunk(stateA.get(), source, 2, 200000);
+        }
+    );
+
+    runThreadedChunk(
+        stateB.get(),
+        source,
+        2,
+        200000,
+        [](lua_State* L, lua_State* T, int index)
+        {
+            CHECK(lua_tonumber(T, -1) < 64 * 1024);
+        }
+    );
+
+    other.join();
+
+    luaC_validate(stateA.get());
+    luaC_validate(stateB.get());
+}
+
+TEST_CASE("ThreadedUpvalues")
+{
+    // closures capturing locals open upvalues on every iteration; abandoned coroutines leave theirs open for the GC to close
+    const char* source = R"(
+return function(n, id)
+    local sum = 0
+    for i = 1, n do
+        local v = i
+        local get = function() return v end
+        v += id
+        sum += get() - i
+
+        if i % 100 == 0 then
+            local co = coroutine.wrap(function()
+                local x = i
+                coroutine.yield(function() return x end)
+            end)
+            sum += co()() - i
+        end
+    end
+    return sum
+end
+)";
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    luaL_openlibs(L);
+
+    runThreadedChunk(
+        L,
+        source,
+        4,
+        100000,
+        [](lua_State* L, lua_State* T, int index)
+        {
+            CHECK(lua_tonumber(T, -1) == 100000 * index);
+        }
+    );
+
+    luaC_validate(L);
+
+    // with the collector stopped no upvalue is gray, so returns close upvalues without the global lock; the lock is only
+    // taken to refill the allocation cache of the worker, which is attached so that locks are enabled
+    const int iterations = 100000;
+
+    REQUIRE(luaL_loadbuffer(L, source, strlen(source), "=threaded") == -1);
+    lua_rawgeti(L, -1, 1);
+    lua_remove(L, -2);
+    lua_call(L, 0, 1);
+
+    lua_State* T = lua_newthread(L);
+    lua_pushvalue(L, -2);
+    lua_xmove(L, T, 1);
+    lua_pushinteger(T, iterations);
+    lua_pushinteger(T, 1);
+
+    lua_gc(L, LUA_GCSTOP, 0);
+    lua_resetlockstats(L);
+
+    int status = LUA_OK;
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread worker(
+        [&]()
+        {
+            luaL_ThreadAttach attach(T);
+            status = lua_pcall(T, 2, 1, 0);
+        }
+    );
+    worker.join();
+
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    lua_LockStats stats = {};
+    lua_getlockstats(L, &stats);
+
+    if (verbose)
+        printf("ThreadedUpvalues: %d closes in %.3f ms, %llu global lock acquisitions\n", iterations, duration * 1000, (unsigned long long)stats.globalacquired);
+
+    REQUIRE(status == LUA_OK);
+    CHECK(lua_tonumber(T, -1) == iterations);
+    CHECK(stats.globalacquired < iterations / 2);
+
+    lua_pop(L, 2);
+    lua_gc(L, LUA_GCRESTART, 0);
+}
+
+TEST_CASE("ThreadedRefs")
+{
+    // every worker keeps a window of live refs; a slot handed out twice would make some check see another worker's value
+    const char* source = R"(
+return function(n, id)
+    local live = {}
+    for i = 1, n do
+        local slot = i % 16
+        if live[slot] then
+            local r = live[slot]
+            local v = getref(r)
+            assert(v[1] == id and v[2] == i - 16)
+            unref(r)
+        end
+        live[slot] = ref({id, i})
+    end
+    for _, r in live do
+        unref(r)
+    end
+    return 0
+end
+)";
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    luaL_openlibs(L);
+
+    lua_pushcfunction(
+        L,
+        [](lua_State* L)
+        {
+            lua_pushinteger(L, lua_ref(L, 1));
+            return 1;
+        },
+        "ref"
+    );
+    lua_setglobal(L, "ref");
+
+    lua_pushcfunction(
+        L,
+        [](lua_State* L)
+        {
+            lua_unref(L, luaL_checkinteger(L, 1));
+            return 0;
+        },
+        "unref"
+    );
+    lua_setglobal(L, "unref");
+
+    lua_pushcfunction(
+        L,
+        [](lua_State* L)
+        {
+            lua_getref(L, luaL_checkinteger(L, 1));
+            return 1;
+        },
+        "getref"
+    );
+    lua_setglobal(L, "getref");
+
+    runThreadedChunk(L, source, 4, 100000);
+
+    // released slots are reused before the registry grows
+    lua_newtable(L);
+    int ref = lua_ref(L, -1);
+    lua_pop(L, 1);
+    CHECK(ref <= 4 * 16);
+
+    lua_unref(L, ref);
+    lua_pushboolean(L, true);
+    CHECK(lua_ref(L, -1) == ref);
+    lua_pop(L, 1);
+
+    lua_getref(L, ref);
+    CHECK(lua_toboolean(L, -1));
+    lua_pop(L, 1);
+}
+
+#if !LUA_USE_LONGJMP
+TEST_CASE("ExceptionObject")
+{
+    struct ExceptionResult
     {
         bool exceptionGenerated;
         std::string description;
@@ -3086,6 +4118,63 @@ TEST_CASE("UserdataApi")
     CHECK(dtorhits == 42);
 }
 
+TEST_CASE("UserdataBatchDestructor")
+{
+    static int calls = 0;
+    static int destroyed = 0;
+    static int sum = 0;
+
+    calls = 0;
+    destroyed = 0;
+    sum = 0;
+
+    StateRef globalState(luaL_newstate(), lua_close);
+    lua_State* L = globalState.get();
+
+    auto dtor = [](lua_State* l, void** data, int count)
+    {
+        calls++;
+        destroyed += count;
+        for (int i = 0; i < count; ++i)
+            sum += *(int*)data[i];
+    };
+
+    CHECK(lua_getuserdatabatchdtor(L, 42) == nullptr);
+    lua_setuserdatabatchdtor(L, 42, dtor);
+    lua_setuserdatabatchdtor(L, 43, dtor);
+    CHECK(lua_getuserdatabatchdtor(L, 42) == dtor);
+
+    // batch destructors take over from the destructor of the tag
+    lua_setuserdatadtor(
+        L,
+        42,
+        [](lua_State* l, void* data)
+        {
+            sum = -1000000;
+        }
+    );
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        *(int*)lua_newuserdatatagged(L, 4, 42 + i % 2) = 1;
+        lua_pop(L, 1);
+    }
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    // dead userdata are destroyed a page at a time, one call for each tag
+    CHECK(destroyed == 1000);
+    CHECK(sum == 1000);
+    CHECK(calls < 100);
+
+    *(int*)lua_newuserdatatagged(L, 4, 42) = 10;
+
+    globalState.reset();
+
+    CHECK(destroyed == 1001);
+    CHECK(sum == 1010);
+}
+
 // provide alignment of 16 for userdata objects with size of 16 and up as long as the Luau allocation functions supports it
 TEST_CASE("UserdataAlignment")
 {
@@ -1945,35 +1945,35 @@ bb_bytecode_1:
   %13 = LOAD_DOUBLE R0
   %14 = TRY_NUM_TO_INDEX %13, bb_fallback_3
   %15 = SUB_INT %14, 1i
-  CHECK_ARRAY_SIZE %12, %15, bb_fallback_3
+  CHECK_ARRAY_SIZE %12, %15, bb_fallback_4
   CHECK_NO_METATABLE %12, bb_fallback_3
   %18 = GET_ARR_ADDR %12, %15
   %19 = LOAD_TVALUE %18
   STORE_TVALUE R5, %19
-  JUMP bb_linear_17
-bb_linear_17:
-  %124 = LOAD_TVALUE %18
-  STORE_TVALUE R6, %124
-  CHECK_TAG R5, tnumber, bb_fallback_7
-  CHECK_TAG R6, tnumber, bb_fallback_7
-  %131 = LOAD_DOUBLE R5
-  %133 = MUL_NUM %131, R6
-  STORE_DOUBLE R4, %133
+  JUMP bb_linear_21
+bb_linear_21:
+  %160 = LOAD_TVALUE %18
+  STORE_TVALUE R6, %160
+  CHECK_TAG R5, tnumber, bb_fallback_9
+  CHECK_TAG R6, tnumber, bb_fallback_9
+  %167 = LOAD_DOUBLE R5
+  %169 = MUL_NUM %167, R6
+  STORE_DOUBLE R4, %169
   STORE_TAG R4, tnumber
-  %137 = LOAD_POINTER R2
-  CHECK_ARRAY_SIZE %137, %15, bb_fallback_9
-  CHECK_NO_METATABLE %137, bb_fallback_9
-  %143 = GET_ARR_ADDR %137, %15
-  %144 = LOAD_TVALUE %143
-  STORE_TVALUE R6, %144
-  %154 = LOAD_TVALUE %143
-  STORE_TVALUE R7, %154
-  CHECK_TAG R6, tnumber, bb_fallback_13
-  CHECK_TAG R7, tnumber, bb_fallback_13
-  %161 = LOAD_DOUBLE R6
-  %163 = MUL_NUM %161, R7
-  %173 = ADD_NUM %133, %163
-  STORE_DOUBLE R3, %173
+  %173 = LOAD_POINTER R2
+  CHECK_ARRAY_SIZE %173, %15, bb_fallback_12
+  CHECK_NO_METATABLE %173, bb_fallback_11
+  %179 = GET_ARR_ADDR %173, %15
+  %180 = LOAD_TVALUE %179
+  STORE_TVALUE R6, %180
+  %190 = LOAD_TVALUE %179
+  STORE_TVALUE R7, %190
+  CHECK_TAG R6, tnumber, bb_fallback_17
+  CHECK_TAG R7, tnumber, bb_fallback_17
+  %197 = LOAD_DOUBLE R6
+  %199 = MUL_NUM %197, R7
+  %209 = ADD_NUM %169, %199
+  STORE_DOUBLE R3, %209
   STORE_TAG R3, tnumber
   INTERRUPT 7u
   RETURN R3, 1i
@@ -2308,25 +2308,25 @@ bb_bytecode_1:
   %9 = LOAD_DOUBLE R1
   %10 = TRY_NUM_TO_INDEX %9, bb_fallback_3
   %11 = SUB_INT %10, 1i
-  CHECK_ARRAY_SIZE %8, %11, bb_fallback_3
+  CHECK_ARRAY_SIZE %8, %11, bb_fallback_4
   CHECK_NO_METATABLE %8, bb_fallback_3
   %14 = GET_ARR_ADDR %8, %11
   %15 = LOAD_TVALUE %14
   STORE_TVALUE R2, %15
-  JUMP bb_4
-bb_4:
+  JUMP bb_5
+bb_5:
   CHECK_TAG R2, ttable, exit(1)
-  %23 = LOAD_POINTER R2
-  %24 = GET_SLOT_NODE_ADDR %23, 1u, K0 ('pos')
-  CHECK_SLOT_MATCH %24, K0 ('pos'), bb_fallback_5
-  %26 = LOAD_TVALUE %24, 0i
-  STORE_TVALUE R4, %26
-  JUMP bb_6
-bb_6:
+  %32 = LOAD_POINTER R2
+  %33 = GET_SLOT_NODE_ADDR %32, 1u, K0 ('pos')
+  CHECK_SLOT_MATCH %33, K0 ('pos'), bb_fallback_6
+  %35 = LOAD_TVALUE %33, 0i
+  STORE_TVALUE R4, %35
+  JUMP bb_7
+bb_7:
   CHECK_TAG R4, tvector, exit(3)
-  %33 = LOAD_FLOAT R4, 4i
-  %34 = FLOAT_TO_NUM %33
-  STORE_DOUBLE R3, %34
+  %42 = LOAD_FLOAT R4, 4i
+  %43 = FLOAT_TO_NUM %42
+  STORE_DOUBLE R3, %43
   STORE_TAG R3, tnumber
   INTERRUPT 5u
   RETURN R3, 1i
@@ -2423,34 +2423,34 @@ bb_bytecode_1:
   %9 = LOAD_DOUBLE R1
   %10 = TRY_NUM_TO_INDEX %9, bb_fallback_3
   %11 = SUB_INT %10, 1i
-  CHECK_ARRAY_SIZE %8, %11, bb_fallback_3
+  CHECK_ARRAY_SIZE %8, %11, bb_fallback_4
   CHECK_NO_METATABLE %8, bb_fallback_3
   %14 = GET_ARR_ADDR %8, %11
   %15 = LOAD_TVALUE %14
   STORE_TVALUE R3, %15
-  JUMP bb_4
-bb_4:
-  CHECK_TAG R3, ttable, bb_fallback_5
-  %23 = LOAD_POINTER R3
-  %24 = GET_SLOT_NODE_ADDR %23, 1u, K0 ('normal')
-  CHECK_SLOT_MATCH %24, K0 ('normal'), bb_fallback_5
-  %26 = LOAD_TVALUE %24, 0i
-  STORE_TVALUE R2, %26
-  JUMP bb_6
-bb_6:
-  %31 = LOAD_TVALUE K1 (0.707000017, 0, 0.707000017), 0i, tvector
-  STORE_TVALUE R4, %31
+  JUMP bb_5
+bb_5:
+  CHECK_TAG R3, ttable, bb_fallback_6
+  %32 = LOAD_POINTER R3
+  %33 = GET_SLOT_NODE_ADDR %32, 1u, K0 ('normal')
+  CHECK_SLOT_MATCH %33, K0 ('normal'), bb_fallback_6
+  %35 = LOAD_TVALUE %33, 0i
+  STORE_TVALUE R2, %35
+  JUMP bb_7
+bb_7:
+  %40 = LOAD_TVALUE K1 (0.707000017, 0, 0.707000017), 0i, tvector
+  STORE_TVALUE R4, %40
   CHECK_TAG R2, tvector, exit(4)
-  %37 = LOAD_FLOAT R2, 0i
-  %39 = MUL_FLOAT %37, 0.7070000171661377
-  %40 = LOAD_FLOAT R2, 4i
-  %42 = MUL_FLOAT %40, 0
-  %43 = LOAD_FLOAT R2, 8i
-  %45 = MUL_FLOAT %43, 0.7070000171661377
-  %46 = ADD_FLOAT %39, %42
-  %47 = ADD_FLOAT %46, %45
-  %48 = FLOAT_TO_NUM %47
-  STORE_DOUBLE R2, %48
+  %46 = LOAD_FLOAT R2, 0i
+  %48 = MUL_FLOAT %46, 0.7070000171661377
+  %49 = LOAD_FLOAT R2, 4i
+  %51 = MUL_FLOAT %49, 0
+  %52 = LOAD_FLOAT R2, 8i
+  %54 = MUL_FLOAT %52, 0.7070000171661377
+  %55 = ADD_FLOAT %48, %51
+  %56 = ADD_FLOAT %55, %54
+  %57 = FLOAT_TO_NUM %56
+  STORE_DOUBLE R2, %57
   STORE_TAG R2, tnumber
   ADJUST_STACK_TO_REG R2, 1i
   INTERRUPT 7u
@@ -2484,19 +2484,19 @@ bb_bytecode_0:
   %5 = LOAD_DOUBLE R1
   %6 = TRY_NUM_TO_INDEX %5, bb_fallback_1
   %7 = SUB_INT %6, 1i
-  CHECK_ARRAY_SIZE %4, %7, bb_fallback_1
+  CHECK_ARRAY_SIZE %4, %7, bb_fallback_2
   CHECK_NO_METATABLE %4, bb_fallback_1
   %10 = GET_ARR_ADDR %4, %7
   %11 = LOAD_TVALUE %10
   STORE_TVALUE R3, %11
-  JUMP bb_2
-bb_2:
+  JUMP bb_3
+bb_3:
   CHECK_TAG R3, tvector, exit(1)
-  %19 = LOAD_TVALUE R3, 0i, tvector
-  %21 = FLOAT_TO_VEC 5
-  %22 = DIV_VEC %19, %21
-  %23 = TAG_VECTOR %22
-  STORE_TVALUE R2, %23
+  %28 = LOAD_TVALUE R3, 0i, tvector
+  %30 = FLOAT_TO_VEC 5
+  %31 = DIV_VEC %28, %30
+  %32 = TAG_VECTOR %31
+  STORE_TVALUE R2, %32
   INTERRUPT 2u
   RETURN R2, 1i
 )"
@@ -2606,10 +2606,10 @@ bb_bytecode_3:
   %54 = LOAD_POINTER R3
   %55 = LOAD_INT R4
   %56 = GET_ARR_ADDR %54, %55
-  CHECK_ARRAY_SIZE %54, %55, bb_9
+  CHECK_ARRAY_SIZE %54, %55, bb_fallback_11
   %58 = LOAD_TAG %56
-  JUMP_EQ_TAG %58, tnil, bb_9, bb_11
-bb_11:
+  JUMP_EQ_TAG %58, tnil, bb_9, bb_12
+bb_12:
   %60 = ADD_INT %55, 1i
   STORE_INT R4, %60
   %62 = INT_TO_NUM %60
@@ -5201,84 +5201,84 @@ bb_bytecode_2:
   %39 = LOAD_DOUBLE R3
   %40 = TRY_NUM_TO_INDEX %39, bb_fallback_7
   %41 = SUB_INT %40, 1i
-  CHECK_ARRAY_SIZE %38, %41, bb_fallback_7
+  CHECK_ARRAY_SIZE %38, %41, bb_fallback_8
   CHECK_NO_METATABLE %38, bb_fallback_7
   %44 = GET_ARR_ADDR %38, %41
   %45 = LOAD_TVALUE %44
   STORE_TVALUE R6, %45
-  JUMP bb_linear_17
-bb_linear_17:
+  JUMP bb_linear_20
+bb_linear_20:
   STORE_TVALUE R9, %30
-  %135 = LOAD_TVALUE %44
-  STORE_TVALUE R8, %135
-  CHECK_TAG R8, tnumber, bb_fallback_11
-  %140 = LOAD_DOUBLE R8
-  %142 = MUL_NUM %140, R0
-  STORE_DOUBLE R7, %142
+  %164 = LOAD_TVALUE %44
+  STORE_TVALUE R8, %164
+  CHECK_TAG R8, tnumber, bb_fallback_13
+  %169 = LOAD_DOUBLE R8
+  %171 = MUL_NUM %169, R0
+  STORE_DOUBLE R7, %171
   STORE_TAG R7, tnumber
-  CHECK_TAG R6, tnumber, bb_fallback_13
-  %150 = LOAD_DOUBLE R6
-  %152 = ADD_NUM %150, %142
-  STORE_DOUBLE R5, %152
+  CHECK_TAG R6, tnumber, bb_fallback_15
+  %179 = LOAD_DOUBLE R6
+  %181 = ADD_NUM %179, %171
+  STORE_DOUBLE R5, %181
   STORE_TAG R5, tnumber
-  CHECK_NO_METATABLE %38, bb_fallback_15
-  CHECK_READONLY %38, bb_fallback_15
-  STORE_SPLIT_TVALUE %44, tnumber, %152
-  %172 = LOAD_DOUBLE R1
-  %174 = ADD_NUM %39, 1
-  STORE_DOUBLE R3, %174
-  JUMP_CMP_NUM %174, %172, le, bb_bytecode_2, bb_bytecode_3
-bb_8:
-  %51 = GET_UPVALUE U0
-  STORE_TVALUE R9, %51
+  CHECK_NO_METATABLE %38, bb_fallback_17
+  CHECK_READONLY %38, bb_fallback_17
+  STORE_SPLIT_TVALUE %44, tnumber, %181
+  %201 = LOAD_DOUBLE R1
+  %203 = ADD_NUM %39, 1
+  STORE_DOUBLE R3, %203
+  JUMP_CMP_NUM %203, %201, le, bb_bytecode_2, bb_bytecode_3
+bb_9:
+  %60 = GET_UPVALUE U0
+  STORE_TVALUE R9, %60
   CHECK_TAG R9, ttable, exit(9)
   CHECK_TAG R3, tnumber, exit(9)
-  %57 = LOAD_POINTER R9
-  %58 = LOAD_DOUBLE R3
-  %59 = TRY_NUM_TO_INDEX %58, bb_fallback_9
-  %60 = SUB_INT %59, 1i
-  CHECK_ARRAY_SIZE %57, %60, bb_fallback_9
-  CHECK_NO_METATABLE %57, bb_fallback_9
-  %63 = GET_ARR_ADDR %57, %60
-  %64 = LOAD_TVALUE %63
-  STORE_TVALUE R8, %64
-  JUMP bb_10
-bb_10:
-  CHECK_TAG R8, tnumber, bb_fallback_11
-  %74 = LOAD_DOUBLE R8
-  %76 = MUL_NUM %74, R0
-  STORE_DOUBLE R7, %76
-  STORE_TAG R7, tnumber
+  %66 = LOAD_POINTER R9
+  %67 = LOAD_DOUBLE R3
+  %68 = TRY_NUM_TO_INDEX %67, bb_fallback_10
+  %69 = SUB_INT %68, 1i
+  CHECK_ARRAY_SIZE %66, %69, bb_fallback_11
+  CHECK_NO_METATABLE %66, bb_fallback_10
+  %72 = GET_ARR_ADDR %66, %69
+  %73 = LOAD_TVALUE %72
+  STORE_TVALUE R8, %73
   JUMP bb_12
 bb_12:
-  CHECK_TAG R6, tnumber, bb_fallback_13
-  CHECK_TAG R7, tnumber, bb_fallback_13
-  %87 = LOAD_DOUBLE R6
-  %89 = ADD_NUM %87, R7
-  STORE_DOUBLE R5, %89
-  STORE_TAG R5, tnumber
+  CHECK_TAG R8, tnumber, bb_fallback_13
+  %92 = LOAD_DOUBLE R8
+  %94 = MUL_NUM %92, R0
+  STORE_DOUBLE R7, %94
+  STORE_TAG R7, tnumber
   JUMP bb_14
 bb_14:
-  CHECK_TAG R4, ttable, exit(12)
-  CHECK_TAG R3, tnumber, exit(12)
-  %100 = LOAD_POINTER R4
-  %101 = LOAD_DOUBLE R3
-  %102 = TRY_NUM_TO_INDEX %101, bb_fallback_15
-  %103 = SUB_INT %102, 1i
-  CHECK_ARRAY_SIZE %100, %103, bb_fallback_15
-  CHECK_NO_METATABLE %100, bb_fallback_15
-  CHECK_READONLY %100, bb_fallback_15
-  %107 = GET_ARR_ADDR %100, %103
-  %108 = LOAD_TVALUE R5
-  STORE_TVALUE %107, %108
-  BARRIER_TABLE_FORWARD %100, R5, undef
+  CHECK_TAG R6, tnumber, bb_fallback_15
+  CHECK_TAG R7, tnumber, bb_fallback_15
+  %105 = LOAD_DOUBLE R6
+  %107 = ADD_NUM %105, R7
+  STORE_DOUBLE R5, %107
+  STORE_TAG R5, tnumber
   JUMP bb_16
 bb_16:
-  %115 = LOAD_DOUBLE R1
-  %116 = LOAD_DOUBLE R3
-  %117 = ADD_NUM %116, 1
-  STORE_DOUBLE R3, %117
-  JUMP_CMP_NUM %117, %115, le, bb_bytecode_2, bb_bytecode_3
+  CHECK_TAG R4, ttable, exit(12)
+  CHECK_TAG R3, tnumber, exit(12)
+  %118 = LOAD_POINTER R4
+  %119 = LOAD_DOUBLE R3
+  %120 = TRY_NUM_TO_INDEX %119, bb_fallback_17
+  %121 = SUB_INT %120, 1i
+  CHECK_ARRAY_SIZE %118, %121, bb_fallback_18
+  CHECK_NO_METATABLE %118, bb_fallback_17
+  CHECK_READONLY %118, bb_fallback_17
+  %125 = GET_ARR_ADDR %118, %121
+  %126 = LOAD_TVALUE R5
+  STORE_TVALUE %125, %126
+  BARRIER_TABLE_FORWARD %118, R5, undef
+  JUMP bb_19
+bb_19:
+  %144 = LOAD_DOUBLE R1
+  %145 = LOAD_DOUBLE R3
+  %146 = ADD_NUM %145, 1
+  STORE_DOUBLE R3, %146
+  JUMP_CMP_NUM %146, %144, le, bb_bytecode_2, bb_bytecode_3
 bb_bytecode_3:
   INTERRUPT 14u
   RETURN R0, 0i
@@ -5717,25 +5717,25 @@ bb_bytecode_2:
   %37 = LOAD_DOUBLE R5
   %38 = TRY_NUM_TO_INDEX %37, bb_fallback_7
   %39 = SUB_INT %38, 1i
-  CHECK_ARRAY_SIZE %36, %39, bb_fallback_7
+  CHECK_ARRAY_SIZE %36, %39, bb_fallback_8
   CHECK_NO_METATABLE %36, bb_fallback_7
   %42 = GET_ARR_ADDR %36, %39
   %43 = LOAD_TVALUE %42
   STORE_TVALUE R6, %43
-  JUMP bb_8
-bb_8:
+  JUMP bb_9
+bb_9:
   CHECK_TAG R2, tnumber, exit(6)
-  CHECK_TAG R6, tnumber, bb_fallback_9
-  %53 = LOAD_DOUBLE R2
-  %55 = ADD_NUM %53, R6
-  STORE_DOUBLE R2, %55
-  JUMP bb_10
-bb_10:
-  %61 = LOAD_DOUBLE R3
-  %62 = LOAD_DOUBLE R5
-  %63 = ADD_NUM %62, 1
-  STORE_DOUBLE R5, %63
-  JUMP_CMP_NUM %63, %61, le, bb_bytecode_2, bb_bytecode_3
+  CHECK_TAG R6, tnumber, bb_fallback_10
+  %62 = LOAD_DOUBLE R2
+  %64 = ADD_NUM %62, R6
+  STORE_DOUBLE R2, %64
+  JUMP bb_11
+bb_11:
+  %70 = LOAD_DOUBLE R3
+  %71 = LOAD_DOUBLE R5
+  %72 = ADD_NUM %71, 1
+  STORE_DOUBLE R5, %72
+  JUMP_CMP_NUM %72, %70, le, bb_bytecode_2, bb_bytecode_3
 bb_bytecode_3:
   INTERRUPT 8u
   RETURN R2, 1i